@@ -239,8 +239,11 @@ function setRunSpeed(percent) {
         .catch(e => { appendLog('Set speed failed'); console.error(e); });
 }
 
+// With a spindle tachometer the slider is an RPM setpoint
+let spindleClosedLoop = false;
+
 function setSpindlePower(val) {
-    const body = { power: parseInt(val) };
+    const body = spindleClosedLoop ? { rpm: parseInt(val) } : { power: parseInt(val) };
     fetch('/api/spindle', { method: 'POST', headers: { 'Content-Type': 'application/json' }, body: JSON.stringify(body) })
         .then(r => r.json()).then(j => { appendLog('Spindle set'); })
         .catch(e => { appendLog('Spindle set failed'); console.error(e); });
@@ -272,7 +275,14 @@ window.addEventListener('load', function() {
     const lsrOff = document.getElementById('laser-off'); if (lsrOff) lsrOff.addEventListener('click', () => { if (lsr) { lsr.value = 0; if (lsrVal) lsrVal.innerText = '0'; setLaserPower(0); } });
 
     // Fetch initial states
-    fetch('/api/spindle').then(r=>r.json()).then(j=>{ if (j && j.power !== undefined && spd) { spd.value = j.power; if (spdVal) spdVal.innerText = j.power; } }).catch(()=>{});
+    fetch('/api/spindle').then(r=>r.json()).then(j=>{
+        if (!j || !spd) return;
+        if (j.closedLoop) {
+            spindleClosedLoop = true;
+            spd.max = j.maxRpm; spd.step = 100;
+            spd.value = j.targetRpm; if (spdVal) spdVal.innerText = Math.round(j.targetRpm) + ' rpm';
+        } else if (j.power !== undefined) { spd.value = j.power; if (spdVal) spdVal.innerText = j.power; }
+    }).catch(()=>{});
     fetch('/api/laser').then(r=>r.json()).then(j=>{ if (j && j.power !== undefined && lsr) { lsr.value = j.power; if (lsrVal) lsrVal.innerText = j.power; } }).catch(()=>{});
     fetch('/api/run').then(r=>r.json()).then(j=>{ if (j && j.speedPercent !== undefined && speed) { speed.value = j.speedPercent; if (speedVal) speedVal.innerText = j.speedPercent + '%'; } }).catch(()=>{});
 });
@@ -2330,6 +2340,65 @@ function downloadGCode() {
     appendLog('Downloaded: ' + currentGCodeData.filename);
 }
 
+// CRC-32 (zlib polynomial) for upload chunk checks
+const CRC32_TABLE = (() => {
+    const t = new Uint32Array(256);
+    for (let n = 0; n < 256; n++) {
+        let c = n;
+        for (let k = 0; k < 8; k++) c = c & 1 ? 0xEDB88320 ^ (c >>> 1) : c >>> 1;
+        t[n] = c >>> 0;
+    }
+    return t;
+})();
+
+function crc32Hex(bytes) {
+    let c = 0xFFFFFFFF;
+    for (let i = 0; i < bytes.length; i++) c = CRC32_TABLE[(c ^ bytes[i]) & 0xFF] ^ (c >>> 8);
+    return ((c ^ 0xFFFFFFFF) >>> 0).toString(16).padStart(8, '0');
+}
+
+/**
+ * Upload a file in checked chunks through an upload session. A dropped
+ * connection or a corrupted chunk costs one chunk, not the whole file:
+ * the device is asked where it got to and the upload carries on.
+ */
+async function uploadResumable(blob, filename, storage = 'littlefs', onProgress = null) {
+    const json = async (r) => {
+        const body = await r.json().catch(() => ({}));
+        if (!r.ok && r.status !== 409) throw new Error(body.error || ('HTTP ' + r.status));
+        return body;
+    };
+    let session = await fetch('/api/upload/session', {
+        method: 'POST',
+        headers: { 'Content-Type': 'application/json' },
+        body: JSON.stringify({ filename, storage, size: blob.size })
+    }).then(json);
+    const url = '/api/upload/session?id=' + session.id;
+    let offset = session.offset;
+    let failures = 0;
+    while (offset < blob.size) {
+        const bytes = new Uint8Array(await blob.slice(offset, offset + session.chunkSize).arrayBuffer());
+        try {
+            const r = await fetch(`${url}&offset=${offset}&crc32=${crc32Hex(bytes)}`, {
+                method: 'PUT',
+                headers: { 'Content-Type': 'application/octet-stream' },
+                body: bytes
+            });
+            const body = await json(r);
+            offset = body.offset;
+            if (r.ok) failures = 0;
+        } catch (e) {
+            if (++failures > 8) throw e;
+            appendLog(`Upload interrupted at ${offset} bytes (${e.message}), resuming...`);
+            await new Promise(res => setTimeout(res, Math.min(500 * failures, 5000)));
+            const st = await fetch(url).then(json).catch(() => null);
+            if (st) offset = st.offset;
+        }
+        if (onProgress) onProgress(offset, blob.size);
+    }
+    return fetch('/api/upload/session/commit?id=' + session.id, { method: 'POST' }).then(json);
+}
+
 /**
  * Save GCode to device filesystem
  */
@@ -2340,8 +2409,6 @@ function saveGCodeToDevice() {
     }
     
     const blob = new Blob([currentGCodeData.content], { type: 'text/plain' });
-    const formData = new FormData();
-    formData.append('file', blob, currentGCodeData.filename);
     
     appendLog('Saving to device: ' + currentGCodeData.filename);
     const saveBtn = document.getElementById('save-btn');
@@ -2350,13 +2417,8 @@ function saveGCodeToDevice() {
         saveBtn.innerText = 'Saving...';
     }
     
-    fetch('/api/upload', {
-        method: 'POST',
-        body: formData
-    })
-    .then(response => {
-        if (!response.ok) throw new Error('Upload failed');
-        return response.text();
+    uploadResumable(blob, currentGCodeData.filename, 'littlefs', (done, total) => {
+        if (saveBtn) saveBtn.innerText = `Saving... ${Math.floor(done * 100 / total)}%`;
     })
     .then(result => {
         appendLog('Saved to device: ' + currentGCodeData.filename);
@@ -2461,23 +2523,31 @@ function uploadAndPrint() {
         return;
     }
     
+    // Streamed: the machine starts on the first lines while the rest is
+    // still being sent, and keeps a copy for re-runs
     const blob = new Blob([currentGCodeData.content], { type: 'text/plain' });
-    const formData = new FormData();
-    formData.append('file', blob, currentGCodeData.filename);
+    const name = currentGCodeData.filename;
+    document.getElementById('job-state').innerText = 'printing';
+    document.getElementById('job-filename').innerText = name;
+    appendLog('Streaming print: ' + name);
     
-    fetch('/api/upload', {
+    fetch(`/api/print?name=${encodeURIComponent(name)}&store=littlefs`, {
         method: 'POST',
-        body: formData
+        headers: { 'Content-Type': 'text/plain' },
+        body: blob
+    })
+    .then(async response => {
+        const result = await response.json().catch(() => ({}));
+        if (!response.ok) throw new Error(result.error || ('HTTP ' + response.status));
+        return result;
     })
-    .then(response => response.text())
     .then(result => {
-        appendLog('Upload complete: ' + currentGCodeData.filename);
-        document.getElementById('job-state').innerText = 'printing';
-        document.getElementById('job-filename').innerText = currentGCodeData.filename;
-        alert('Upload & Print started');
+        if (result.stopped) appendLog('Print stopped: ' + name);
+        else appendLog(`Print sent: ${name} (${result.bytes} bytes, first line after ${result.firstLineMs} ms)`);
     })
     .catch(error => {
-        appendLog('Upload failed: ' + error);
+        document.getElementById('job-state').innerText = 'error';
+        appendLog('Print failed: ' + error.message);
         console.error('Error:', error);
     });
 }
@@ -1,23 +1,74 @@
+// Settings form, generated from the firmware settings registry
+// (/api/config/schema lists every setting with its type and range).
+let settingsSchema = [];
+
+const GROUP_TITLES = {
+    countsPerMM: 'Steps / Counts per mm',
+    pid: 'PID Tunings (P I D)',
+    maxFeedrate: 'Max Feedrates (mm/min)',
+    maxAccel: 'Max Acceleration (mm/s²)',
+    maxJerk: 'Max Jerk (mm/s³)',
+    arcTolerance: 'Arc Chord Tolerance (mm)',
+    spindle: 'Spindle',
+    laser: 'Laser'
+};
+
+function fieldId(path) {
+    return 'cfg-' + path.replace(/\./g, '-');
+}
+
+function getPath(doc, path) {
+    return path.split('.').reduce((o, k) => (o == null ? undefined : o[k]), doc);
+}
+
+function setPath(doc, path, value) {
+    const keys = path.split('.');
+    let o = doc;
+    keys.slice(0, -1).forEach(k => { if (typeof o[k] !== 'object') o[k] = {}; o = o[k]; });
+    o[keys[keys.length - 1]] = value;
+}
+
+function buildForm(schema) {
+    const root = document.getElementById('cfg-fields');
+    root.innerHTML = '';
+    let group = null, row = null, rowKey = null;
+    schema.forEach(s => {
+        const keys = s.path.split('.');
+        if (keys[0] !== group) {
+            group = keys[0]; rowKey = null;
+            const title = document.createElement('div');
+            title.style.cssText = 'font-size:0.9em; color:#aaa; margin-top:6px';
+            title.textContent = GROUP_TITLES[group] || group;
+            root.appendChild(title);
+        }
+        // One line per axis ("pid.x.p/i/d" share a row), one per setting otherwise
+        const thisRow = keys.length > 2 ? keys.slice(0, -1).join('.') : s.path;
+        if (thisRow !== rowKey) {
+            rowKey = thisRow;
+            row = document.createElement('p');
+            if (keys.length > 1) row.appendChild(document.createTextNode(keys[1].toUpperCase() + ': '));
+            root.appendChild(row);
+        }
+        const input = document.createElement('input');
+        input.id = fieldId(s.path);
+        input.type = 'number';
+        input.step = s.type === 'int' ? '1' : 'any';
+        input.min = s.min; input.max = s.max;
+        input.title = s.path + ' (' + s.min + ' – ' + s.max + ', default ' + s.default + ')';
+        input.style.width = '100px';
+        row.appendChild(input);
+        row.appendChild(document.createTextNode(' '));
+    });
+}
+
 function populateConfig(doc) {
     if (!doc) return;
-    document.getElementById('cfg-cpm-x').value = Number(doc.countsPerMM.x).toFixed(4);
-    document.getElementById('cfg-cpm-y').value = Number(doc.countsPerMM.y).toFixed(4);
-    document.getElementById('cfg-cpm-z').value = Number(doc.countsPerMM.z).toFixed(4);
-    document.getElementById('cfg-cpm-e').value = Number(doc.countsPerMM.e).toFixed(4);
+    settingsSchema.forEach(s => {
+        const el = document.getElementById(fieldId(s.path));
+        const v = getPath(doc, s.path);
+        if (el && v !== undefined) el.value = s.type === 'int' ? v : Number(Number(v).toPrecision(6));
+    });
 
-    if (doc.pid) {
-        if (doc.pid.x) { document.getElementById('cfg-pid-x-p').value = Number(doc.pid.x.p); document.getElementById('cfg-pid-x-i').value = Number(doc.pid.x.i); document.getElementById('cfg-pid-x-d').value = Number(doc.pid.x.d); }
-        if (doc.pid.y) { document.getElementById('cfg-pid-y-p').value = Number(doc.pid.y.p); document.getElementById('cfg-pid-y-i').value = Number(doc.pid.y.i); document.getElementById('cfg-pid-y-d').value = Number(doc.pid.y.d); }
-        if (doc.pid.z) { document.getElementById('cfg-pid-z-p').value = Number(doc.pid.z.p); document.getElementById('cfg-pid-z-i').value = Number(doc.pid.z.i); document.getElementById('cfg-pid-z-d').value = Number(doc.pid.z.d); }
-        if (doc.pid.e) { document.getElementById('cfg-pid-e-p').value = Number(doc.pid.e.p); document.getElementById('cfg-pid-e-i').value = Number(doc.pid.e.i); document.getElementById('cfg-pid-e-d').value = Number(doc.pid.e.d); }
-    }
-    if (doc.maxFeedrate) {
-        document.getElementById('cfg-maxf-x').value = Number(doc.maxFeedrate.x);
-        document.getElementById('cfg-maxf-y').value = Number(doc.maxFeedrate.y);
-        document.getElementById('cfg-maxf-z').value = Number(doc.maxFeedrate.z);
-        document.getElementById('cfg-maxf-e').value = Number(doc.maxFeedrate.e);
-    }
-    
     // Load CSG settings from localStorage
     const csgThreads = localStorage.getItem('csgThreads');
     if (document.getElementById('cfg-csg-threads')) {
@@ -28,32 +79,17 @@ function populateConfig(doc) {
 function loadConfig() {
     fetch('/api/config').then(r => r.json()).then(doc => {
         populateConfig(doc);
-        alert('Config loaded');
     }).catch(e => { alert('Config load failed'); console.error(e); });
 }
 
 function saveConfig() {
-    const body = {
-        countsPerMM: {
-            x: parseFloat(document.getElementById('cfg-cpm-x').value),
-            y: parseFloat(document.getElementById('cfg-cpm-y').value),
-            z: parseFloat(document.getElementById('cfg-cpm-z').value),
-            e: parseFloat(document.getElementById('cfg-cpm-e').value)
-        },
-        pid: {
-            x: { p: parseFloat(document.getElementById('cfg-pid-x-p').value), i: parseFloat(document.getElementById('cfg-pid-x-i').value), d: parseFloat(document.getElementById('cfg-pid-x-d').value) },
-            y: { p: parseFloat(document.getElementById('cfg-pid-y-p').value), i: parseFloat(document.getElementById('cfg-pid-y-i').value), d: parseFloat(document.getElementById('cfg-pid-y-d').value) },
-            z: { p: parseFloat(document.getElementById('cfg-pid-z-p').value), i: parseFloat(document.getElementById('cfg-pid-z-i').value), d: parseFloat(document.getElementById('cfg-pid-z-d').value) },
-            e: { p: parseFloat(document.getElementById('cfg-pid-e-p').value), i: parseFloat(document.getElementById('cfg-pid-e-i').value), d: parseFloat(document.getElementById('cfg-pid-e-d').value) }
-        },
-        maxFeedrate: {
-            x: parseInt(document.getElementById('cfg-maxf-x').value),
-            y: parseInt(document.getElementById('cfg-maxf-y').value),
-            z: parseInt(document.getElementById('cfg-maxf-z').value),
-            e: parseInt(document.getElementById('cfg-maxf-e').value)
-        }
-    };
-    
+    const body = {};
+    settingsSchema.forEach(s => {
+        const el = document.getElementById(fieldId(s.path));
+        if (!el || el.value === '') return;
+        setPath(body, s.path, s.type === 'int' ? parseInt(el.value) : parseFloat(el.value));
+    });
+
     // Save CSG settings to localStorage
     const csgThreadsInput = document.getElementById('cfg-csg-threads');
     if (csgThreadsInput) {
@@ -64,14 +100,39 @@ function saveConfig() {
             localStorage.removeItem('csgThreads');
         }
     }
-    
+
     fetch('/api/config', { method: 'POST', headers: { 'Content-Type': 'application/json' }, body: JSON.stringify(body) })
-        .then(r => r.json()).then(j => { alert('Config saved'); }).catch(e => { alert('Config save failed'); console.error(e); });
+        .then(r => r.json()).then(j => {
+            if (j.rejected && j.rejected.length) alert('Out of range, not saved: ' + j.rejected.join(', '));
+            else alert('Config saved');
+            loadConfig();
+        }).catch(e => { alert('Config save failed'); console.error(e); });
+}
+
+function importConfig(file) {
+    const form = new FormData();
+    form.append('file', file, file.name);
+    fetch('/api/config/import', { method: 'POST', body: form })
+        .then(r => r.json()).then(j => {
+            if (!j.success) { alert('Import failed: ' + (j.error || 'unknown error')); return; }
+            alert('Imported ' + j.applied + ' setting(s)' +
+                  (j.rejected ? ', ' + j.rejected + ' out of range' : '') +
+                  (j.unknown ? ', ' + j.unknown + ' unknown' : ''));
+            loadConfig();
+        }).catch(e => { alert('Import failed'); console.error(e); });
 }
 
 window.addEventListener('load', function() {
     document.getElementById('cfg-load').addEventListener('click', loadConfig);
     document.getElementById('cfg-save').addEventListener('click', saveConfig);
-    // load current settings on page open
-    loadConfig();
+    document.getElementById('cfg-export').addEventListener('click', () => { window.location = '/api/config/export'; });
+    const fileInput = document.getElementById('cfg-import-file');
+    document.getElementById('cfg-import').addEventListener('click', () => fileInput.click());
+    fileInput.addEventListener('change', () => { if (fileInput.files.length) importConfig(fileInput.files[0]); fileInput.value = ''; });
+    // build the form from the schema, then load current settings
+    fetch('/api/config/schema').then(r => r.json()).then(schema => {
+        settingsSchema = schema;
+        buildForm(schema);
+        loadConfig();
+    }).catch(e => { alert('Config schema load failed'); console.error(e); });
 });
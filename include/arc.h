@@ -0,0 +1,257 @@
+#ifndef ARC_H
+#define ARC_H
+
+#include <math.h>
+#include <stdint.h>
+#include "kinematics.h"
+
+// Re-anchor the incremental rotation to an exact sin/cos every N segments
+// so float rounding cannot accumulate along long arcs.
+#ifndef ARC_CORRECTION_INTERVAL
+#define ARC_CORRECTION_INTERVAL 12
+#endif
+
+// Upper bound on segments per arc (keeps a huge radius/tiny tolerance finite)
+#ifndef ARC_MAX_SEGMENTS
+#define ARC_MAX_SEGMENTS 2000
+#endif
+
+// G2/G3 arc interpolation in the XY plane.
+//
+// The segment count is chosen so that the chord never deviates from the true
+// circle by more than `tolerance` mm. Points are produced with an incremental
+// rotation matrix (one multiply-add pair per point instead of sin/cos), and
+// every other axis (Z for helical moves, E) is interpolated linearly along
+// the sweep. The final point is always the exact programmed end point.
+class ArcGenerator {
+private:
+    float startPos[NUM_AXES];
+    float endPos[NUM_AXES];
+    float cx, cy;         // center (mm)
+    float r;              // radius (mm)
+    float startAngle;     // angle of the start point around the center
+    float sweepAngle;     // signed sweep (negative = clockwise)
+    float segAngle;       // sweep per segment
+    float cosT, sinT;     // rotation per segment
+    float rx, ry;         // current radius vector
+    int count;            // number of segments
+    int index;            // segments emitted so far
+
+    bool setup(const float start[NUM_AXES], const float end[NUM_AXES], float centerX, float centerY, bool clockwise, float tolerance) {
+        for (int i = 0; i < NUM_AXES; ++i) { startPos[i] = start[i]; endPos[i] = end[i]; }
+        cx = centerX; cy = centerY;
+        rx = start[AXIS_X] - cx;
+        ry = start[AXIS_Y] - cy;
+        r = sqrtf(rx * rx + ry * ry);
+        if (!(r > 0.0f)) return false;
+
+        // Signed angle between the start and end radius vectors; equal
+        // start/end points describe a full circle.
+        float ex = end[AXIS_X] - cx;
+        float ey = end[AXIS_Y] - cy;
+        float sweep = atan2f(rx * ey - ry * ex, rx * ex + ry * ey);
+        const float eps = 1e-6f;
+        if (clockwise) { if (sweep >= -eps) sweep -= 2.0f * (float)M_PI; }
+        else           { if (sweep <= eps)  sweep += 2.0f * (float)M_PI; }
+        sweepAngle = sweep;
+        startAngle = atan2f(ry, rx);
+
+        count = segmentsFor(r, fabsf(sweep), tolerance);
+        segAngle = sweep / (float)count;
+        cosT = cosf(segAngle);
+        sinT = sinf(segAngle);
+        index = 0;
+        return true;
+    }
+
+public:
+    ArcGenerator() : cx(0), cy(0), r(0), startAngle(0), sweepAngle(0), segAngle(0),
+                     cosT(1), sinT(0), rx(0), ry(0), count(0), index(0) {
+        for (int i = 0; i < NUM_AXES; ++i) { startPos[i] = 0; endPos[i] = 0; }
+    }
+
+    // Segments needed so the chord error (sagitta) stays within tolerance
+    static int segmentsFor(float radius, float sweepAbs, float tolerance) {
+        float theta = (float)M_PI / 2.0f;
+        if (tolerance > 0.0f && tolerance < radius) {
+            theta = 2.0f * acosf(1.0f - tolerance / radius);
+            if (theta > (float)M_PI / 2.0f) theta = (float)M_PI / 2.0f;
+        }
+        int n = (int)ceilf(sweepAbs / theta);
+        if (n < 1) n = 1;
+        if (n > ARC_MAX_SEGMENTS) n = ARC_MAX_SEGMENTS;
+        return n;
+    }
+
+    // Arc with center given as I/J offsets from the start point
+    bool beginCenter(const float start[NUM_AXES], const float end[NUM_AXES], float i, float j, bool clockwise, float tolerance) {
+        return setup(start, end, start[AXIS_X] + i, start[AXIS_Y] + j, clockwise, tolerance);
+    }
+
+    // Arc given by radius; a negative radius selects the arc longer than 180
+    // degrees. Start and end must differ (a full circle needs I/J).
+    bool beginRadius(const float start[NUM_AXES], const float end[NUM_AXES], float radius, bool clockwise, float tolerance) {
+        float dx = end[AXIS_X] - start[AXIS_X];
+        float dy = end[AXIS_Y] - start[AXIS_Y];
+        float chord = sqrtf(dx * dx + dy * dy);
+        if (!(chord > 0.0f) || radius == 0.0f) return false;
+        float h2 = 4.0f * radius * radius - chord * chord;
+        if (h2 < 0.0f) {
+            // Radius slightly too small for the chord (rounding in the
+            // G-code): accept up to 0.1% and treat it as a half circle.
+            if (-h2 > 0.002f * 4.0f * radius * radius) return false;
+            h2 = 0.0f;
+        }
+        float k = -sqrtf(h2) / chord;
+        if (!clockwise) k = -k;
+        if (radius < 0.0f) k = -k;
+        float i = 0.5f * (dx - dy * k);
+        float j = 0.5f * (dy + dx * k);
+        return beginCenter(start, end, i, j, clockwise, tolerance);
+    }
+
+    int segments() const { return count; }
+    float radius() const { return r; }
+    float sweep() const { return sweepAngle; }
+    float centerX() const { return cx; }
+    float centerY() const { return cy; }
+
+    // Emit the next segment end point. Returns false once the arc is done.
+    bool next(float out[NUM_AXES]) {
+        if (index >= count) return false;
+        ++index;
+        if (index == count) {
+            for (int i = 0; i < NUM_AXES; ++i) out[i] = endPos[i];
+            return true;
+        }
+        if (index % ARC_CORRECTION_INTERVAL == 0) {
+            float a = startAngle + segAngle * (float)index;
+            rx = r * cosf(a);
+            ry = r * sinf(a);
+        } else {
+            float nx = rx * cosT - ry * sinT;
+            ry = rx * sinT + ry * cosT;
+            rx = nx;
+        }
+        float t = (float)index / (float)count;
+        for (int i = 0; i < NUM_AXES; ++i) out[i] = startPos[i] + (endPos[i] - startPos[i]) * t;
+        out[AXIS_X] = cx + rx;
+        out[AXIS_Y] = cy + ry;
+        return true;
+    }
+};
+
+// XY bounding box of an arc from (sx, sy) to (ex, ey) around (cx, cy) with
+// a signed sweep: the end points plus each quadrant point (0, 90, 180, 270
+// degrees) the sweep passes. Constant time whatever the arc's length.
+static inline void arcBoundsXY(float sx, float sy, float ex, float ey, float cx, float cy, float sweep, float lo[2], float hi[2]) {
+    lo[0] = fminf(sx, ex); hi[0] = fmaxf(sx, ex);
+    lo[1] = fminf(sy, ey); hi[1] = fmaxf(sy, ey);
+    float r = sqrtf((sx - cx) * (sx - cx) + (sy - cy) * (sy - cy));
+    float a0 = atan2f(sy - cy, sx - cx);
+    const float twoPi = 2.0f * (float)M_PI;
+    for (int k = 0; k < 4; ++k) {
+        // Angle still to go from the start to this quadrant point, in the sweep's direction
+        float d = sweep >= 0.0f ? (float)k * (float)M_PI / 2.0f - a0 : a0 - (float)k * (float)M_PI / 2.0f;
+        d = fmodf(d, twoPi);
+        if (d < 0.0f) d += twoPi;
+        if (d > fabsf(sweep)) continue;
+        float px = cx + (k == 0 ? r : k == 2 ? -r : 0.0f);
+        float py = cy + (k == 1 ? r : k == 3 ? -r : 0.0f);
+        lo[0] = fminf(lo[0], px); hi[0] = fmaxf(hi[0], px);
+        lo[1] = fminf(lo[1], py); hi[1] = fmaxf(hi[1], py);
+    }
+}
+
+// Fixed-point CORDIC sine/cosine (rotation mode). Angles are Q29 radians,
+// results Q30; 24 iterations give ~6e-8 relative error, i.e. well under a
+// micron on any radius this machine can reach, using only shifts and adds.
+#define CORDIC_ITERATIONS 24
+
+static inline void cordicSinCos(float angle, float &s, float &c) {
+    static const int32_t atanTable[CORDIC_ITERATIONS] = {
+        421657428, 248918915, 131521918, 66762579, 33510843, 16771758, 8387925, 4194219,
+        2097141, 1048575, 524288, 262144, 131072, 65536, 32768, 16384,
+        8192, 4096, 2048, 1024, 512, 256, 128, 64
+    };
+    const float pi = (float)M_PI;
+    // Reduce to [-pi, pi], then fold into [-pi/2, pi/2] where CORDIC converges
+    angle = fmodf(angle, 2.0f * pi);
+    if (angle > pi) angle -= 2.0f * pi;
+    else if (angle < -pi) angle += 2.0f * pi;
+    bool flipCos = false;
+    if (angle > pi / 2.0f) { angle = pi - angle; flipCos = true; }
+    else if (angle < -pi / 2.0f) { angle = -pi - angle; flipCos = true; }
+
+    int32_t x = 652032874; // CORDIC gain 0.60725 in Q30
+    int32_t y = 0;
+    int32_t z = (int32_t)(angle * (float)(1L << 29));
+    for (int i = 0; i < CORDIC_ITERATIONS; ++i) {
+        int32_t dx = y >> i;
+        int32_t dy = x >> i;
+        if (z >= 0) { x -= dx; y += dy; z -= atanTable[i]; }
+        else        { x += dx; y -= dy; z += atanTable[i]; }
+    }
+    c = (float)x / (float)(1L << 30);
+    s = (float)y / (float)(1L << 30);
+    if (flipCos) c = -c;
+}
+
+// Native circular move for the servo trajectory: one queue entry describes
+// the whole arc and the setpoint is evaluated on the true circle every tick,
+// so there are no chord facets. The radius is blended from the start to the
+// end radius (they differ only by G-code rounding) so the path ends exactly
+// on the programmed point; Z and E move linearly with the sweep.
+class ArcPath {
+private:
+    float startPos[NUM_AXES];
+    float endPos[NUM_AXES];
+    float cx, cy;
+    float r0, dr;         // start radius and end-start difference
+    float startAngle;
+    float sweepAngle;
+
+public:
+    ArcPath() : cx(0), cy(0), r0(0), dr(0), startAngle(0), sweepAngle(0) {
+        for (int i = 0; i < NUM_AXES; ++i) { startPos[i] = 0; endPos[i] = 0; }
+    }
+
+    bool begin(const float start[NUM_AXES], const float end[NUM_AXES], float centerX, float centerY, float sweep) {
+        for (int i = 0; i < NUM_AXES; ++i) { startPos[i] = start[i]; endPos[i] = end[i]; }
+        cx = centerX; cy = centerY;
+        float sx = start[AXIS_X] - cx, sy = start[AXIS_Y] - cy;
+        float ex = end[AXIS_X] - cx, ey = end[AXIS_Y] - cy;
+        r0 = sqrtf(sx * sx + sy * sy);
+        dr = sqrtf(ex * ex + ey * ey) - r0;
+        startAngle = atan2f(sy, sx);
+        sweepAngle = sweep;
+        return r0 > 0.0f && sweep != 0.0f;
+    }
+
+    // Path length (mm) including the helical and extruder components
+    float length() const {
+        float arcLen = fabsf(sweepAngle) * (r0 + 0.5f * dr);
+        float len2 = arcLen * arcLen;
+        for (int i = AXIS_Z; i < NUM_AXES; ++i) {
+            float d = endPos[i] - startPos[i];
+            len2 += d * d;
+        }
+        return sqrtf(len2);
+    }
+
+    // Point at fraction t (0..1) of the move
+    void at(float t, float out[NUM_AXES]) const {
+        if (t >= 1.0f) {
+            for (int i = 0; i < NUM_AXES; ++i) out[i] = endPos[i];
+            return;
+        }
+        for (int i = 0; i < NUM_AXES; ++i) out[i] = startPos[i] + (endPos[i] - startPos[i]) * t;
+        float s, c;
+        cordicSinCos(startAngle + sweepAngle * t, s, c);
+        float r = r0 + dr * t;
+        out[AXIS_X] = cx + r * c;
+        out[AXIS_Y] = cy + r * s;
+    }
+};
+
+#endif
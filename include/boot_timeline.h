@@ -0,0 +1,69 @@
+#ifndef BOOT_TIMELINE_H
+#define BOOT_TIMELINE_H
+
+#include <stdint.h>
+#include <string.h>
+
+#ifdef ARDUINO
+#include <freertos/FreeRTOS.h>
+#define BOOT_LOCK() portENTER_CRITICAL(&mux)
+#define BOOT_UNLOCK() portEXIT_CRITICAL(&mux)
+#else
+#define BOOT_LOCK()
+#define BOOT_UNLOCK()
+#endif
+
+#ifndef BOOT_MAX_STAGES
+#define BOOT_MAX_STAGES 16
+#endif
+
+// Boot stage names (time since reset is recorded the first time each is reached)
+#define BOOT_SETUP "setup"                  // setup() entered
+#define BOOT_SETTINGS "settings_loaded"     // NVS settings blob applied
+#define BOOT_TASKS "tasks_started"          // all RTOS tasks created
+#define BOOT_MOTION_READY "motion_ready"    // first control loop tick
+#define BOOT_THERMAL_READY "thermal_ready"  // first thermal update
+#define BOOT_FS "fs_mounted"                // LittleFS / SD probed
+#define BOOT_HTTP "http_listening"          // web, websocket and telnet servers up
+#define BOOT_WIFI "wifi_connected"          // station got an IP
+#define BOOT_AP "ap_started"                // fell back to access point mode
+
+// Records when each boot stage was first reached. Stages are marked from
+// several tasks (setup, control, thermal, network), so marks are locked.
+class BootTimeline {
+private:
+    struct Stage { const char* name; uint32_t us; };
+    Stage stages[BOOT_MAX_STAGES];
+    int count;
+#ifdef ARDUINO
+    portMUX_TYPE mux = portMUX_INITIALIZER_UNLOCKED;
+#endif
+
+    int find(const char* name) const {
+        for (int i = 0; i < count; ++i) if (strcmp(stages[i].name, name) == 0) return i;
+        return -1;
+    }
+
+public:
+    BootTimeline() : count(0) {}
+
+    // Record `name` at `us` (microseconds since reset). Only the first mark
+    // of a stage counts; returns false for repeats or when full.
+    bool mark(const char* name, uint32_t us) {
+        BOOT_LOCK();
+        bool added = find(name) < 0 && count < BOOT_MAX_STAGES;
+        if (added) { stages[count].name = name; stages[count].us = us; count++; }
+        BOOT_UNLOCK();
+        return added;
+    }
+
+    bool has(const char* name) const { return find(name) >= 0; }
+    // Microseconds since reset for a stage, or 0 if not reached yet
+    uint32_t at(const char* name) const { int i = find(name); return i < 0 ? 0 : stages[i].us; }
+
+    int size() const { return count; }
+    const char* name(int i) const { return stages[i].name; }
+    uint32_t us(int i) const { return stages[i].us; }
+};
+
+#endif
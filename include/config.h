@@ -62,7 +62,27 @@
 #define POSITION_TOLERANCE 5
 
 // Command execution behavior
-#define COMMAND_EXECUTE_TIMEOUT_MS 5000 // maximum time allowed per command (ms)
+#define COMMAND_EXECUTE_TIMEOUT_MS 5000 // time allowed beyond the planned move duration (ms)
+#define EXECUTOR_LEASE_MS 5000 // a client keeps the executor this long after its last command (ms)
+
+// Network
+#define WIFI_CONNECT_TIMEOUT_MS 10000 // station association time before falling back to AP mode
+// Protocol service tasks (core 0): WebSocket and telnet carry jog commands,
+// so they outrank HTTP, whose handlers can run long (listings, downloads)
+#define NET_WS_TASK_PRIORITY     3
+#define NET_TELNET_TASK_PRIORITY 3
+#define NET_HTTP_TASK_PRIORITY   1
+#define NET_WS_TASK_STACK     4096
+#define NET_TELNET_TASK_STACK 4096
+#define NET_HTTP_TASK_STACK   8192
+// Background G-code metadata indexer (core 0): lowest priority, it only
+// reads files nobody is waiting for
+#define GCODE_INDEX_TASK_PRIORITY 0
+#define GCODE_INDEX_TASK_STACK    4096
+// Job queue runner: plays queued jobs back to back (same priority as a
+// directly started job streamer)
+#define JOB_RUNNER_TASK_PRIORITY 1
+#define JOB_RUNNER_TASK_STACK    6144
 
 // --- Optional I/O (set to -1 if not present on your board) ---
 // Fan, spindle and laser pins are optional. Configure to match hardware.
@@ -75,10 +95,43 @@
 #define PWM_CHAN_SPINDLE 7
 #define PWM_CHAN_LASER  8
 
+// Optional spindle tachometer (PCNT input, -1 = open-loop spindle). With a
+// tachometer M3/M4 S and /api/spindle take RPM and motion waits for the
+// spindle to reach speed; without one S stays a 0-255 PWM value.
+#define PIN_SPINDLE_TACH -1
+#define SPINDLE_PULSES_PER_REV 1
+#define SPINDLE_MAX_RPM 24000.0f // RPM at full PWM (feed-forward and S limit)
+
+// Laser modes carried by motion commands (applied in motion order)
+#define LASER_OFF      0
+#define LASER_CONSTANT 1 // M3: fixed power while the segment runs
+#define LASER_DYNAMIC  2 // M4: power scaled by actual / planned velocity
+#define LASER_RASTER   3 // raster row: power from the pixel under encoder X
+// Window (control ticks, 1 ms each) for the encoder velocity used by M4
+#define LASER_VELOCITY_WINDOW 8
+
 // Feedrate limits (mm/min). If feedrate is 0 in G-code, controller will use full power.
 #define DEFAULT_FEEDRATE 1500
 #define MAX_FEEDRATE     12000
 
+// Default per-axis motion limits for the S-curve trajectory planner
+#define DEFAULT_MAX_ACCEL 1000.0f  // mm/s^2
+#define DEFAULT_MAX_JERK  20000.0f // mm/s^3
+
+// Arc (G2/G3) chord tolerance (mm): max deviation of a segment from the true circle
+#define ARC_CHORD_TOLERANCE_MM 0.01f
+
+// Soft limits: default travel envelope (mm, machine coordinates) checked
+// by the planner. Off until enabled in the settings; an axis whose max is
+// not above its min is unlimited.
+#define SOFT_LIMITS_ENABLED 0
+#define SOFT_LIMIT_X_MIN 0.0f
+#define SOFT_LIMIT_X_MAX 200.0f
+#define SOFT_LIMIT_Y_MIN 0.0f
+#define SOFT_LIMIT_Y_MAX 200.0f
+#define SOFT_LIMIT_Z_MIN 0.0f
+#define SOFT_LIMIT_Z_MAX 200.0f
+
 // Position deviation thresholds (counts)
 // - POSITION_WARN_TOLERANCE_COUNTS: deviation above this sends warnings (broadcast)
 // - POSITION_HALT_TOLERANCE_COUNTS: deviation above this triggers a halt (broadcast error)
@@ -92,6 +145,19 @@
 #define DEFAULT_COUNTS_PER_MM_Z 100.0f
 #define DEFAULT_COUNTS_PER_MM_E 100.0f
 
+// --- KINEMATICS ---
+// Geometry used to map Cartesian targets onto motor encoder targets
+// (see kinematics.h). CoreXY/H-bot drive the X and Y motor channels as the
+// A/B belts; delta drives X/Y/Z as the three tower carriages.
+#define KINEMATICS_CARTESIAN 0
+#define KINEMATICS_COREXY    1
+#define KINEMATICS_DELTA     2
+#define KINEMATICS KINEMATICS_CARTESIAN
+
+// Linear delta geometry (mm), only used with KINEMATICS_DELTA
+#define DELTA_DIAGONAL_ROD 250.0f
+#define DELTA_RADIUS       124.0f
+
 // --- PID CONSTANTS (Placeholder - Needs Tuning) ---
 #define KP_DEFAULT      1.0
 #define KI_DEFAULT      0.0
@@ -0,0 +1,167 @@
+#ifndef EXECUTOR_OWNER_H
+#define EXECUTOR_OWNER_H
+
+#include <atomic>
+#include <stdint.h>
+
+// Lease deadlines are kept in 128 ms ticks so they fit the owner word;
+// a lapsed lease must be expired (expire()) within ~70 minutes, before the
+// 16-bit tick count wraps around it.
+#define EXECUTOR_LEASE_TICK_MS 128
+#define EXECUTOR_OWNER_ID_MAX 63
+
+// Snapshot of the owner word for status replies
+struct ExecutorOwnerView {
+    bool busy;          // held by a live owner
+    bool pinned;        // held until released (jobs)
+    bool active;        // executing one of the owner's commands
+    uint8_t type;       // SRC_*
+    int id;             // -1 when free
+    uint8_t generation; // changes whenever ownership changes hands
+    uint32_t leaseMs;   // lease left (0 when pinned, active or free)
+};
+
+// Who may feed the executor. One client at a time owns it: claim() takes it
+// when it is free or the holder's lease has lapsed, the owner renews the
+// lease with every command, and it is given back explicitly (release(), a
+// client disconnect, a stop). The whole state is one 32-bit word updated by
+// compare-and-swap, so any task on either core can read or change it
+// without a lock:
+//   bits  0-5  owner id     bits 6-7  owner type   bit 8  busy
+//   bit   9    pinned       bit  10   active       bits 11-15  generation
+//   bits 16-31 lease deadline (ticks)
+class ExecutorOwnership {
+private:
+    std::atomic<uint32_t> word;
+
+    static const uint32_t BUSY = 1u << 8;
+    static const uint32_t PINNED = 1u << 9;
+    static const uint32_t ACTIVE = 1u << 10;
+    static const int GEN_SHIFT = 11;
+    static const uint32_t GEN_MASK = 0x1Fu << GEN_SHIFT;
+
+    static uint32_t deadline(uint32_t now, uint32_t leaseMs) {
+        return ((now + leaseMs + EXECUTOR_LEASE_TICK_MS - 1) / EXECUTOR_LEASE_TICK_MS) & 0xFFFF;
+    }
+    static bool isOwner(uint32_t w, uint8_t type, int id) {
+        return (w & BUSY) && ((w >> 6) & 3) == type && (int)(w & 0x3F) == id;
+    }
+    static bool live(uint32_t w, uint32_t now) {
+        if (!(w & BUSY)) return false;
+        if (w & (PINNED | ACTIVE)) return true;
+        return (int16_t)(uint16_t)((w >> 16) - now / EXECUTOR_LEASE_TICK_MS) > 0;
+    }
+    static uint32_t nextGen(uint32_t w) { return (w + (1u << GEN_SHIFT)) & GEN_MASK; }
+    static bool validOwner(uint8_t type, int id) { return type <= 3 && id >= 0 && id <= EXECUTOR_OWNER_ID_MAX; }
+
+    // Apply `f(old, next)` until the CAS lands; false if f declines
+    template <class F>
+    bool update(F f) {
+        uint32_t w = word.load();
+        while (true) {
+            uint32_t n;
+            if (!f(w, n)) return false;
+            if (w == n || word.compare_exchange_weak(w, n)) return true;
+        }
+    }
+
+public:
+    ExecutorOwnership() : word(0) {}
+
+    // Take (or keep) the executor for type/id. Succeeds if it is free, the
+    // holder's lease has lapsed, or type/id already holds it (the lease is
+    // then renewed). leaseMs == 0 pins it until released.
+    bool claim(uint8_t type, int id, uint32_t now, uint32_t leaseMs) {
+        if (!validOwner(type, id)) return false;
+        return update([&](uint32_t w, uint32_t& n) {
+            uint32_t keep;
+            if (isOwner(w, type, id)) keep = (w & (GEN_MASK | PINNED | ACTIVE));
+            else if (!live(w, now)) keep = nextGen(w);
+            else return false;
+            if (leaseMs == 0) keep |= PINNED;
+            n = deadline(now, leaseMs) << 16 | keep | BUSY | (uint32_t)type << 6 | (uint32_t)id;
+            return true;
+        });
+    }
+
+    // Owner only: push the lease out to now + leaseMs (a pin stays)
+    bool renew(uint8_t type, int id, uint32_t now, uint32_t leaseMs) {
+        return update([&](uint32_t w, uint32_t& n) {
+            if (!isOwner(w, type, id)) return false;
+            n = deadline(now, leaseMs) << 16 | (w & 0xFFFF);
+            return true;
+        });
+    }
+
+    // Whether type/id may run a command now: the executor is free, its
+    // lease lapsed, or type/id holds it
+    bool admits(uint8_t type, int id, uint32_t now) const {
+        uint32_t w = word.load();
+        return isOwner(w, type, id) || !live(w, now);
+    }
+
+    bool owns(uint8_t type, int id) const { return isOwner(word.load(), type, id); }
+
+    // The executor starts one of type/id's commands. Returns admits(); for
+    // the owner the lease then cannot lapse until end().
+    bool begin(uint8_t type, int id, uint32_t now) {
+        bool admitted = true;
+        update([&](uint32_t w, uint32_t& n) {
+            if (!isOwner(w, type, id)) { admitted = !live(w, now); return false; }
+            n = w | ACTIVE;
+            return true;
+        });
+        return admitted;
+    }
+
+    // The command finished; the owner's lease runs from here
+    void end(uint8_t type, int id, uint32_t now, uint32_t leaseMs) {
+        update([&](uint32_t w, uint32_t& n) {
+            if (!isOwner(w, type, id)) return false;
+            n = deadline(now, leaseMs) << 16 | (w & 0xFFFF & ~ACTIVE);
+            return true;
+        });
+    }
+
+    // Owner only (a client that disconnected, a job that ended)
+    bool release(uint8_t type, int id) {
+        return update([&](uint32_t w, uint32_t& n) {
+            if (!isOwner(w, type, id)) return false;
+            n = nextGen(w);
+            return true;
+        });
+    }
+
+    // Free it whoever holds it (stop, admin release)
+    void reset() {
+        update([](uint32_t w, uint32_t& n) { n = (w & BUSY) ? nextGen(w) : w; return true; });
+    }
+
+    // Free a lapsed lease; call periodically. True if one was freed.
+    bool expire(uint32_t now) {
+        return update([&](uint32_t w, uint32_t& n) {
+            if (!(w & BUSY) || live(w, now)) return false;
+            n = nextGen(w);
+            return true;
+        });
+    }
+
+    ExecutorOwnerView view(uint32_t now) const {
+        uint32_t w = word.load();
+        ExecutorOwnerView v;
+        v.busy = live(w, now);
+        v.pinned = v.busy && (w & PINNED);
+        v.active = v.busy && (w & ACTIVE);
+        v.type = v.busy ? (uint8_t)((w >> 6) & 3) : 0;
+        v.id = v.busy ? (int)(w & 0x3F) : -1;
+        v.generation = (uint8_t)((w & GEN_MASK) >> GEN_SHIFT);
+        v.leaseMs = 0;
+        if (v.busy && !v.pinned && !v.active) {
+            int32_t ticks = (int16_t)(uint16_t)((w >> 16) - now / EXECUTOR_LEASE_TICK_MS);
+            v.leaseMs = (uint32_t)ticks * EXECUTOR_LEASE_TICK_MS - now % EXECUTOR_LEASE_TICK_MS;
+        }
+        return v;
+    }
+};
+
+#endif
@@ -0,0 +1,64 @@
+#ifndef FEED_HOLD_H
+#define FEED_HOLD_H
+
+#include <math.h>
+
+// Feed hold by time scaling. A move's S-curve profile is evaluated at a
+// profile time that advances `rate` times as fast as real time. A hold
+// ramps the rate down to 0, so the machine slows along its path and stops
+// on it. The profile time stays frozen while held, and a resume ramps the
+// rate back to 1 from exactly where it stopped, with no jump in position.
+//
+// The rate follows a smoothstep between its end values. Its steepest slope
+// is 1.5x the mean, so a ramp of 1.5 * dRate * v / decel keeps the change
+// in path speed within the deceleration limit. The hold state carries over
+// between moves; only the profile time restarts with each move.
+class FeedHold {
+private:
+    float t;               // profile time of the current move (s)
+    float scale;           // profile seconds per real second (0..1)
+    float from, to;        // current or last ramp
+    float rampT, rampLen;  // time into the ramp / its length (s); rampLen 0 = none
+
+    static float smooth(float u) { return u * u * (3.0f - 2.0f * u); }
+
+public:
+    FeedHold() : t(0), scale(1), from(1), to(1), rampT(0), rampLen(0) {}
+
+    void startMove() { t = 0; }
+
+    // Hold (or resume) from the current rate. `v` is the profile's path
+    // speed at the current profile time (mm/s), `decel` the path's
+    // acceleration limit (mm/s^2).
+    void request(bool hold, float v, float decel) {
+        float target = hold ? 0.0f : 1.0f;
+        if (target == to) return;
+        from = scale;
+        to = target;
+        rampT = 0.0f;
+        rampLen = decel > 0.0f ? 1.5f * fabsf(to - from) * v / decel : 0.0f;
+        if (!(rampLen > 0.0f)) { scale = to; rampLen = 0.0f; }
+    }
+
+    // Advance by `dt` real seconds; returns the profile time
+    float advance(float dt) {
+        if (rampLen > 0.0f) {
+            float before = scale;
+            rampT += dt;
+            if (rampT >= rampLen) { scale = to; rampLen = 0.0f; }
+            else scale = from + (to - from) * smooth(rampT / rampLen);
+            t += 0.5f * (before + scale) * dt;
+        } else {
+            t += scale * dt;
+        }
+        return t;
+    }
+
+    float profileTime() const { return t; }
+    float rate() const { return scale; }
+    bool holding() const { return to == 0.0f; }                      // a hold was requested
+    bool held() const { return scale == 0.0f && rampLen == 0.0f; }   // ... and the path has stopped
+    bool fullSpeed() const { return scale == 1.0f && rampLen == 0.0f; }
+};
+
+#endif
@@ -0,0 +1,132 @@
+#ifndef FILE_LIST_H
+#define FILE_LIST_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifndef FILE_LIST_PAGE_MAX
+#define FILE_LIST_PAGE_MAX 50   // largest page /api/files returns (and the sort buffer size)
+#endif
+#ifndef FILE_NAME_MAX
+#define FILE_NAME_MAX 80        // longest name a sorted listing can hold, incl. NUL
+#endif
+
+enum FileSortKey : uint8_t { FILE_SORT_NONE = 0, FILE_SORT_NAME, FILE_SORT_SIZE, FILE_SORT_MTIME };
+
+struct FileListEntry {
+    char name[FILE_NAME_MAX];
+    uint32_t size;
+    uint32_t mtime; // seconds since epoch, 0 if the filesystem doesn't keep it
+};
+
+inline FileSortKey fileSortKeyFromString(const char* s) {
+    if (!s || !*s || strcmp(s, "name") == 0) return FILE_SORT_NAME;
+    if (strcmp(s, "size") == 0) return FILE_SORT_SIZE;
+    if (strcmp(s, "mtime") == 0 || strcmp(s, "date") == 0) return FILE_SORT_MTIME;
+    return FILE_SORT_NONE; // "none": directory order, no buffering
+}
+
+// One page of a sorted directory listing, in fixed memory. The directory
+// is read once per page: every entry is offered, and the page keeps the
+// `capacity` entries that come first in sort order after an optional
+// cursor (the last entry of the previous page). Deeper pages are reached
+// by chaining pages, so memory stays the same for any directory size.
+// Names are unique within a directory, so ties on size/mtime are broken
+// by name and the order is total.
+class FileListPage {
+private:
+    FileListEntry items[FILE_LIST_PAGE_MAX];
+    int n;
+    int cap;
+    FileSortKey key;
+    bool desc;
+    bool hasCursor;
+    FileListEntry cursor;
+    uint32_t seen;      // entries offered (directory size)
+    uint32_t tooLong;   // names that didn't fit FILE_NAME_MAX
+
+    int cmp(const FileListEntry& a, const char* bName, uint32_t bSize, uint32_t bMtime) const {
+        int c = 0;
+        if (key == FILE_SORT_SIZE && a.size != bSize) c = a.size < bSize ? -1 : 1;
+        else if (key == FILE_SORT_MTIME && a.mtime != bMtime) c = a.mtime < bMtime ? -1 : 1;
+        else c = strcmp(a.name, bName);
+        return desc ? -c : c;
+    }
+
+public:
+    FileListPage() : n(0), cap(FILE_LIST_PAGE_MAX), key(FILE_SORT_NAME), desc(false), hasCursor(false), seen(0), tooLong(0) {}
+
+    // Start a page of up to `capacity` entries following `after` (or from
+    // the start when null)
+    void begin(FileSortKey k, bool descending, int capacity, const FileListEntry* after) {
+        key = k == FILE_SORT_NONE ? FILE_SORT_NAME : k;
+        desc = descending;
+        cap = capacity < 0 ? 0 : (capacity > FILE_LIST_PAGE_MAX ? FILE_LIST_PAGE_MAX : capacity);
+        hasCursor = after != nullptr;
+        if (after) cursor = *after;
+        n = 0; seen = 0; tooLong = 0;
+    }
+
+    // Offer one directory entry
+    void offer(const char* name, uint32_t size, uint32_t mtime) {
+        seen++;
+        size_t len = strlen(name);
+        if (len >= FILE_NAME_MAX) { tooLong++; return; }
+        if (hasCursor && cmp(cursor, name, size, mtime) >= 0) return;
+        if (cap == 0) return;
+        // Insertion into the sorted buffer; when full, the last one drops out
+        int pos = n;
+        while (pos > 0 && cmp(items[pos - 1], name, size, mtime) > 0) pos--;
+        if (pos >= cap) return;
+        int last = n < cap ? n : cap - 1;
+        memmove(&items[pos + 1], &items[pos], (last - pos) * sizeof(FileListEntry));
+        memcpy(items[pos].name, name, len + 1);
+        items[pos].size = size;
+        items[pos].mtime = mtime;
+        if (n < cap) n++;
+    }
+
+    int count() const { return n; }
+    const FileListEntry& at(int i) const { return items[i]; }
+    uint32_t total() const { return seen; }
+    uint32_t skippedLongNames() const { return tooLong; }
+};
+
+// JSON string contents with the escapes JSON requires. Returns the length
+// written, or (size_t)-1 if the whole string doesn't fit `cap`.
+inline size_t fileListJsonEscape(char* out, size_t cap, const char* s) {
+    size_t o = 0;
+    for (; *s; ++s) {
+        unsigned char c = (unsigned char)*s;
+        char esc[8];
+        size_t k;
+        if (c == '"' || c == '\\') { esc[0] = '\\'; esc[1] = (char)c; k = 2; }
+        else if (c < 0x20) { k = (size_t)snprintf(esc, sizeof(esc), "\\u%04x", c); }
+        else { esc[0] = (char)c; k = 1; }
+        if (o + k >= cap) { if (cap) out[o] = '\0'; return (size_t)-1; }
+        memcpy(out + o, esc, k);
+        o += k;
+    }
+    if (cap) out[o] = '\0';
+    return o;
+}
+
+// One listing element: {"name":..,"size":..,"mtime":..,"storage":..}.
+// Returns the length written, or 0 if `cap` is too small.
+inline size_t fileListJsonEntry(char* out, size_t cap, const char* name, uint32_t size, uint32_t mtime, const char* storage) {
+    static const char head[] = "{\"name\":\"";
+    if (cap < sizeof(head)) return 0;
+    memcpy(out, head, sizeof(head) - 1);
+    size_t o = sizeof(head) - 1;
+    // A name cut short would name a different file: fail instead
+    size_t nameLen = fileListJsonEscape(out + o, cap - o, name);
+    if (nameLen == (size_t)-1) return 0;
+    o += nameLen;
+    int len = snprintf(out + o, cap - o, "\",\"size\":%lu,\"mtime\":%lu,\"storage\":\"%s\"}",
+                       (unsigned long)size, (unsigned long)mtime, storage);
+    return len < 0 || (size_t)len >= cap - o ? 0 : o + (size_t)len;
+}
+
+#endif
@@ -0,0 +1,404 @@
+#ifndef GCODE_INDEX_H
+#define GCODE_INDEX_H
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include "arc.h"
+
+#ifndef GCODE_LINE_MAX
+#define GCODE_LINE_MAX 256
+#endif
+
+// Sidecar index file, one per storage (listings hide dot-files)
+#define GCODE_INDEX_PATH "/.gcode.idx"
+#define GCODE_INDEX_MAGIC "E3GI"
+#define GCODE_INDEX_VERSION 2     // older indexes are rebuilt
+#define GCODE_INDEX_HEADER 16     // magic, version, record size, slot count, reserved
+#define GCODE_INDEX_RECORD 160    // name + metadata, fixed size
+#define GCODE_INDEX_NAME_MAX 64   // incl. NUL; longer names aren't indexed
+#ifndef GCODE_INDEX_SLOTS_LITTLEFS
+#define GCODE_INDEX_SLOTS_LITTLEFS 128   // 20 KB of flash
+#endif
+#ifndef GCODE_INDEX_SLOTS_SD
+#define GCODE_INDEX_SLOTS_SD 1024        // 160 KB
+#endif
+
+// What the index knows about one G-code file. size/mtime identify the
+// version of the file that was indexed; a mismatch means it is stale.
+struct GcodeMeta {
+    uint32_t size;
+    uint32_t mtime;
+    uint32_t lines;
+    uint32_t moves;         // G0-G3 with motion
+    float min[3], max[3];   // X/Y/Z bounds (mm) of the printed / cut part
+    float timeSec;          // distance / feedrate, plus dwells (no acceleration)
+    float filamentMm;       // net E advance
+    uint32_t layers;        // slicer layer comments, else Z steps while extruding
+    uint32_t thumbOffset;   // base64 PNG block ("; thumbnail begin" .. "; thumbnail end")
+    uint32_t thumbLength;   //   0 = no thumbnail
+    uint16_t thumbW, thumbH;
+    float travelMin[3], travelMax[3]; // everywhere the tool goes, travel and arcs included
+};
+
+// Incremental G-code scanner: feed() the file in any chunk sizes, then
+// finish(). Tracks absolute/relative modes (G90/G91, M82/M83), G92, G20/21
+// and G28 so bounds and distances follow the machine position. Arcs are
+// measured as their chord, except for the travel box, which takes their
+// true extent.
+class GcodeIndexer {
+private:
+    char buf[GCODE_LINE_MAX + 1];
+    size_t len;
+    uint32_t pos;          // bytes consumed
+    uint32_t lineStart;    // file offset of buf[0]
+    GcodeMeta m;
+
+    float x, y, z, e, feedRate; // position (mm), feed (mm/min)
+    bool relXYZ, relEMode; // G91, M83 (E is relative under either)
+    float unit;
+    uint32_t commentLayers, zLayers;
+    float lastLayerZ;
+    bool anyLayerZ;
+    struct Box {
+        float lo[3], hi[3]; bool any;
+        void add(float px, float py, float pz) {
+            float p[3] = { px, py, pz };
+            for (int i = 0; i < 3; ++i) {
+                if (!any || p[i] < lo[i]) lo[i] = p[i];
+                if (!any || p[i] > hi[i]) hi[i] = p[i];
+            }
+            any = true;
+        }
+    } workBox, printBox, travelBox;
+    bool inThumb;
+    uint32_t thumbStart;
+    uint16_t thumbW, thumbH;
+
+    static bool startsWith(const char* s, const char* prefix) { return strncmp(s, prefix, strlen(prefix)) == 0; }
+
+    void comment(const char* c, uint32_t nextLine) {
+        while (*c == ' ') c++;
+        if (startsWith(c, "LAYER:") || startsWith(c, "LAYER_CHANGE")) { commentLayers++; return; }
+        if (startsWith(c, "thumbnail begin ")) {
+            unsigned w = 0, h = 0;
+            if (sscanf(c + 16, "%ux%u", &w, &h) == 2) { inThumb = true; thumbStart = nextLine; thumbW = (uint16_t)w; thumbH = (uint16_t)h; }
+            return;
+        }
+        if (inThumb && startsWith(c, "thumbnail end")) {
+            inThumb = false;
+            // Several sizes are common; keep the largest
+            if ((uint32_t)thumbW * thumbH > (uint32_t)m.thumbW * m.thumbH) {
+                m.thumbOffset = thumbStart;
+                m.thumbLength = lineStart - thumbStart;
+                m.thumbW = thumbW; m.thumbH = thumbH;
+            }
+        }
+    }
+
+    void line(char* s, uint32_t nextLine) {
+        m.lines++;
+        char* semi = strchr(s, ';');
+        if (semi) { *semi = '\0'; comment(semi + 1, nextLine); }
+        if (inThumb) return;
+
+        // Words: letter + number; parenthesised comments are skipped
+        bool has[26] = { false };
+        float val[26] = { 0 };
+        for (char* p = s; *p; ) {
+            if (*p == '(') { while (*p && *p != ')') p++; if (*p) p++; continue; }
+            if (isalpha((unsigned char)*p)) {
+                int k = toupper((unsigned char)*p) - 'A';
+                char* end;
+                float v = strtof(p + 1, &end);
+                if (end != p + 1) { if (!has[k]) { has[k] = true; val[k] = v; } p = end; continue; }
+            }
+            p++;
+        }
+
+        if (has['G' - 'A']) {
+            int g = (int)val['G' - 'A'];
+            switch (g) {
+            case 0: case 1: case 2: case 3: move(has, val, g); break;
+            case 4: m.timeSec += has['P' - 'A'] ? val['P' - 'A'] / 1000.0f : val['S' - 'A']; break;
+            case 20: unit = 25.4f; break;
+            case 21: unit = 1.0f; break;
+            case 28: {
+                bool any = has['X' - 'A'] || has['Y' - 'A'] || has['Z' - 'A'];
+                if (!any || has['X' - 'A']) x = 0;
+                if (!any || has['Y' - 'A']) y = 0;
+                if (!any || has['Z' - 'A']) z = 0;
+                break;
+            }
+            case 90: relXYZ = false; break;
+            case 91: relXYZ = true; break;
+            case 92:
+                if (has['X' - 'A']) x = val['X' - 'A'] * unit;
+                if (has['Y' - 'A']) y = val['Y' - 'A'] * unit;
+                if (has['Z' - 'A']) z = val['Z' - 'A'] * unit;
+                if (has['E' - 'A']) e = val['E' - 'A'] * unit;
+                break;
+            default: break;
+            }
+        } else if (has['M' - 'A']) {
+            int mc = (int)val['M' - 'A'];
+            if (mc == 82) relEMode = false;
+            else if (mc == 83) relEMode = true;
+        }
+    }
+
+    void move(const bool* has, const float* val, int g) {
+        bool working = g != 0;
+        if (has['F' - 'A'] && val['F' - 'A'] > 0) feedRate = val['F' - 'A'] * unit;
+        float nx = x, ny = y, nz = z, ne = e;
+        if (has['X' - 'A']) nx = relXYZ ? x + val['X' - 'A'] * unit : val['X' - 'A'] * unit;
+        if (has['Y' - 'A']) ny = relXYZ ? y + val['Y' - 'A'] * unit : val['Y' - 'A'] * unit;
+        if (has['Z' - 'A']) nz = relXYZ ? z + val['Z' - 'A'] * unit : val['Z' - 'A'] * unit;
+        if (has['E' - 'A']) ne = relXYZ || relEMode ? e + val['E' - 'A'] * unit : val['E' - 'A'] * unit;
+
+        float dx = nx - x, dy = ny - y, dz = nz - z, de = ne - e;
+        float dist = sqrtf(dx * dx + dy * dy + dz * dz);
+        bool moved = dist > 0.0f;
+        if (!moved) dist = fabsf(de);
+        if (dist > 0.0f && feedRate > 0.0f) m.timeSec += dist / feedRate * 60.0f;
+        m.filamentMm += de;
+
+        if (moved) {
+            m.moves++;
+            travelBox.add(x, y, z); travelBox.add(nx, ny, nz);
+            if (g == 2 || g == 3) arc(has, val, g == 2, nx, ny, nz);
+            if (working) { workBox.add(x, y, z); workBox.add(nx, ny, nz); }
+            if (de > 0.0f && (dx != 0.0f || dy != 0.0f)) {
+                printBox.add(x, y, z); printBox.add(nx, ny, nz);
+                if (!anyLayerZ || nz > lastLayerZ + 0.0001f) { zLayers++; lastLayerZ = nz; anyLayerZ = true; }
+            }
+        }
+        x = nx; y = ny; z = nz; e = ne;
+    }
+
+    // Widen the travel box by the arc's bulge (I/J centre or R radius);
+    // geometry the machine would refuse adds nothing
+    void arc(const bool* has, const float* val, bool clockwise, float nx, float ny, float nz) {
+        const float from[NUM_AXES] = { x, y, z, 0.0f }, to[NUM_AXES] = { nx, ny, nz, 0.0f };
+        ArcGenerator a;
+        bool ok = has['R' - 'A'] ? a.beginRadius(from, to, val['R' - 'A'] * unit, clockwise, 0.0f)
+                                 : a.beginCenter(from, to, has['I' - 'A'] ? val['I' - 'A'] * unit : 0.0f,
+                                                 has['J' - 'A'] ? val['J' - 'A'] * unit : 0.0f, clockwise, 0.0f);
+        if (!ok) return;
+        float lo[2], hi[2];
+        arcBoundsXY(x, y, nx, ny, a.centerX(), a.centerY(), a.sweep(), lo, hi);
+        travelBox.add(lo[0], lo[1], z);
+        travelBox.add(hi[0], hi[1], z);
+    }
+
+public:
+    GcodeIndexer() { begin(); }
+
+    void begin() {
+        len = 0; pos = 0; lineStart = 0;
+        memset(&m, 0, sizeof(m));
+        x = y = z = e = 0.0f; feedRate = 0.0f;
+        relXYZ = relEMode = false; unit = 1.0f;
+        commentLayers = zLayers = 0; lastLayerZ = 0.0f; anyLayerZ = false;
+        workBox.any = printBox.any = travelBox.any = false;
+        inThumb = false; thumbStart = 0; thumbW = thumbH = 0;
+    }
+
+    void feed(const char* data, size_t n) {
+        for (size_t i = 0; i < n; ++i) {
+            char c = data[i];
+            pos++;
+            if (c == '\n') {
+                buf[len] = '\0';
+                line(buf, pos);
+                len = 0;
+                lineStart = pos;
+            } else if (c != '\r' && len < GCODE_LINE_MAX) {
+                buf[len++] = c;
+            }
+        }
+    }
+
+    // Complete the scan (an unterminated last line counts) and return the
+    // metadata; size/mtime are left for the caller to fill in
+    const GcodeMeta& finish() {
+        if (len > 0) { buf[len] = '\0'; line(buf, pos); len = 0; }
+        const Box& b = printBox.any ? printBox : workBox;
+        for (int i = 0; i < 3; ++i) { m.min[i] = b.any ? b.lo[i] : 0.0f; m.max[i] = b.any ? b.hi[i] : 0.0f; }
+        for (int i = 0; i < 3; ++i) { m.travelMin[i] = travelBox.any ? travelBox.lo[i] : 0.0f; m.travelMax[i] = travelBox.any ? travelBox.hi[i] : 0.0f; }
+        m.layers = commentLayers ? commentLayers : zLayers;
+        if (m.filamentMm < 0.0f) m.filamentMm = 0.0f;
+        return m;
+    }
+};
+
+// --- Index records -----------------------------------------------------
+
+static inline void gcodeIndexPut32(uint8_t* p, uint32_t v) { for (int i = 0; i < 4; ++i) p[i] = (v >> (8 * i)) & 0xFF; }
+static inline uint32_t gcodeIndexGet32(const uint8_t* p) { return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24); }
+static inline void gcodeIndexPutF(uint8_t* p, float f) { uint32_t v; memcpy(&v, &f, 4); gcodeIndexPut32(p, v); }
+static inline float gcodeIndexGetF(const uint8_t* p) { uint32_t v = gcodeIndexGet32(p); float f; memcpy(&f, &v, 4); return f; }
+
+// Slot states: name[0] == 0 is empty, 1 a deleted entry (probing goes on)
+#define GCODE_INDEX_TOMBSTONE 0x01
+
+inline void gcodeIndexHeader(uint8_t* h, uint32_t slots) {
+    memset(h, 0, GCODE_INDEX_HEADER);
+    memcpy(h, GCODE_INDEX_MAGIC, 4);
+    h[4] = GCODE_INDEX_VERSION; h[5] = 0;
+    h[6] = GCODE_INDEX_RECORD & 0xFF; h[7] = GCODE_INDEX_RECORD >> 8;
+    gcodeIndexPut32(h + 8, slots);
+}
+
+// Slot count from a header, or 0 if it isn't one this build can use
+inline uint32_t gcodeIndexHeaderSlots(const uint8_t* h) {
+    if (memcmp(h, GCODE_INDEX_MAGIC, 4) != 0 || h[4] != GCODE_INDEX_VERSION) return 0;
+    if ((h[6] | (h[7] << 8)) != GCODE_INDEX_RECORD) return 0;
+    return gcodeIndexGet32(h + 8);
+}
+
+inline void gcodeIndexEncode(uint8_t* rec, const char* name, const GcodeMeta& m) {
+    memset(rec, 0, GCODE_INDEX_RECORD);
+    strncpy((char*)rec, name, GCODE_INDEX_NAME_MAX - 1);
+    uint8_t* p = rec + GCODE_INDEX_NAME_MAX;
+    gcodeIndexPut32(p, m.size); gcodeIndexPut32(p + 4, m.mtime);
+    gcodeIndexPut32(p + 8, m.lines); gcodeIndexPut32(p + 12, m.moves);
+    for (int i = 0; i < 3; ++i) { gcodeIndexPutF(p + 16 + 4 * i, m.min[i]); gcodeIndexPutF(p + 28 + 4 * i, m.max[i]); }
+    gcodeIndexPutF(p + 40, m.timeSec); gcodeIndexPutF(p + 44, m.filamentMm);
+    gcodeIndexPut32(p + 48, m.layers);
+    gcodeIndexPut32(p + 52, m.thumbOffset); gcodeIndexPut32(p + 56, m.thumbLength);
+    gcodeIndexPut32(p + 60, (uint32_t)m.thumbW | ((uint32_t)m.thumbH << 16));
+    for (int i = 0; i < 3; ++i) { gcodeIndexPutF(p + 64 + 4 * i, m.travelMin[i]); gcodeIndexPutF(p + 76 + 4 * i, m.travelMax[i]); }
+}
+
+inline void gcodeIndexDecode(const uint8_t* rec, GcodeMeta& m) {
+    const uint8_t* p = rec + GCODE_INDEX_NAME_MAX;
+    m.size = gcodeIndexGet32(p); m.mtime = gcodeIndexGet32(p + 4);
+    m.lines = gcodeIndexGet32(p + 8); m.moves = gcodeIndexGet32(p + 12);
+    for (int i = 0; i < 3; ++i) { m.min[i] = gcodeIndexGetF(p + 16 + 4 * i); m.max[i] = gcodeIndexGetF(p + 28 + 4 * i); }
+    m.timeSec = gcodeIndexGetF(p + 40); m.filamentMm = gcodeIndexGetF(p + 44);
+    m.layers = gcodeIndexGet32(p + 48);
+    m.thumbOffset = gcodeIndexGet32(p + 52); m.thumbLength = gcodeIndexGet32(p + 56);
+    uint32_t wh = gcodeIndexGet32(p + 60);
+    m.thumbW = wh & 0xFFFF; m.thumbH = wh >> 16;
+    for (int i = 0; i < 3; ++i) { m.travelMin[i] = gcodeIndexGetF(p + 64 + 4 * i); m.travelMax[i] = gcodeIndexGetF(p + 76 + 4 * i); }
+}
+
+inline uint32_t gcodeIndexHash(const char* name) {
+    uint32_t h = 2166136261u; // FNV-1a
+    while (*name) { h ^= (uint8_t)*name++; h *= 16777619u; }
+    return h;
+}
+
+// Open-addressing hash table of records over a Store providing
+//   bool read(uint32_t slot, uint8_t* rec) / bool write(uint32_t slot, const uint8_t* rec)
+// so a lookup is one or two record reads however many files there are.
+// Deleted entries leave a tombstone that put() reuses.
+template <class Store>
+class GcodeIndexTable {
+private:
+    Store& store;
+    uint32_t slots;
+    uint8_t rec[GCODE_INDEX_RECORD];
+
+    // Slot holding `name`, or -1; `insertAt` gets the first reusable slot
+    int32_t probe(const char* name, int32_t* insertAt) {
+        if (insertAt) *insertAt = -1;
+        if (!slots) return -1;
+        uint32_t start = gcodeIndexHash(name) % slots;
+        for (uint32_t i = 0; i < slots; ++i) {
+            uint32_t s = (start + i) % slots;
+            if (!store.read(s, rec)) return -1;
+            if (rec[0] == 0) { if (insertAt && *insertAt < 0) *insertAt = (int32_t)s; return -1; }
+            if (rec[0] == GCODE_INDEX_TOMBSTONE) { if (insertAt && *insertAt < 0) *insertAt = (int32_t)s; continue; }
+            if (strncmp((const char*)rec, name, GCODE_INDEX_NAME_MAX) == 0) return (int32_t)s;
+        }
+        return -1;
+    }
+
+public:
+    GcodeIndexTable(Store& s, uint32_t slotCount) : store(s), slots(slotCount) {}
+
+    bool get(const char* name, GcodeMeta& m) {
+        if (probe(name, nullptr) < 0) return false;
+        gcodeIndexDecode(rec, m);
+        return true;
+    }
+
+    // Insert or replace; false if the name is too long or the table is full
+    bool put(const char* name, const GcodeMeta& m) {
+        if (!*name || (uint8_t)name[0] == GCODE_INDEX_TOMBSTONE || strlen(name) >= GCODE_INDEX_NAME_MAX) return false;
+        int32_t freeSlot;
+        int32_t s = probe(name, &freeSlot);
+        if (s < 0) s = freeSlot;
+        if (s < 0) return false;
+        gcodeIndexEncode(rec, name, m);
+        return store.write((uint32_t)s, rec);
+    }
+
+    bool remove(const char* name) {
+        int32_t s = probe(name, nullptr);
+        if (s < 0) return false;
+        memset(rec, 0, GCODE_INDEX_RECORD);
+        rec[0] = GCODE_INDEX_TOMBSTONE;
+        return store.write((uint32_t)s, rec);
+    }
+};
+
+// Metadata as a JSON object (no thumbnail data, just whether there is one)
+inline size_t gcodeMetaJson(char* out, size_t cap, const GcodeMeta& m) {
+    int n = snprintf(out, cap,
+        "{\"lines\":%lu,\"moves\":%lu,\"bounds\":{\"min\":[%.3f,%.3f,%.3f],\"max\":[%.3f,%.3f,%.3f]},"
+        "\"travel\":{\"min\":[%.3f,%.3f,%.3f],\"max\":[%.3f,%.3f,%.3f]},"
+        "\"timeSec\":%.0f,\"filamentMm\":%.1f,\"layers\":%lu,\"thumbnail\":",
+        (unsigned long)m.lines, (unsigned long)m.moves, m.min[0], m.min[1], m.min[2], m.max[0], m.max[1], m.max[2],
+        m.travelMin[0], m.travelMin[1], m.travelMin[2], m.travelMax[0], m.travelMax[1], m.travelMax[2],
+        m.timeSec, m.filamentMm, (unsigned long)m.layers);
+    if (n < 0 || (size_t)n >= cap) return 0;
+    int t = m.thumbLength ? snprintf(out + n, cap - n, "{\"width\":%u,\"height\":%u}}", m.thumbW, m.thumbH)
+                          : snprintf(out + n, cap - n, "null}");
+    if (t < 0 || (size_t)(n + t) >= cap) return 0;
+    return (size_t)(n + t);
+}
+
+// Streaming base64 decoder for thumbnail blocks: anything outside the
+// alphabet (the "; " comment prefixes, line breaks) is skipped
+class Base64Decoder {
+private:
+    uint32_t acc;
+    int bits;
+    bool done;
+
+    static int value(char c) {
+        if (c >= 'A' && c <= 'Z') return c - 'A';
+        if (c >= 'a' && c <= 'z') return c - 'a' + 26;
+        if (c >= '0' && c <= '9') return c - '0' + 52;
+        if (c == '+') return 62;
+        if (c == '/') return 63;
+        return -1;
+    }
+
+public:
+    Base64Decoder() : acc(0), bits(0), done(false) {}
+
+    // Decode `n` input chars into `out` (room for n * 3 / 4 + 1 bytes);
+    // returns the bytes produced. Stops for good at '=' padding.
+    size_t feed(const char* in, size_t n, uint8_t* out) {
+        size_t o = 0;
+        for (size_t i = 0; i < n && !done; ++i) {
+            if (in[i] == '=') { done = true; break; }
+            int v = value(in[i]);
+            if (v < 0) continue;
+            acc = (acc << 6) | (uint32_t)v;
+            bits += 6;
+            if (bits >= 8) { bits -= 8; out[o++] = (uint8_t)(acc >> bits); acc &= (1u << bits) - 1; }
+        }
+        return o;
+    }
+};
+
+#endif
@@ -0,0 +1,58 @@
+#ifndef HTTP_RANGE_H
+#define HTTP_RANGE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+enum HttpRangeResult {
+    HTTP_RANGE_NONE,           // no usable Range header: send the whole file (200)
+    HTTP_RANGE_OK,             // send bytes first..last (206)
+    HTTP_RANGE_UNSATISFIABLE,  // starts past the end (416)
+};
+
+// Parse a single-range "Range: bytes=..." header against a file of `size`
+// bytes: "a-b", "a-" (to the end) or "-n" (last n bytes). A range running
+// past the end is clamped. Multiple ranges, other units and malformed
+// headers are ignored, as RFC 9110 allows, and the whole file is sent.
+inline HttpRangeResult httpParseRange(const char* h, uint32_t size, uint32_t& first, uint32_t& last) {
+    if (!h) return HTTP_RANGE_NONE;
+    while (*h == ' ') h++;
+    if (strncmp(h, "bytes=", 6) != 0) return HTTP_RANGE_NONE;
+    h += 6;
+    if (strchr(h, ',')) return HTTP_RANGE_NONE;
+
+    // Digits up to UINT32_MAX; `any` tells whether there were any
+    auto number = [](const char*& p, uint64_t& v, bool& any) {
+        while (*p == ' ') p++;
+        v = 0; any = false;
+        while (*p >= '0' && *p <= '9') {
+            v = v * 10 + (uint64_t)(*p++ - '0');
+            if (v > 0xFFFFFFFFull) v = 0xFFFFFFFFull + 1; // saturate
+            any = true;
+        }
+        while (*p == ' ') p++;
+    };
+
+    uint64_t a, b;
+    bool haveA, haveB;
+    number(h, a, haveA);
+    if (*h++ != '-') return HTTP_RANGE_NONE;
+    number(h, b, haveB);
+    if (*h != '\0' || (!haveA && !haveB)) return HTTP_RANGE_NONE;
+
+    if (!haveA) {
+        // Suffix: the last b bytes
+        if (b == 0 || size == 0) return HTTP_RANGE_UNSATISFIABLE;
+        first = b >= size ? 0 : (uint32_t)(size - b);
+        last = size - 1;
+        return HTTP_RANGE_OK;
+    }
+    if (haveB && b < a) return HTTP_RANGE_NONE;
+    if (a >= size) return HTTP_RANGE_UNSATISFIABLE;
+    first = (uint32_t)a;
+    last = (!haveB || b >= size) ? size - 1 : (uint32_t)b;
+    return HTTP_RANGE_OK;
+}
+
+#endif
@@ -0,0 +1,198 @@
+#ifndef JOB_QUEUE_H
+#define JOB_QUEUE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include "settings.h" // settingsCrc32, settingsPut32/Get32
+
+#ifndef JOB_QUEUE_MAX
+#define JOB_QUEUE_MAX 16
+#endif
+#define JOB_NAME_MAX 64
+#define JOB_HOOK_MAX 128 // start/end G-code of one job, lines separated by '\n'
+#define JOB_QUEUE_PATH "/jobqueue.bin"
+
+// What the runner does between two jobs
+enum JobBarrier {
+    JOB_BARRIER_NONE,      // next job as soon as the last one's moves are done
+    JOB_BARRIER_COOLDOWN,  // wait cooldownSec first
+    JOB_BARRIER_OPERATOR,  // wait for someone to clear the bed and continue
+};
+
+struct QueuedJob {
+    uint32_t id;          // never reused while the queue file exists
+    uint8_t storage;      // STORAGE_LITTLEFS / STORAGE_SD
+    char name[JOB_NAME_MAX];
+    char startGcode[JOB_HOOK_MAX];
+    char endGcode[JOB_HOOK_MAX];
+};
+
+// Encoded queue: "E3JQ", version, barrier, cooldown (u16), next id (u32),
+// count, CRC-32 of the records (u32); then per job id (u32), storage and
+// the three strings, each as a length byte and the characters.
+#define JOB_QUEUE_VERSION 1
+#define JOB_QUEUE_BLOB_HEADER 17
+#define JOB_QUEUE_BLOB_MAX (JOB_QUEUE_BLOB_HEADER + JOB_QUEUE_MAX * (5 + 3 + JOB_NAME_MAX + 2 * JOB_HOOK_MAX))
+
+// Fixed-size ordered list of jobs waiting to run; the front runs next
+class JobQueue {
+private:
+    QueuedJob jobs[JOB_QUEUE_MAX];
+    int count;
+    uint32_t nextId;
+
+    static bool fits(const char* s, size_t cap) { return strlen(s ? s : "") < cap; }
+    static void copy(char* dst, const char* s, size_t cap) {
+        size_t n = strlen(s ? s : "");
+        if (n >= cap) n = cap - 1;
+        memcpy(dst, s ? s : "", n);
+        dst[n] = '\0';
+    }
+
+public:
+    JobBarrier barrier;
+    uint16_t cooldownSec;
+
+    JobQueue() { clear(); }
+
+    void clear() { count = 0; nextId = 1; barrier = JOB_BARRIER_NONE; cooldownSec = 0; }
+
+    int size() const { return count; }
+    bool full() const { return count == JOB_QUEUE_MAX; }
+    const QueuedJob& at(int i) const { return jobs[i]; }
+
+    int indexOf(uint32_t id) const {
+        for (int i = 0; i < count; ++i) if (jobs[i].id == id) return i;
+        return -1;
+    }
+
+    // Insert at `position` (end if negative or past it). Returns the job's
+    // id, or 0 if the queue is full or a field is too long.
+    uint32_t add(const char* name, uint8_t storage, const char* start, const char* end, int position = -1) {
+        if (full() || !name || !*name || !fits(name, JOB_NAME_MAX) || !fits(start, JOB_HOOK_MAX) || !fits(end, JOB_HOOK_MAX)) return 0;
+        if (position < 0 || position > count) position = count;
+        memmove(&jobs[position + 1], &jobs[position], (count - position) * sizeof(QueuedJob));
+        QueuedJob& j = jobs[position];
+        j.id = nextId++;
+        if (nextId == 0) nextId = 1;
+        j.storage = storage;
+        copy(j.name, name, JOB_NAME_MAX);
+        copy(j.startGcode, start, JOB_HOOK_MAX);
+        copy(j.endGcode, end, JOB_HOOK_MAX);
+        count++;
+        return j.id;
+    }
+
+    bool remove(uint32_t id) {
+        int i = indexOf(id);
+        if (i < 0) return false;
+        memmove(&jobs[i], &jobs[i + 1], (count - i - 1) * sizeof(QueuedJob));
+        count--;
+        return true;
+    }
+
+    // Move a job to `position` (clamped to the queue)
+    bool move(uint32_t id, int position) {
+        int i = indexOf(id);
+        if (i < 0) return false;
+        if (position < 0) position = 0;
+        if (position >= count) position = count - 1;
+        QueuedJob j = jobs[i];
+        if (position < i) memmove(&jobs[position + 1], &jobs[position], (i - position) * sizeof(QueuedJob));
+        else memmove(&jobs[i], &jobs[i + 1], (position - i) * sizeof(QueuedJob));
+        jobs[position] = j;
+        return true;
+    }
+
+    // Take the front job
+    bool pop(QueuedJob& out) {
+        if (count == 0) return false;
+        out = jobs[0];
+        memmove(&jobs[0], &jobs[1], (count - 1) * sizeof(QueuedJob));
+        count--;
+        return true;
+    }
+
+    // Returns the encoded length, 0 if `cap` is too small
+    size_t encode(uint8_t* out, size_t cap) const {
+        if (cap < JOB_QUEUE_BLOB_HEADER) return 0;
+        size_t p = JOB_QUEUE_BLOB_HEADER;
+        for (int i = 0; i < count; ++i) {
+            const QueuedJob& j = jobs[i];
+            const char* strs[3] = { j.name, j.startGcode, j.endGcode };
+            size_t need = 5;
+            for (const char* s : strs) need += 1 + strlen(s);
+            if (p + need > cap) return 0;
+            settingsPut32(out + p, j.id);
+            out[p + 4] = j.storage;
+            p += 5;
+            for (const char* s : strs) {
+                size_t n = strlen(s);
+                out[p++] = (uint8_t)n;
+                memcpy(out + p, s, n);
+                p += n;
+            }
+        }
+        memcpy(out, "E3JQ", 4);
+        out[4] = JOB_QUEUE_VERSION;
+        out[5] = (uint8_t)barrier;
+        out[6] = (uint8_t)(cooldownSec & 0xFF);
+        out[7] = (uint8_t)(cooldownSec >> 8);
+        settingsPut32(out + 8, nextId);
+        out[12] = (uint8_t)count;
+        settingsPut32(out + 13, settingsCrc32(out + JOB_QUEUE_BLOB_HEADER, p - JOB_QUEUE_BLOB_HEADER));
+        return p;
+    }
+
+    // Replaces the queue only if the whole blob is valid
+    bool decode(const uint8_t* in, size_t len) {
+        if (len < JOB_QUEUE_BLOB_HEADER || memcmp(in, "E3JQ", 4) != 0 || in[4] != JOB_QUEUE_VERSION) return false;
+        if (in[5] > JOB_BARRIER_OPERATOR || in[12] > JOB_QUEUE_MAX) return false;
+        if (settingsGet32(in + 13) != settingsCrc32(in + JOB_QUEUE_BLOB_HEADER, len - JOB_QUEUE_BLOB_HEADER)) return false;
+        static JobQueue tmp; // too big for a task stack
+        tmp.clear();
+        tmp.barrier = (JobBarrier)in[5];
+        tmp.cooldownSec = (uint16_t)(in[6] | in[7] << 8);
+        tmp.nextId = settingsGet32(in + 8);
+        size_t p = JOB_QUEUE_BLOB_HEADER;
+        for (int i = 0; i < in[12]; ++i) {
+            if (p + 5 > len) return false;
+            QueuedJob& j = tmp.jobs[i];
+            j.id = settingsGet32(in + p);
+            j.storage = in[p + 4];
+            p += 5;
+            char* strs[3] = { j.name, j.startGcode, j.endGcode };
+            const size_t caps[3] = { JOB_NAME_MAX, JOB_HOOK_MAX, JOB_HOOK_MAX };
+            for (int k = 0; k < 3; ++k) {
+                if (p >= len) return false;
+                size_t n = in[p++];
+                if (n >= caps[k] || p + n > len) return false;
+                memcpy(strs[k], in + p, n);
+                strs[k][n] = '\0';
+                p += n;
+            }
+            tmp.count++;
+        }
+        if (p != len || tmp.nextId == 0) return false;
+        *this = tmp;
+        return true;
+    }
+};
+
+inline const char* jobBarrierName(JobBarrier b) {
+    switch (b) {
+        case JOB_BARRIER_COOLDOWN: return "cooldown";
+        case JOB_BARRIER_OPERATOR: return "operator";
+        default: return "none";
+    }
+}
+
+inline bool jobBarrierFromString(const char* s, JobBarrier& out) {
+    for (int b = JOB_BARRIER_NONE; b <= JOB_BARRIER_OPERATOR; ++b) {
+        if (strcmp(s, jobBarrierName((JobBarrier)b)) == 0) { out = (JobBarrier)b; return true; }
+    }
+    return false;
+}
+
+#endif
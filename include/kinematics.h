@@ -0,0 +1,158 @@
+#ifndef KINEMATICS_H
+#define KINEMATICS_H
+
+#include <math.h>
+
+// Motion axis indices. Motor/encoder channels use the same order; for CoreXY
+// and delta machines the X/Y(/Z) channels drive the belts or towers instead
+// of a single Cartesian axis each.
+#define AXIS_X 0
+#define AXIS_Y 1
+#define AXIS_Z 2
+#define AXIS_E 3
+
+// Number of motor channels wired on the board (X, Y, Z, E)
+#ifndef NUM_AXES
+#define NUM_AXES 4
+#endif
+
+// Kinematics policies.
+//
+// Each policy maps a Cartesian position (mm) onto motor positions (mm of
+// belt/carriage travel) with inverse(), and back with forward(). Axes the
+// mechanism does not couple (e.g. Z on CoreXY, E everywhere) pass through
+// unchanged. Everything is static and inline so the control loop resolves
+// the machine geometry at compile time with no virtual dispatch.
+// LINEAR is true when straight Cartesian lines stay straight in motor space.
+
+template <int N>
+struct CartesianKinematics {
+    static const int AXES = N;
+    static const bool LINEAR = true;
+
+    static inline bool inverse(const float* cart, float* motor) {
+        for (int i = 0; i < N; ++i) motor[i] = cart[i];
+        return true;
+    }
+
+    static inline bool forward(const float* motor, float* cart) {
+        for (int i = 0; i < N; ++i) cart[i] = motor[i];
+        return true;
+    }
+};
+
+// CoreXY / H-bot: A = X + Y, B = X - Y (A on the X channel, B on Y)
+template <int N>
+struct CoreXYKinematics {
+    static_assert(N >= 2, "CoreXY needs at least two axes");
+    static const int AXES = N;
+    static const bool LINEAR = true;
+
+    static inline bool inverse(const float* cart, float* motor) {
+        motor[AXIS_X] = cart[AXIS_X] + cart[AXIS_Y];
+        motor[AXIS_Y] = cart[AXIS_X] - cart[AXIS_Y];
+        for (int i = 2; i < N; ++i) motor[i] = cart[i];
+        return true;
+    }
+
+    static inline bool forward(const float* motor, float* cart) {
+        cart[AXIS_X] = 0.5f * (motor[AXIS_X] + motor[AXIS_Y]);
+        cart[AXIS_Y] = 0.5f * (motor[AXIS_X] - motor[AXIS_Y]);
+        for (int i = 2; i < N; ++i) cart[i] = motor[i];
+        return true;
+    }
+};
+
+// Default linear delta geometry (mm). Override in config.h.
+#ifndef DELTA_DIAGONAL_ROD
+#define DELTA_DIAGONAL_ROD 250.0f
+#endif
+#ifndef DELTA_RADIUS
+#define DELTA_RADIUS 124.0f
+#endif
+
+struct DefaultDeltaGeometry {
+    static constexpr float diagonalRod = DELTA_DIAGONAL_ROD;
+    static constexpr float radius = DELTA_RADIUS;
+};
+
+// Linear delta: towers at 210, 330 and 90 degrees drive the X, Y and Z
+// channels. Motor position is the carriage height above the effector plane.
+template <int N, class Geometry = DefaultDeltaGeometry>
+struct DeltaKinematics {
+    static_assert(N >= 3, "Delta needs at least three axes");
+    static const int AXES = N;
+    static const bool LINEAR = false;
+
+    static inline void towerXY(int tower, float &tx, float &ty) {
+        // cos/sin of 210, 330 and 90 degrees
+        static const float c[3] = { -0.8660254f, 0.8660254f, 0.0f };
+        static const float s[3] = { -0.5f, -0.5f, 1.0f };
+        tx = Geometry::radius * c[tower];
+        ty = Geometry::radius * s[tower];
+    }
+
+    static inline bool inverse(const float* cart, float* motor) {
+        const float rod2 = Geometry::diagonalRod * Geometry::diagonalRod;
+        for (int t = 0; t < 3; ++t) {
+            float tx, ty;
+            towerXY(t, tx, ty);
+            float dx = cart[AXIS_X] - tx;
+            float dy = cart[AXIS_Y] - ty;
+            float h2 = rod2 - dx * dx - dy * dy;
+            if (h2 < 0.0f) return false; // out of reach
+            motor[t] = cart[AXIS_Z] + sqrtf(h2);
+        }
+        for (int i = 3; i < N; ++i) motor[i] = cart[i];
+        return true;
+    }
+
+    // Trilateration of the three carriage spheres (effector below carriages)
+    static inline bool forward(const float* motor, float* cart) {
+        float p1[3], p2[3], p3[3];
+        towerXY(0, p1[0], p1[1]); p1[2] = motor[AXIS_X];
+        towerXY(1, p2[0], p2[1]); p2[2] = motor[AXIS_Y];
+        towerXY(2, p3[0], p3[1]); p3[2] = motor[AXIS_Z];
+
+        float ex[3] = { p2[0] - p1[0], p2[1] - p1[1], p2[2] - p1[2] };
+        float d = sqrtf(ex[0] * ex[0] + ex[1] * ex[1] + ex[2] * ex[2]);
+        if (d <= 0.0f) return false;
+        for (int k = 0; k < 3; ++k) ex[k] /= d;
+
+        float p13[3] = { p3[0] - p1[0], p3[1] - p1[1], p3[2] - p1[2] };
+        float i = ex[0] * p13[0] + ex[1] * p13[1] + ex[2] * p13[2];
+        float ey[3] = { p13[0] - i * ex[0], p13[1] - i * ex[1], p13[2] - i * ex[2] };
+        float j = sqrtf(ey[0] * ey[0] + ey[1] * ey[1] + ey[2] * ey[2]);
+        if (j <= 0.0f) return false;
+        for (int k = 0; k < 3; ++k) ey[k] /= j;
+
+        float ez[3] = {
+            ex[1] * ey[2] - ex[2] * ey[1],
+            ex[2] * ey[0] - ex[0] * ey[2],
+            ex[0] * ey[1] - ex[1] * ey[0]
+        };
+
+        float xn = 0.5f * d;
+        float yn = (0.5f * (i * i + j * j) - i * xn) / j;
+        float zn2 = Geometry::diagonalRod * Geometry::diagonalRod - xn * xn - yn * yn;
+        if (zn2 < 0.0f) return false;
+        float zn = sqrtf(zn2);
+
+        for (int k = 0; k < 3; ++k) cart[k] = p1[k] + ex[k] * xn + ey[k] * yn - ez[k] * zn;
+        for (int k = 3; k < N; ++k) cart[k] = motor[k];
+        return true;
+    }
+};
+
+// Machine kinematics selected in config.h
+#if defined(KINEMATICS)
+#if KINEMATICS == KINEMATICS_COREXY
+typedef CoreXYKinematics<NUM_AXES> MachineKinematics;
+#elif KINEMATICS == KINEMATICS_DELTA
+typedef DeltaKinematics<NUM_AXES> MachineKinematics;
+#else
+typedef CartesianKinematics<NUM_AXES> MachineKinematics;
+#endif
+#endif
+
+#endif
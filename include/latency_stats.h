@@ -0,0 +1,59 @@
+#ifndef LATENCY_STATS_H
+#define LATENCY_STATS_H
+
+#include <stdint.h>
+
+// Power-of-two histogram buckets: bucket k holds samples below 2^k us,
+// the last one everything from ~1 s up
+#define LATENCY_BUCKETS 21
+
+// Latency histogram for one measurement point (e.g. the WebSocket task's
+// loop gap). record() is called by a single task; readers on other tasks
+// may see a sample half-added, which is fine for diagnostics.
+class LatencyStats {
+private:
+    uint32_t buckets[LATENCY_BUCKETS];
+    uint32_t n;
+    uint32_t maxUs;
+    uint64_t sumUs;
+
+public:
+    LatencyStats() { reset(); }
+
+    void reset() {
+        for (int i = 0; i < LATENCY_BUCKETS; ++i) buckets[i] = 0;
+        n = 0; maxUs = 0; sumUs = 0;
+    }
+
+    void record(uint32_t us) {
+        int k = 0;
+        while (k < LATENCY_BUCKETS - 1 && us >= (1u << k)) k++;
+        buckets[k]++;
+        n++;
+        sumUs += us;
+        if (us > maxUs) maxUs = us;
+    }
+
+    uint32_t count() const { return n; }
+    uint32_t max() const { return maxUs; }
+    uint32_t mean() const { return n ? (uint32_t)(sumUs / n) : 0; }
+
+    // Upper bound of the bucket holding the given percentile (0..100),
+    // capped at the largest sample seen
+    uint32_t percentile(float p) const {
+        if (!n) return 0;
+        uint32_t want = (uint32_t)(n * p / 100.0f + 0.5f);
+        if (want < 1) want = 1;
+        uint32_t seen = 0;
+        for (int k = 0; k < LATENCY_BUCKETS; ++k) {
+            seen += buckets[k];
+            if (seen >= want) {
+                uint32_t bound = k < LATENCY_BUCKETS - 1 ? (1u << k) : maxUs;
+                return bound < maxUs ? bound : maxUs;
+            }
+        }
+        return maxUs;
+    }
+};
+
+#endif
@@ -0,0 +1,55 @@
+#ifndef LINE_ASSEMBLER_H
+#define LINE_ASSEMBLER_H
+
+#include <stddef.h>
+#include <string.h>
+
+#ifndef GCODE_LINE_MAX
+#define GCODE_LINE_MAX 256 // longest G-code line accepted from the stream
+#endif
+
+// Reassembles lines from the G-code stream buffer. Writers send whatever
+// they have (whole NUL-terminated lines from the job streamer, raw chunks
+// from Serial), so a receive can hold several lines or end mid-line.
+// '\n', '\r' and '\0' all end a line; empty lines are skipped. A line
+// longer than GCODE_LINE_MAX is dropped as a whole and flagged.
+class LineAssembler {
+private:
+    char buf[GCODE_LINE_MAX + 1];
+    size_t len;
+    bool complete;
+    bool overflow;   // current line ran past the buffer
+    bool dropped;    // the line just completed was too long
+
+public:
+    LineAssembler() : len(0), complete(false), overflow(false), dropped(false) { buf[0] = '\0'; }
+
+    // Consume bytes until a line completes (or `n` runs out); returns the
+    // number of bytes used. Call next() before feeding again once ready().
+    size_t feed(const char* data, size_t n) {
+        size_t i = 0;
+        while (i < n && !complete) {
+            char c = data[i++];
+            if (c == '\n' || c == '\r' || c == '\0') {
+                if (overflow) { overflow = false; dropped = true; len = 0; continue; }
+                if (len > 0) { buf[len] = '\0'; complete = true; }
+                continue;
+            }
+            if (len < GCODE_LINE_MAX) buf[len++] = c;
+            else overflow = true;
+        }
+        return i;
+    }
+
+    bool ready() const { return complete; }
+    const char* line() const { return buf; }
+    size_t length() const { return len; }
+
+    // Release the completed line
+    void next() { len = 0; complete = false; buf[0] = '\0'; }
+
+    // True once after an over-long line was thrown away
+    bool takeDropped() { bool d = dropped; dropped = false; return d; }
+};
+
+#endif
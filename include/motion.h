@@ -0,0 +1,40 @@
+#ifndef MOTION_H
+#define MOTION_H
+
+#include <stdint.h>
+
+// Entry of the motion queue (parser / job streamers -> controlTask).
+// Targets are Cartesian mm; see controlTask for how each field is applied.
+struct MotionCommand {
+    float targetXmm, targetYmm, targetZmm, targetEmm;
+    bool hasX, hasY, hasZ, hasE; // which axes were specified
+    bool isRelative;
+    bool isHoming;
+    bool isEmergency; // M112
+    uint8_t ownerType; // SRC_*
+    int ownerId;
+    float feedrate; // mm/min (0 == unspecified / full)
+    bool blend; // continue into the next queued segment without stopping to settle
+    // Native arc (G2/G3 with a feedrate): the trajectory follows the circle
+    // around (arcCenterXmm, arcCenterYmm) by arcSweep radians from the
+    // previous commanded point to the target
+    bool isArc;
+    float arcCenterXmm, arcCenterYmm;
+    float arcSweep;
+    // Laser state for this segment (modal M3/M4/M5 and S), applied when the
+    // segment starts so power changes stay in step with motion
+    uint8_t laserMode;
+    uint8_t laserPower;
+    bool isStateOnly; // no motion: only applies the laser/spindle state in queue order
+    // Spindle setpoint change (M3/M4/M5): RPM with a tachometer, else PWM.
+    // With closed-loop control the queue is held until the spindle is at speed.
+    bool setsSpindle;
+    float spindleTarget;
+    // Raster scan row (laserMode == LASER_RASTER): laser power follows the
+    // pixel under the encoder X position, read from a raster pool row buffer
+    int8_t rasterSlot; // -1 when not a raster row
+    uint16_t rasterWidth;
+    float rasterOriginXmm, rasterPitchMm;
+};
+
+#endif
@@ -0,0 +1,58 @@
+#ifndef PRINT_STREAM_H
+#define PRINT_STREAM_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// Body of a streamed /api/print request, told apart by its first bytes
+enum PrintBodyKind {
+    PRINT_BODY_GCODE,
+    PRINT_BODY_RASTER,  // "E3R1" raster job (see raster.h)
+};
+
+inline PrintBodyKind printBodyKind(const uint8_t* p, size_t n) {
+    return n >= 4 && memcmp(p, "E3R1", 4) == 0 ? PRINT_BODY_RASTER : PRINT_BODY_GCODE;
+}
+
+// Hand body bytes to the parser's bounded stream buffer as they arrive.
+// When the buffer is full the HTTP task waits here, which stops it reading
+// the socket, so TCP flow control slows the sender to the machine's pace.
+// `write(p, n)` sends what fits within a short wait and returns the count;
+// `stopped()` is polled between waits so a job stop ends the request.
+class PrintStreamFeeder {
+private:
+    uint32_t delivered;
+    bool midLine;   // last byte delivered wasn't a line end
+
+public:
+    PrintStreamFeeder() : delivered(0), midLine(false) {}
+
+    void begin() { delivered = 0; midLine = false; }
+
+    // Returns false if stopped before all of `p` was delivered
+    template <class Write, class Stopped>
+    bool push(const uint8_t* p, size_t n, Write write, Stopped stopped) {
+        size_t off = 0;
+        while (off < n) {
+            if (stopped()) return false;
+            size_t w = write(p + off, n - off);
+            off += w;
+            delivered += (uint32_t)w;
+        }
+        if (n) midLine = p[n - 1] != '\n' && p[n - 1] != '\r';
+        return true;
+    }
+
+    // The body may end without a newline; the parser only runs complete lines
+    template <class Write, class Stopped>
+    bool finish(Write write, Stopped stopped) {
+        if (!midLine) return true;
+        static const uint8_t nl = '\n';
+        return push(&nl, 1, write, stopped);
+    }
+
+    uint32_t bytes() const { return delivered; }
+};
+
+#endif
@@ -0,0 +1,133 @@
+#ifndef RASTER_H
+#define RASTER_H
+
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+
+// Raster engraving jobs (.e3r): a fixed header followed by `height` rows of
+// `width` packed 8-bit laser powers (0-255), all little-endian.
+//
+//   offset size  field
+//   0      4     magic "E3R1"
+//   4      2     width  (pixels per row)
+//   6      2     height (rows)
+//   8      4     originX (mm, left edge of pixel 0)
+//   12     4     originY (mm, center line of row 0)
+//   16     4     pitchX  (mm per pixel along a row)
+//   20     4     pitchY  (mm between rows; negative steps towards -Y)
+//   24     4     feed    (mm/min scan speed)
+//   28     4     overscan (mm run-in/run-out beyond the image on each row)
+//   32     1     flags   (RASTER_FLAG_*)
+//   33     3     reserved
+//
+// Rows are always stored left to right; scan direction only changes motion.
+#define RASTER_HEADER_SIZE 36
+#define RASTER_FLAG_BIDIRECTIONAL 0x01 // alternate scan direction per row
+#define RASTER_FLAG_START_REVERSED 0x02 // first row scans right to left
+
+// Row buffer pool shared by the raster streamer and the control loop
+#ifndef RASTER_MAX_WIDTH
+#define RASTER_MAX_WIDTH 2048
+#endif
+#ifndef RASTER_ROW_SLOTS
+#define RASTER_ROW_SLOTS 4
+#endif
+
+struct RasterHeader {
+    uint16_t width;
+    uint16_t height;
+    float originX, originY;
+    float pitchX, pitchY;
+    float feed;
+    float overscan;
+    uint8_t flags;
+
+    // Decode and validate a header; returns false for anything this
+    // firmware cannot run.
+    bool parse(const uint8_t* buf, size_t len) {
+        if (len < RASTER_HEADER_SIZE || memcmp(buf, "E3R1", 4) != 0) return false;
+        width = (uint16_t)(buf[4] | (buf[5] << 8));
+        height = (uint16_t)(buf[6] | (buf[7] << 8));
+        originX = readFloat(buf + 8);
+        originY = readFloat(buf + 12);
+        pitchX = readFloat(buf + 16);
+        pitchY = readFloat(buf + 20);
+        feed = readFloat(buf + 24);
+        overscan = readFloat(buf + 28);
+        flags = buf[32];
+        if (width == 0 || width > RASTER_MAX_WIDTH || height == 0) return false;
+        if (!(pitchX > 0.0f) || pitchY == 0.0f || !(feed > 0.0f) || overscan < 0.0f) return false;
+        if (!isfinite(originX) || !isfinite(originY) || !isfinite(pitchY) || !isfinite(overscan)) return false;
+        return true;
+    }
+
+    size_t rowBytes() const { return width; }
+
+    static float readFloat(const uint8_t* p) {
+        uint32_t u = (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+        float f;
+        memcpy(&f, &u, sizeof(f));
+        return f;
+    }
+};
+
+// Motion for one scanned row: run-in start, run-out end and the row's Y
+struct RasterRowPlan {
+    float startX, endX, y;
+    bool reversed;
+};
+
+// Plan the `scanIndex`-th scanned row (image row `row`). With bidirectional
+// scanning the direction alternates per scanned row so the head never
+// travels back across the image.
+static inline RasterRowPlan rasterPlanRow(const RasterHeader &h, int row, int scanIndex) {
+    RasterRowPlan p;
+    bool reversed = (h.flags & RASTER_FLAG_START_REVERSED) != 0;
+    if ((h.flags & RASTER_FLAG_BIDIRECTIONAL) && (scanIndex & 1)) reversed = !reversed;
+    float left = h.originX - h.overscan;
+    float right = h.originX + h.width * h.pitchX + h.overscan;
+    p.startX = reversed ? right : left;
+    p.endX = reversed ? left : right;
+    p.y = h.originY + row * h.pitchY;
+    p.reversed = reversed;
+    return p;
+}
+
+// Power for the pixel under head position x (mm); 0 in the overscan
+static inline uint8_t rasterPixelAt(const uint8_t* row, uint16_t width, float originX, float pitchX, float x) {
+    float i = floorf((x - originX) / pitchX);
+    if (i < 0.0f || i >= (float)width) return 0;
+    return row[(int)i];
+}
+
+// True when a row has nothing to burn (it is then skipped entirely)
+static inline bool rasterRowBlank(const uint8_t* row, uint16_t width) {
+    for (uint16_t i = 0; i < width; ++i) if (row[i]) return false;
+    return true;
+}
+
+// Fixed pool of row buffers. The streamer fills a free slot and queues the
+// scan move that references it; the control loop releases the slot when the
+// move ends.
+class RasterRowPool {
+private:
+    uint8_t rows[RASTER_ROW_SLOTS][RASTER_MAX_WIDTH];
+    volatile bool used[RASTER_ROW_SLOTS];
+
+public:
+    RasterRowPool() { releaseAll(); }
+
+    // Returns a free slot index, or -1 when all rows are in flight
+    int acquire() {
+        for (int i = 0; i < RASTER_ROW_SLOTS; ++i) {
+            if (!used[i]) { used[i] = true; return i; }
+        }
+        return -1;
+    }
+    void release(int slot) { if (slot >= 0 && slot < RASTER_ROW_SLOTS) used[slot] = false; }
+    void releaseAll() { for (int i = 0; i < RASTER_ROW_SLOTS; ++i) used[i] = false; }
+    uint8_t* row(int slot) { return rows[slot]; }
+};
+
+#endif
@@ -0,0 +1,82 @@
+#ifndef REALTIME_H
+#define REALTIME_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// GRBL-style realtime commands. They are picked out of a client's byte
+// stream as they arrive and act on the run flags directly, so they never
+// wait behind queued G-code.
+enum RealtimeCommand {
+    RT_NONE,
+    RT_FEED_HOLD,  // '!'
+    RT_RESUME,     // '~'
+    RT_STATUS,     // '?'
+    RT_RESET,      // Ctrl-X: stop and flush, position kept
+    RT_ESTOP,      // an M112 line
+};
+
+#define RT_BYTE_RESET 0x18
+
+inline RealtimeCommand realtimeFromByte(uint8_t c) {
+    switch (c) {
+        case '!': return RT_FEED_HOLD;
+        case '~': return RT_RESUME;
+        case '?': return RT_STATUS;
+        case RT_BYTE_RESET: return RT_RESET;
+        default: return RT_NONE;
+    }
+}
+
+inline const char* realtimeName(RealtimeCommand c) {
+    switch (c) {
+        case RT_FEED_HOLD: return "hold";
+        case RT_RESUME: return "resume";
+        case RT_STATUS: return "status";
+        case RT_RESET: return "reset";
+        case RT_ESTOP: return "estop";
+        default: return "none";
+    }
+}
+
+// A complete line that must not be queued either: M112 (any case, as the
+// first word, optionally followed by a comment)
+inline RealtimeCommand realtimeFromLine(const char* s, size_t n) {
+    size_t i = 0;
+    while (i < n && (s[i] == ' ' || s[i] == '\t')) i++;
+    if (n - i < 4 || (s[i] != 'M' && s[i] != 'm') || s[i + 1] != '1' || s[i + 2] != '1' || s[i + 3] != '2') return RT_NONE;
+    i += 4;
+    if (i == n) return RT_ESTOP;
+    char c = s[i];
+    return (c == ' ' || c == '\t' || c == ';' || c == '(' || c == '\r' || c == '\n') ? RT_ESTOP : RT_NONE;
+}
+
+// Picks realtime bytes out of a client's stream. Inside a ';' or '(...)'
+// comment the characters are text (a "done!" comment must not hold the
+// machine); Ctrl-X is never text. Keep one per connection.
+class RealtimeFilter {
+private:
+    bool lineComment;
+    bool parenComment;
+
+public:
+    RealtimeFilter() : lineComment(false), parenComment(false) {}
+
+    void reset() { lineComment = parenComment = false; }
+
+    // The command `c` stands for, or RT_NONE if it is G-code text to keep
+    RealtimeCommand feed(uint8_t c) {
+        if (c == RT_BYTE_RESET) return RT_RESET;
+        if (!lineComment && !parenComment) {
+            RealtimeCommand r = realtimeFromByte(c);
+            if (r != RT_NONE) return r;
+        }
+        if (c == '\n' || c == '\r') lineComment = parenComment = false;
+        else if (c == ';' && !parenComment) lineComment = true;
+        else if (c == '(' && !lineComment) parenComment = true;
+        else if (c == ')' && parenComment) parenComment = false;
+        return RT_NONE;
+    }
+};
+
+#endif
@@ -0,0 +1,132 @@
+#ifndef SCURVE_H
+#define SCURVE_H
+
+#include <math.h>
+
+// Jerk-limited (7-segment S-curve) motion profile ending at rest.
+//
+// plan() works out the phase durations once per move:
+//   jerk+  accel  jerk-  cruise  jerk-  decel  jerk+
+// and stores the position/velocity/acceleration at the start of each phase,
+// so evaluate() is a single cubic per tick. When the move is too short to
+// reach the requested velocity (or acceleration) the peak is lowered and the
+// constant phases collapse to zero length.
+//
+// A profile may also start at a cruise velocity (zero acceleration) so the
+// remainder of a move can be re-planned while cruising, e.g. when the speed
+// override changes; the first ramp then accelerates or brakes to the new
+// peak velocity.
+class SCurveProfile {
+private:
+    static const int PHASES = 7;
+    float t0[PHASES + 1];   // phase start times (s); t0[PHASES] = total time
+    float s0[PHASES];       // position at phase start (mm)
+    float v0[PHASES];       // velocity at phase start (mm/s)
+    float a0[PHASES];       // acceleration at phase start (mm/s^2)
+    float jerk[PHASES];     // constant jerk during the phase (mm/s^3)
+    float dist;             // total distance (mm)
+    float peakVel;          // velocity actually reached (mm/s)
+    mutable int phase;      // cached phase index (ticks move forward in time)
+
+    // Time spent in the constant-jerk and constant-accel parts of a ramp
+    // between velocities `va` and `vb`, and the distance that ramp covers
+    static float rampDistance(float va, float vb, float amax, float jmax, float &tj, float &ta) {
+        float dv = fabsf(vb - va);
+        if (dv * jmax >= amax * amax) {
+            tj = amax / jmax;
+            ta = dv / amax - tj;
+        } else {
+            tj = sqrtf(dv / jmax);
+            ta = 0.0f;
+        }
+        // the ramp is point-symmetric about its midpoint, so the mean velocity is (va+vb)/2
+        return (va + vb) * (2.0f * tj + ta) * 0.5f;
+    }
+
+    // Distance to go from vStart to peak v and back to rest
+    static float totalRamps(float vStart, float v, float amax, float jmax) {
+        float tj, ta;
+        return rampDistance(vStart, v, amax, jmax, tj, ta) + rampDistance(v, 0.0f, amax, jmax, tj, ta);
+    }
+
+public:
+    SCurveProfile() : dist(0), peakVel(0), phase(0) {
+        for (int i = 0; i <= PHASES; ++i) t0[i] = 0;
+        for (int i = 0; i < PHASES; ++i) { s0[i] = 0; v0[i] = 0; a0[i] = 0; jerk[i] = 0; }
+    }
+
+    // Plan a move of `distance` mm limited to vmax (mm/s), amax (mm/s^2) and
+    // jmax (mm/s^3), starting at velocity vStart with zero acceleration.
+    // Returns the total duration in seconds, or a negative value when the
+    // distance is too short to reach vmax from vStart and stop in time.
+    float plan(float distance, float vmax, float amax, float jmax, float vStart = 0.0f) {
+        dist = distance > 0.0f ? distance : 0.0f;
+        phase = 0;
+        for (int i = 0; i <= PHASES; ++i) t0[i] = 0;
+        for (int i = 0; i < PHASES; ++i) { s0[i] = 0; v0[i] = 0; a0[i] = 0; jerk[i] = 0; }
+        peakVel = 0.0f;
+        if (dist <= 0.0f || !(vmax > 0.0f) || !(amax > 0.0f) || !(jmax > 0.0f)) return 0.0f;
+        if (vStart < 0.0f) vStart = 0.0f;
+
+        float tc = 0.0f;
+        float v = vmax;
+        float dRamps = totalRamps(vStart, v, amax, jmax);
+        if (dRamps <= dist) {
+            tc = (dist - dRamps) / v;
+        } else {
+            // Too short to reach vmax: find the peak velocity whose ramps
+            // exactly cover the distance (the distance grows with v above vStart)
+            if (vmax < vStart || totalRamps(vStart, vStart, amax, jmax) > dist) return -1.0f;
+            float lo = vStart, hi = vmax;
+            for (int it = 0; it < 40; ++it) {
+                v = 0.5f * (lo + hi);
+                if (totalRamps(vStart, v, amax, jmax) > dist) hi = v; else lo = v;
+            }
+            v = lo;
+        }
+        peakVel = v;
+
+        float tj1, ta1, tj2, ta2;
+        rampDistance(vStart, v, amax, jmax, tj1, ta1);
+        rampDistance(v, 0.0f, amax, jmax, tj2, ta2);
+        const float dur[PHASES] = { tj1, ta1, tj1, tc, tj2, ta2, tj2 };
+        const float j1 = v >= vStart ? jmax : -jmax;
+        const float jr[PHASES] = { j1, 0.0f, -j1, 0.0f, -jmax, 0.0f, jmax };
+        float s = 0.0f, vel = vStart, a = 0.0f, t = 0.0f;
+        for (int i = 0; i < PHASES; ++i) {
+            t0[i] = t; s0[i] = s; v0[i] = vel; a0[i] = a; jerk[i] = jr[i];
+            float d = dur[i];
+            s += vel * d + a * d * d * 0.5f + jr[i] * d * d * d / 6.0f;
+            vel += a * d + jr[i] * d * d * 0.5f;
+            a += jr[i] * d;
+            t += d;
+        }
+        t0[PHASES] = t;
+        return t;
+    }
+
+    // True while the profile is cruising at constant velocity (a re-plan
+    // from here keeps acceleration continuous)
+    bool cruising(float t) const {
+        return t0[4] > t0[3] && t >= t0[3] && t < t0[4];
+    }
+
+    float duration() const { return t0[PHASES]; }
+    float distance() const { return dist; }
+    float peakVelocity() const { return peakVel; }
+
+    // Position (mm) and velocity (mm/s) at time t (s) since the move started
+    void evaluate(float t, float &s, float &v) const {
+        if (t >= t0[PHASES]) { s = dist; v = 0.0f; return; }
+        if (t <= 0.0f) { s = 0.0f; v = v0[0]; return; }
+        if (t < t0[phase]) phase = 0;
+        while (phase < PHASES - 1 && t >= t0[phase + 1]) ++phase;
+        float tau = t - t0[phase];
+        float j = jerk[phase], a = a0[phase];
+        s = s0[phase] + tau * (v0[phase] + tau * (a * 0.5f + tau * j / 6.0f));
+        v = v0[phase] + tau * (a + tau * j * 0.5f);
+        if (s > dist) s = dist;
+    }
+};
+
+#endif
@@ -0,0 +1,214 @@
+#ifndef SETTINGS_H
+#define SETTINGS_H
+
+#include <stdint.h>
+#include <string.h>
+#include <strings.h>
+#include <math.h>
+
+// Typed settings registry.
+//
+// Every runtime setting is one row of a SettingDesc table (see main.cpp):
+// NVS/blob key, dotted /api/config path, type, the variable it lives in,
+// default, valid range and whether it is persisted. M500/M501/M503, the
+// /api/config endpoints, the UI form and the NVS blob are all driven from
+// that table, so adding a setting is a one-line change.
+
+enum SettingType : uint8_t { SETTING_INT = 0, SETTING_FLOAT = 1 };
+
+struct SettingDesc {
+    const char* key;  // NVS / blob key (at most 15 characters)
+    const char* path; // JSON path in /api/config, e.g. "pid.x.p"
+    uint8_t type;     // SettingType
+    void* ptr;        // int* or float*
+    float def, min, max;
+    bool persist;     // saved in the NVS blob / export
+};
+
+static inline float settingGet(const SettingDesc &d) {
+    return d.type == SETTING_INT ? (float)*(int*)d.ptr : *(float*)d.ptr;
+}
+
+// Range-checked write; returns false (leaving the value untouched) when out of range
+static inline bool settingSet(const SettingDesc &d, float v) {
+    if (!isfinite(v) || v < d.min || v > d.max) return false;
+    if (d.type == SETTING_INT) *(int*)d.ptr = (int)lroundf(v);
+    else *(float*)d.ptr = v;
+    return true;
+}
+
+// Look a setting up by NVS key or JSON path (case-insensitive, so G-code
+// upper-casing does not matter)
+static inline const SettingDesc* settingFind(const SettingDesc* table, int n, const char* name) {
+    for (int i = 0; i < n; ++i) {
+        if (strcasecmp(table[i].key, name) == 0 || strcasecmp(table[i].path, name) == 0) return &table[i];
+    }
+    return nullptr;
+}
+
+// One value from a command (M92, M301...) bound for the registry
+struct SettingWrite {
+    const char* path;  // key or JSON path
+    float value;
+    bool parsed;       // the command carried a number for it
+};
+
+// Apply several writes all or nothing: returns nullptr once all are set, or
+// the path of the first that is unknown, unparsed or out of range (nothing
+// is written then)
+static inline const char* settingsWriteAll(const SettingDesc* table, int n, const SettingWrite* w, int count) {
+    for (int i = 0; i < count; ++i) {
+        const SettingDesc* d = settingFind(table, n, w[i].path);
+        if (!d || !w[i].parsed || !isfinite(w[i].value) || w[i].value < d->min || w[i].value > d->max) return w[i].path;
+    }
+    for (int i = 0; i < count; ++i) settingSet(*settingFind(table, n, w[i].path), w[i].value);
+    return nullptr;
+}
+
+static inline void settingsResetDefaults(const SettingDesc* table, int n) {
+    for (int i = 0; i < n; ++i) settingSet(table[i], table[i].def);
+}
+
+// --- Binary blob (NVS "cfg" key and /api/config/export) ---
+//
+//   offset size  field
+//   0      4     magic "E3S1"
+//   4      2     format version (SETTINGS_BLOB_VERSION)
+//   6      2     entry count
+//   8      4     CRC-32 of the entries
+//   12     24*n  entries: key[16] (NUL padded), type u8, 3 reserved, value u32
+//
+// Entries are matched by key, so blobs from older or newer firmware import
+// whatever settings both sides know about.
+#define SETTINGS_BLOB_VERSION 1
+#define SETTINGS_BLOB_HEADER 12
+#define SETTINGS_BLOB_ENTRY 24
+#ifndef SETTINGS_BLOB_MAX
+#define SETTINGS_BLOB_MAX (SETTINGS_BLOB_HEADER + 96 * SETTINGS_BLOB_ENTRY)
+#endif
+
+static inline uint32_t settingsCrc32(const uint8_t* p, size_t len) {
+    uint32_t crc = 0xFFFFFFFFu;
+    while (len--) {
+        crc ^= *p++;
+        for (int k = 0; k < 8; ++k) crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1u)));
+    }
+    return ~crc;
+}
+
+static inline void settingsPut16(uint8_t* p, uint16_t v) { p[0] = v & 0xFF; p[1] = v >> 8; }
+static inline void settingsPut32(uint8_t* p, uint32_t v) { for (int i = 0; i < 4; ++i) p[i] = (v >> (8 * i)) & 0xFF; }
+static inline uint16_t settingsGet16(const uint8_t* p) { return (uint16_t)(p[0] | (p[1] << 8)); }
+static inline uint32_t settingsGet32(const uint8_t* p) { return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24); }
+
+// Serialize the persisted settings; returns the blob size (0 if `cap` is too small)
+static inline size_t settingsEncode(const SettingDesc* table, int n, uint8_t* out, size_t cap) {
+    int count = 0;
+    for (int i = 0; i < n; ++i) if (table[i].persist) count++;
+    size_t size = SETTINGS_BLOB_HEADER + (size_t)count * SETTINGS_BLOB_ENTRY;
+    if (size > cap) return 0;
+    memset(out, 0, size);
+    memcpy(out, "E3S1", 4);
+    settingsPut16(out + 4, SETTINGS_BLOB_VERSION);
+    settingsPut16(out + 6, (uint16_t)count);
+    uint8_t* e = out + SETTINGS_BLOB_HEADER;
+    for (int i = 0; i < n; ++i) {
+        const SettingDesc &d = table[i];
+        if (!d.persist) continue;
+        strncpy((char*)e, d.key, 15);
+        e[16] = d.type;
+        uint32_t raw;
+        if (d.type == SETTING_INT) { int32_t v = *(int*)d.ptr; memcpy(&raw, &v, 4); }
+        else memcpy(&raw, (float*)d.ptr, 4);
+        settingsPut32(e + 20, raw);
+        e += SETTINGS_BLOB_ENTRY;
+    }
+    settingsPut32(out + 8, settingsCrc32(out + SETTINGS_BLOB_HEADER, size - SETTINGS_BLOB_HEADER));
+    return size;
+}
+
+struct SettingsImportResult {
+    bool valid;   // header, size and CRC check out
+    int applied;  // settings written
+    int rejected; // known settings whose value was out of range / wrong type
+    int unknown;  // keys this firmware does not have
+};
+
+// Validate a blob and, if `apply`, write its values. Nothing is written
+// unless the whole blob is intact; individual out-of-range values are
+// skipped and counted.
+static inline SettingsImportResult settingsDecode(const SettingDesc* table, int n, const uint8_t* in, size_t len, bool apply) {
+    SettingsImportResult r = { false, 0, 0, 0 };
+    if (len < SETTINGS_BLOB_HEADER || memcmp(in, "E3S1", 4) != 0) return r;
+    if (settingsGet16(in + 4) != SETTINGS_BLOB_VERSION) return r;
+    size_t count = settingsGet16(in + 6);
+    if (len != SETTINGS_BLOB_HEADER + count * SETTINGS_BLOB_ENTRY) return r;
+    if (settingsGet32(in + 8) != settingsCrc32(in + SETTINGS_BLOB_HEADER, len - SETTINGS_BLOB_HEADER)) return r;
+    r.valid = true;
+    const uint8_t* e = in + SETTINGS_BLOB_HEADER;
+    for (size_t k = 0; k < count; ++k, e += SETTINGS_BLOB_ENTRY) {
+        char key[16];
+        memcpy(key, e, 15); key[15] = '\0';
+        const SettingDesc* d = nullptr;
+        for (int i = 0; i < n; ++i) if (table[i].persist && strcmp(table[i].key, key) == 0) { d = &table[i]; break; }
+        if (!d) { r.unknown++; continue; }
+        uint32_t raw = settingsGet32(e + 20);
+        float v;
+        if (e[16] != d->type) { r.rejected++; continue; }
+        if (d->type == SETTING_INT) { int32_t iv; memcpy(&iv, &raw, 4); v = (float)iv; }
+        else memcpy(&v, &raw, 4);
+        if (!isfinite(v) || v < d->min || v > d->max) { r.rejected++; continue; }
+        if (apply) settingSet(*d, v);
+        r.applied++;
+    }
+    return r;
+}
+
+// When to write the blob: after changes have been quiet for
+// SETTINGS_FLUSH_DEBOUNCE_MS, at most SETTINGS_FLUSH_MAX_DELAY_MS after the
+// first change, or right away after requestFlush() (M500). The flush task
+// still compares the encoded blob with the last one written and skips
+// identical ones, so marking dirty is cheap and safe from any task.
+#ifndef SETTINGS_FLUSH_DEBOUNCE_MS
+#define SETTINGS_FLUSH_DEBOUNCE_MS 2000
+#endif
+#ifndef SETTINGS_FLUSH_MAX_DELAY_MS
+#define SETTINGS_FLUSH_MAX_DELAY_MS 10000
+#endif
+
+class SettingsFlushSchedule {
+private:
+    volatile bool dirty;
+    volatile bool forced;
+    volatile uint32_t firstDirtyMs, lastChangeMs;
+
+public:
+    SettingsFlushSchedule() : dirty(false), forced(false), firstDirtyMs(0), lastChangeMs(0) {}
+
+    void markDirty(uint32_t nowMs) {
+        if (!dirty) firstDirtyMs = nowMs;
+        lastChangeMs = nowMs;
+        dirty = true;
+    }
+    void requestFlush(uint32_t nowMs) { markDirty(nowMs); forced = true; }
+    bool pending() const { return dirty; }
+
+    // True when a flush should run now; clears the dirty state (call
+    // markFailed() if the write does not succeed)
+    bool take(uint32_t nowMs) {
+        if (!dirty) return false;
+        if (!forced && nowMs - lastChangeMs < SETTINGS_FLUSH_DEBOUNCE_MS && nowMs - firstDirtyMs < SETTINGS_FLUSH_MAX_DELAY_MS) return false;
+        dirty = false;
+        forced = false;
+        return true;
+    }
+
+    // Retry after another debounce period
+    void markFailed(uint32_t nowMs) {
+        if (!dirty) firstDirtyMs = nowMs;
+        lastChangeMs = nowMs;
+        dirty = true;
+    }
+};
+
+#endif
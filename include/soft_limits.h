@@ -0,0 +1,82 @@
+#ifndef SOFT_LIMITS_H
+#define SOFT_LIMITS_H
+
+#include <math.h>
+#include <stddef.h>
+#include <stdio.h>
+#include "kinematics.h"
+#include "arc.h"
+
+// Rounding slack: a target this far past a limit still counts as on it
+#ifndef SOFT_LIMIT_SLACK_MM
+#define SOFT_LIMIT_SLACK_MM 0.001f
+#endif
+
+// The limit a move would cross, and by how much
+struct SoftLimitViolation {
+    int axis;      // AXIS_X, AXIS_Y or AXIS_Z
+    bool above;    // past the max (else below the min)
+    float value;   // furthest the move goes on that axis (mm)
+    float limit;   // the limit it passes (mm)
+};
+
+// Travel envelope: a min/max per X, Y and Z axis, in machine coordinates.
+// An axis whose max is not above its min has no limit. A move is checked by
+// comparing its bounding box with the envelope, so each check costs the
+// same whatever the move's length. A straight move stays in the box when
+// both of its ends do. An arc uses its true extent (arcBoundsXY); its chord
+// segments lie inside that extent.
+class TravelEnvelope {
+private:
+    bool on;
+    float lo[3], hi[3];
+
+public:
+    TravelEnvelope() : on(false) {
+        for (int i = 0; i < 3; ++i) { lo[i] = 0.0f; hi[i] = 0.0f; }
+    }
+
+    void configure(bool enabled, const float mins[3], const float maxs[3]) {
+        on = enabled;
+        for (int i = 0; i < 3; ++i) { lo[i] = mins[i]; hi[i] = maxs[i]; }
+    }
+
+    bool enabled() const { return on; }
+    bool limited(int axis) const { return on && axis >= 0 && axis < 3 && hi[axis] > lo[axis]; }
+
+    // True if the box [bmin, bmax] (X, Y, Z, or just the first `axes`) is
+    // inside; otherwise `v` gets the first axis that is out
+    bool containsBox(const float bmin[], const float bmax[], SoftLimitViolation* v, int axes = 3) const {
+        for (int a = 0; a < axes && a < 3; ++a) {
+            if (!limited(a)) continue;
+            if (bmax[a] > hi[a] + SOFT_LIMIT_SLACK_MM) { if (v) { v->axis = a; v->above = true; v->value = bmax[a]; v->limit = hi[a]; } return false; }
+            if (bmin[a] < lo[a] - SOFT_LIMIT_SLACK_MM) { if (v) { v->axis = a; v->above = false; v->value = bmin[a]; v->limit = lo[a]; } return false; }
+        }
+        return true;
+    }
+
+    bool containsLine(const float from[NUM_AXES], const float to[NUM_AXES], SoftLimitViolation* v) const {
+        float bmin[3], bmax[3];
+        for (int a = 0; a < 3; ++a) { bmin[a] = fminf(from[a], to[a]); bmax[a] = fmaxf(from[a], to[a]); }
+        return containsBox(bmin, bmax, v);
+    }
+
+    // XY arc around (cx, cy) with a signed sweep; Z moves linearly (helix)
+    bool containsArc(const float from[NUM_AXES], const float to[NUM_AXES], float cx, float cy, float sweep, SoftLimitViolation* v) const {
+        if (!on) return true;
+        float bmin[3], bmax[3];
+        arcBoundsXY(from[AXIS_X], from[AXIS_Y], to[AXIS_X], to[AXIS_Y], cx, cy, sweep, bmin, bmax);
+        bmin[AXIS_Z] = fminf(from[AXIS_Z], to[AXIS_Z]);
+        bmax[AXIS_Z] = fmaxf(from[AXIS_Z], to[AXIS_Z]);
+        return containsBox(bmin, bmax, v);
+    }
+};
+
+// "X=312.000 above max 300.000"; returns the length written (0 if it doesn't fit)
+inline size_t softLimitDescribe(char* out, size_t cap, const SoftLimitViolation& v) {
+    static const char names[3] = { 'X', 'Y', 'Z' };
+    int n = snprintf(out, cap, "%c=%.3f %s %.3f", names[v.axis % 3], v.value, v.above ? "above max" : "below min", v.limit);
+    return n < 0 || (size_t)n >= cap ? 0 : (size_t)n;
+}
+
+#endif
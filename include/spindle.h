@@ -0,0 +1,164 @@
+#ifndef SPINDLE_H
+#define SPINDLE_H
+
+#include <stdint.h>
+#include <math.h>
+
+// Regulator defaults; the hardware-specific ones are set in config.h
+#ifndef SPINDLE_PULSES_PER_REV
+#define SPINDLE_PULSES_PER_REV 1
+#endif
+#ifndef SPINDLE_MAX_RPM
+#define SPINDLE_MAX_RPM 24000.0f
+#endif
+#ifndef SPINDLE_KP
+#define SPINDLE_KP 0.01f           // PWM per RPM of error
+#endif
+#ifndef SPINDLE_KI
+#define SPINDLE_KI 0.05f           // PWM per RPM*s of error
+#endif
+#ifndef SPINDLE_RPM_WINDOW
+#define SPINDLE_RPM_WINDOW 10      // regulator samples in the RPM window
+#endif
+#ifndef SPINDLE_AT_SPEED_TOLERANCE
+#define SPINDLE_AT_SPEED_TOLERANCE 0.05f // fraction of the setpoint
+#endif
+#ifndef SPINDLE_AT_SPEED_MS
+#define SPINDLE_AT_SPEED_MS 200    // time inside the band before motion resumes
+#endif
+#ifndef SPINDLE_SPINUP_TIMEOUT_MS
+#define SPINDLE_SPINUP_TIMEOUT_MS 10000
+#endif
+#ifndef SPINDLE_STALL_FRACTION
+#define SPINDLE_STALL_FRACTION 0.5f // below this fraction of the setpoint...
+#endif
+#ifndef SPINDLE_STALL_MS
+#define SPINDLE_STALL_MS 300       // ...for this long counts as a stall
+#endif
+
+// Spindle speed from tachometer pulses. Pulse counts are accumulated over a
+// sliding window of SPINDLE_RPM_WINDOW samples so a 1-2 pulse/rev sensor
+// still resolves low speeds at the 50 Hz regulator rate.
+class SpindleTach {
+private:
+    int32_t pulses[SPINDLE_RPM_WINDOW];
+    uint32_t ms[SPINDLE_RPM_WINDOW];
+    int32_t pulseSum;
+    uint32_t msSum;
+    int head;
+    float pulsesPerRev;
+
+public:
+    SpindleTach() : pulsesPerRev(SPINDLE_PULSES_PER_REV) { reset(); }
+
+    void reset() {
+        for (int i = 0; i < SPINDLE_RPM_WINDOW; ++i) { pulses[i] = 0; ms[i] = 0; }
+        pulseSum = 0; msSum = 0; head = 0;
+    }
+    void setPulsesPerRev(float ppr) { if (ppr > 0.0f) pulsesPerRev = ppr; }
+
+    // Add the pulses counted over the last `dtMs` and return the windowed RPM
+    float add(int32_t count, uint32_t dtMs) {
+        pulseSum += count - pulses[head];
+        msSum += dtMs - ms[head];
+        pulses[head] = count; ms[head] = dtMs;
+        head = (head + 1) % SPINDLE_RPM_WINDOW;
+        if (msSum == 0) return 0.0f;
+        return pulseSum * 60000.0f / (pulsesPerRev * msSum);
+    }
+};
+
+// Spindle speed regulator: feed-forward from the RPM setpoint plus a PI trim
+// on the measured speed, producing the 8-bit spindle PWM. Without a
+// tachometer it runs open loop and setTarget() takes a PWM value instead.
+//
+// Closed loop it also tracks whether the spindle is at speed (the motion
+// barrier after M3/M4 waits for this) and flags a stall when the spindle
+// either never gets there or drops well below the setpoint while cutting.
+class SpindleRegulator {
+private:
+    bool closedLoop;
+    float maxRpm, kp, ki;
+    volatile float target;   // RPM (closed loop) or PWM (open loop)
+    float integral;          // PWM trim
+    volatile float measured; // RPM
+    volatile int pwm;
+    volatile bool reached;   // has been at speed since the last setpoint change
+    volatile bool stall;
+    uint32_t inBandMs, belowMs, sinceChangeMs;
+
+public:
+    SpindleRegulator()
+        : closedLoop(false), maxRpm(SPINDLE_MAX_RPM), kp(SPINDLE_KP), ki(SPINDLE_KI),
+          target(0), integral(0), measured(0), pwm(0), reached(true), stall(false),
+          inBandMs(0), belowMs(0), sinceChangeMs(0) {}
+
+    void setClosedLoop(bool on) { closedLoop = on; }
+    bool isClosedLoop() const { return closedLoop; }
+    void setTunings(float p, float i) { kp = p; ki = i; }
+    void setMaxRpm(float rpm) { if (rpm > 0.0f) maxRpm = rpm; }
+    float getKp() const { return kp; }
+    float getKi() const { return ki; }
+    float getMaxRpm() const { return maxRpm; }
+
+    // New setpoint: RPM closed loop, 0-255 PWM open loop. Clears a stall.
+    void setTarget(float t) {
+        float limit = closedLoop ? maxRpm : 255.0f;
+        if (t < 0.0f) t = 0.0f;
+        if (t > limit) t = limit;
+        if (t == target && !stall) return;
+        target = t;
+        stall = false;
+        reached = !closedLoop || t == 0.0f;
+        inBandMs = belowMs = sinceChangeMs = 0;
+        if (t == 0.0f) integral = 0.0f;
+    }
+
+    float getTarget() const { return target; }
+    float rpm() const { return measured; }
+    int output() const { return pwm; }
+    bool atSpeed() const { return reached; }
+    bool stalled() const { return stall; }
+
+    // Run one regulator step with the latest measured RPM; returns the PWM
+    int update(float rpmNow, uint32_t dtMs) {
+        measured = rpmNow;
+        float t = target;
+        if (!closedLoop) {
+            pwm = (int)t;
+            return pwm;
+        }
+        if (t <= 0.0f || stall) {
+            integral = 0.0f;
+            pwm = 0;
+            return pwm;
+        }
+
+        float dt = dtMs * 0.001f;
+        float err = t - rpmNow;
+        float ff = t / maxRpm * 255.0f;
+        float out = ff + kp * err + integral;
+        // Only integrate while the output is not pinned (anti-windup)
+        if ((out < 255.0f || err < 0.0f) && (out > 0.0f || err > 0.0f)) integral += ki * err * dt;
+        out = ff + kp * err + integral;
+        if (out > 255.0f) out = 255.0f;
+        if (out < 0.0f) out = 0.0f;
+        pwm = (int)lroundf(out);
+
+        // At speed once inside the band for SPINDLE_AT_SPEED_MS
+        sinceChangeMs += dtMs;
+        if (fabsf(err) <= t * SPINDLE_AT_SPEED_TOLERANCE) inBandMs += dtMs; else inBandMs = 0;
+        if (!reached && inBandMs >= SPINDLE_AT_SPEED_MS) reached = true;
+
+        if (!reached) {
+            if (sinceChangeMs > SPINDLE_SPINUP_TIMEOUT_MS) stall = true;
+        } else {
+            if (rpmNow < t * SPINDLE_STALL_FRACTION) belowMs += dtMs; else belowMs = 0;
+            if (belowMs >= SPINDLE_STALL_MS) stall = true;
+        }
+        if (stall) { integral = 0.0f; pwm = 0; }
+        return pwm;
+    }
+};
+
+#endif
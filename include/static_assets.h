@@ -0,0 +1,136 @@
+#ifndef STATIC_ASSETS_H
+#define STATIC_ASSETS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#ifndef STATIC_ASSETS_MAX
+#define STATIC_ASSETS_MAX 64      // files listed in the UI asset manifest
+#endif
+#define STATIC_PATH_MAX 48        // longest URI path, e.g. "/js/vendor/GLTFExporter.js"
+#define STATIC_ETAG_MAX 20        // quoted 16-hex-digit tag + NUL
+
+// Manifest written next to /www by scripts/build_www.py, one line per file:
+//   <uri path> TAB <etag> TAB <flags>
+// flags: 'z' = only the gzipped copy (<path>.gz) is stored,
+//        'i' = name is version-pinned, the client may cache it forever
+#define STATIC_MANIFEST_PATH "/www.idx"
+
+#define STATIC_CACHE_IMMUTABLE "public, max-age=31536000, immutable"
+#define STATIC_CACHE_REVALIDATE "no-cache" // may be cached, but ask (cheap 304) every time
+
+struct StaticAsset {
+    char path[STATIC_PATH_MAX];
+    char etag[STATIC_ETAG_MAX];  // with the quotes, as sent in the header
+    bool gzipped;
+    bool immutable;
+};
+
+// MIME type from the file extension
+inline const char* staticContentType(const char* path) {
+    const char* dot = strrchr(path, '.');
+    if (!dot) return "application/octet-stream";
+    static const struct { const char* ext; const char* type; } types[] = {
+        { ".html", "text/html" }, { ".htm", "text/html" }, { ".css", "text/css" },
+        { ".js", "application/javascript" }, { ".mjs", "application/javascript" }, { ".cjs", "application/javascript" },
+        { ".json", "application/json" }, { ".svg", "image/svg+xml" }, { ".png", "image/png" },
+        { ".jpg", "image/jpeg" }, { ".ico", "image/x-icon" }, { ".txt", "text/plain" },
+    };
+    for (size_t i = 0; i < sizeof(types) / sizeof(types[0]); ++i) {
+        if (strcasecmp(dot, types[i].ext) == 0) return types[i].type;
+    }
+    return "application/octet-stream";
+}
+
+// True unless Accept-Encoding leaves gzip out or refuses it with q=0
+inline bool staticAcceptsGzip(const char* acceptEncoding) {
+    if (!acceptEncoding) return false;
+    const char* p = acceptEncoding;
+    while (*p) {
+        while (*p == ' ' || *p == ',') p++;
+        const char* tok = p;
+        while (*p && *p != ',' && *p != ';' && *p != ' ') p++;
+        size_t n = p - tok;
+        bool isGzip = (n == 4 && strncasecmp(tok, "gzip", 4) == 0) || (n == 1 && *tok == '*');
+        float q = 1.0f;
+        while (*p && *p != ',') {
+            if (*p == 'q' && p[1] == '=') { q = (float)atof(p + 2); }
+            p++;
+        }
+        if (isGzip) return q > 0.0f;
+    }
+    return false;
+}
+
+// If-None-Match check: a list of tags or "*"; weak tags (W/"..") compare
+// by their opaque part, as RFC 9110 requires for If-None-Match
+inline bool staticEtagMatches(const char* ifNoneMatch, const char* etag) {
+    if (!ifNoneMatch || !etag || !*etag) return false;
+    size_t etagLen = strlen(etag);
+    const char* p = ifNoneMatch;
+    while (*p) {
+        while (*p == ' ' || *p == ',') p++;
+        if (*p == '*') return true;
+        if (p[0] == 'W' && p[1] == '/') p += 2;
+        const char* tok = p;
+        if (*p == '"') { p++; while (*p && *p != '"') p++; if (*p) p++; }
+        else { while (*p && *p != ',' && *p != ' ') p++; }
+        if ((size_t)(p - tok) == etagLen && strncmp(tok, etag, etagLen) == 0) return true;
+        while (*p && *p != ',') p++;
+    }
+    return false;
+}
+
+// Asset manifest loaded once at boot; lookups are by exact URI path
+class StaticAssetIndex {
+private:
+    StaticAsset assets[STATIC_ASSETS_MAX];
+    int count;
+
+public:
+    StaticAssetIndex() : count(0) {}
+
+    void clear() { count = 0; }
+    int size() const { return count; }
+
+    // Add one manifest line (trailing CR/LF ignored). Returns false for
+    // malformed lines, over-long paths or a full table.
+    bool parseLine(const char* line) {
+        if (count >= STATIC_ASSETS_MAX || line[0] != '/') return false;
+        const char* tab1 = strchr(line, '\t');
+        if (!tab1 || (size_t)(tab1 - line) >= STATIC_PATH_MAX) return false;
+        const char* tag = tab1 + 1;
+        const char* tab2 = strchr(tag, '\t');
+        size_t tagLen = tab2 ? (size_t)(tab2 - tag) : strcspn(tag, "\r\n");
+        if (tagLen == 0 || tagLen + 3 > STATIC_ETAG_MAX) return false;
+
+        StaticAsset& a = assets[count];
+        memcpy(a.path, line, tab1 - line);
+        a.path[tab1 - line] = '\0';
+        a.etag[0] = '"';
+        memcpy(a.etag + 1, tag, tagLen);
+        a.etag[tagLen + 1] = '"';
+        a.etag[tagLen + 2] = '\0';
+        a.gzipped = a.immutable = false;
+        for (const char* f = tab2 ? tab2 + 1 : ""; *f && *f != '\r' && *f != '\n'; ++f) {
+            if (*f == 'z') a.gzipped = true;
+            else if (*f == 'i') a.immutable = true;
+        }
+        count++;
+        return true;
+    }
+
+    const StaticAsset* find(const char* path) const {
+        for (int i = 0; i < count; ++i) if (strcmp(assets[i].path, path) == 0) return &assets[i];
+        return nullptr;
+    }
+};
+
+inline const char* staticCacheControl(const StaticAsset& a) {
+    return a.immutable ? STATIC_CACHE_IMMUTABLE : STATIC_CACHE_REVALIDATE;
+}
+
+#endif
@@ -0,0 +1,139 @@
+#ifndef UPLOAD_SESSION_H
+#define UPLOAD_SESSION_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#ifndef UPLOAD_WRITE_BUF
+#define UPLOAD_WRITE_BUF 8192   // two LittleFS blocks / a whole number of SD sectors
+#endif
+// Space kept free on top of the upload itself (filesystem metadata, the
+// index record, the old copy of a file being replaced)
+#define UPLOAD_FREE_MARGIN (2 * 4096)
+
+// zlib-compatible running CRC-32: start with 0, feed chunks in order
+inline uint32_t uploadCrc32Update(uint32_t crc, const uint8_t* p, size_t n) {
+    static const uint32_t nibble[16] = {
+        0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+        0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C,
+    };
+    crc = ~crc;
+    while (n--) {
+        crc ^= *p++;
+        crc = nibble[crc & 0x0F] ^ (crc >> 4);
+        crc = nibble[crc & 0x0F] ^ (crc >> 4);
+    }
+    return ~crc;
+}
+
+// Collects small incoming chunks (the WebServer hands out ~1.4 KB at a
+// time) and passes them on in full UPLOAD_WRITE_BUF blocks, so the
+// filesystem sees large writes at block-aligned offsets. Sink needs
+// size_t write(const uint8_t*, size_t). After a short write (storage
+// full) everything further is refused.
+template <class Sink>
+class BufferedWriter {
+private:
+    Sink* sink;
+    uint8_t buf[UPLOAD_WRITE_BUF] __attribute__((aligned(4)));
+    size_t len;
+    uint32_t total;   // bytes that reached the sink
+    bool failed;
+
+public:
+    BufferedWriter() : sink(nullptr), len(0), total(0), failed(false) {}
+
+    void begin(Sink* s) { sink = s; len = 0; total = 0; failed = false; }
+
+    bool write(const uint8_t* data, size_t n) {
+        while (n > 0 && !failed) {
+            size_t take = UPLOAD_WRITE_BUF - len;
+            if (take > n) take = n;
+            memcpy(buf + len, data, take);
+            len += take; data += take; n -= take;
+            if (len == UPLOAD_WRITE_BUF) flush();
+        }
+        return !failed;
+    }
+
+    bool flush() {
+        if (failed || len == 0 || !sink) return !failed;
+        size_t w = sink->write(buf, len);
+        total += w;
+        if (w != len) failed = true;
+        len = 0;
+        return !failed;
+    }
+
+    bool ok() const { return !failed; }
+    uint32_t written() const { return total; }
+};
+
+// Upload file names become a single path component: leading slashes are
+// dropped; empty names, "..", further slashes and control characters are
+// refused. Returns false if the name can't be used.
+inline bool uploadSanitizeName(const char* in, char* out, size_t cap) {
+    while (*in == '/') in++;
+    size_t n = strlen(in);
+    if (n == 0 || n >= cap) return false;
+    if (strcmp(in, ".") == 0 || strcmp(in, "..") == 0) return false;
+    for (size_t i = 0; i < n; ++i) {
+        unsigned char c = (unsigned char)in[i];
+        if (c < 0x20 || c == 0x7F || c == '/' || c == '\\') return false;
+    }
+    // Dot-files are the index and in-progress uploads
+    if (in[0] == '.') return false;
+    memcpy(out, in, n + 1);
+    return true;
+}
+
+// --- Chunked upload sessions ---
+// A client opens a session with the file's name and size, PUTs the file in
+// chunks at explicit offsets (each with its CRC-32) and commits. Chunks are
+// appended strictly in order; after a dropped connection the client asks
+// for the session's offset and carries on from there.
+#ifndef UPLOAD_SESSION_MAX
+#define UPLOAD_SESSION_MAX 2
+#endif
+#define UPLOAD_CHUNK_SIZE (64 * 1024)      // suggested to clients
+#define UPLOAD_CHUNK_MAX (1024 * 1024)
+#define UPLOAD_SESSION_IDLE_MS (15 * 60 * 1000UL) // then the partial file is dropped
+
+enum UploadChunkVerdict {
+    UPLOAD_CHUNK_APPEND,     // next chunk: write it
+    UPLOAD_CHUNK_DUPLICATE,  // already stored (the reply was lost): acknowledge, don't write
+    UPLOAD_CHUNK_CONFLICT,   // gap or overlap with the end: client must resync (409)
+    UPLOAD_CHUNK_TOO_LARGE,  // over UPLOAD_CHUNK_MAX or past the declared size (413)
+};
+
+// Decide what to do with `len` bytes at `offset` when `received` bytes of a
+// `size`-byte file are stored
+inline UploadChunkVerdict uploadChunkCheck(uint32_t received, uint32_t size, uint32_t offset, uint32_t len) {
+    if (len > UPLOAD_CHUNK_MAX || (uint64_t)offset + len > size) return UPLOAD_CHUNK_TOO_LARGE;
+    if (offset == received) return UPLOAD_CHUNK_APPEND;
+    if ((uint64_t)offset + len <= received) return UPLOAD_CHUNK_DUPLICATE;
+    return UPLOAD_CHUNK_CONFLICT;
+}
+
+// Parse 8 hex digits (a CRC-32 as sent by clients); false if malformed
+inline bool uploadParseHex32(const char* s, uint32_t& out) {
+    uint32_t v = 0;
+    int n = 0;
+    for (; s[n]; ++n) {
+        char c = s[n];
+        int d = c >= '0' && c <= '9' ? c - '0' : c >= 'a' && c <= 'f' ? c - 'a' + 10 : c >= 'A' && c <= 'F' ? c - 'A' + 10 : -1;
+        if (d < 0 || n >= 8) return false;
+        v = v << 4 | (uint32_t)d;
+    }
+    if (n == 0) return false;
+    out = v;
+    return true;
+}
+
+// Throughput for the upload response
+inline float uploadMBps(uint32_t bytes, uint32_t us) {
+    return us ? (float)bytes / (float)us : 0.0f; // bytes/us == MB/s
+}
+
+#endif
@@ -15,6 +15,24 @@
 #include "config.h"
 #include "thermal.h"
 #include "pid_controller.h"
+#include "motion.h"
+#include "raster.h"
+#include "spindle.h"
+#include "settings.h"
+#include "boot_timeline.h"
+#include "wifi_manager.h"
+#include "latency_stats.h"
+#include "static_assets.h"
+#include "file_list.h"
+#include "gcode_index.h"
+#include "upload_session.h"
+#include "http_range.h"
+#include "print_stream.h"
+#include "job_queue.h"
+#include "executor_owner.h"
+#include "realtime.h"
+#include "soft_limits.h"
+#include <freertos/semphr.h>
 
 // Forward declarations
 class ThermalManager;
@@ -33,10 +51,8 @@ struct RawCommand {
     size_t len;
 };
 
-// Executor owner info is shared from main
-extern volatile uint8_t executorOwnerType;
-extern volatile int executorOwnerId;
-extern volatile bool executorBusy;
+// Executor ownership is shared from main (see executor_owner.h)
+extern ExecutorOwnership executorOwner;
 // (no test-only globals declared here)
 // encoder presence flags (shared)
 extern volatile bool encSeenX;
@@ -50,15 +66,18 @@ extern float countsPerMM_Y;
 extern float countsPerMM_Z;
 extern float countsPerMM_E;
 
-// Global executor spinlock (shared across translation units)
-extern portMUX_TYPE g_executorMux;
-
 extern float pid_kp_x; extern float pid_ki_x; extern float pid_kd_x;
 extern float pid_kp_y; extern float pid_ki_y; extern float pid_kd_y;
 extern float pid_kp_z; extern float pid_ki_z; extern float pid_kd_z;
 extern float pid_kp_e; extern float pid_ki_e; extern float pid_kd_e;
 
 extern int maxFeedrateX; extern int maxFeedrateY; extern int maxFeedrateZ; extern int maxFeedrateE;
+extern float maxAccelX; extern float maxAccelY; extern float maxAccelZ; extern float maxAccelE;
+extern float maxJerkX; extern float maxJerkY; extern float maxJerkZ; extern float maxJerkE;
+extern float arcTolerance; // G2/G3 chord tolerance (mm)
+extern TravelEnvelope travelEnvelope; // soft limits (from the softLimits.* settings)
+extern int softLimitsRequireHomed;    // moves refused until a G28 has run
+extern volatile bool machineHomed;
 
 // Run controls (pause/play/stop and speed multiplier)
 extern volatile bool runPaused;
@@ -68,7 +87,29 @@ extern volatile float runSpeedMultiplier; // derived from percent
 
 // Spindle / Laser runtime state
 extern volatile int spindlePower; // 0..255
+extern SpindleRegulator spindle; // spindle setpoint / RPM feedback (defined in main.cpp)
 extern volatile int laserPower; // 0..255
+extern volatile uint8_t laserMode; // LASER_OFF / LASER_CONSTANT / LASER_DYNAMIC / LASER_RASTER
+extern RasterRowPool rasterRows; // row buffers for raster jobs (defined in main.cpp)
+
+// Settings registry (defined in main.cpp, see settings.h)
+extern const SettingDesc settingsTable[];
+extern const int settingsCount;
+extern SettingsFlushSchedule settingsSchedule;
+extern int savedLaserPower; // laser power restored at boot
+void settingsChanged(); // apply + schedule the NVS write
+bool settingsLoad();
+
+// Write into the G-code stream and wake parserTask (defined in main.cpp)
+size_t gcodeStreamWrite(const void* data, size_t len, TickType_t wait);
+
+// Realtime command support (defined in main.cpp)
+void emergencyStop();
+String machineStatusReport();
+
+// Boot stage timestamps (defined in main.cpp)
+extern BootTimeline bootTimeline;
+void bootMark(const char* stage);
 
 // Global instance (defined in main.cpp)
 extern class WebServerManager* webServer;
@@ -76,9 +117,8 @@ extern class WebServerManager* webServer;
 // Expose queues so admin endpoints can clear them if needed
 extern QueueHandle_t motionQueue;
 extern QueueHandle_t commandQueue;
-
-// Reservation state set by web_server when push-time reservation is made
-extern volatile unsigned long executorReservedUntil;
+// Send on motionQueue; every motion command goes through this (main.cpp)
+bool motionSend(const MotionCommand& m, TickType_t wait);
 
 // Job state exported so parser can tag streamed input as job-origin
 extern volatile bool jobActive;
@@ -103,24 +143,57 @@ private:
     DNSServer* dnsServer;
     WiFiServer* telnetServer; // Telnet Server
     WiFiClient telnetClient;  // Single Telnet Client
+    // ws and telnetClient are used from their service tasks and from any
+    // task that broadcasts or replies; recursive because event handlers
+    // running inside ws->loop() reply to their client
+    SemaphoreHandle_t wsLock;
+    SemaphoreHandle_t telnetLock;
     ThermalManager* thermal;
     StreamBufferHandle_t* gcodeStream;
     QueueHandle_t* commandQueue; // Raw commands from clients
     
     bool isAPMode;
     String deviceHostname;
+    // Connection / scan state machine; update() carries out its actions
+    WifiManager wifi;
+    String wifiSsid, wifiPass;
 
     void setupRoutes();
     void handleTelnet(); // Handle Telnet Logic
     void setupFileSystem();
     void setupWiFi();
+    void updateWiFi();
+    void startMDNS();
+    void loadStaticIndex();
+    void startIndexer(); // background G-code metadata indexer
+    bool serveStaticFile(String uri); // false if no such UI file
+    void streamFileList(File& root, bool sd, long offset, long limit, FileSortKey key, bool desc, bool withMeta);
     void handleUpload();
+    void finishUpload();
+    void sendFile(File& f);  // whole file or the requested Range
+    void sendJson(int status, JsonDocument& doc);
+    void sendJsonOk();
+    void sendJsonError(int status, const char* error);
+    void handleJobStart(const String& body);
+    void startJobRunner();
+    void handlePrintStream();
+    void finishPrintStream();
+    // Chunked upload sessions
+    void openUploadSession();
+    void uploadSessionStatus();
+    void handleUploadChunk();
+    void finishUploadChunk();
+    void commitUploadSession();
+    void abortUploadSession();
     void onWebSocketEvent(uint8_t num, WStype_t type, uint8_t * payload, size_t length);
 
 public:
     WebServerManager(ThermalManager* t, StreamBufferHandle_t* stream, QueueHandle_t* cmdQueue);
     void begin();
-    void update();
+    // Protocol service loops, one per task (started by begin())
+    void serviceHttp();
+    void serviceWebSocket();
+    void serviceTelnet();
     // Broadcast encoder positions (mm), temperature, targets and additional diagnostics
     void broadcastStatus(float x, float y, float z, float e,
                          float extTemp, float bedTemp, float extTarget, float bedTarget,
@@ -134,7 +207,15 @@ public:
     void sendTelnet(String message);
     // Returns empty string on success, or 'busy' when the executor is owned by a different client.
     String pushClientCommand(const RawCommand &cmd); // Check ownership and push to queue
+    void handleRealtime(RealtimeCommand c, uint8_t srcType, int srcId); // Act on a realtime command now
+    void stopJob(const String& why); // Stop the running job as /api/job/stop does, and say why
     void sendResponseToClient(uint8_t srcType, int srcId, const String &msg);
+
+    // Per-protocol latency (us). gap = time between service passes, i.e. the
+    // worst wait before a queued request is looked at; service/cmd = time
+    // spent handling it
+    struct ProtocolLatency { LatencyStats gap; LatencyStats service; };
+    ProtocolLatency httpLatency, wsLatency, telnetLatency;
 };
 
 #endif
@@ -0,0 +1,196 @@
+#ifndef WIFI_MANAGER_H
+#define WIFI_MANAGER_H
+
+#include <stdint.h>
+
+#ifndef WIFI_CONNECT_TIMEOUT_MS
+#define WIFI_CONNECT_TIMEOUT_MS 10000 // one association attempt
+#endif
+#ifndef WIFI_BACKOFF_MIN_MS
+#define WIFI_BACKOFF_MIN_MS 2000     // first retry after a drop / failed attempt
+#endif
+#ifndef WIFI_BACKOFF_MAX_MS
+#define WIFI_BACKOFF_MAX_MS 300000   // retries settle at one per 5 minutes
+#endif
+#ifndef WIFI_AP_LINGER_MS
+#define WIFI_AP_LINGER_MS 30000      // keep the setup AP up after joining a network
+#endif
+#ifndef WIFI_SCAN_CACHE_MS
+#define WIFI_SCAN_CACHE_MS 30000     // scan results younger than this are served as-is
+#endif
+
+// What the network task has to do next (see WifiManager::poll)
+enum WifiAction : uint8_t {
+    WIFI_ACT_NONE = 0,
+    WIFI_ACT_BEGIN,      // WiFi.begin() with the stored credentials
+    WIFI_ACT_CONNECTED,  // got an IP: start mDNS, log
+    WIFI_ACT_START_AP,   // bring up the setup AP (+ captive DNS)
+    WIFI_ACT_STOP_AP,    // joined a network: drop the setup AP
+    WIFI_ACT_SCAN        // WiFi.scanNetworks(true)
+};
+
+enum WifiState : uint8_t {
+    WIFI_ST_IDLE = 0,    // no credentials
+    WIFI_ST_CONNECTING,  // association in progress
+    WIFI_ST_CONNECTED,
+    WIFI_ST_BACKOFF      // waiting to retry
+};
+
+enum WifiJobStatus : uint8_t { WIFI_JOB_PENDING = 0, WIFI_JOB_DONE, WIFI_JOB_FAILED, WIFI_JOB_UNKNOWN };
+
+// Event-driven WiFi connection manager. Nothing here blocks: HTTP handlers
+// start a connect or scan and get a job id back, the WiFi event callback
+// reports IP / disconnect through the event flags, and the network task
+// calls poll() every pass and carries out the returned actions.
+//
+// A failed first connection brings up the setup AP; retries continue in
+// the background with exponential backoff, as they do when the station
+// drops later.
+class WifiManager {
+private:
+    WifiState st;
+    bool apUp;
+    bool everConnected;
+    bool beginPending, apStartPending;
+    uint32_t stateSince;
+    uint32_t retryAt;
+    uint32_t backoffMs;
+    bool apStopScheduled;
+    uint32_t apStopAt;
+    // Set from the WiFi event task
+    volatile bool evGotIp, evLost;
+
+    uint32_t nextJob;
+    uint32_t connectJob; WifiJobStatus connectStatus;
+    uint32_t scanJob; WifiJobStatus scanStatus;
+    bool scanPending, scanRunning;
+    uint32_t scanDoneAt; bool haveScan;
+
+    void startAttempt(uint32_t now) {
+        st = WIFI_ST_CONNECTING;
+        stateSince = now;
+        evGotIp = evLost = false;
+        beginPending = true;
+    }
+
+    void scheduleRetry(uint32_t now) {
+        st = WIFI_ST_BACKOFF;
+        stateSince = now;
+        retryAt = now + backoffMs;
+        backoffMs = backoffMs >= WIFI_BACKOFF_MAX_MS / 2 ? WIFI_BACKOFF_MAX_MS : backoffMs * 2;
+    }
+
+public:
+    WifiManager() : st(WIFI_ST_IDLE), apUp(false), everConnected(false), beginPending(false), apStartPending(false),
+                    stateSince(0), retryAt(0), backoffMs(WIFI_BACKOFF_MIN_MS), apStopScheduled(false), apStopAt(0),
+                    evGotIp(false), evLost(false), nextJob(1), connectJob(0), connectStatus(WIFI_JOB_UNKNOWN),
+                    scanJob(0), scanStatus(WIFI_JOB_UNKNOWN), scanPending(false), scanRunning(false), scanDoneAt(0),
+                    haveScan(false) {}
+
+    // Start connecting with (new) credentials; returns the job id to poll.
+    // Any earlier connect job is superseded.
+    uint32_t connect(uint32_t now) {
+        connectJob = nextJob++;
+        connectStatus = WIFI_JOB_PENDING;
+        backoffMs = WIFI_BACKOFF_MIN_MS;
+        apStopScheduled = false;
+        startAttempt(now);
+        return connectJob;
+    }
+
+    // No credentials stored: setup AP only
+    void startApOnly() { st = WIFI_ST_IDLE; if (!apUp) apStartPending = true; }
+
+    // Scan, unless results younger than WIFI_SCAN_CACHE_MS exist (force skips
+    // the cache). Returns the scan job id; a running scan is shared.
+    uint32_t scan(uint32_t now, bool force) {
+        if (scanPending || scanRunning) return scanJob;
+        scanJob = nextJob++;
+        if (!force && haveScan && now - scanDoneAt < WIFI_SCAN_CACHE_MS) { scanStatus = WIFI_JOB_DONE; return scanJob; }
+        scanStatus = WIFI_JOB_PENDING;
+        scanPending = true;
+        return scanJob;
+    }
+    // Called by the network task when WiFi.scanComplete() reports a result
+    void scanFinished(uint32_t now, bool ok) {
+        scanRunning = false;
+        scanStatus = ok ? WIFI_JOB_DONE : WIFI_JOB_FAILED;
+        if (ok) { haveScan = true; scanDoneAt = now; }
+    }
+    bool scanning() const { return scanPending || scanRunning; }
+    bool scanStarted() const { return scanRunning; } // WIFI_ACT_SCAN issued, result outstanding
+    bool hasScanResults() const { return haveScan; }
+    uint32_t scanAgeMs(uint32_t now) const { return haveScan ? now - scanDoneAt : 0; }
+
+    // WiFi event callbacks (any task)
+    void onGotIp() { evGotIp = true; }
+    void onDisconnected() { evLost = true; }
+
+    // Advance the state machine; call until it returns WIFI_ACT_NONE
+    WifiAction poll(uint32_t now) {
+        if (apStartPending) { apStartPending = false; apUp = true; return WIFI_ACT_START_AP; }
+        if (beginPending) { beginPending = false; return WIFI_ACT_BEGIN; }
+
+        switch (st) {
+        case WIFI_ST_CONNECTING:
+            if (evGotIp) {
+                evGotIp = evLost = false;
+                st = WIFI_ST_CONNECTED;
+                stateSince = now;
+                everConnected = true;
+                backoffMs = WIFI_BACKOFF_MIN_MS;
+                if (connectStatus == WIFI_JOB_PENDING) connectStatus = WIFI_JOB_DONE;
+                // Leave the setup AP up long enough for its client to read the new IP
+                if (apUp) { apStopScheduled = true; apStopAt = now + WIFI_AP_LINGER_MS; }
+                return WIFI_ACT_CONNECTED;
+            }
+            if (now - stateSince >= WIFI_CONNECT_TIMEOUT_MS) {
+                if (connectStatus == WIFI_JOB_PENDING) connectStatus = WIFI_JOB_FAILED;
+                scheduleRetry(now);
+                // Never reached a network since boot: make the device reachable
+                if (!everConnected && !apUp) { apUp = true; return WIFI_ACT_START_AP; }
+            }
+            break;
+        case WIFI_ST_CONNECTED:
+            if (evLost) {
+                evLost = false;
+                scheduleRetry(now);
+                break;
+            }
+            if (apUp && apStopScheduled && (int32_t)(now - apStopAt) >= 0) {
+                apUp = false;
+                apStopScheduled = false;
+                return WIFI_ACT_STOP_AP;
+            }
+            break;
+        case WIFI_ST_BACKOFF:
+            if (evGotIp) {
+                // Driver auto-reconnect beat us to it
+                st = WIFI_ST_CONNECTING;
+                return poll(now);
+            }
+            if ((int32_t)(now - retryAt) >= 0) { startAttempt(now); return poll(now); }
+            break;
+        default:
+            break;
+        }
+
+        // Scans hop channels; don't start one in the middle of an association
+        if (scanPending && st != WIFI_ST_CONNECTING) { scanPending = false; scanRunning = true; return WIFI_ACT_SCAN; }
+        return WIFI_ACT_NONE;
+    }
+
+    WifiState state() const { return st; }
+    bool apActive() const { return apUp; }
+    uint32_t retryInMs(uint32_t now) const { return st == WIFI_ST_BACKOFF && (int32_t)(retryAt - now) > 0 ? retryAt - now : 0; }
+
+    // Status of a job returned by connect() or scan()
+    WifiJobStatus job(uint32_t id) const {
+        if (id && id == connectJob) return connectStatus;
+        if (id && id == scanJob) return scanStatus;
+        return WIFI_JOB_UNKNOWN;
+    }
+    bool isScanJob(uint32_t id) const { return id && id == scanJob; }
+};
+
+#endif
@@ -0,0 +1,100 @@
+#!/usr/bin/env python3
+"""Stage data/www for the LittleFS image with gzip precompression.
+
+Text assets (html/js/css/json/svg) are stored only as <name>.gz when that
+saves space; everything else is copied as-is. A manifest (www.idx at the
+image root) lists every file with a strong ETag and flags the firmware
+uses to pick Content-Encoding and Cache-Control:
+
+    <uri path> TAB <etag> TAB <flags>     flags: z = gzipped, i = immutable
+
+Runs automatically before `pio run -t buildfs/uploadfs` (extra_scripts in
+platformio.ini) and can be run by hand:
+
+    python3 scripts/build_www.py [src_dir] [out_dir]
+"""
+import fnmatch
+import gzip
+import hashlib
+import os
+import shutil
+import sys
+
+SRC = "data"
+OUT = os.path.join(".pio", "www")
+MANIFEST = "www.idx"
+
+COMPRESS_EXT = {".html", ".htm", ".js", ".mjs", ".cjs", ".css", ".json", ".svg", ".txt"}
+MIN_COMPRESS = 512  # smaller files aren't worth the decode on the client
+# Version-pinned names: safe to cache forever
+IMMUTABLE = ["js/vendor/*", "js/three.r*.min.js"]
+PATH_MAX = 47  # STATIC_PATH_MAX - 1 in include/static_assets.h
+
+
+def up_to_date(www, out_root):
+    try:
+        built = os.path.getmtime(os.path.join(out_root, MANIFEST))
+    except OSError:
+        return False
+    for dirpath, _, files in os.walk(www):
+        # a deleted file only shows up as a newer directory mtime
+        if os.path.getmtime(dirpath) > built:
+            return False
+        if any(os.path.getmtime(os.path.join(dirpath, n)) > built for n in files):
+            return False
+    return True
+
+
+def stage(src_root, out_root):
+    www = os.path.join(src_root, "www")
+    if up_to_date(www, out_root):
+        return
+    if os.path.isdir(out_root):
+        shutil.rmtree(out_root)
+    os.makedirs(out_root)
+
+    entries = []
+    before = after = 0
+    for dirpath, _, files in os.walk(www):
+        for name in sorted(files):
+            src = os.path.join(dirpath, name)
+            rel = os.path.relpath(src, www).replace(os.sep, "/")
+            uri = "/" + rel
+            if len(uri) > PATH_MAX:
+                sys.exit("build_www: path too long for the firmware index: " + uri)
+            with open(src, "rb") as f:
+                data = f.read()
+
+            flags = ""
+            stored, dest = data, os.path.join(out_root, "www", rel)
+            if os.path.splitext(name)[1].lower() in COMPRESS_EXT and len(data) >= MIN_COMPRESS:
+                # mtime=0 keeps the output (and so the ETag) reproducible
+                packed = gzip.compress(data, compresslevel=9, mtime=0)
+                if len(packed) < len(data) * 0.9:
+                    stored, dest = packed, dest + ".gz"
+                    flags += "z"
+            if any(fnmatch.fnmatch(rel, p) for p in IMMUTABLE):
+                flags += "i"
+
+            os.makedirs(os.path.dirname(dest), exist_ok=True)
+            with open(dest, "wb") as f:
+                f.write(stored)
+            entries.append((uri, hashlib.sha1(stored).hexdigest()[:16], flags))
+            before += len(data)
+            after += len(stored)
+
+    with open(os.path.join(out_root, MANIFEST), "w", newline="\n") as f:
+        for uri, tag, flags in sorted(entries):
+            f.write("%s\t%s\t%s\n" % (uri, tag, flags))
+
+    print("build_www: %d files, %d -> %d bytes (%.0f%%)" %
+          (len(entries), before, after, 100.0 * after / before if before else 0))
+
+
+try:
+    Import("env")  # noqa: F821 (running under PlatformIO/SCons)
+    stage(os.path.join(env.subst("$PROJECT_DIR"), SRC),  # noqa: F821
+          os.path.join(env.subst("$PROJECT_DIR"), OUT))  # noqa: F821
+except NameError:
+    if __name__ == "__main__":
+        stage(sys.argv[1] if len(sys.argv) > 1 else SRC, sys.argv[2] if len(sys.argv) > 2 else OUT)
@@ -1,5 +1,6 @@
 #include <Arduino.h>
 #include <math.h>
+#include <atomic>
 #include <freertos/FreeRTOS.h>
 #include <freertos/stream_buffer.h>
 #include <freertos/queue.h>
@@ -8,6 +9,21 @@
 #include "pid_controller.h"
 #include "thermal.h"
 #include "web_server.h"
+#include "kinematics.h"
+#include "arc.h"
+#include "scurve.h"
+#include "feed_hold.h"
+#include "soft_limits.h"
+#include "motion.h"
+#include "raster.h"
+#include "spindle.h"
+#include "settings.h"
+#include "boot_timeline.h"
+#include "line_assembler.h"
+#include "esp_timer.h"
+#if PIN_SPINDLE_TACH >= 0
+#include "driver/pcnt.h"
+#endif
 
 // --- GLOBAL OBJECTS ---
 MotorDriver motorX(PIN_X_MOTOR_A, PIN_X_MOTOR_B, PWM_CHAN_X);
@@ -23,15 +39,45 @@ PIDController pidE(KP_DEFAULT, KI_DEFAULT, KD_DEFAULT);
 ThermalManager thermal;
 WebServerManager* webServer = nullptr; // created in networkTask
 
+// Boot stage timestamps (reported by /api/diag/boot)
+BootTimeline bootTimeline;
+void bootMark(const char* stage) { bootTimeline.mark(stage, (uint32_t)esp_timer_get_time()); }
+
 // --- RTOS HANDLES ---
 StreamBufferHandle_t gcodeStream = NULL;
+// Given after every gcodeStream write, so parserTask can block on one queue
+// set covering both commandQueue and the stream
+SemaphoreHandle_t gcodeStreamSignal = NULL;
+QueueSetHandle_t parserInputs = NULL;
+// Client commands a run stop cancelled. commandQueue is in parserInputs, so
+// it can't be reset (the set would keep an entry per dropped command);
+// parserTask receives and discards them instead.
+static volatile UBaseType_t commandsToDrop = 0;
+TaskHandle_t networkTaskHandle = NULL; // woken by Serial receive
+
+// Write to the G-code stream and wake the parser
+size_t gcodeStreamWrite(const void* data, size_t len, TickType_t wait) {
+    size_t sent = xStreamBufferSend(gcodeStream, data, len, wait);
+    if (sent) xSemaphoreGive(gcodeStreamSignal);
+    return sent;
+}
 QueueHandle_t motionQueue = NULL; // MotionCommand queue (Parser -> Control)
 QueueHandle_t commandQueue = NULL; // RawCommand queue (Web/Telnet -> Parser)
+// Motion commands sent but not yet taken into currentPos* by controlTask
+// (or dropped). Unlike the queue length it covers the command controlTask
+// has just received and not applied yet.
+static std::atomic<int> motionInFlight(0);
+
+// Queue a motion command for controlTask, counted in motionInFlight
+bool motionSend(const MotionCommand& m, TickType_t wait) {
+    motionInFlight++;
+    if (xQueueSend(motionQueue, &m, wait) == pdTRUE) return true;
+    motionInFlight--;
+    return false;
+}
 
 // --- EXECUTOR / CLIENT STATE (shared with web_server) ---
-volatile uint8_t executorOwnerType = SRC_SERIAL;
-volatile int executorOwnerId = -1;
-volatile bool executorBusy = false;
+ExecutorOwnership executorOwner;
 
 // Last motor outputs (signed -255..255) for diagnostics
 volatile int motorOutX = 0;
@@ -52,7 +98,7 @@ unsigned long lastEncChangeX = 0, lastEncChangeY = 0, lastEncChangeZ = 0, lastEn
 // Last time we broadcasted position warnings (rate-limit)
 unsigned long lastPosWarnX = 0, lastPosWarnY = 0, lastPosWarnZ = 0, lastPosWarnE = 0;
 
-// Current desired positions (scaled counts)
+// Current desired Cartesian positions (mm scaled by the axis counts per mm)
 long currentPosX = 0, currentPosY = 0, currentPosZ = 0, currentPosE = 0;
 
 // Runtime-configurable parameters (stored in Preferences)
@@ -73,6 +119,114 @@ int maxFeedrateY = MAX_FEEDRATE;
 int maxFeedrateZ = MAX_FEEDRATE;
 int maxFeedrateE = MAX_FEEDRATE;
 
+// Max acceleration (mm/s^2) and jerk (mm/s^3) per axis
+float maxAccelX = DEFAULT_MAX_ACCEL, maxAccelY = DEFAULT_MAX_ACCEL, maxAccelZ = DEFAULT_MAX_ACCEL, maxAccelE = DEFAULT_MAX_ACCEL;
+float maxJerkX = DEFAULT_MAX_JERK, maxJerkY = DEFAULT_MAX_JERK, maxJerkZ = DEFAULT_MAX_JERK, maxJerkE = DEFAULT_MAX_JERK;
+
+// Arc chord tolerance (mm)
+float arcTolerance = ARC_CHORD_TOLERANCE_MM;
+
+// Soft limits (pushed into `travelEnvelope` by settingsApply). With
+// softLimitsRequireHomed, moves are refused until a G28 has set the origin.
+int softLimitsEnabled = SOFT_LIMITS_ENABLED, softLimitsRequireHomed = 0;
+float softLimitMinX = SOFT_LIMIT_X_MIN, softLimitMinY = SOFT_LIMIT_Y_MIN, softLimitMinZ = SOFT_LIMIT_Z_MIN;
+float softLimitMaxX = SOFT_LIMIT_X_MAX, softLimitMaxY = SOFT_LIMIT_Y_MAX, softLimitMaxZ = SOFT_LIMIT_Z_MAX;
+TravelEnvelope travelEnvelope;
+volatile bool machineHomed = false; // a G28 has run since boot (or the last G92 X/Y/Z)
+
+// Spindle regulator settings (pushed into `spindle` by settingsApply)
+float spindleMaxRpm = SPINDLE_MAX_RPM, spindleKp = SPINDLE_KP, spindleKi = SPINDLE_KI;
+
+// Laser power restored at boot (last /api/laser value; 0 after a halt)
+int savedLaserPower = 0;
+
+// Settings registry: the one place a runtime setting is declared. Keys are
+// the NVS keys older firmware used per value (read once for migration).
+const SettingDesc settingsTable[] = {
+    // key        path               type           variable         default                   min     max       persist
+    { "cpm_x",    "countsPerMM.x",   SETTING_FLOAT, &countsPerMM_X,  DEFAULT_COUNTS_PER_MM_X,  0.001f, 1000000.0f, true },
+    { "cpm_y",    "countsPerMM.y",   SETTING_FLOAT, &countsPerMM_Y,  DEFAULT_COUNTS_PER_MM_Y,  0.001f, 1000000.0f, true },
+    { "cpm_z",    "countsPerMM.z",   SETTING_FLOAT, &countsPerMM_Z,  DEFAULT_COUNTS_PER_MM_Z,  0.001f, 1000000.0f, true },
+    { "cpm_e",    "countsPerMM.e",   SETTING_FLOAT, &countsPerMM_E,  DEFAULT_COUNTS_PER_MM_E,  0.001f, 1000000.0f, true },
+    { "pid_kp_x", "pid.x.p",         SETTING_FLOAT, &pid_kp_x,       KP_DEFAULT,               0.0f,   10000.0f, true },
+    { "pid_ki_x", "pid.x.i",         SETTING_FLOAT, &pid_ki_x,       KI_DEFAULT,               0.0f,   10000.0f, true },
+    { "pid_kd_x", "pid.x.d",         SETTING_FLOAT, &pid_kd_x,       KD_DEFAULT,               0.0f,   10000.0f, true },
+    { "pid_kp_y", "pid.y.p",         SETTING_FLOAT, &pid_kp_y,       KP_DEFAULT,               0.0f,   10000.0f, true },
+    { "pid_ki_y", "pid.y.i",         SETTING_FLOAT, &pid_ki_y,       KI_DEFAULT,               0.0f,   10000.0f, true },
+    { "pid_kd_y", "pid.y.d",         SETTING_FLOAT, &pid_kd_y,       KD_DEFAULT,               0.0f,   10000.0f, true },
+    { "pid_kp_z", "pid.z.p",         SETTING_FLOAT, &pid_kp_z,       KP_DEFAULT,               0.0f,   10000.0f, true },
+    { "pid_ki_z", "pid.z.i",         SETTING_FLOAT, &pid_ki_z,       KI_DEFAULT,               0.0f,   10000.0f, true },
+    { "pid_kd_z", "pid.z.d",         SETTING_FLOAT, &pid_kd_z,       KD_DEFAULT,               0.0f,   10000.0f, true },
+    { "pid_kp_e", "pid.e.p",         SETTING_FLOAT, &pid_kp_e,       KP_DEFAULT,               0.0f,   10000.0f, true },
+    { "pid_ki_e", "pid.e.i",         SETTING_FLOAT, &pid_ki_e,       KI_DEFAULT,               0.0f,   10000.0f, true },
+    { "pid_kd_e", "pid.e.d",         SETTING_FLOAT, &pid_kd_e,       KD_DEFAULT,               0.0f,   10000.0f, true },
+    { "maxF_x",   "maxFeedrate.x",   SETTING_INT,   &maxFeedrateX,   MAX_FEEDRATE,             1.0f,   100000.0f, true },
+    { "maxF_y",   "maxFeedrate.y",   SETTING_INT,   &maxFeedrateY,   MAX_FEEDRATE,             1.0f,   100000.0f, true },
+    { "maxF_z",   "maxFeedrate.z",   SETTING_INT,   &maxFeedrateZ,   MAX_FEEDRATE,             1.0f,   100000.0f, true },
+    { "maxF_e",   "maxFeedrate.e",   SETTING_INT,   &maxFeedrateE,   MAX_FEEDRATE,             1.0f,   100000.0f, true },
+    { "maxA_x",   "maxAccel.x",      SETTING_FLOAT, &maxAccelX,      DEFAULT_MAX_ACCEL,        0.001f, 1000000.0f, true },
+    { "maxA_y",   "maxAccel.y",      SETTING_FLOAT, &maxAccelY,      DEFAULT_MAX_ACCEL,        0.001f, 1000000.0f, true },
+    { "maxA_z",   "maxAccel.z",      SETTING_FLOAT, &maxAccelZ,      DEFAULT_MAX_ACCEL,        0.001f, 1000000.0f, true },
+    { "maxA_e",   "maxAccel.e",      SETTING_FLOAT, &maxAccelE,      DEFAULT_MAX_ACCEL,        0.001f, 1000000.0f, true },
+    { "maxJ_x",   "maxJerk.x",       SETTING_FLOAT, &maxJerkX,       DEFAULT_MAX_JERK,         0.001f, 100000000.0f, true },
+    { "maxJ_y",   "maxJerk.y",       SETTING_FLOAT, &maxJerkY,       DEFAULT_MAX_JERK,         0.001f, 100000000.0f, true },
+    { "maxJ_z",   "maxJerk.z",       SETTING_FLOAT, &maxJerkZ,       DEFAULT_MAX_JERK,         0.001f, 100000000.0f, true },
+    { "maxJ_e",   "maxJerk.e",       SETTING_FLOAT, &maxJerkE,       DEFAULT_MAX_JERK,         0.001f, 100000000.0f, true },
+    { "arc_tol",  "arcTolerance",    SETTING_FLOAT, &arcTolerance,   ARC_CHORD_TOLERANCE_MM,   0.0001f, 1.0f,    true },
+    { "sp_max",   "spindle.maxRpm",  SETTING_FLOAT, &spindleMaxRpm,  SPINDLE_MAX_RPM,          1.0f,   100000.0f, true },
+    { "sp_kp",    "spindle.kp",      SETTING_FLOAT, &spindleKp,      SPINDLE_KP,               0.0f,   10.0f,    true },
+    { "sp_ki",    "spindle.ki",      SETTING_FLOAT, &spindleKi,      SPINDLE_KI,               0.0f,   10.0f,    true },
+    { "laser_p",  "laser.power",     SETTING_INT,   &savedLaserPower, 0,                       0.0f,   255.0f,   true },
+    { "sl_on",    "softLimits.enabled",       SETTING_INT,   &softLimitsEnabled,      SOFT_LIMITS_ENABLED, 0.0f, 1.0f, true },
+    { "sl_homed", "softLimits.requireHomed",  SETTING_INT,   &softLimitsRequireHomed, 0,                   0.0f, 1.0f, true },
+    { "sl_xmin",  "softLimits.x.min", SETTING_FLOAT, &softLimitMinX,  SOFT_LIMIT_X_MIN,         -100000.0f, 100000.0f, true },
+    { "sl_xmax",  "softLimits.x.max", SETTING_FLOAT, &softLimitMaxX,  SOFT_LIMIT_X_MAX,         -100000.0f, 100000.0f, true },
+    { "sl_ymin",  "softLimits.y.min", SETTING_FLOAT, &softLimitMinY,  SOFT_LIMIT_Y_MIN,         -100000.0f, 100000.0f, true },
+    { "sl_ymax",  "softLimits.y.max", SETTING_FLOAT, &softLimitMaxY,  SOFT_LIMIT_Y_MAX,         -100000.0f, 100000.0f, true },
+    { "sl_zmin",  "softLimits.z.min", SETTING_FLOAT, &softLimitMinZ,  SOFT_LIMIT_Z_MIN,         -100000.0f, 100000.0f, true },
+    { "sl_zmax",  "softLimits.z.max", SETTING_FLOAT, &softLimitMaxZ,  SOFT_LIMIT_Z_MAX,         -100000.0f, 100000.0f, true },
+};
+const int settingsCount = sizeof(settingsTable) / sizeof(settingsTable[0]);
+SettingsFlushSchedule settingsSchedule;
+
+// Last blob written to (or read from) NVS, to skip identical rewrites.
+// settingsBlobLock covers it and the NVS "cfg" key: settingsTask writes
+// them, settingsLoad (boot and M501 on parserTask) reads them.
+static uint8_t settingsLastBlob[SETTINGS_BLOB_MAX];
+static size_t settingsLastLen = 0;
+static SemaphoreHandle_t settingsBlobLock = NULL;
+
+// Convert a Cartesian position (mm) into motor encoder counts through the
+// configured kinematics. Returns false when the point is unreachable.
+static inline bool cartesianToCounts(const float cart[NUM_AXES], long counts[NUM_AXES]) {
+    const float cpm[NUM_AXES] = { countsPerMM_X, countsPerMM_Y, countsPerMM_Z, countsPerMM_E };
+    float motor[NUM_AXES];
+    if (!MachineKinematics::inverse(cart, motor)) return false;
+    for (int i = 0; i < NUM_AXES; ++i) counts[i] = lroundf(motor[i] * cpm[i]);
+    return true;
+}
+
+// Limit along a path direction (unit vector components, absolute) from
+// per-axis limits: the tightest axis relative to its share of the motion wins.
+// Axes with a non-positive limit are unconstrained; 0 means no limit at all.
+static inline float pathLimit(const float limits[NUM_AXES], const float unit[NUM_AXES]) {
+    float limit = 0.0f;
+    for (int i = 0; i < NUM_AXES; ++i) {
+        if (unit[i] < 1e-6f || limits[i] <= 0.0f) continue;
+        float l = limits[i] / unit[i];
+        if (limit == 0.0f || l < limit) limit = l;
+    }
+    return limit;
+}
+
+// Convert motor encoder counts back into a Cartesian position (mm)
+static inline bool countsToCartesian(const long counts[NUM_AXES], float cart[NUM_AXES]) {
+    const float cpm[NUM_AXES] = { countsPerMM_X, countsPerMM_Y, countsPerMM_Z, countsPerMM_E };
+    float motor[NUM_AXES];
+    for (int i = 0; i < NUM_AXES; ++i) motor[i] = counts[i] / cpm[i];
+    return MachineKinematics::forward(motor, cart);
+}
+
 // Positioning mode
 bool absolutePositioning = false; // Default to relative (G91) for simple jogs
 
@@ -80,20 +234,104 @@ bool absolutePositioning = false; // Default to relative (G91) for simple jogs
 volatile bool isHalted = false;
 String haltReason = "";
 
+// Push settings that live inside controller objects
+void settingsApply() {
+    pidX.setTunings(pid_kp_x, pid_ki_x, pid_kd_x);
+    pidY.setTunings(pid_kp_y, pid_ki_y, pid_kd_y);
+    pidZ.setTunings(pid_kp_z, pid_ki_z, pid_kd_z);
+    pidE.setTunings(pid_kp_e, pid_ki_e, pid_kd_e);
+    spindle.setMaxRpm(spindleMaxRpm);
+    spindle.setTunings(spindleKp, spindleKi);
+    const float mins[3] = { softLimitMinX, softLimitMinY, softLimitMinZ };
+    const float maxs[3] = { softLimitMaxX, softLimitMaxY, softLimitMaxZ };
+    travelEnvelope.configure(softLimitsEnabled != 0, mins, maxs);
+}
+
+// Call after changing any setting: applies it and schedules the NVS write
+void settingsChanged() {
+    settingsApply();
+    settingsSchedule.markDirty(millis());
+}
+
+// Load all settings with a single NVS blob read. Without a blob (first boot
+// after upgrading) the old per-key values are migrated and a blob is
+// scheduled. Returns false if a stored blob was corrupt.
+bool settingsLoad() {
+    xSemaphoreTake(settingsBlobLock, portMAX_DELAY);
+    Preferences prefs;
+    prefs.begin("cnc", true);
+    size_t len = prefs.getBytesLength("cfg");
+    bool ok = true;
+    if (len > 0 && len <= sizeof(settingsLastBlob)) {
+        // Read aside; only a blob that decodes becomes the "last written" copy
+        static uint8_t blob[SETTINGS_BLOB_MAX];
+        prefs.getBytes("cfg", blob, len);
+        SettingsImportResult r = settingsDecode(settingsTable, settingsCount, blob, len, true);
+        if (r.valid) {
+            memcpy(settingsLastBlob, blob, len);
+            settingsLastLen = len;
+            Serial.printf("Settings: loaded %d from NVS blob (%d rejected, %d unknown)\n", r.applied, r.rejected, r.unknown);
+        } else {
+            ok = false;
+            Serial.println("Settings: NVS blob corrupt, using defaults");
+        }
+    } else {
+        int migrated = 0;
+        for (int i = 0; i < settingsCount; ++i) {
+            const SettingDesc &d = settingsTable[i];
+            if (!d.persist || !prefs.isKey(d.key)) continue;
+            float v = d.type == SETTING_INT ? (float)prefs.getInt(d.key, 0) : prefs.getFloat(d.key, d.def);
+            if (settingSet(d, v)) migrated++;
+        }
+        if (migrated) {
+            Serial.printf("Settings: migrated %d per-key values\n", migrated);
+            settingsSchedule.requestFlush(millis());
+        }
+    }
+    prefs.end();
+    xSemaphoreGive(settingsBlobLock);
+    settingsApply();
+    return ok;
+}
+
+// Background NVS writer: the whole registry as one blob, debounced and
+// skipped when identical to what NVS already holds
+void settingsTask(void *pvParameters) {
+    static uint8_t blob[SETTINGS_BLOB_MAX];
+    while (true) {
+        if (settingsSchedule.take(millis())) {
+            xSemaphoreTake(settingsBlobLock, portMAX_DELAY);
+            size_t len = settingsEncode(settingsTable, settingsCount, blob, sizeof(blob));
+            if (len && !(len == settingsLastLen && memcmp(blob, settingsLastBlob, len) == 0)) {
+                Preferences prefs;
+                bool ok = prefs.begin("cnc", false) && prefs.putBytes("cfg", blob, len) == len;
+                prefs.end();
+                if (ok) {
+                    memcpy(settingsLastBlob, blob, len);
+                    settingsLastLen = len;
+                    Serial.printf("Settings: wrote %u byte blob to NVS\n", (unsigned)len);
+                } else {
+                    settingsSchedule.markFailed(millis());
+                }
+            }
+            xSemaphoreGive(settingsBlobLock);
+        }
+        vTaskDelay(100 / portTICK_PERIOD_MS);
+    }
+}
+
 // Helper: disable spindle and laser immediately and persist state
 void disableSpindleAndLaser() {
     // Turn off hardware outputs if present
     if (PIN_SPINDLE >= 0) ledcWrite(PWM_CHAN_SPINDLE, 0);
     if (PIN_LASER >= 0) ledcWrite(PWM_CHAN_LASER, 0);
     // Update runtime globals
+    spindle.setTarget(0);
     spindlePower = 0;
     laserPower = 0;
-    // Persist to Preferences
-    Preferences prefs;
-    prefs.begin("cnc", false);
-    prefs.putInt("spindle_p", 0);
-    prefs.putInt("laser_p", 0);
-    prefs.end();
+    laserMode = LASER_OFF;
+    // Persist (settingsTask writes the blob; nothing to do once it is 0)
+    if (savedLaserPower != 0) { savedLaserPower = 0; settingsSchedule.markDirty(millis()); }
     // Notify connected clients
     if (webServer) {
         webServer->broadcastWarning(String("Spindle and laser disabled: ") + haltReason);
@@ -105,10 +343,39 @@ volatile bool runPaused = false;
 volatile bool runStopped = false;
 volatile int runSpeedPercent = 100; // percent (5 - 500)
 volatile float runSpeedMultiplier = 1.0f; // = runSpeedPercent / 100.0
+static volatile bool moveInProgress = false; // controlTask is executing a command
+
+// Realtime E-stop (M112 picked out by a transport): halt now instead of
+// when the command reaches the front of motionQueue. controlTask leaves the
+// current move on its next tick and drops everything queued.
+void emergencyStop() {
+    haltReason = "Emergency Stop (M112)";
+    isHalted = true;
+    disableSpindleAndLaser();
+}
+
+// One-line state report for the '?' realtime command, laid out like GRBL's:
+// <state|MPos:x,y,z|E:e|Q:queued moves|Ov:speed %>
+String machineStatusReport() {
+    UBaseType_t queued = motionQueue ? uxQueueMessagesWaiting(motionQueue) : 0;
+    const char* state = isHalted ? "Alarm" : runPaused ? "Hold" : (moveInProgress || queued) ? "Run" : "Idle";
+    long enc[NUM_AXES] = { encX, encY, encZ, encE };
+    float mm[NUM_AXES];
+    countsToCartesian(enc, mm);
+    char buf[128];
+    snprintf(buf, sizeof(buf), "<%s|MPos:%.3f,%.3f,%.3f|E:%.3f|Q:%u|Ov:%d>", state,
+             mm[AXIS_X], mm[AXIS_Y], mm[AXIS_Z], mm[AXIS_E], (unsigned)queued, (int)runSpeedPercent);
+    return String(buf);
+}
 
 // Spindle / Laser runtime globals (0..255)
-volatile int spindlePower = 0;
+volatile int spindlePower = 0; // spindle PWM currently output
+SpindleRegulator spindle;      // RPM setpoint / feedback (spindleTask)
 volatile int laserPower = 0;
+volatile uint8_t laserMode = LASER_OFF; // mode of the executing motion (M3/M4/M5, raster)
+
+// Row buffers for raster jobs (filled by the raster streamer, released here)
+RasterRowPool rasterRows;
 
 // Encoder presence flags - set when we observe any encoder edges
 volatile bool encSeenX = false;
@@ -139,21 +406,30 @@ void networkTask(void *pvParameters) {
     webServer = new WebServerManager(&thermal, &gcodeStream, &commandQueue);
     webServer->begin();
 
+    // Serial bytes wake this task at once instead of waiting for the next poll
+    networkTaskHandle = xTaskGetCurrentTaskHandle();
+    Serial.onReceive([]() { if (networkTaskHandle) xTaskNotifyGive(networkTaskHandle); });
+
     char buffer[64];
     while (true) {
-        // Handle Web Server & WebSockets
-        webServer->update();
+        // HTTP, WebSocket and telnet are serviced by their own tasks
+        // (started by begin()); this loop only broadcasts and reads Serial
 
         // Broadcast status and/or errors periodically
         static unsigned long lastStatus = 0;
         if (millis() - lastStatus > 100) {
+            // Lapsed leases are only noticed lazily; free them for good here
+            if (executorOwner.expire(millis())) Serial.println("Executor lease expired -> released");
             if (isHalted) {
                 // Ensure spindle/laser are disabled on halt
                 disableSpindleAndLaser();
                 webServer->broadcastError(haltReason);
             } else {
-                // Send encoder positions (converted to mm), setpoints (mm), and last movement ages
-                float encXm = encX / countsPerMM_X; float encYm = encY / countsPerMM_Y; float encZm = encZ / countsPerMM_Z; float encEm = encE / countsPerMM_E;
+                // Send encoder positions (converted to Cartesian mm), setpoints (mm), and last movement ages
+                long encNow[NUM_AXES] = { encX, encY, encZ, encE };
+                float encCart[NUM_AXES];
+                countsToCartesian(encNow, encCart);
+                float encXm = encCart[AXIS_X]; float encYm = encCart[AXIS_Y]; float encZm = encCart[AXIS_Z]; float encEm = encCart[AXIS_E];
                 float setXm = currentPosX / countsPerMM_X; float setYm = currentPosY / countsPerMM_Y; float setZm = currentPosZ / countsPerMM_Z; float setEm = currentPosE / countsPerMM_E;
                 unsigned long now = millis();
                 unsigned long lmX = now - lastEncChangeX;
@@ -175,56 +451,200 @@ void networkTask(void *pvParameters) {
             lastStatus = millis();
         }
 
-        // Serial Input (Legacy)
-        if (Serial.available()) {
-            int len = Serial.readBytesUntil('\n', buffer, 63);
-            buffer[len] = '\0';
-            xStreamBufferSend(gcodeStream, buffer, len + 1, 0);
+        // Serial Input (Legacy): forward raw bytes, parserTask reassembles lines
+        int avail;
+        while ((avail = Serial.available()) > 0) {
+            size_t n = Serial.readBytes(buffer, min((size_t)avail, sizeof(buffer)));
+            if (n == 0 || gcodeStreamWrite(buffer, n, pdMS_TO_TICKS(50)) < n) break;
         }
 
-        vTaskDelay(10 / portTICK_PERIOD_MS);
+        // Sleep until Serial data arrives or the next status broadcast is due
+        unsigned long sinceStatus = millis() - lastStatus;
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(sinceStatus < 100 ? 101 - sinceStatus : 1));
     }
 
 }
 
 void thermalTask(void *pvParameters) {
+    // Ready once the first readings are in
+    thermal.update();
+    bootMark(BOOT_THERMAL_READY);
     while (true) {
-        thermal.update();
         vTaskDelay(100 / portTICK_PERIOD_MS); // 10Hz
+        thermal.update();
     }
 }
 
-// Core 1: Motion Control
-struct MotionCommand {
-    float targetXmm, targetYmm, targetZmm, targetEmm;
-    bool hasX, hasY, hasZ, hasE; // which axes were specified
-    bool isRelative;
-    bool isHoming;
-    bool isEmergency; // M112
-    uint8_t ownerType; // SRC_*
-    int ownerId;
-    float feedrate; // mm/min (0 == unspecified / full)
-};
+#if PIN_SPINDLE_TACH >= 0
+// Tachometer pulses are counted in hardware (PCNT) and sampled by spindleTask
+static void spindleTachBegin() {
+    pcnt_config_t c = {};
+    c.pulse_gpio_num = PIN_SPINDLE_TACH;
+    c.ctrl_gpio_num = PCNT_PIN_NOT_USED;
+    c.lctrl_mode = PCNT_MODE_KEEP; c.hctrl_mode = PCNT_MODE_KEEP;
+    c.pos_mode = PCNT_COUNT_INC; c.neg_mode = PCNT_COUNT_DIS;
+    c.counter_h_lim = 32767; c.counter_l_lim = 0;
+    c.unit = PCNT_UNIT_0; c.channel = PCNT_CHANNEL_0;
+    pcnt_unit_config(&c);
+    pcnt_set_filter_value(PCNT_UNIT_0, 1000); // ignore glitches < 12.5 us
+    pcnt_filter_enable(PCNT_UNIT_0);
+    pcnt_counter_clear(PCNT_UNIT_0);
+    pcnt_counter_resume(PCNT_UNIT_0);
+}
+
+// Pulses since the previous call (the counter wraps to 0 at its high limit)
+static int32_t spindleTachRead() {
+    static int16_t last = 0;
+    int16_t now = 0;
+    pcnt_get_counter_value(PCNT_UNIT_0, &now);
+    int32_t d = (int32_t)now - last;
+    if (d < 0) d += 32767;
+    last = now;
+    return d;
+}
+#endif
+
+// Spindle regulator (50 Hz): RPM feedback, PWM output and stall detection
+void spindleTask(void *pvParameters) {
+    SpindleTach tach;
+    int lastPwm = -1;
+    TickType_t xLastWakeTime = xTaskGetTickCount();
+    const uint32_t periodMs = 20;
+    while (true) {
+        float rpm = 0.0f;
+#if PIN_SPINDLE_TACH >= 0
+        rpm = tach.add(spindleTachRead(), periodMs);
+#endif
+        int pwm = isHalted ? 0 : spindle.update(rpm, periodMs);
+        if (pwm != lastPwm) {
+            ledcWrite(PWM_CHAN_SPINDLE, pwm);
+            lastPwm = pwm;
+        }
+        spindlePower = pwm;
+        if (spindle.stalled() && !isHalted) {
+            haltReason = spindle.atSpeed() ? "Spindle stall" : "Spindle did not reach speed";
+            isHalted = true;
+            Serial.printf("%s (target %.0f RPM, measured %.0f RPM)\n", haltReason.c_str(), spindle.getTarget(), rpm);
+        }
+        vTaskDelayUntil(&xLastWakeTime, pdMS_TO_TICKS(periodMs));
+    }
+}
+
+// Number right after `at` in a G-code line; false if there isn't one
+static bool gcodeWordValue(const String &line, int at, float &v) {
+    const char* s = line.c_str() + at;
+    char* end;
+    v = strtof(s, &end);
+    return end != s;
+}
+
+// True when `line` starts with `code` as a whole word (so "G2" does not match "G28")
+static bool isGCode(const String &line, const char* code) {
+    if (!line.startsWith(code)) return false;
+    size_t n = strlen(code);
+    return line.length() == n || !isdigit((unsigned char)line.charAt(n));
+}
 
 void parserTask(void *pvParameters) {
-    char buffer[64];
+    // Stream bytes received but not yet fed to the line assembler
+    char chunk[64];
+    size_t chunkLen = 0, chunkPos = 0;
+    LineAssembler streamLines;
     MotionCommand cmd;
     // Initialize targets to 0 and clear axis flags
     cmd.targetXmm = 0.0f; cmd.targetYmm = 0.0f; cmd.targetZmm = 0.0f; cmd.targetEmm = 0.0f;
     cmd.hasX = cmd.hasY = cmd.hasZ = cmd.hasE = false;
     cmd.isRelative = true; // Default to relative for jog buttons
     cmd.isHoming = false;
+    cmd.blend = false;
+    cmd.isArc = false;
+    cmd.isStateOnly = false;
+    cmd.setsSpindle = false;
+    cmd.rasterSlot = -1;
+
+    // Planned Cartesian position (mm) at the end of the last queued move.
+    // Moves are resolved to absolute targets here so arcs and later G90/G91
+    // changes see the position the queue will actually reach.
+    float plannedPos[NUM_AXES] = { 0, 0, 0, 0 };
+    float modalFeed = 0.0f; // last programmed F (used by arcs without F)
+    // Modal laser state (M3/M4/M5 and S); stamped onto every queued segment
+    uint8_t modalLaserMode = LASER_OFF;
+    uint8_t modalLaserPower = 0;
+    // Laser PWM for an S word: S is PWM (0-255), or with a closed-loop
+    // spindle RPM, scaled so the spindle's max RPM is full laser power
+    auto laserPowerFromS = [&](float sVal) -> uint8_t {
+        if (spindle.isClosedLoop() && spindle.getMaxRpm() > 0.0f) sVal = sVal / spindle.getMaxRpm() * 255.0f;
+        return (uint8_t)constrain(lroundf(sVal), 0L, 255L);
+    };
+    // S on a motion line changes the power from that segment on. Rapids
+    // (G0) never fire the laser.
+    auto stampLaser = [&](MotionCommand &m, const String &l, bool rapid) {
+        int sIdx = l.indexOf('S');
+        if (sIdx != -1) modalLaserPower = laserPowerFromS(l.substring(sIdx + 1).toFloat());
+        m.laserMode = rapid ? LASER_OFF : modalLaserMode;
+        m.laserPower = modalLaserPower;
+        m.isStateOnly = false;
+    };
+    // A G28 is queued but hasn't run yet (machineHomed is set when it does)
+    bool homingQueued = false;
+    // With nothing in flight the executed position is authoritative again
+    // (covers stops, rejected commands and G92). A command controlTask has
+    // received but not applied yet still counts, or a relative move parsed
+    // in that window would be resolved from the position before it.
+    auto syncPlannedPos = [&]() {
+        if (motionInFlight != 0) return;
+        plannedPos[AXIS_X] = currentPosX / countsPerMM_X; plannedPos[AXIS_Y] = currentPosY / countsPerMM_Y;
+        plannedPos[AXIS_Z] = currentPosZ / countsPerMM_Z; plannedPos[AXIS_E] = currentPosE / countsPerMM_E;
+        homingQueued = false;
+    };
+    // After a job's move is refused, the rest of it is dropped, including
+    // lines still buffered when it has ended
+    bool jobRefused = false;
+    // Soft limits: each move is checked against the travel envelope as it
+    // is planned, before anything is queued, so a refused move leaves the
+    // plan as it was. Outside the envelope already (limits changed, G92)
+    // only the target is checked, so the machine can be driven back in.
+    auto moveAllowed = [&](const RawCommand &r, const float to[NUM_AXES], const ArcGenerator* arc) -> bool {
+        SoftLimitViolation v;
+        bool inside;
+        if (!travelEnvelope.containsLine(plannedPos, plannedPos, nullptr)) inside = travelEnvelope.containsLine(to, to, &v);
+        else if (arc) inside = travelEnvelope.containsArc(plannedPos, to, arc->centerX(), arc->centerY(), arc->sweep(), &v);
+        else inside = travelEnvelope.containsLine(plannedPos, to, &v);
+        char error[80];
+        if (softLimitsRequireHomed && !machineHomed && !homingQueued) {
+            strcpy(error, "not_homed");
+        } else if (!inside) {
+            strcpy(error, "soft_limit:");
+            softLimitDescribe(error + 11, sizeof(error) - 11, v);
+        } else {
+            return true;
+        }
+        Serial.printf("parserTask: move refused (%s)\n", error);
+        if (webServer) {
+            webServer->sendResponseToClient(r.srcType, r.srcId, String("error:") + error);
+            // Running on without one of its moves would spoil the work
+            if (r.srcType == SRC_JOB) { jobRefused = true; webServer->stopJob(String("Job stopped, move refused: ") + error); }
+        }
+        return false;
+    };
 
     // Wait for stream to be initialized
-    while (gcodeStream == NULL || motionQueue == NULL) {
+    while (parserInputs == NULL || motionQueue == NULL) {
         vTaskDelay(10 / portTICK_PERIOD_MS);
     }
 
     while (true) {
-        // Prefer queued client commands over serial stream
         RawCommand raw;
         String line;
-        if (commandQueue != NULL && xQueueReceive(commandQueue, &raw, (TickType_t)10) == pdTRUE) {
+        // Block until a client command or stream data arrives. While stream
+        // data is already waiting, only peek for client commands: they are
+        // preferred over the stream.
+        bool streamPending = streamLines.ready() || chunkPos < chunkLen || xStreamBufferBytesAvailable(gcodeStream) > 0;
+        if (jobRefused && !jobActive && !streamPending) jobRefused = false;
+        QueueSetMemberHandle_t ready = xQueueSelectFromSet(parserInputs, streamPending ? 0 : portMAX_DELAY);
+        if (ready == (QueueSetMemberHandle_t)gcodeStreamSignal) xSemaphoreTake(gcodeStreamSignal, 0);
+        if (ready == (QueueSetMemberHandle_t)commandQueue && xQueueReceive(commandQueue, &raw, 0) == pdTRUE) {
+            if (commandsToDrop > 0) { commandsToDrop = commandsToDrop - 1; continue; }
             // use raw.line as input
             line = String(raw.line);
             // We'll set owner info in the MotionCommand below (fall through to parsing)
@@ -233,14 +653,20 @@ void parserTask(void *pvParameters) {
             line.toUpperCase();
             if (line.length() == 0) continue;
         } else {
-            // Avoid blocking forever on the serial stream so we can still
-            // service queued client commands that arrive while no serial
-            // input is present. Use a short timeout and loop back to check
-            // the `commandQueue` frequently.
-            size_t bytes = xStreamBufferReceive(gcodeStream, buffer, 64, (TickType_t)10);
-            if (bytes <= 0) continue;
-            buffer[bytes] = '\0'; // Ensure null termination
-            line = String(buffer);
+            // Next complete line from the stream (receives may hold several
+            // lines or end mid-line)
+            while (!streamLines.ready()) {
+                if (chunkPos >= chunkLen) {
+                    chunkLen = xStreamBufferReceive(gcodeStream, chunk, sizeof(chunk), 0);
+                    chunkPos = 0;
+                    if (chunkLen == 0) break;
+                }
+                chunkPos += streamLines.feed(chunk + chunkPos, chunkLen - chunkPos);
+            }
+            if (streamLines.takeDropped()) Serial.println("error:line_too_long");
+            if (!streamLines.ready()) continue;
+            size_t bytes = streamLines.length();
+            line = String(streamLines.line());
             line.trim();
             // Normalize to uppercase so both 'X' and 'x' (and 'g','G') are parsed
             line.toUpperCase();
@@ -250,9 +676,11 @@ void parserTask(void *pvParameters) {
             // from a file job rather than an interactive client.
             raw.srcType = jobActive ? SRC_JOB : SRC_SERIAL;
             raw.srcId = 0;
-            raw.len = bytes;
-            strncpy(raw.line, buffer, min((size_t)127, bytes));
-            raw.line[min((size_t)127, bytes)] = '\0';
+            raw.len = min((size_t)127, bytes);
+            memcpy(raw.line, streamLines.line(), raw.len);
+            raw.line[raw.len] = '\0';
+            streamLines.next();
+            if (jobRefused) continue;
         }
 
             // Parse G-Code
@@ -293,79 +721,136 @@ void parserTask(void *pvParameters) {
                 int fIdx = line.indexOf('F');
                 if (fIdx != -1) {
                     cmd.feedrate = line.substring(fIdx + 1).toFloat();
+                    modalFeed = cmd.feedrate;
                 } else {
                     cmd.feedrate = 0.0f;
                 }
 
+                // Resolve to absolute Cartesian targets against the planned position
+                syncPlannedPos();
+                float target[NUM_AXES] = { plannedPos[AXIS_X], plannedPos[AXIS_Y], plannedPos[AXIS_Z], plannedPos[AXIS_E] };
+                if (cmd.hasX) target[AXIS_X] = absolutePositioning ? cmd.targetXmm : plannedPos[AXIS_X] + cmd.targetXmm;
+                if (cmd.hasY) target[AXIS_Y] = absolutePositioning ? cmd.targetYmm : plannedPos[AXIS_Y] + cmd.targetYmm;
+                if (cmd.hasZ) target[AXIS_Z] = absolutePositioning ? cmd.targetZmm : plannedPos[AXIS_Z] + cmd.targetZmm;
+                if (cmd.hasE) target[AXIS_E] = absolutePositioning ? cmd.targetEmm : plannedPos[AXIS_E] + cmd.targetEmm;
+                if (!moveAllowed(raw, target, nullptr)) continue;
+                for (int a = 0; a < NUM_AXES; ++a) plannedPos[a] = target[a];
+                cmd.targetXmm = target[AXIS_X]; cmd.targetYmm = target[AXIS_Y];
+                cmd.targetZmm = target[AXIS_Z]; cmd.targetEmm = target[AXIS_E];
+                cmd.isRelative = false;
+                cmd.blend = false;
+                stampLaser(cmd, line, isGCode(line, "G0") || isGCode(line, "G00"));
+
                 // set owner fields
                 cmd.ownerType = raw.srcType;
                 cmd.ownerId = raw.srcId;
                 Serial.printf("parserTask: received raw from %d/%d -> enqueue motion\n", raw.srcType, raw.srcId);
                 cmd.isEmergency = false;
-                xQueueSend(motionQueue, &cmd, portMAX_DELAY);
+                motionSend(cmd, portMAX_DELAY);
             }
-            else if (line.startsWith("G2") || line.startsWith("G3")) {
-                // Arc move (XY plane). Support I and J center offsets (relative to start).
-                bool clockwise = line.startsWith("G2");
-                // Parse X/Y target (absolute or relative depending on mode)
-                float targetXmm = NAN, targetYmm = NAN;
-                int xIdx = line.indexOf('X');
-                if (xIdx != -1) targetXmm = line.substring(xIdx + 1).toFloat();
-                int yIdx = line.indexOf('Y');
-                if (yIdx != -1) targetYmm = line.substring(yIdx + 1).toFloat();
-                // Parse I/J center offsets
-                float iOff = 0.0, jOff = 0.0;
-                int iIdx = line.indexOf('I'); if (iIdx != -1) iOff = line.substring(iIdx + 1).toFloat();
-                int jIdx = line.indexOf('J'); if (jIdx != -1) jOff = line.substring(jIdx + 1).toFloat();
-                // Feedrate
-                int fIdx2 = line.indexOf('F'); int feed = 0; if (fIdx2 != -1) feed = line.substring(fIdx2 + 1).toInt();
-
-                // Determine start (current) position in mm
-                float startXmm = currentPosX / 100.0f;
-                float startYmm = currentPosY / 100.0f;
-                // Resolve absolute/relative target
-                float endXmm = isnan(targetXmm) ? startXmm : (absolutePositioning ? targetXmm : startXmm + targetXmm);
-                float endYmm = isnan(targetYmm) ? startYmm : (absolutePositioning ? targetYmm : startYmm + targetYmm);
-
-                // Compute center
-                float cx = startXmm + iOff;
-                float cy = startYmm + jOff;
-                float r = hypot(startXmm - cx, startYmm - cy);
-                if (r <= 0.0f) {
-                    Serial.println("parserTask: arc radius zero -> ignoring");
+            else if (isGCode(line, "G2") || isGCode(line, "G3")) {
+                // Arc move in the XY plane, helical when Z (or E) changes.
+                // Center from I/J offsets, or from R (negative R = long arc).
+                bool clockwise = isGCode(line, "G2");
+                syncPlannedPos();
+                float endPos[NUM_AXES];
+                const char axisWords[NUM_AXES] = { 'X', 'Y', 'Z', 'E' };
+                for (int a = 0; a < NUM_AXES; ++a) {
+                    endPos[a] = plannedPos[a];
+                    int idx = line.indexOf(axisWords[a]);
+                    if (idx == -1) continue;
+                    float v = line.substring(idx + 1).toFloat();
+                    endPos[a] = absolutePositioning ? v : plannedPos[a] + v;
+                }
+                // Feedrate (modal for arcs so slicer arc output keeps its speed)
+                int fIdx2 = line.indexOf('F');
+                if (fIdx2 != -1) modalFeed = line.substring(fIdx2 + 1).toFloat();
+                float feed = modalFeed;
+
+                ArcGenerator arc;
+                bool valid;
+                int rIdx = line.indexOf('R');
+                if (rIdx != -1) {
+                    valid = arc.beginRadius(plannedPos, endPos, line.substring(rIdx + 1).toFloat(), clockwise, arcTolerance);
+                } else {
+                    float iOff = 0.0f, jOff = 0.0f;
+                    int iIdx = line.indexOf('I'); if (iIdx != -1) iOff = line.substring(iIdx + 1).toFloat();
+                    int jIdx = line.indexOf('J'); if (jIdx != -1) jOff = line.substring(jIdx + 1).toFloat();
+                    valid = arc.beginCenter(plannedPos, endPos, iOff, jOff, clockwise, arcTolerance);
+                }
+                if (!valid) {
+                    Serial.println("parserTask: invalid arc geometry -> ignoring");
+                    if (webServer) webServer->sendResponseToClient(raw.srcType, raw.srcId, String("error:invalid_arc"));
+                } else if (!moveAllowed(raw, endPos, &arc)) {
+                    // refused before any of it is queued
+                } else if (feed > 0.0f) {
+                    // With a feedrate the servo trajectory interpolates the
+                    // true circle itself: one queue entry for the whole arc
+                    Serial.printf("parserTask: arc r=%.3f sweep=%.3f -> native\n", arc.radius(), arc.sweep());
+                    MotionCommand arcCmd;
+                    arcCmd.isHoming = false; arcCmd.isEmergency = false;
+                    arcCmd.ownerType = raw.srcType; arcCmd.ownerId = raw.srcId;
+                    arcCmd.hasX = true; arcCmd.hasY = true;
+                    arcCmd.hasZ = endPos[AXIS_Z] != plannedPos[AXIS_Z];
+                    arcCmd.hasE = endPos[AXIS_E] != plannedPos[AXIS_E];
+                    arcCmd.targetXmm = endPos[AXIS_X];
+                    arcCmd.targetYmm = endPos[AXIS_Y];
+                    arcCmd.targetZmm = endPos[AXIS_Z];
+                    arcCmd.targetEmm = endPos[AXIS_E];
+                    arcCmd.isRelative = false;
+                    arcCmd.feedrate = feed;
+                    arcCmd.blend = false;
+                    arcCmd.isArc = true;
+                    arcCmd.rasterSlot = -1;
+                    stampLaser(arcCmd, line, false);
+                    arcCmd.arcCenterXmm = arc.centerX();
+                    arcCmd.arcCenterYmm = arc.centerY();
+                    arcCmd.arcSweep = arc.sweep();
+                    motionSend(arcCmd, portMAX_DELAY);
+                    for (int a = 0; a < NUM_AXES; ++a) plannedPos[a] = endPos[a];
                 } else {
-                    float startAng = atan2(startYmm - cy, startXmm - cx);
-                    float endAng = atan2(endYmm - cy, endXmm - cx);
-                    float delta = endAng - startAng;
-                    if (clockwise && delta > 0) delta -= 2.0 * PI;
-                    if (!clockwise && delta < 0) delta += 2.0 * PI;
-                    float absDelta = fabs(delta);
-                    int segments = max(8, (int)(r * absDelta));
-                    for (int s = 1; s <= segments; ++s) {
-                        float t = (float)s / (float)segments;
-                        float ang = startAng + delta * t;
-                        float px = cx + r * cos(ang);
-                        float py = cy + r * sin(ang);
-                            MotionCommand arcCmd;
-                            arcCmd.isHoming = false; arcCmd.isEmergency = false;
-                            arcCmd.ownerType = raw.srcType; arcCmd.ownerId = raw.srcId;
-                            arcCmd.hasX = true; arcCmd.hasY = true; arcCmd.hasZ = false; arcCmd.hasE = false;
-                            arcCmd.targetXmm = px;
-                            arcCmd.targetYmm = py;
-                            arcCmd.isRelative = false;
-                            arcCmd.feedrate = (float)feed;
-                            xQueueSend(motionQueue, &arcCmd, portMAX_DELAY);
+                    // Without a feedrate there is no trajectory to follow, so
+                    // step the setpoint through chords
+                    Serial.printf("parserTask: arc r=%.3f sweep=%.3f -> %d segments\n", arc.radius(), arc.sweep(), arc.segments());
+                    // Only the final chord acknowledges the G2/G3 line
+                    int remaining = arc.segments();
+                    float point[NUM_AXES];
+                    while (arc.next(point)) {
+                        MotionCommand arcCmd;
+                        arcCmd.isHoming = false; arcCmd.isEmergency = false;
+                        arcCmd.ownerType = raw.srcType; arcCmd.ownerId = raw.srcId;
+                        arcCmd.hasX = true; arcCmd.hasY = true;
+                        arcCmd.hasZ = endPos[AXIS_Z] != plannedPos[AXIS_Z];
+                        arcCmd.hasE = endPos[AXIS_E] != plannedPos[AXIS_E];
+                        arcCmd.targetXmm = point[AXIS_X];
+                        arcCmd.targetYmm = point[AXIS_Y];
+                        arcCmd.targetZmm = point[AXIS_Z];
+                        arcCmd.targetEmm = point[AXIS_E];
+                        arcCmd.isRelative = false;
+                        arcCmd.feedrate = feed;
+                        arcCmd.blend = --remaining > 0;
+                        arcCmd.isArc = false;
+                        arcCmd.rasterSlot = -1;
+                        stampLaser(arcCmd, line, false);
+                        motionSend(arcCmd, portMAX_DELAY);
                     }
+                    for (int a = 0; a < NUM_AXES; ++a) plannedPos[a] = endPos[a];
                 }
             }
             else if (line.startsWith("G28")) {
                 // Homing (reset encoders and position)
                 cmd.isHoming = true;
+                cmd.blend = false;
+                cmd.laserMode = LASER_OFF; // never fire while homing
+                cmd.isStateOnly = false;
+                const long zeroCounts[NUM_AXES] = { 0, 0, 0, 0 };
+                countsToCartesian(zeroCounts, plannedPos);
+                homingQueued = true;
                 cmd.ownerType = raw.srcType;
                 cmd.ownerId = raw.srcId;
                 Serial.printf("parserTask: enqueue homing from %d/%d\n", raw.srcType, raw.srcId);
                 cmd.isEmergency = false;
-                xQueueSend(motionQueue, &cmd, portMAX_DELAY);
+                motionSend(cmd, portMAX_DELAY);
             }
             else if (line.startsWith("G90")) {
                 // Absolute Positioning
@@ -410,7 +895,7 @@ void parserTask(void *pvParameters) {
                 cmd.isEmergency = true;
                 cmd.ownerType = raw.srcType;
                 cmd.ownerId = raw.srcId;
-                xQueueSend(motionQueue, &cmd, portMAX_DELAY);
+                motionSend(cmd, portMAX_DELAY);
             }
             else if (line.startsWith("M999")) {
                 // Clear Halt
@@ -422,26 +907,31 @@ void parserTask(void *pvParameters) {
                 int xIdx = line.indexOf('X');
                 if (xIdx != -1) {
                     float vx = line.substring(xIdx + 1).toFloat();
-                    currentPosX = (long)round(vx * 100.0);
-                    encX = currentPosX;
+                    currentPosX = (long)round(vx * countsPerMM_X);
                 }
                 int yIdx = line.indexOf('Y');
                 if (yIdx != -1) {
                     float vy = line.substring(yIdx + 1).toFloat();
-                    currentPosY = (long)round(vy * 100.0);
-                    encY = currentPosY;
+                    currentPosY = (long)round(vy * countsPerMM_Y);
                 }
                 int zIdx = line.indexOf('Z');
                 if (zIdx != -1) {
                     float vz = line.substring(zIdx + 1).toFloat();
-                    currentPosZ = (long)round(vz * 100.0);
-                    encZ = currentPosZ;
+                    currentPosZ = (long)round(vz * countsPerMM_Z);
                 }
                 int eIdx2 = line.indexOf('E');
                 if (eIdx2 != -1) {
                     float ve = line.substring(eIdx2 + 1).toFloat();
-                    currentPosE = (long)round(ve * 100.0);
-                    encE = currentPosE;
+                    currentPosE = (long)round(ve * countsPerMM_E);
+                }
+                // A new X/Y/Z origin is no longer the homed one
+                if (xIdx != -1 || yIdx != -1 || zIdx != -1) { machineHomed = false; homingQueued = false; }
+                // Re-seed the encoders with the matching motor positions
+                float cart[NUM_AXES] = { currentPosX / countsPerMM_X, currentPosY / countsPerMM_Y, currentPosZ / countsPerMM_Z, currentPosE / countsPerMM_E };
+                for (int a = 0; a < NUM_AXES; ++a) plannedPos[a] = cart[a];
+                long counts[NUM_AXES];
+                if (cartesianToCounts(cart, counts)) {
+                    encX = counts[AXIS_X]; encY = counts[AXIS_Y]; encZ = counts[AXIS_Z]; encE = counts[AXIS_E];
                 }
             }
             else if (line.startsWith("M106") || line.startsWith("M107")) {
@@ -472,131 +962,162 @@ void parserTask(void *pvParameters) {
                     Serial.println(response);
                 }
             }
-            else if (line.startsWith("M92")) {
-                // Set steps/counts per mm: M92 Xnnn Ynnn Znnn Enn
-                int xIdx = line.indexOf('X');
-                if (xIdx != -1) countsPerMM_X = line.substring(xIdx + 1).toFloat();
-                int yIdx = line.indexOf('Y');
-                if (yIdx != -1) countsPerMM_Y = line.substring(yIdx + 1).toFloat();
-                int zIdx = line.indexOf('Z');
-                if (zIdx != -1) countsPerMM_Z = line.substring(zIdx + 1).toFloat();
-                int eIdx2 = line.indexOf('E');
-                if (eIdx2 != -1) countsPerMM_E = line.substring(eIdx2 + 1).toFloat();
-                Serial.println("M92: updated counts per mm");
-            }
-            else if (line.startsWith("M301")) {
-                // Set PID tuning: M301 [X P... I... D...] [Y ...] [Z ...] [E ...]
-                // Parse P/I/D groups for each axis if present
-                auto parseAxisTunings = [&](char axis, float &kp, float &ki, float &kd) {
-                    int idx = line.indexOf(axis);
-                    if (idx != -1) {
-                        // substring from axis letter to end; parse tokens for P/I/D
-                        String rest = line.substring(idx + 1);
-                        int pIdx = rest.indexOf('P'); if (pIdx != -1) {
-                            kp = rest.substring(pIdx + 1).toFloat();
-                        }
-                        int iIdx = rest.indexOf('I'); if (iIdx != -1) {
-                            ki = rest.substring(iIdx + 1).toFloat();
-                        }
-                        int dIdx = rest.indexOf('D'); if (dIdx != -1) {
-                            kd = rest.substring(dIdx + 1).toFloat();
-                        }
-                        return true;
+            else if (line.startsWith("M92") || line.startsWith("M301")) {
+                // M92 X<counts/mm> Y.. Z.. E..  /  M301 [X P.. I.. D..] [Y ..] [Z ..] [E ..]
+                // Every value goes through the settings registry; the line is
+                // refused whole if any of them is unparsable or out of range.
+                bool m92 = line.startsWith("M92");
+                const char axes[NUM_AXES] = { 'X', 'Y', 'Z', 'E' };
+                const char* axisNames[NUM_AXES] = { "x", "y", "z", "e" };
+                SettingWrite writes[NUM_AXES * 3];
+                int n = 0;
+                char paths[NUM_AXES * 3][24];
+                for (int a = 0; a < NUM_AXES; ++a) {
+                    int idx = line.indexOf(axes[a], 3);
+                    if (idx == -1) continue;
+                    if (m92) {
+                        snprintf(paths[n], sizeof(paths[n]), "countsPerMM.%s", axisNames[a]);
+                        writes[n].path = paths[n];
+                        writes[n].parsed = gcodeWordValue(line, idx + 1, writes[n].value);
+                        n++;
+                        continue;
+                    }
+                    // P/I/D words up to the next axis letter
+                    int end = line.length();
+                    for (int b = 0; b < NUM_AXES; ++b) {
+                        int next = line.indexOf(axes[b], idx + 1);
+                        if (next != -1 && next < end) end = next;
                     }
-                    return false;
-                };
-
-                bool changed = false;
-                if (parseAxisTunings('X', pid_kp_x, pid_ki_x, pid_kd_x)) { pidX.setTunings(pid_kp_x, pid_ki_x, pid_kd_x); changed = true; }
-                if (parseAxisTunings('Y', pid_kp_y, pid_ki_y, pid_kd_y)) { pidY.setTunings(pid_kp_y, pid_ki_y, pid_kd_y); changed = true; }
-                if (parseAxisTunings('Z', pid_kp_z, pid_ki_z, pid_kd_z)) { pidZ.setTunings(pid_kp_z, pid_ki_z, pid_kd_z); changed = true; }
-                if (parseAxisTunings('E', pid_kp_e, pid_ki_e, pid_kd_e)) { pidE.setTunings(pid_kp_e, pid_ki_e, pid_kd_e); changed = true; }
-                if (changed) Serial.println("M301: PID tunings updated");
+                    const char terms[3] = { 'P', 'I', 'D' };
+                    for (int t = 0; t < 3; ++t) {
+                        int tIdx = line.indexOf(terms[t], idx + 1);
+                        if (tIdx == -1 || tIdx >= end) continue;
+                        snprintf(paths[n], sizeof(paths[n]), "pid.%s.%c", axisNames[a], terms[t] + ('a' - 'A'));
+                        writes[n].path = paths[n];
+                        writes[n].parsed = gcodeWordValue(line, tIdx + 1, writes[n].value);
+                        n++;
+                    }
+                }
+                const char* bad = settingsWriteAll(settingsTable, settingsCount, writes, n);
+                if (bad) {
+                    Serial.printf("%s: invalid %s, nothing changed\n", m92 ? "M92" : "M301", bad);
+                    if (webServer) webServer->sendResponseToClient(raw.srcType, raw.srcId, String("error:invalid_setting:") + bad);
+                } else if (n > 0) {
+                    settingsChanged();
+                    Serial.println(m92 ? "M92: updated counts per mm" : "M301: PID tunings updated");
+                }
             }
             else if (line.startsWith("M503")) {
-                // Report settings
-                char buf[256];
-                snprintf(buf, sizeof(buf), "M92 X%.4f Y%.4f Z%.4f E%.4f\n", countsPerMM_X, countsPerMM_Y, countsPerMM_Z, countsPerMM_E);
-                Serial.print(buf);
-                if (webServer) webServer->sendTelnet(String(buf));
-                snprintf(buf, sizeof(buf), "PID X P%.4f I%.4f D%.4f\n", pid_kp_x, pid_ki_x, pid_kd_x);
-                Serial.print(buf); if (webServer) webServer->sendTelnet(String(buf));
-                snprintf(buf, sizeof(buf), "PID Y P%.4f I%.4f D%.4f\n", pid_kp_y, pid_ki_y, pid_kd_y);
-                Serial.print(buf); if (webServer) webServer->sendTelnet(String(buf));
-                snprintf(buf, sizeof(buf), "PID Z P%.4f I%.4f D%.4f\n", pid_kp_z, pid_ki_z, pid_kd_z);
-                Serial.print(buf); if (webServer) webServer->sendTelnet(String(buf));
-                snprintf(buf, sizeof(buf), "PID E P%.4f I%.4f D%.4f\n", pid_kp_e, pid_ki_e, pid_kd_e);
-                Serial.print(buf); if (webServer) webServer->sendTelnet(String(buf));
+                // Report settings (one line per registry entry), or just the
+                // one named after M503 ("M503 pid.x.p" / "M503 pid_kp_x")
+                String name = line.substring(4); name.trim();
+                const SettingDesc* only = name.length() ? settingFind(settingsTable, settingsCount, name.c_str()) : nullptr;
+                if (name.length() && !only) Serial.println("M503: unknown setting " + name);
+                char buf[96];
+                for (int i = 0; i < settingsCount; ++i) {
+                    const SettingDesc &d = settingsTable[i];
+                    if (name.length() && &d != only) continue;
+                    if (d.type == SETTING_INT) snprintf(buf, sizeof(buf), "%s=%d\n", d.path, (int)settingGet(d));
+                    else snprintf(buf, sizeof(buf), "%s=%.4f\n", d.path, settingGet(d));
+                    Serial.print(buf); if (webServer) webServer->sendTelnet(String(buf));
+                }
             }
             else if (line.startsWith("M500")) {
-                // Save settings to Preferences
-                Preferences prefs;
-                prefs.begin("cnc", false);
-                prefs.putFloat("cpm_x", countsPerMM_X);
-                prefs.putFloat("cpm_y", countsPerMM_Y);
-                prefs.putFloat("cpm_z", countsPerMM_Z);
-                prefs.putFloat("cpm_e", countsPerMM_E);
-                prefs.putFloat("pid_kp_x", pid_kp_x); prefs.putFloat("pid_ki_x", pid_ki_x); prefs.putFloat("pid_kd_x", pid_kd_x);
-                prefs.putFloat("pid_kp_y", pid_kp_y); prefs.putFloat("pid_ki_y", pid_ki_y); prefs.putFloat("pid_kd_y", pid_kd_y);
-                prefs.putFloat("pid_kp_z", pid_kp_z); prefs.putFloat("pid_ki_z", pid_ki_z); prefs.putFloat("pid_kd_z", pid_kd_z);
-                prefs.putFloat("pid_kp_e", pid_kp_e); prefs.putFloat("pid_ki_e", pid_ki_e); prefs.putFloat("pid_kd_e", pid_kd_e);
-                prefs.end();
+                // Save settings (settingsTask writes the blob right away)
+                settingsSchedule.requestFlush(millis());
                 Serial.println("Settings saved (M500)");
             }
             else if (line.startsWith("M501")) {
-                // Load settings from Preferences
-                Preferences prefs;
-                prefs.begin("cnc", true);
-                countsPerMM_X = prefs.getFloat("cpm_x", countsPerMM_X);
-                countsPerMM_Y = prefs.getFloat("cpm_y", countsPerMM_Y);
-                countsPerMM_Z = prefs.getFloat("cpm_z", countsPerMM_Z);
-                countsPerMM_E = prefs.getFloat("cpm_e", countsPerMM_E);
-                pid_kp_x = prefs.getFloat("pid_kp_x", pid_kp_x); pid_ki_x = prefs.getFloat("pid_ki_x", pid_ki_x); pid_kd_x = prefs.getFloat("pid_kd_x", pid_kd_x);
-                pid_kp_y = prefs.getFloat("pid_kp_y", pid_kp_y); pid_ki_y = prefs.getFloat("pid_ki_y", pid_ki_y); pid_kd_y = prefs.getFloat("pid_kd_y", pid_kd_y);
-                pid_kp_z = prefs.getFloat("pid_kp_z", pid_kp_z); pid_ki_z = prefs.getFloat("pid_ki_z", pid_ki_z); pid_kd_z = prefs.getFloat("pid_kd_z", pid_kd_z);
-                pid_kp_e = prefs.getFloat("pid_kp_e", pid_kp_e); pid_ki_e = prefs.getFloat("pid_ki_e", pid_ki_e); pid_kd_e = prefs.getFloat("pid_kd_e", pid_kd_e);
-                prefs.end();
-                // Apply loaded tunings to controllers
-                pidX.setTunings(pid_kp_x, pid_ki_x, pid_kd_x);
-                pidY.setTunings(pid_kp_y, pid_ki_y, pid_kd_y);
-                pidZ.setTunings(pid_kp_z, pid_ki_z, pid_kd_z);
-                pidE.setTunings(pid_kp_e, pid_ki_e, pid_kd_e);
+                // Reload settings from the NVS blob
+                settingsLoad();
                 Serial.println("Settings loaded (M501)");
             }
-            else if (line.startsWith("M3") || line.startsWith("M5")) {
-                // Spindle / Laser on/off. M3 S<0-255> to set power, M5 to stop
-                if (line.startsWith("M5")) {
-                    if (PIN_SPINDLE >= 0) ledcWrite(PWM_CHAN_SPINDLE, 0);
-                    if (PIN_LASER >= 0) ledcWrite(PWM_CHAN_LASER, 0);
-                    // update runtime state and persist
-                    spindlePower = 0; laserPower = 0;
-                    Preferences prefs; prefs.begin("cnc", false);
-                    prefs.putInt("spindle_p", 0);
-                    prefs.putInt("laser_p", 0);
-                    prefs.end();
+            else if (line.startsWith("M502")) {
+                // Factory defaults (not saved until M500 or the next change)
+                settingsResetDefaults(settingsTable, settingsCount);
+                settingsApply();
+                Serial.println("Settings reset to defaults (M502)");
+            }
+            else if (isGCode(line, "M3") || isGCode(line, "M4") || isGCode(line, "M5")) {
+                // Spindle / Laser. M3 S<0-255> constant power, M4 S<0-255> dynamic
+                // laser power (scaled with actual speed), M5 to stop. With a
+                // spindle tachometer S is the spindle RPM instead.
+                // Both are queued so they change in step with the moves
+                // around them; a closed-loop spindle also holds the queue
+                // until it is at speed.
+                float spindleTarget = 0.0f;
+                if (isGCode(line, "M5")) {
+                    modalLaserMode = LASER_OFF;
                 } else {
                     int sIdx = line.indexOf('S');
-                    int val = 255;
-                    if (sIdx != -1) val = line.substring(sIdx + 1).toInt();
-                    int v = constrain(val, 0, 255);
-                    if (PIN_SPINDLE >= 0) ledcWrite(PWM_CHAN_SPINDLE, v);
-                    if (PIN_LASER >= 0) ledcWrite(PWM_CHAN_LASER, v);
-                    // update runtime state and persist
-                    spindlePower = v; laserPower = v;
-                    Preferences prefs; prefs.begin("cnc", false);
-                    prefs.putInt("spindle_p", spindlePower);
-                    prefs.putInt("laser_p", laserPower);
-                    prefs.end();
+                    // S is RPM for a closed-loop spindle, otherwise PWM; the
+                    // laser gets it as PWM, scaled from RPM if need be
+                    float sVal = sIdx != -1 ? line.substring(sIdx + 1).toFloat() : (spindle.isClosedLoop() ? spindle.getMaxRpm() : 255.0f);
+                    spindleTarget = sVal;
+                    modalLaserMode = isGCode(line, "M4") ? LASER_DYNAMIC : LASER_CONSTANT;
+                    modalLaserPower = laserPowerFromS(sVal);
                 }
+                MotionCommand laserCmd = cmd;
+                laserCmd.isStateOnly = true;
+                laserCmd.isHoming = false; laserCmd.isEmergency = false;
+                laserCmd.laserMode = modalLaserMode;
+                laserCmd.laserPower = modalLaserPower;
+                laserCmd.setsSpindle = PIN_SPINDLE >= 0;
+                laserCmd.spindleTarget = spindleTarget;
+                laserCmd.ownerType = raw.srcType; laserCmd.ownerId = raw.srcId;
+                motionSend(laserCmd, portMAX_DELAY);
             }
         }
 }
 
+// Drop every queued motion command, handing back the raster rows they hold
+static void motionQueueClear() {
+    MotionCommand dropped;
+    while (xQueueReceive(motionQueue, &dropped, 0) == pdTRUE) {
+        rasterRows.release(dropped.rasterSlot);
+        motionInFlight--;
+    }
+}
+
 // Execution / Control Loop (Core 1) - single executor semantics
 // declared above
 void controlTask(void *pvParameters) {
     MotionCommand currentTarget = {0, 0, 0, 0, false, false, false, false, false, false};
     long setpointX = 0, setpointY = 0, setpointZ = 0, setpointE = 0;
+    // Set when the previous segment handed over to the next one without
+    // settling; the next trajectory then starts from the commanded point.
+    bool lastBlended = false;
+    // Feed hold: slows the current trajectory to a stop along its path
+    // (see feed_hold.h); the hold state carries across moves
+    FeedHold feedHold;
+    // Recent Cartesian positions from the encoders (one per tick) for the
+    // actual velocity used by the dynamic laser mode. Kept across blended
+    // moves so consecutive M4 segments don't restart blind; cleared whenever
+    // the head stops (end of an unblended move, stop, park, halt) or the
+    // laser leaves M4.
+    float laserVelHist[LASER_VELOCITY_WINDOW][3];
+    int laserVelIdx = 0, laserVelCount = 0;
+    // Last PWM written to the laser (-1 = unknown, forces the next write)
+    int laserOut = -1;
+    auto writeLaser = [&](int pwm) {
+        if (PIN_LASER < 0 || pwm == laserOut) return;
+        ledcWrite(PWM_CHAN_LASER, pwm);
+        laserOut = pwm;
+    };
+    
+    // Run stop: stop motors and laser, clear queues and release executor
+    auto stopRun = [&](const MotionCommand &c) {
+        motorX.setSpeed(0); motorY.setSpeed(0); motorZ.setSpeed(0); motorE.setSpeed(0);
+        writeLaser(0); laserMode = LASER_OFF; laserPower = 0;
+        laserVelCount = 0;
+        // Clear pending motion commands (handing back any raster rows they hold)
+        if (motionQueue != NULL) motionQueueClear();
+        if (commandQueue != NULL) commandsToDrop = uxQueueMessagesWaiting(commandQueue);
+        if (webServer) webServer->sendResponseToClient(c.ownerType, c.ownerId, String("ok:stopped"));
+        // A stop ends whoever's session it was
+        executorOwner.reset();
+        runStopped = false; // clear
+    };
     
     TickType_t xLastWakeTime = xTaskGetTickCount();
     const TickType_t xFrequency = 1; // 1ms = 1kHz
@@ -605,6 +1126,7 @@ void controlTask(void *pvParameters) {
     while (motionQueue == NULL) {
         vTaskDelay(10 / portTICK_PERIOD_MS);
     }
+    bootMark(BOOT_MOTION_READY);
 
     while (true) {
         // If we're halted globally, stop motors and wait for clear
@@ -616,13 +1138,20 @@ void controlTask(void *pvParameters) {
             motorE.setSpeed(0);
             // Ensure spindle/laser are off while halted
             disableSpindleAndLaser();
+            laserVelCount = 0;
+            // Nothing queued before or during a halt may run once it is cleared
+            motionQueueClear();
             vTaskDelay(100 / portTICK_PERIOD_MS);
             continue;
         }
 
-        // Wait for next motion command (executor semantics)
+        // Wait for next motion command (executor semantics). The short
+        // timeout lets a stop that arrives while idle take effect too.
         MotionCommand cmd;
-        if (xQueueReceive(motionQueue, &cmd, portMAX_DELAY) == pdTRUE) {
+        if (xQueueReceive(motionQueue, &cmd, pdMS_TO_TICKS(10)) == pdTRUE) {
+            // Counted out of motionInFlight when this block is left, by which
+            // time currentPos* holds the command's target (or it was dropped)
+            struct InFlightDone { ~InFlightDone() { motionInFlight--; } } inFlightDone;
             // Handle emergency commands immediately
             if (cmd.isEmergency) {
                 isHalted = true;
@@ -635,127 +1164,276 @@ void controlTask(void *pvParameters) {
                 continue;
             }
 
-            // Claim executor if not busy (protected by global executor spinlock)
-            portENTER_CRITICAL(&g_executorMux);
-            if (!executorBusy) {
-                executorBusy = true;
-                executorOwnerType = cmd.ownerType;
-                executorOwnerId = cmd.ownerId;
-                // controlTask claims executor for real; clear any push-time reservation
-                executorReservedUntil = 0;
-                Serial.printf("controlTask: claimed executor for %d/%d\n", cmd.ownerType, cmd.ownerId);
+            // Laser state travels with the segment (M3 constant power now,
+            // M4 follows the velocity below, G0/M5 off). Halts and manual
+            // writes may have touched the output, so always rewrite it.
+            laserOut = -1;
+            laserMode = cmd.laserMode;
+            laserPower = cmd.laserMode == LASER_OFF ? 0 : cmd.laserPower;
+            writeLaser(cmd.laserMode == LASER_CONSTANT ? cmd.laserPower : 0);
+
+            // Spindle setpoint (M3/M4/M5). Closed loop this is a barrier: the
+            // moves queued behind it wait until the spindle is at speed.
+            // spindleTask halts the machine if it stalls or never gets there.
+            if (cmd.setsSpindle) {
+                spindle.setTarget(cmd.spindleTarget);
+                if (!spindle.atSpeed()) {
+                    Serial.printf("controlTask: waiting for spindle (%.0f RPM)\n", spindle.getTarget());
+                    while (!spindle.atSpeed() && !spindle.stalled() && !isHalted && !runStopped) {
+                        vTaskDelay(10 / portTICK_PERIOD_MS);
+                    }
+                    if (runStopped) { stopRun(cmd); continue; }
+                    if (!spindle.atSpeed()) {
+                        if (!isHalted) { haltReason = "Spindle did not reach speed"; isHalted = true; }
+                        if (webServer) webServer->sendResponseToClient(cmd.ownerType, cmd.ownerId, String("error:halt:spindle_not_at_speed"));
+                        continue;
+                    }
+                }
             }
-            portEXIT_CRITICAL(&g_executorMux);
+            if (cmd.isStateOnly) continue;
 
+            // Ownership is taken when commands are accepted (pushClientCommand,
+            // job start); here the owner's lease is held for the whole move.
             // Safety: reject commands from other owners (shouldn't be queued by web_server)
-            if (executorBusy && !(executorOwnerType == cmd.ownerType && executorOwnerId == cmd.ownerId)) {
-                Serial.printf("controlTask: rejecting command from %d/%d because executor owned by %d/%d -> error:busy\n", cmd.ownerType, cmd.ownerId, executorOwnerType, executorOwnerId);
+            if (!executorOwner.begin(cmd.ownerType, cmd.ownerId, millis())) {
+                ExecutorOwnerView holder = executorOwner.view(millis());
+                Serial.printf("controlTask: rejecting command from %d/%d because executor owned by %d/%d -> error:busy\n", cmd.ownerType, cmd.ownerId, holder.type, holder.id);
                 if (webServer) webServer->sendResponseToClient(cmd.ownerType, cmd.ownerId, String("error:busy"));
+                rasterRows.release(cmd.rasterSlot);
                 continue;
             }
+            moveInProgress = true;
 
-            // Apply the setpoints
+            // Apply the setpoints. Targets are Cartesian (mm); the kinematics
+            // policy maps them onto motor encoder counts.
+            long prevSetpointX = setpointX, prevSetpointY = setpointY, prevSetpointZ = setpointZ, prevSetpointE = setpointE;
+            float cartTarget[NUM_AXES] = { currentPosX / countsPerMM_X, currentPosY / countsPerMM_Y, currentPosZ / countsPerMM_Z, currentPosE / countsPerMM_E };
+            float cartPrev[NUM_AXES] = { cartTarget[AXIS_X], cartTarget[AXIS_Y], cartTarget[AXIS_Z], cartTarget[AXIS_E] };
             if (cmd.isHoming) {
                 encX = encY = encZ = encE = 0;
+                const long zeroCounts[NUM_AXES] = { 0, 0, 0, 0 };
+                countsToCartesian(zeroCounts, cartTarget);
+                currentPosX = lroundf(cartTarget[AXIS_X] * countsPerMM_X); currentPosY = lroundf(cartTarget[AXIS_Y] * countsPerMM_Y);
+                currentPosZ = lroundf(cartTarget[AXIS_Z] * countsPerMM_Z); currentPosE = lroundf(cartTarget[AXIS_E] * countsPerMM_E);
                 setpointX = setpointY = setpointZ = setpointE = 0;
                 pidX.reset(); pidY.reset(); pidZ.reset(); pidE.reset();
+                machineHomed = true;
             } else {
-                if (absolutePositioning) {
-                    if (cmd.hasX) { setpointX = (long)round(cmd.targetXmm * countsPerMM_X); currentPosX = setpointX; }
-                    if (cmd.hasY) { setpointY = (long)round(cmd.targetYmm * countsPerMM_Y); currentPosY = setpointY; }
-                    if (cmd.hasZ) { setpointZ = (long)round(cmd.targetZmm * countsPerMM_Z); currentPosZ = setpointZ; }
-                    if (cmd.hasE) { setpointE = (long)round(cmd.targetEmm * countsPerMM_E); currentPosE = setpointE; }
-                } else {
-                    if (cmd.hasX) { setpointX += (long)round(cmd.targetXmm * countsPerMM_X); currentPosX = setpointX; }
-                    if (cmd.hasY) { setpointY += (long)round(cmd.targetYmm * countsPerMM_Y); currentPosY = setpointY; }
-                    if (cmd.hasZ) { setpointZ += (long)round(cmd.targetZmm * countsPerMM_Z); currentPosZ = setpointZ; }
-                    if (cmd.hasE) { setpointE += (long)round(cmd.targetEmm * countsPerMM_E); currentPosE = setpointE; }
+                const bool has[NUM_AXES] = { cmd.hasX, cmd.hasY, cmd.hasZ, cmd.hasE };
+                const float target[NUM_AXES] = { cmd.targetXmm, cmd.targetYmm, cmd.targetZmm, cmd.targetEmm };
+                for (int i = 0; i < NUM_AXES; ++i) {
+                    if (!has[i]) continue;
+                    cartTarget[i] = cmd.isRelative ? cartTarget[i] + target[i] : target[i];
                 }
+                long motorTarget[NUM_AXES];
+                if (!cartesianToCounts(cartTarget, motorTarget)) {
+                    Serial.println("controlTask: target outside machine kinematics -> error:unreachable");
+                    if (webServer) webServer->sendResponseToClient(cmd.ownerType, cmd.ownerId, String("error:unreachable"));
+                    rasterRows.release(cmd.rasterSlot);
+                    executorOwner.end(cmd.ownerType, cmd.ownerId, millis(), EXECUTOR_LEASE_MS);
+                    moveInProgress = false;
+                    continue;
+                }
+                setpointX = motorTarget[AXIS_X]; setpointY = motorTarget[AXIS_Y]; setpointZ = motorTarget[AXIS_Z]; setpointE = motorTarget[AXIS_E];
+                currentPosX = lroundf(cartTarget[AXIS_X] * countsPerMM_X); currentPosY = lroundf(cartTarget[AXIS_Y] * countsPerMM_Y);
+                currentPosZ = lroundf(cartTarget[AXIS_Z] * countsPerMM_Z); currentPosE = lroundf(cartTarget[AXIS_E] * countsPerMM_E);
             }
 
-            // Prepare trajectory following if feedrate provided
+            // A motor takes part in this command when its axis was named or the
+            // kinematics coupled it in (e.g. X-only moves drive both CoreXY belts)
+            bool activeX = cmd.hasX || setpointX != prevSetpointX;
+            bool activeY = cmd.hasY || setpointY != prevSetpointY;
+            bool activeZ = cmd.hasZ || setpointZ != prevSetpointZ;
+            bool activeE = cmd.hasE || setpointE != prevSetpointE;
+
+            // Prepare trajectory following if feedrate provided. The segment is
+            // interpolated in Cartesian space and mapped through the kinematics
+            // every tick so non-linear machines (delta) still move in straight lines.
+            // Progress along the path follows a jerk-limited S-curve profile.
             bool useTrajectory = false;
-            long trajStartX = 0, trajStartY = 0, trajStartZ = 0, trajStartE = 0;
-            long trajTargetX = setpointX, trajTargetY = setpointY, trajTargetZ = setpointZ, trajTargetE = setpointE;
+            bool useArc = false;
+            ArcPath arcPath;
+            float trajStartCart[NUM_AXES] = { 0, 0, 0, 0 };
+            float trajDeltaCart[NUM_AXES] = { 0, 0, 0, 0 };
             float trajDurationMs = 0.0f;
-            float totalDistanceCounts = 0.0f;
+            float trajDistMm = 0.0f;
+            float trajFeed = 0.0f;          // programmed feed (mm/s)
+            float trajVelLimit = 0.0f;      // path velocity allowed by the axes (0 = none)
+            float trajPlannedVel = 0.0f;    // cruise velocity of the current plan (mm/s)
+            float trajAccel = 0.0f, trajJerk = 0.0f;
+            float plannedMultiplier = 1.0f; // speed override the profile was planned with
+            SCurveProfile profile;
+            // The profile is re-planned mid-move when the override changes;
+            // it then starts at profileStartS (move clock), profileOffsetMm along the path
+            float profileStartS = 0.0f;
+            float profileOffsetMm = 0.0f;
             if (cmd.feedrate > 0) {
-                // Use actual encoder positions as the start point
-                trajStartX = encX; trajStartY = encY; trajStartZ = encZ; trajStartE = encE;
-                long dx = trajTargetX - trajStartX;
-                long dy = trajTargetY - trajStartY;
-                long dz = trajTargetZ - trajStartZ;
-                long de = trajTargetE - trajStartE;
-                totalDistanceCounts = sqrt((float)dx*(float)dx + (float)dy*(float)dy + (float)dz*(float)dz + (float)de*(float)de);
-                if (totalDistanceCounts > 0.0f) {
-                    // distance in mm = counts / 100.0
-                    float dist_mm = totalDistanceCounts / 100.0f;
-                    // apply run speed multiplier
-                    float effectiveFeed = (float)cmd.feedrate * runSpeedMultiplier;
-                    if (effectiveFeed < 0.001f) effectiveFeed = 0.001f;
-                    // feedrate is mm per minute -> convert to ms: durationMs = dist_mm (mm) / (feedrate mm/min) * 60000 ms/min
-                    trajDurationMs = (dist_mm / effectiveFeed) * 60000.0f;
+                float dist_mm = 0.0f;
+                if (cmd.isArc && !cmd.isHoming) {
+                    // The arc center was planned from the previous commanded
+                    // point, so the circle always starts there
+                    useArc = arcPath.begin(cartPrev, cartTarget, cmd.arcCenterXmm, cmd.arcCenterYmm, cmd.arcSweep);
+                    if (useArc) dist_mm = arcPath.length();
+                } else {
+                    // Start from the actual encoder positions, or from the previous
+                    // commanded point when the last segment blended into this one
+                    if (lastBlended && !cmd.isHoming) {
+                        for (int i = 0; i < NUM_AXES; ++i) trajStartCart[i] = cartPrev[i];
+                    } else {
+                        const long encStart[NUM_AXES] = { encX, encY, encZ, encE };
+                        countsToCartesian(encStart, trajStartCart);
+                    }
+                    float dist2 = 0.0f;
+                    for (int i = 0; i < NUM_AXES; ++i) {
+                        trajDeltaCart[i] = cartTarget[i] - trajStartCart[i];
+                        dist2 += trajDeltaCart[i] * trajDeltaCart[i];
+                    }
+                    dist_mm = sqrtf(dist2);
+                }
+                if (dist_mm > 0.0f) {
+                    // Path velocity/acceleration/jerk limits follow from the
+                    // per-axis limits and the share of the motion each axis carries
+                    float unit[NUM_AXES];
+                    if (useArc) {
+                        // X and Y trade off around the circle; budget both at the planar share
+                        float planar = fabsf(cmd.arcSweep) * hypotf(cartPrev[AXIS_X] - cmd.arcCenterXmm, cartPrev[AXIS_Y] - cmd.arcCenterYmm) / dist_mm;
+                        unit[AXIS_X] = unit[AXIS_Y] = planar;
+                        unit[AXIS_Z] = fabsf(cartTarget[AXIS_Z] - cartPrev[AXIS_Z]) / dist_mm;
+                        unit[AXIS_E] = fabsf(cartTarget[AXIS_E] - cartPrev[AXIS_E]) / dist_mm;
+                    } else {
+                        for (int i = 0; i < NUM_AXES; ++i) unit[i] = fabsf(trajDeltaCart[i]) / dist_mm;
+                    }
+                    const float feedLimits[NUM_AXES] = { maxFeedrateX / 60.0f, maxFeedrateY / 60.0f, maxFeedrateZ / 60.0f, maxFeedrateE / 60.0f };
+                    const float accelLimits[NUM_AXES] = { maxAccelX, maxAccelY, maxAccelZ, maxAccelE };
+                    const float jerkLimits[NUM_AXES] = { maxJerkX, maxJerkY, maxJerkZ, maxJerkE };
+                    trajVelLimit = pathLimit(feedLimits, unit);
+                    trajAccel = pathLimit(accelLimits, unit);
+                    trajJerk = pathLimit(jerkLimits, unit);
+                    if (useArc) {
+                        // keep the centripetal acceleration v^2/r within the planar limit
+                        float r = hypotf(cartPrev[AXIS_X] - cmd.arcCenterXmm, cartPrev[AXIS_Y] - cmd.arcCenterYmm);
+                        float vCentripetal = sqrtf(fminf(maxAccelX, maxAccelY) * r);
+                        if (trajVelLimit <= 0.0f || trajVelLimit > vCentripetal) trajVelLimit = vCentripetal;
+                    }
+                    // Programmed feed (mm/s) scaled by the speed override, never
+                    // beyond what the axes can track
+                    trajFeed = (float)cmd.feedrate / 60.0f;
+                    plannedMultiplier = runSpeedMultiplier;
+                    float vmax = trajFeed * plannedMultiplier;
+                    if (trajVelLimit > 0.0f && vmax > trajVelLimit) vmax = trajVelLimit;
+                    if (vmax < 0.001f) vmax = 0.001f;
+                    trajPlannedVel = vmax;
+                    trajDurationMs = profile.plan(dist_mm, vmax, trajAccel, trajJerk) * 1000.0f;
+                    trajDistMm = dist_mm;
                     if (trajDurationMs < 1.0f) trajDurationMs = 1.0f;
                     useTrajectory = true;
                 }
             }
 
-            // Reset pause accounting for this command
+            // Time spent parked in a feed hold doesn't count towards the timeout
             unsigned long pauseAccumMs = 0;
-            unsigned long pauseStartMs = 0;
+            bool parked = false;
 
             // Execute command until completion or timeout/halt
             unsigned long startTime = millis();
+            unsigned long lastTick = startTime;
+            feedHold.startMove();
             bool finished = false;
+            bool blended = false;
+            lastBlended = false;
             while (!isHalted) {
                 // Handle run stop: immediate cancel of this command
                 if (runStopped) {
-                    // Stop motors, clear queues and release executor
-                    motorX.setSpeed(0); motorY.setSpeed(0); motorZ.setSpeed(0); motorE.setSpeed(0);
-                    // Clear pending motion commands
-                    if (motionQueue != NULL) xQueueReset(motionQueue);
-                    if (commandQueue != NULL) xQueueReset(commandQueue);
-                    if (webServer) webServer->sendResponseToClient(cmd.ownerType, cmd.ownerId, String("ok:stopped"));
-                    // release ownership (protected)
-                    portENTER_CRITICAL(&g_executorMux);
-                    executorBusy = false; executorOwnerType = SRC_SERIAL; executorOwnerId = -1;
-                    portEXIT_CRITICAL(&g_executorMux);
-                    runStopped = false; // clear
+                    stopRun(cmd);
                     finished = false;
                     break;
                 }
 
-                // Handle pause: park motors but keep ownership and adjust pause accounting
-                if (runPaused) {
-                    // record pause start if not already
-                    if (pauseStartMs == 0) pauseStartMs = millis();
+                // Feed hold. A trajectory slows down along its path at the
+                // path's acceleration limit, with its clock frozen once
+                // stopped; a move without one can only park at once.
+                unsigned long now = millis();
+                if (useTrajectory && runPaused != feedHold.holding()) {
+                    float sNow, vNow;
+                    profile.evaluate(feedHold.profileTime() - profileStartS, sNow, vNow);
+                    feedHold.request(runPaused, vNow, trajAccel);
+                }
+                if (runPaused && (!useTrajectory || feedHold.held())) {
+                    // Parked: motors off but ownership kept
                     motorX.setSpeed(0); motorY.setSpeed(0); motorZ.setSpeed(0); motorE.setSpeed(0);
+                    writeLaser(0);
+                    laserVelCount = 0;
+                    if (parked) pauseAccumMs += now - lastTick;
+                    parked = true;
+                    lastTick = now;
                     vTaskDelay(10 / portTICK_PERIOD_MS);
                     continue; // stay in pause loop until unpaused or stopped
-                } else {
-                    // if we were paused, accumulate pause duration
-                    if (pauseStartMs != 0) {
-                        pauseAccumMs += (millis() - pauseStartMs);
-                        pauseStartMs = 0;
-                    }
                 }
+                if (parked) {
+                    // Restarting from standstill: the PIDs and stall timers
+                    // must not count the time spent parked
+                    pauseAccumMs += now - lastTick;
+                    parked = false;
+                    pidX.reset(); pidY.reset(); pidZ.reset(); pidE.reset();
+                    lastEncChangeX = lastEncChangeY = lastEncChangeZ = lastEncChangeE = now;
+                }
+                float dtS = (float)(now - lastTick) / 1000.0f;
+                lastTick = now;
+
                 // Determine desired setpoints (if using trajectory, compute time-based desired positions)
                 long desiredX = setpointX;
                 long desiredY = setpointY;
                 long desiredZ = setpointZ;
                 long desiredE = setpointE;
-                unsigned long now = millis();
+                bool trajectoryDone = false;
+                float commandedVel = 0.0f; // path velocity of the profile this tick (mm/s)
+                // Move time (ms) for the timeout: the trajectory's own clock,
+                // or wall time less any parked time
+                float elapsed = (float)(now - startTime - pauseAccumMs);
                 if (useTrajectory) {
-                    float elapsed = (float)(now - startTime);
-                    float frac = elapsed / trajDurationMs;
-                    if (frac > 1.0f) frac = 1.0f;
-                    desiredX = trajStartX + (long)round((trajTargetX - trajStartX) * frac);
-                    desiredY = trajStartY + (long)round((trajTargetY - trajStartY) * frac);
-                    desiredZ = trajStartZ + (long)round((trajTargetZ - trajStartZ) * frac);
-                    desiredE = trajStartE + (long)round((trajTargetE - trajStartE) * frac);
+                    // The profile runs on the feed-hold clock, which matches
+                    // real time except while slowing down, held or speeding up
+                    elapsed = feedHold.advance(dtS) * 1000.0f;
+                    float tProfile = elapsed / 1000.0f - profileStartS;
+                    // Speed override changed: re-plan the rest of the move from the
+                    // current velocity. Done while cruising so acceleration stays
+                    // continuous; moves without a cruise keep their plan and the
+                    // next move picks the new override up.
+                    if (runSpeedMultiplier != plannedMultiplier && feedHold.fullSpeed() && profile.cruising(tProfile)) {
+                        float sNow, vNow;
+                        profile.evaluate(tProfile, sNow, vNow);
+                        float vNew = trajFeed * runSpeedMultiplier;
+                        if (trajVelLimit > 0.0f && vNew > trajVelLimit) vNew = trajVelLimit;
+                        if (vNew < 0.001f) vNew = 0.001f;
+                        SCurveProfile replanned;
+                        float T = replanned.plan(profile.distance() - sNow, vNew, trajAccel, trajJerk, vNow);
+                        if (T > 0.0f) {
+                            profile = replanned;
+                            profileOffsetMm += sNow;
+                            profileStartS = elapsed / 1000.0f;
+                            tProfile = 0.0f;
+                            trajDurationMs = elapsed + T * 1000.0f;
+                            trajPlannedVel = vNew;
+                            plannedMultiplier = runSpeedMultiplier;
+                        }
+                        // else: keep the old plan and multiplier, and retry
+                        // while the move is still cruising
+                    }
+                    float pathPos, pathVel;
+                    profile.evaluate(tProfile, pathPos, pathVel);
+                    commandedVel = pathVel * feedHold.rate();
+                    float frac = (profileOffsetMm + pathPos) / trajDistMm;
+                    if (elapsed >= trajDurationMs || frac >= 1.0f) { frac = 1.0f; trajectoryDone = true; }
+                    float cart[NUM_AXES];
+                    long desired[NUM_AXES];
+                    if (useArc) arcPath.at(frac, cart);
+                    else for (int i = 0; i < NUM_AXES; ++i) cart[i] = trajStartCart[i] + trajDeltaCart[i] * frac;
+                    if (cartesianToCounts(cart, desired)) {
+                        desiredX = desired[AXIS_X]; desiredY = desired[AXIS_Y]; desiredZ = desired[AXIS_Z]; desiredE = desired[AXIS_E];
+                    }
 
                     // Trajectory deviation handling: warn range and halt range (broadcasted)
-                    if (cmd.hasX) {
+                    if (activeX) {
                         long dev = labs(encX - desiredX);
                         if (dev > POSITION_HALT_TOLERANCE_COUNTS) {
                             isHalted = true; haltReason = "X position deviation";
@@ -770,7 +1448,7 @@ void controlTask(void *pvParameters) {
                             }
                         }
                     }
-                    if (cmd.hasY) {
+                    if (activeY) {
                         long dev = labs(encY - desiredY);
                         if (dev > POSITION_HALT_TOLERANCE_COUNTS) {
                             isHalted = true; haltReason = "Y position deviation";
@@ -784,7 +1462,7 @@ void controlTask(void *pvParameters) {
                             }
                         }
                     }
-                    if (cmd.hasZ) {
+                    if (activeZ) {
                         long dev = labs(encZ - desiredZ);
                         if (dev > POSITION_HALT_TOLERANCE_COUNTS) {
                             isHalted = true; haltReason = "Z position deviation";
@@ -798,7 +1476,7 @@ void controlTask(void *pvParameters) {
                             }
                         }
                     }
-                    if (cmd.hasE) {
+                    if (activeE) {
                         long dev = labs(encE - desiredE);
                         if (dev > POSITION_HALT_TOLERANCE_COUNTS) {
                             isHalted = true; haltReason = "E position deviation";
@@ -814,6 +1492,46 @@ void controlTask(void *pvParameters) {
                     }
                 }
 
+                // Laser power: constant (re-asserted after a pause), or in
+                // dynamic mode scaled by actual / planned velocity so slow
+                // corners and ramps do not burn deeper. The planned velocity
+                // is the feed after the override and the axis limits, so a
+                // move capped below its F still reaches full power.
+                if (cmd.laserMode != LASER_DYNAMIC) laserVelCount = 0;
+                if (cmd.laserMode == LASER_CONSTANT) {
+                    writeLaser(cmd.laserPower);
+                } else if (cmd.laserMode == LASER_DYNAMIC) {
+                    const long encNow[NUM_AXES] = { encX, encY, encZ, encE };
+                    float cartNow[NUM_AXES];
+                    countsToCartesian(encNow, cartNow);
+                    int pwm = cmd.laserPower; // no programmed speed: full S
+                    if (useTrajectory && trajPlannedVel > 0.0f) {
+                        // Until the window has filled, trust the trajectory's
+                        // commanded velocity
+                        float actual = commandedVel;
+                        if (laserVelCount >= LASER_VELOCITY_WINDOW) {
+                            const float* old = laserVelHist[laserVelIdx];
+                            float dx = cartNow[AXIS_X] - old[0], dy = cartNow[AXIS_Y] - old[1], dz = cartNow[AXIS_Z] - old[2];
+                            actual = sqrtf(dx * dx + dy * dy + dz * dz) * 1000.0f / LASER_VELOCITY_WINDOW;
+                        }
+                        float ratio = actual / trajPlannedVel;
+                        if (ratio > 1.0f) ratio = 1.0f;
+                        pwm = lroundf(cmd.laserPower * ratio);
+                    }
+                    laserVelHist[laserVelIdx][0] = cartNow[AXIS_X];
+                    laserVelHist[laserVelIdx][1] = cartNow[AXIS_Y];
+                    laserVelHist[laserVelIdx][2] = cartNow[AXIS_Z];
+                    laserVelIdx = (laserVelIdx + 1) % LASER_VELOCITY_WINDOW;
+                    laserVelCount++;
+                    writeLaser(pwm);
+                } else if (cmd.laserMode == LASER_RASTER && cmd.rasterSlot >= 0) {
+                    // Raster row: burn the pixel currently under the head
+                    const long encNow[NUM_AXES] = { encX, encY, encZ, encE };
+                    float cartNow[NUM_AXES];
+                    countsToCartesian(encNow, cartNow);
+                    writeLaser(rasterPixelAt(rasterRows.row(cmd.rasterSlot), cmd.rasterWidth, cmd.rasterOriginXmm, cmd.rasterPitchMm, cartNow[AXIS_X]));
+                }
+
                 // Compute outputs toward desired setpoints
                 int outX = pidX.compute(desiredX, encX);
                 int outY = pidY.compute(desiredY, encY);
@@ -837,9 +1555,10 @@ void controlTask(void *pvParameters) {
                 if (encZ != lastSeenEncZ) { lastSeenEncZ = encZ; lastEncChangeZ = now; }
                 if (encE != lastSeenEncE) { lastSeenEncE = encE; lastEncChangeE = now; }
 
-                // Check following deviation warnings & halts
-                if (cmd.hasX) {
-                    long d = abs(setpointX - encX);
+                // Check following deviation warnings & halts (against the
+                // trajectory point, not the final target of a long move)
+                if (activeX) {
+                    long d = abs(desiredX - encX);
                     if (d > FOLLOWING_ERROR_WARN && webServer) webServer->sendResponseToClient(cmd.ownerType, cmd.ownerId, String("warn:X_following"));
                     if (d > FOLLOWING_ERROR_HALT) {
                         isHalted = true; haltReason = "X following error";
@@ -848,8 +1567,8 @@ void controlTask(void *pvParameters) {
                         break;
                     }
                 }
-                if (cmd.hasY) {
-                    long d = abs(setpointY - encY);
+                if (activeY) {
+                    long d = abs(desiredY - encY);
                     if (d > FOLLOWING_ERROR_WARN && webServer) webServer->sendResponseToClient(cmd.ownerType, cmd.ownerId, String("warn:Y_following"));
                     if (d > FOLLOWING_ERROR_HALT) {
                         isHalted = true; haltReason = "Y following error";
@@ -858,8 +1577,8 @@ void controlTask(void *pvParameters) {
                         break;
                     }
                 }
-                if (cmd.hasZ) {
-                    long d = abs(setpointZ - encZ);
+                if (activeZ) {
+                    long d = abs(desiredZ - encZ);
                     if (d > FOLLOWING_ERROR_WARN && webServer) webServer->sendResponseToClient(cmd.ownerType, cmd.ownerId, String("warn:Z_following"));
                     if (d > FOLLOWING_ERROR_HALT) {
                         isHalted = true; haltReason = "Z following error";
@@ -868,8 +1587,8 @@ void controlTask(void *pvParameters) {
                         break;
                     }
                 }
-                if (cmd.hasE) {
-                    long d = abs(setpointE - encE);
+                if (activeE) {
+                    long d = abs(desiredE - encE);
                     if (d > FOLLOWING_ERROR_WARN && webServer) webServer->sendResponseToClient(cmd.ownerType, cmd.ownerId, String("warn:E_following"));
                     if (d > FOLLOWING_ERROR_HALT) {
                         isHalted = true; haltReason = "E following error";
@@ -917,15 +1636,24 @@ void controlTask(void *pvParameters) {
                     }
                 }
 
+                // Blended segment: once its trajectory has played out and the
+                // next segment is already queued, hand over without settling
+                if (cmd.blend && trajectoryDone && uxQueueMessagesWaiting(motionQueue) > 0) {
+                    finished = true; blended = true;
+                    break;
+                }
+
                 // Check finished
                 bool done = true;
-                if (cmd.hasX && abs(setpointX - encX) > POSITION_TOLERANCE) done = false;
-                if (cmd.hasY && abs(setpointY - encY) > POSITION_TOLERANCE) done = false;
-                if (cmd.hasZ && abs(setpointZ - encZ) > POSITION_TOLERANCE) done = false;
-                if (cmd.hasE && abs(setpointE - encE) > POSITION_TOLERANCE) done = false;
+                if (activeX && abs(setpointX - encX) > POSITION_TOLERANCE) done = false;
+                if (activeY && abs(setpointY - encY) > POSITION_TOLERANCE) done = false;
+                if (activeZ && abs(setpointZ - encZ) > POSITION_TOLERANCE) done = false;
+                if (activeE && abs(setpointE - encE) > POSITION_TOLERANCE) done = false;
                 if (done) { finished = true; break; }
 
-                if ((now - startTime) > COMMAND_EXECUTE_TIMEOUT_MS) {
+                // The timeout runs on top of the planned trajectory time so long
+                // moves (e.g. a full native circle) are not cut short
+                if (elapsed > trajDurationMs + COMMAND_EXECUTE_TIMEOUT_MS) {
                     isHalted = true;
                     haltReason = "Command timeout";
                     // Turn off spindle/laser on timeout
@@ -937,45 +1665,29 @@ void controlTask(void *pvParameters) {
                 vTaskDelayUntil(&xLastWakeTime, xFrequency);
             }
 
-            // Stop motors for this command
-            motorX.setSpeed(0); motorY.setSpeed(0); motorZ.setSpeed(0); motorE.setSpeed(0);
+            // The owner's lease runs from the end of its last move
+            executorOwner.end(cmd.ownerType, cmd.ownerId, millis(), EXECUTOR_LEASE_MS);
+            moveInProgress = false;
 
-            // Respond to originating client
-            if (finished && webServer) webServer->sendResponseToClient(cmd.ownerType, cmd.ownerId, String("ok"));
-
-            // Allow a small grace period for additional commands from same owner
-            unsigned long graceStart = millis();
-            bool keepOwnership = false;
-            while ((millis() - graceStart) < 250) {
-                MotionCommand nextCmd;
-                if (xQueueReceive(motionQueue, &nextCmd, 0) == pdTRUE) {
-                    if (nextCmd.ownerType == executorOwnerType && nextCmd.ownerId == executorOwnerId) {
-                        // process inline by setting cmd to nextCmd and continuing
-                        cmd = nextCmd;
-                        keepOwnership = true;
-                        break; // outer while will now continue (we will loop back)
-                    } else {
-                        // requeue for later
-                        Serial.printf("controlTask: requeueing command from %d/%d for later\n", nextCmd.ownerType, nextCmd.ownerId);
-                        xQueueSend(motionQueue, &nextCmd, 0);
-                        break;
-                    }
-                }
-                vTaskDelay(5 / portTICK_PERIOD_MS);
-            }
-
-            if (keepOwnership) {
-                // continue processing next command from same owner immediately
+            // Keep driving into the next segment when blending
+            if (blended) {
+                lastBlended = true;
                 continue;
             }
 
-            // release executor (protected)
-            Serial.printf("controlTask: releasing executor from %d/%d\n", executorOwnerType, executorOwnerId);
-            portENTER_CRITICAL(&g_executorMux);
-            executorBusy = false;
-            executorOwnerType = SRC_SERIAL;
-            executorOwnerId = -1;
-            portEXIT_CRITICAL(&g_executorMux);
+            // Stop motors for this command; a dynamic laser has no speed left
+            motorX.setSpeed(0); motorY.setSpeed(0); motorZ.setSpeed(0); motorE.setSpeed(0);
+            if (cmd.laserMode == LASER_DYNAMIC || cmd.laserMode == LASER_RASTER) writeLaser(0);
+            laserVelCount = 0;
+            rasterRows.release(cmd.rasterSlot);
+
+            // Respond to originating client (blended arc segments are acknowledged
+            // once, by the final segment)
+            if (finished && !cmd.blend && webServer) webServer->sendResponseToClient(cmd.ownerType, cmd.ownerId, String("ok"));
+        } else if (runStopped) {
+            // Nothing was moving: the stop only ends the session
+            executorOwner.reset();
+            runStopped = false;
         }
 
         // Small scheduling delay (keep loop predictable)
@@ -984,8 +1696,14 @@ void controlTask(void *pvParameters) {
 }
 
 void setup() {
+    bootMark(BOOT_SETUP);
     Serial.begin(115200);
 
+    // Settings first: one NVS blob read fills every registry variable
+    settingsBlobLock = xSemaphoreCreateMutex();
+    settingsLoad();
+    bootMark(BOOT_SETTINGS);
+
     // Init Hardware
     motorX.begin(); motorY.begin(); motorZ.begin(); motorE.begin();
     thermal.begin();
@@ -1001,20 +1719,20 @@ void setup() {
         pinMode(PIN_SPINDLE, OUTPUT);
         ledcSetup(PWM_CHAN_SPINDLE, PWM_FREQ, PWM_RES);
         ledcAttachPin(PIN_SPINDLE, PWM_CHAN_SPINDLE);
-        // Restore persisted spindle power (if any)
-        Preferences prefs; prefs.begin("cnc", true);
-        spindlePower = prefs.getInt("spindle_p", 0);
-        prefs.end();
-        ledcWrite(PWM_CHAN_SPINDLE, constrain(spindlePower, 0, 255));
+        // The spindle always starts stopped
+        ledcWrite(PWM_CHAN_SPINDLE, 0);
+#if PIN_SPINDLE_TACH >= 0
+        pinMode(PIN_SPINDLE_TACH, INPUT_PULLUP);
+        spindleTachBegin();
+        spindle.setClosedLoop(true);
+#endif
     }
     if (PIN_LASER >= 0) {
         pinMode(PIN_LASER, OUTPUT);
         ledcSetup(PWM_CHAN_LASER, PWM_FREQ, PWM_RES);
         ledcAttachPin(PIN_LASER, PWM_CHAN_LASER);
         // Restore persisted laser power (if any)
-        Preferences lprefs; lprefs.begin("cnc", true);
-        laserPower = lprefs.getInt("laser_p", 0);
-        lprefs.end();
+        laserPower = savedLaserPower;
         ledcWrite(PWM_CHAN_LASER, constrain(laserPower, 0, 255));
     }
 
@@ -1036,14 +1754,22 @@ void setup() {
 
     // Init RTOS Objects
     gcodeStream = xStreamBufferCreate(1024, 1);
+    gcodeStreamSignal = xSemaphoreCreateBinary();
     motionQueue = xQueueCreate(10, sizeof(MotionCommand));
     commandQueue = xQueueCreate(32, sizeof(RawCommand));
+    parserInputs = xQueueCreateSet(32 + 1);
+    xQueueAddToSet(commandQueue, parserInputs);
+    xQueueAddToSet(gcodeStreamSignal, parserInputs);
 
     // Create Tasks
-    xTaskCreatePinnedToCore(networkTask, "Network", 4096, NULL, 1, NULL, 0);
     xTaskCreatePinnedToCore(thermalTask, "Thermal", 2048, NULL, 1, NULL, 0);
+    xTaskCreatePinnedToCore(settingsTask, "Settings", 3072, NULL, 1, NULL, 0);
+    if (PIN_SPINDLE >= 0) xTaskCreatePinnedToCore(spindleTask, "Spindle", 2048, NULL, 1, NULL, 0);
     xTaskCreatePinnedToCore(parserTask, "Parser", 4096, NULL, 1, NULL, 1);
     xTaskCreatePinnedToCore(controlTask, "Control", 4096, NULL, 2, NULL, 1); // High Priority
+    // Network last: filesystem mount and WiFi bring-up never delay motion
+    xTaskCreatePinnedToCore(networkTask, "Network", 4096, NULL, 1, NULL, 0);
+    bootMark(BOOT_TASKS);
 }
 
 void loop() {
@@ -1,9 +1,15 @@
 #include "web_server.h"
 #include <SD.h>
 #include <FS.h>
-
-// Global executor spinlock (shared across translation units)
-portMUX_TYPE g_executorMux = portMUX_INITIALIZER_UNLOCKED;
+#include "esp_timer.h"
+#include "mbedtls/sha256.h"
+
+// Scoped hold of one of the connection locks (wsLock / telnetLock)
+struct NetLock {
+    SemaphoreHandle_t m;
+    explicit NetLock(SemaphoreHandle_t mutex) : m(mutex) { xSemaphoreTakeRecursive(m, portMAX_DELAY); }
+    ~NetLock() { xSemaphoreGiveRecursive(m); }
+};
 
 WebServerManager::WebServerManager(ThermalManager* t, StreamBufferHandle_t* stream, QueueHandle_t* cmdQueue) {
     thermal = t;
@@ -13,6 +19,8 @@ WebServerManager::WebServerManager(ThermalManager* t, StreamBufferHandle_t* stre
     ws = new WebSocketsServer(81);
     telnetServer = new WiFiServer(23); // Telnet Port
     dnsServer = new DNSServer();
+    wsLock = xSemaphoreCreateRecursiveMutex();
+    telnetLock = xSemaphoreCreateRecursiveMutex();
     isAPMode = false;
     // nothing to initialize for waiters here
 }
@@ -37,15 +45,50 @@ struct JobStreamArgs {
 volatile bool jobActive = false;
 static volatile bool jobStopRequested = false;
 static char currentJobFile[128] = "";
+static portMUX_TYPE jobMux = portMUX_INITIALIZER_UNLOCKED;
+
+// The job slot: one job (stored file, streamed print or queue entry) feeds
+// the machine at a time, and holds the executor until it ends so no client
+// can jog in between its moves. Returns why not, or nullptr once claimed.
+static const char* jobClaim(const char* name) {
+    portENTER_CRITICAL(&jobMux);
+    bool ok = !jobActive;
+    jobActive = true;
+    portEXIT_CRITICAL(&jobMux);
+    if (!ok) return "a job is already running";
+    if (!executorOwner.claim(SRC_JOB, 0, millis(), 0)) {
+        jobActive = false;
+        return "executor busy";
+    }
+    jobStopRequested = false;
+    strncpy(currentJobFile, name, sizeof(currentJobFile)-1);
+    currentJobFile[sizeof(currentJobFile)-1] = '\0';
+    return nullptr;
+}
+
+static void jobRelease() {
+    jobStopRequested = false;
+    currentJobFile[0] = '\0';
+    executorOwner.release(SRC_JOB, 0);
+    jobActive = false;
+}
+
+// Wait until everything sent so far has been parsed and executed. A job
+// keeps the slot and executor until then: its last lines are still in the
+// stream and the motion queue when the feeder returns.
+static void waitMachineIdle(StreamBufferHandle_t* stream) {
+    int quiet = 0;
+    while (quiet < 3 && !jobStopRequested) {
+        bool idle = xStreamBufferBytesAvailable(*stream) == 0 && uxQueueMessagesWaiting(motionQueue) == 0 &&
+                    !executorOwner.view(millis()).active;
+        quiet = idle ? quiet + 1 : 0;
+        vTaskDelay(pdMS_TO_TICKS(50));
+    }
+}
 
 // SD availability flag (attempt to init in setupFileSystem)
 static bool sdAvailable = false;
 
-// Executor reservation timeout (ms)
-static const uint32_t EXECUTOR_RESERVATION_MS = 5000;
-// Reservation expiry timestamp (millis) when set during push-time reservation.
-volatile unsigned long executorReservedUntil = 0;
-
 // Background task which waits for queue space and enqueues the command,
 // then sends the appropriate response back to the originating client.
 static void enqueueWaiterTask(void* pvParameters) {
@@ -76,43 +119,23 @@ static void enqueueWaiterTask(void* pvParameters) {
     vTaskDelete(NULL);
 }
 
-// Background task which streams a G-Code file into the gcode stream buffer.
-// Runs off the network thread so file IO doesn't block HTTP handlers.
-static void jobStreamerTask(void* pvParameters) {
-    JobStreamArgs* args = reinterpret_cast<JobStreamArgs*>(pvParameters);
-    WebServerManager* self = args->mgr;
-    StreamBufferHandle_t* gcodeStream = args->gcodeStream;
-
-    jobActive = true;
-    jobStopRequested = false;
-    strncpy(currentJobFile, args->filename, sizeof(currentJobFile)-1);
-    currentJobFile[sizeof(currentJobFile)-1] = '\0';
-
-    // Broadcast job started
-    if (self) self->broadcastJobEvent("started", args->filename, (args->storage == STORAGE_SD) ? "sd" : "littlefs", -1);
-
+// Open a job file from the selected storage. Reports failures to clients
+// (the caller sends the "error" job event).
+static bool openJobFile(WebServerManager* self, JobStreamArgs* args, File &f) {
     String path;
-    File f;
     if (args->storage == STORAGE_SD) {
         path = String(args->filename); // SD paths are root-relative on SD
         Serial.printf("jobStreamer: starting job from SD %s\n", path.c_str());
         if (!sdAvailable) {
             Serial.printf("jobStreamer: SD not available for %s\n", path.c_str());
             if (self) self->broadcastError(String("Job open failed (SD not available): ") + path);
-            jobActive = false;
-            delete args;
-            vTaskDelete(NULL);
-            return;
+            return false;
         }
         f = SD.open(path, FILE_READ);
         if (!f) {
             Serial.printf("jobStreamer: failed to open SD %s\n", path.c_str());
             if (self) self->broadcastError(String("Job open failed: ") + path);
-            if (self) self->broadcastJobEvent("error", args->filename, "sd", -1);
-            jobActive = false;
-            delete args;
-            vTaskDelete(NULL);
-            return;
+            return false;
         }
     } else {
         path = String("/gcode/") + String(args->filename);
@@ -121,13 +144,18 @@ static void jobStreamerTask(void* pvParameters) {
         if (!f) {
             Serial.printf("jobStreamer: failed to open %s\n", path.c_str());
             if (self) self->broadcastError(String("Job open failed: ") + path);
-            if (self) self->broadcastJobEvent("error", args->filename, "littlefs", -1);
-            jobActive = false;
-            delete args;
-            vTaskDelete(NULL);
-            return;
+            return false;
         }
     }
+    return true;
+}
+
+// Stream a G-Code file into the gcode stream buffer, honouring stop
+// requests. Returns the job event: "finished", "stopped" or "error".
+static const char* runGcodeJob(WebServerManager* self, JobStreamArgs* args) {
+    StreamBufferHandle_t* gcodeStream = args->gcodeStream;
+    File f;
+    if (!openJobFile(self, args, f)) return "error";
 
     // Read line-by-line and push into gcode stream buffer. Honor stop request.
     char linebuf[256];
@@ -139,53 +167,217 @@ static void jobStreamerTask(void* pvParameters) {
         linebuf[len] = '\0';
         // Send to gcode stream; block briefly to avoid busy-looping if buffer full
         if (gcodeStream != NULL) {
-            xStreamBufferSend(*gcodeStream, linebuf, len + 1, pdMS_TO_TICKS(200));
+            gcodeStreamWrite(linebuf, len + 1, pdMS_TO_TICKS(200));
         }
         // tiny pause to let parser pick up lines; this also yields CPU
         vTaskDelay(pdMS_TO_TICKS(1));
     }
 
     f.close();
-    // Broadcast job finished (unless stop requested was set)
-    if (self) self->broadcastJobEvent(jobStopRequested ? "stopped" : "finished", args->filename, (args->storage == STORAGE_SD) ? "sd" : "littlefs", -1);
-    jobActive = false;
-    jobStopRequested = false;
-    currentJobFile[0] = '\0';
     Serial.println("jobStreamer: finished");
+    return jobStopRequested ? "stopped" : "finished";
+}
+
+// Run a raster engraving job (.e3r, see raster.h). Rows are read into the
+// raster row pool and queued as scan moves directly on the motion queue;
+// controlTask drives the laser from the row buffer by encoder X position,
+// so the G-code text path is not involved at all.
+static const char* runRasterJob(WebServerManager* self, JobStreamArgs* args) {
+    File f;
+    if (!openJobFile(self, args, f)) return "error";
+    RasterHeader h;
+    uint8_t hdrBuf[RASTER_HEADER_SIZE];
+    bool ok = f.read(hdrBuf, RASTER_HEADER_SIZE) == RASTER_HEADER_SIZE && h.parse(hdrBuf, RASTER_HEADER_SIZE);
+    if (!ok) {
+        Serial.printf("rasterStreamer: invalid raster header in %s\n", args->filename);
+        if (self) self->broadcastError(String("Invalid raster file: ") + args->filename);
+    } else {
+        float v = h.feed / 60.0f;
+        float ramp = 0.5f * v * (v / maxAccelX + maxAccelX / maxJerkX);
+        Serial.printf("rasterStreamer: %ux%u px, pitch %.3f/%.3f mm, F%.0f, overscan %.2f mm (X ramp ~%.2f mm)\n",
+                      h.width, h.height, h.pitchX, h.pitchY, h.feed, h.overscan, ramp);
+        if (h.overscan < ramp && self) self->broadcastWarning("Raster overscan shorter than the X acceleration ramp");
+    }
+    // Raster moves skip the planner, so the soft limits are checked here for
+    // the whole engraving: every row, overscan included
+    if (ok && softLimitsRequireHomed && !machineHomed) {
+        if (self) self->broadcastError(String("Raster job refused (not homed): ") + args->filename);
+        ok = false;
+    }
+    if (ok) {
+        RasterRowPlan first = rasterPlanRow(h, 0, 0), last = rasterPlanRow(h, h.height - 1, 0);
+        const float bmin[2] = { fminf(first.startX, first.endX), fminf(first.y, last.y) };
+        const float bmax[2] = { fmaxf(first.startX, first.endX), fmaxf(first.y, last.y) };
+        SoftLimitViolation v;
+        if (!travelEnvelope.containsBox(bmin, bmax, &v, 2)) {
+            char why[64];
+            softLimitDescribe(why, sizeof(why), v);
+            Serial.printf("rasterStreamer: %s leaves the travel envelope: %s\n", args->filename, why);
+            if (self) self->broadcastError(String("Raster job refused, soft limit: ") + why);
+            ok = false;
+        }
+    }
+
+    MotionCommand m;
+    memset(&m, 0, sizeof(m));
+    m.hasX = true; m.hasY = true;
+    m.isRelative = false;
+    m.ownerType = SRC_JOB; m.ownerId = 0;
+    m.rasterSlot = -1;
+    // Queue a move, giving up if the job is stopped while the queue is full
+    auto queueMove = [&](const MotionCommand &cmd) -> bool {
+        while (!jobStopRequested) {
+            if (motionSend(cmd, pdMS_TO_TICKS(100))) return true;
+        }
+        return false;
+    };
+
+    int scanIndex = 0;
+    for (int row = 0; ok && row < h.height && !jobStopRequested; ++row) {
+        // Wait for a free row buffer (rows in flight are released as their scans finish)
+        int slot = -1;
+        while (!jobStopRequested && (slot = rasterRows.acquire()) < 0) vTaskDelay(pdMS_TO_TICKS(2));
+        if (slot < 0) break;
+        if (f.read(rasterRows.row(slot), h.rowBytes()) != h.rowBytes()) {
+            rasterRows.release(slot);
+            Serial.printf("rasterStreamer: file ends at row %d of %u\n", row, h.height);
+            if (self) self->broadcastError(String("Raster file truncated: ") + args->filename);
+            ok = false;
+            break;
+        }
+        if (rasterRowBlank(rasterRows.row(slot), h.width)) { rasterRows.release(slot); continue; }
+
+        RasterRowPlan plan = rasterPlanRow(h, row, scanIndex++);
+        // Position at the run-in point with the laser off, then scan the row
+        m.targetXmm = plan.startX; m.targetYmm = plan.y;
+        m.feedrate = h.feed;
+        m.laserMode = LASER_OFF; m.laserPower = 0;
+        m.rasterSlot = -1;
+        if (!queueMove(m)) { rasterRows.release(slot); break; }
+        m.targetXmm = plan.endX;
+        m.laserMode = LASER_RASTER; m.laserPower = 255;
+        m.rasterSlot = (int8_t)slot;
+        m.rasterWidth = h.width;
+        m.rasterOriginXmm = h.originX;
+        m.rasterPitchMm = h.pitchX;
+        if (!queueMove(m)) { rasterRows.release(slot); break; }
+    }
+
+    f.close();
+    const char* event = !ok ? "error" : (jobStopRequested ? "stopped" : "finished");
+    Serial.printf("rasterStreamer: %s after %d scanned rows\n", event, scanIndex);
+    return event;
+}
+
+static const char* jobStorageName(uint8_t storage) { return storage == STORAGE_SD ? "sd" : "littlefs"; }
+
+static bool jobIsRaster(const char* filename) {
+    String lower = filename; lower.toLowerCase();
+    return lower.endsWith(".e3r");
+}
+
+// Background task for a job started directly (/api/job/start): runs one
+// file off the network thread so file IO doesn't block HTTP handlers.
+// The caller has already claimed the job slot (jobClaim).
+static void jobStreamerTask(void* pvParameters) {
+    JobStreamArgs* args = reinterpret_cast<JobStreamArgs*>(pvParameters);
+    WebServerManager* self = args->mgr;
+    const char* storageName = jobStorageName(args->storage);
+    if (self) self->broadcastJobEvent("started", args->filename, storageName, -1);
+    const char* event = jobIsRaster(args->filename) ? runRasterJob(self, args) : runGcodeJob(self, args);
+    if (!jobStopRequested) waitMachineIdle(args->gcodeStream);
+    if (jobStopRequested && strcmp(event, "finished") == 0) event = "stopped";
+    if (self) self->broadcastJobEvent(event, args->filename, storageName, -1);
+    jobRelease();
     delete args;
     vTaskDelete(NULL);
 }
 
+// Protocol service tasks: each protocol gets its own loop so a slow HTTP
+// handler (file listing, download, upload) never delays WebSocket or
+// telnet command intake
+static void httpTask(void* pv) { ((WebServerManager*)pv)->serviceHttp(); }
+static void wsTask(void* pv) { ((WebServerManager*)pv)->serviceWebSocket(); }
+static void telnetTask(void* pv) { ((WebServerManager*)pv)->serviceTelnet(); }
+
 void WebServerManager::begin() {
     setupFileSystem();
-    setupWiFi(); // Initialize Network
+    bootMark(BOOT_FS);
+    setupWiFi(); // Starts association (or AP mode) without waiting for it
     setupRoutes();
-    
+
     ws->begin();
     ws->onEvent([this](uint8_t num, WStype_t type, uint8_t * payload, size_t length) {
         this->onWebSocketEvent(num, type, payload, length);
     });
-    
+
     server->begin();
     telnetServer->begin();
     telnetServer->setNoDelay(true);
+
+    xTaskCreatePinnedToCore(wsTask, "WS", NET_WS_TASK_STACK, this, NET_WS_TASK_PRIORITY, NULL, 0);
+    xTaskCreatePinnedToCore(telnetTask, "Telnet", NET_TELNET_TASK_STACK, this, NET_TELNET_TASK_PRIORITY, NULL, 0);
+    xTaskCreatePinnedToCore(httpTask, "HTTP", NET_HTTP_TASK_STACK, this, NET_HTTP_TASK_PRIORITY, NULL, 0);
+    bootMark(BOOT_HTTP);
+}
+
+// HTTP, captive DNS and the WiFi state machine
+void WebServerManager::serviceHttp() {
+    int64_t last = esp_timer_get_time();
+    while (true) {
+        int64_t start = esp_timer_get_time();
+        httpLatency.gap.record((uint32_t)(start - last));
+        updateWiFi();
+        if (isAPMode) {
+            dnsServer->processNextRequest();
+        }
+        server->handleClient();
+        last = esp_timer_get_time();
+        httpLatency.service.record((uint32_t)(last - start));
+        vTaskDelay(1);
+    }
+}
+
+void WebServerManager::serviceWebSocket() {
+    int64_t last = esp_timer_get_time();
+    while (true) {
+        int64_t start = esp_timer_get_time();
+        wsLatency.gap.record((uint32_t)(start - last));
+        {
+            NetLock lock(wsLock);
+            ws->loop();
+        }
+        last = esp_timer_get_time();
+        vTaskDelay(1);
+    }
 }
 
-void WebServerManager::update() {
-    if (isAPMode) {
-        dnsServer->processNextRequest();
+void WebServerManager::serviceTelnet() {
+    int64_t last = esp_timer_get_time();
+    while (true) {
+        int64_t start = esp_timer_get_time();
+        telnetLatency.gap.record((uint32_t)(start - last));
+        handleTelnet();
+        last = esp_timer_get_time();
+        vTaskDelay(1);
     }
-    server->handleClient();
-    ws->loop();
-    handleTelnet();
 }
 
 void WebServerManager::handleTelnet() {
+    NetLock lock(telnetLock);
+    // A dropped telnet session gives up the executor like a WebSocket does
+    static bool telnetUp = false;
+    bool up = telnetClient && telnetClient.connected();
+    if (telnetUp && !up && executorOwner.release(SRC_TELNET, 0)) Serial.println("Telnet disconnected -> executor released");
+    telnetUp = up;
+    // Realtime bytes are taken out of the stream as they arrive
+    static RealtimeFilter realtime;
     // Check for new clients
     if (telnetServer->hasClient()) {
         if (!telnetClient || !telnetClient.connected()) {
             if (telnetClient) telnetClient.stop();
             telnetClient = telnetServer->available();
+            realtime.reset();
             telnetClient.println("Encoder3D Telnet Connected");
             telnetClient.flush();
         } else {
@@ -202,9 +394,15 @@ void WebServerManager::handleTelnet() {
         static size_t idx = 0;
         while (telnetClient.available()) {
             char c = telnetClient.read();
+            RealtimeCommand rt = realtime.feed((uint8_t)c);
+            if (rt != RT_NONE) { handleRealtime(rt, SRC_TELNET, 0); continue; }
             if (c == '\r') continue;
             if (c == '\n') {
-                if (idx > 0) {
+                if (idx > 0 && realtimeFromLine(linebuf, idx) == RT_ESTOP) {
+                    handleRealtime(RT_ESTOP, SRC_TELNET, 0);
+                    idx = 0;
+                } else if (idx > 0) {
+                    int64_t t0 = esp_timer_get_time();
                     RawCommand rc;
                     rc.srcType = SRC_TELNET;
                     rc.srcId = 0; // single telnet
@@ -221,6 +419,7 @@ void WebServerManager::handleTelnet() {
                     } else {
                         sendResponseToClient(rc.srcType, rc.srcId, String("error:") + reason);
                     }
+                    telnetLatency.service.record((uint32_t)(esp_timer_get_time() - t0));
                     idx = 0;
                 }
             } else {
@@ -230,56 +429,144 @@ void WebServerManager::handleTelnet() {
     }
 }
 
+// Last scan results (served from cache by /api/wifi/scan and /api/wifi/job)
+#define WIFI_SCAN_MAX 24
+struct WifiNetwork { char ssid[33]; int8_t rssi; bool secure; };
+static WifiNetwork scanCache[WIFI_SCAN_MAX];
+static int scanCount = 0;
+
+static void addScanResults(JsonArray arr) {
+    for (int i = 0; i < scanCount; ++i) {
+        JsonObject obj = arr.add<JsonObject>();
+        obj["ssid"] = scanCache[i].ssid;
+        obj["rssi"] = scanCache[i].rssi;
+        obj["secure"] = scanCache[i].secure;
+    }
+}
+
+static const char* wifiJobName(WifiJobStatus s) {
+    switch (s) {
+    case WIFI_JOB_PENDING: return "pending";
+    case WIFI_JOB_DONE: return "done";
+    case WIFI_JOB_FAILED: return "failed";
+    default: return "unknown";
+    }
+}
+
 void WebServerManager::setupWiFi() {
     Preferences prefs;
     prefs.begin("wifi", true); // Read-only
-    String ssid = prefs.getString("ssid", "");
-    String pass = prefs.getString("pass", "");
+    wifiSsid = prefs.getString("ssid", "");
+    wifiPass = prefs.getString("pass", "");
     deviceHostname = prefs.getString("hostname", "encoder3d");
     prefs.end();
 
-    if (ssid.length() > 0) {
-        Serial.print("Connecting to "); Serial.println(ssid);
-        WiFi.mode(WIFI_STA);
-        WiFi.setHostname(deviceHostname.c_str());
-        WiFi.begin(ssid.c_str(), pass.c_str());
-        
-        // Wait up to 10s for connection
-        int attempts = 0;
-        while (WiFi.status() != WL_CONNECTED && attempts < 20) {
-            delay(500);
-            Serial.print(".");
-            attempts++;
-        }
-        
-        if (WiFi.status() == WL_CONNECTED) {
-            Serial.println("\nConnected! IP: " + WiFi.localIP().toString());
-            isAPMode = false;
-            
-            // Start mDNS after connection
-            if (MDNS.begin(deviceHostname.c_str())) {
-                Serial.println("MDNS responder started: " + deviceHostname);
-                MDNS.addService("http", "tcp", 80);
+    // Event callbacks run on the WiFi event task; they only set flags
+    WiFi.onEvent([this](arduino_event_id_t event, arduino_event_info_t info) { wifi.onGotIp(); },
+                 ARDUINO_EVENT_WIFI_STA_GOT_IP);
+    WiFi.onEvent([this](arduino_event_id_t event, arduino_event_info_t info) { wifi.onDisconnected(); },
+                 ARDUINO_EVENT_WIFI_STA_DISCONNECTED);
+    // Reconnects are paced by WifiManager's backoff instead of the driver
+    WiFi.setAutoReconnect(false);
+
+    if (wifiSsid.length() > 0) {
+        Serial.print("Connecting to "); Serial.println(wifiSsid);
+        wifi.connect(millis());
+    } else {
+        wifi.startApOnly();
+    }
+    updateWiFi();
+}
+
+// Carry out whatever the WiFi state machine asks for; never waits
+void WebServerManager::updateWiFi() {
+    uint32_t now = millis();
+    if (wifi.scanStarted()) {
+        int16_t n = WiFi.scanComplete();
+        if (n >= 0) {
+            scanCount = 0;
+            for (int i = 0; i < n && scanCount < WIFI_SCAN_MAX; ++i) {
+                WifiNetwork &w = scanCache[scanCount++];
+                strncpy(w.ssid, WiFi.SSID(i).c_str(), sizeof(w.ssid) - 1);
+                w.ssid[sizeof(w.ssid) - 1] = '\0';
+                w.rssi = (int8_t)WiFi.RSSI(i);
+                w.secure = WiFi.encryptionType(i) != WIFI_AUTH_OPEN;
             }
-            return;
+            WiFi.scanDelete();
+            wifi.scanFinished(now, true);
+        } else if (n == WIFI_SCAN_FAILED) {
+            wifi.scanFinished(now, false);
         }
     }
 
-    // Fallback to AP Mode
-    Serial.println("\nStarting AP Mode...");
-    WiFi.mode(WIFI_AP);
-    WiFi.softAP(deviceHostname.c_str());
-    Serial.println("AP IP: " + WiFi.softAPIP().toString());
-    
-    // Start mDNS in AP Mode
+    WifiAction act;
+    while ((act = wifi.poll(now)) != WIFI_ACT_NONE) {
+        switch (act) {
+        case WIFI_ACT_BEGIN:
+            WiFi.mode(wifi.apActive() ? WIFI_AP_STA : WIFI_STA);
+            WiFi.setHostname(deviceHostname.c_str());
+            WiFi.begin(wifiSsid.c_str(), wifiPass.c_str());
+            break;
+        case WIFI_ACT_CONNECTED:
+            bootMark(BOOT_WIFI);
+            Serial.println("Connected! IP: " + WiFi.localIP().toString());
+            startMDNS();
+            break;
+        case WIFI_ACT_START_AP:
+            Serial.println("Starting AP Mode...");
+            WiFi.mode(wifi.state() == WIFI_ST_IDLE ? WIFI_AP : WIFI_AP_STA);
+            WiFi.softAP(deviceHostname.c_str());
+            Serial.println("AP IP: " + WiFi.softAPIP().toString());
+            startMDNS();
+            // Start DNS Server for Captive Portal (Redirect all to AP IP)
+            dnsServer->start(53, "*", WiFi.softAPIP());
+            isAPMode = true;
+            bootMark(BOOT_AP);
+            break;
+        case WIFI_ACT_STOP_AP:
+            Serial.println("Stopping AP Mode");
+            dnsServer->stop();
+            WiFi.softAPdisconnect(true);
+            WiFi.mode(WIFI_STA);
+            isAPMode = false;
+            break;
+        case WIFI_ACT_SCAN:
+            WiFi.scanNetworks(true);
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+void WebServerManager::startMDNS() {
     if (MDNS.begin(deviceHostname.c_str())) {
         Serial.println("MDNS responder started: " + deviceHostname);
         MDNS.addService("http", "tcp", 80);
     }
-    
-    // Start DNS Server for Captive Portal (Redirect all to AP IP)
-    dnsServer->start(53, "*", WiFi.softAPIP());
-    isAPMode = true;
+}
+
+// Upload sessions don't survive a reboot, so partial files left by one
+// are only taking space
+static void removeStaleUploads(bool sd) {
+    File root = sd ? SD.open("/") : LittleFS.open("/gcode");
+    if (!root || !root.isDirectory()) return;
+    String stale[8];
+    int n = 0;
+    File f = root.openNextFile();
+    while (f && n < 8) {
+        String name = f.name();
+        int slash = name.lastIndexOf('/');
+        if (slash >= 0) name = name.substring(slash + 1);
+        if (name.startsWith(".") && (name.endsWith(".part") || name.endsWith(".resume"))) stale[n++] = name;
+        f = root.openNextFile();
+    }
+    root.close();
+    for (int i = 0; i < n; ++i) {
+        if (sd) SD.remove("/" + stale[i]);
+        else LittleFS.remove("/gcode/" + stale[i]);
+        Serial.printf("Removed unfinished upload %s\n", stale[i].c_str());
+    }
 }
 
 void WebServerManager::setupFileSystem() {
@@ -287,6 +574,7 @@ void WebServerManager::setupFileSystem() {
         Serial.println("LittleFS Mount Failed");
         return;
     }
+    loadStaticIndex();
     // Try to initialize SD (optional). If the board has no SD card or init fails,
     // we'll leave sdAvailable false and SD endpoints will report not available.
     sdAvailable = false;
@@ -296,22 +584,630 @@ void WebServerManager::setupFileSystem() {
     } else {
         Serial.println("SD init failed or not present");
     }
+    removeStaleUploads(false);
+    if (sdAvailable) removeStaleUploads(true);
+    startIndexer();
+    startJobRunner();
+}
+
+// UI asset manifest (see scripts/build_www.py)
+static StaticAssetIndex staticAssets;
+// Read buffer for static files and downloads: one LittleFS block, so large
+// files are read block by block straight into the socket without going
+// through the FS cache. Only the HTTP task serves files.
+static uint8_t staticBuf[4096];
+
+void WebServerManager::loadStaticIndex() {
+    staticAssets.clear();
+    File f = LittleFS.open(STATIC_MANIFEST_PATH, "r");
+    if (!f) {
+        Serial.println("No " STATIC_MANIFEST_PATH ": UI served uncompressed, without ETags");
+        return;
+    }
+    char line[STATIC_PATH_MAX + STATIC_ETAG_MAX + 8];
+    while (f.available()) {
+        size_t n = f.readBytesUntil('\n', line, sizeof(line) - 1);
+        line[n] = '\0';
+        if (n && !staticAssets.parseLine(line)) Serial.printf("Bad UI manifest line: %s\n", line);
+    }
+    f.close();
+    Serial.printf("UI manifest: %d files\n", staticAssets.size());
+}
+
+// Serve a file from /www. Files in the manifest get their ETag (304 when
+// the client already has it), cache policy and gzip encoding; anything else
+// (a filesystem image built without the manifest) is sent as stored. A
+// client that refuses gzip gets the plain copy if one is stored, else 406.
+bool WebServerManager::serveStaticFile(String uri) {
+    if (uri.endsWith("/")) uri += "index.html";
+    const StaticAsset* asset = staticAssets.find(uri.c_str());
+    String path = "/www" + uri;
+    bool gz = asset ? asset->gzipped : !LittleFS.exists(path);
+    if (gz && !asset && !LittleFS.exists(path + ".gz")) return false;
+
+    // Vary only matters when there is another encoding to choose
+    bool bothStored = false;
+    if (gz) {
+        bothStored = LittleFS.exists(path);
+        if (!staticAcceptsGzip(server->header("Accept-Encoding").c_str())) {
+            if (!bothStored) {
+                server->send(406, "text/plain", "gzip encoding required");
+                return true;
+            }
+            gz = false;
+            asset = nullptr; // the manifest's tag and policy describe the .gz copy
+        }
+    }
+    if (bothStored) server->sendHeader("Vary", "Accept-Encoding");
+    if (asset) {
+        server->sendHeader("ETag", asset->etag);
+        server->sendHeader("Cache-Control", staticCacheControl(*asset));
+        if (staticEtagMatches(server->header("If-None-Match").c_str(), asset->etag)) {
+            server->send(304);
+            return true;
+        }
+    }
+
+    File f = LittleFS.open(gz ? path + ".gz" : path, "r");
+    if (!f) return false;
+    if (gz) server->sendHeader("Content-Encoding", "gzip");
+    server->setContentLength(f.size());
+    server->send(200, staticContentType(uri.c_str()), "");
+    if (server->method() != HTTP_HEAD) {
+        WiFiClient client = server->client();
+        size_t n;
+        while ((n = f.read(staticBuf, sizeof(staticBuf))) > 0) {
+            if (client.write(staticBuf, n) != n) break; // client went away
+        }
+    }
+    f.close();
+    return true;
+}
+
+// Send a job file for download, honouring a single byte range so an
+// interrupted transfer can resume. The validator is size + mtime: enough
+// for If-Range to notice the file was replaced in between.
+void WebServerManager::sendFile(File& f) {
+    uint32_t size = f.size();
+    char etag[24];
+    snprintf(etag, sizeof(etag), "\"%lx-%lx\"", (unsigned long)size, (unsigned long)f.getLastWrite());
+    server->sendHeader("Accept-Ranges", "bytes");
+    server->sendHeader("ETag", etag);
+
+    uint32_t first = 0, last = size ? size - 1 : 0;
+    int code = 200;
+    String range = server->header("Range");
+    String ifRange = server->header("If-Range");
+    if (range.length() && (!ifRange.length() || ifRange == etag)) {
+        HttpRangeResult r = httpParseRange(range.c_str(), size, first, last);
+        char cr[40];
+        if (r == HTTP_RANGE_UNSATISFIABLE) {
+            snprintf(cr, sizeof(cr), "bytes */%lu", (unsigned long)size);
+            server->sendHeader("Content-Range", cr);
+            server->send(416, "text/plain", "");
+            return;
+        }
+        if (r == HTTP_RANGE_OK) {
+            code = 206;
+            snprintf(cr, sizeof(cr), "bytes %lu-%lu/%lu", (unsigned long)first, (unsigned long)last, (unsigned long)size);
+            server->sendHeader("Content-Range", cr);
+        }
+    }
+    uint32_t remaining = size ? last - first + 1 : 0;
+    server->setContentLength(remaining);
+    server->send(code, "application/octet-stream", "");
+    if (!f.seek(first)) return;
+    WiFiClient client = server->client();
+    while (remaining > 0) {
+        size_t n = f.read(staticBuf, remaining < sizeof(staticBuf) ? remaining : sizeof(staticBuf));
+        if (n == 0 || client.write(staticBuf, n) != n) break; // short file or client gone
+        remaining -= n;
+    }
+}
+
+// Gathers small pieces of a streamed response into one HTTP chunk
+struct ChunkWriter {
+    WebServer* server;
+    char buf[1024];
+    size_t len;
+    explicit ChunkWriter(WebServer* s) : server(s), len(0) {}
+    void add(const char* s, size_t n) {
+        if (len + n > sizeof(buf)) flush();
+        if (n > sizeof(buf)) { server->sendContent(s, n); return; }
+        memcpy(buf + len, s, n);
+        len += n;
+    }
+    void add(const char* s) { add(s, strlen(s)); }
+    void flush() { if (len) { server->sendContent(buf, len); len = 0; } }
+};
+
+// Sort buffer for /api/files pages (only the HTTP task lists files)
+static FileListPage filePage;
+
+// Display name of a directory entry (LittleFS may report the full path)
+static const char* fileListName(File& f) {
+    const char* name = f.name();
+    if (strncmp(name, "/gcode/", 7) == 0) return name + 7;
+    return name;
+}
+
+// Offer every file in `root` to `page` (one directory pass)
+static void fileListPass(File& root, FileListPage& page) {
+    root.rewindDirectory();
+    File f = root.openNextFile();
+    while (f) {
+        const char* name = fileListName(f);
+        if (!f.isDirectory() && name[0] != '.') page.offer(name, f.size(), (uint32_t)f.getLastWrite());
+        f = root.openNextFile();
+    }
+}
+
+// --- G-code metadata index (see gcode_index.h) ---
+// One sidecar table per storage, used by the HTTP task (uploads, lookups,
+// listings) and the indexer task, one at a time
+static SemaphoreHandle_t indexLock = NULL;
+static TaskHandle_t indexerTaskHandle = NULL;
+
+// Table records in the open index file
+struct IndexFileStore {
+    File& f;
+    explicit IndexFileStore(File& file) : f(file) {}
+    bool read(uint32_t slot, uint8_t* rec) {
+        return f.seek(GCODE_INDEX_HEADER + slot * GCODE_INDEX_RECORD) && f.read(rec, GCODE_INDEX_RECORD) == GCODE_INDEX_RECORD;
+    }
+    bool write(uint32_t slot, const uint8_t* rec) {
+        return f.seek(GCODE_INDEX_HEADER + slot * GCODE_INDEX_RECORD) && f.write(rec, GCODE_INDEX_RECORD) == GCODE_INDEX_RECORD;
+    }
+};
+typedef GcodeIndexTable<IndexFileStore> IndexTable;
+
+static fs::FS& storageFs(bool sd) {
+    if (sd) return SD;
+    return LittleFS;
+}
+
+// Where a listed job lives on its filesystem
+static String jobPath(bool sd, const String& name) {
+    if (sd) return name.startsWith("/") ? name : "/" + name;
+    return "/gcode/" + name;
+}
+
+// Open the index, creating an empty one if it is missing or unreadable
+static File indexOpen(bool sd, uint32_t& slots) {
+    fs::FS& fs = storageFs(sd);
+    uint8_t h[GCODE_INDEX_HEADER];
+    if (fs.exists(GCODE_INDEX_PATH)) {
+        File f = fs.open(GCODE_INDEX_PATH, "r+");
+        if (f && f.read(h, sizeof(h)) == sizeof(h) && (slots = gcodeIndexHeaderSlots(h)) > 0) return f;
+        if (f) f.close();
+    }
+    slots = sd ? GCODE_INDEX_SLOTS_SD : GCODE_INDEX_SLOTS_LITTLEFS;
+    File f = fs.open(GCODE_INDEX_PATH, "w+");
+    if (!f) return f;
+    gcodeIndexHeader(h, slots);
+    f.write(h, sizeof(h));
+    uint8_t empty[GCODE_INDEX_RECORD] = { 0 };
+    for (uint32_t i = 0; i < slots; ++i) f.write(empty, sizeof(empty));
+    return f;
+}
+
+// Run `fn(IndexTable&)` with the storage's index open and locked
+template <class Fn>
+static bool withIndex(bool sd, Fn fn) {
+    if (!indexLock) return false;
+    xSemaphoreTake(indexLock, portMAX_DELAY);
+    uint32_t slots = 0;
+    File f = indexOpen(sd, slots);
+    bool ok = false;
+    if (f) {
+        IndexFileStore store(f);
+        IndexTable table(store, slots);
+        ok = fn(table);
+        f.close();
+    }
+    xSemaphoreGive(indexLock);
+    return ok;
+}
+
+static bool indexFresh(const GcodeMeta& m, uint32_t size, uint32_t mtime) { return m.size == size && m.mtime == mtime; }
+
+// Scan a whole file; the indexer yields between chunks so a large SD
+// file doesn't hold the core
+static GcodeMeta indexScan(File& f, GcodeIndexer& ix, bool yield) {
+    static char chunk[512]; // indexer task only
+    ix.begin();
+    f.seek(0);
+    size_t n;
+    int chunks = 0;
+    while ((n = f.read((uint8_t*)chunk, sizeof(chunk))) > 0) {
+        ix.feed(chunk, n);
+        if (yield && (++chunks & 15) == 0) vTaskDelay(1);
+    }
+    GcodeMeta m = ix.finish();
+    m.size = f.size();
+    m.mtime = (uint32_t)f.getLastWrite();
+    return m;
+}
+
+// Index every job on both storages that has no current record
+static void gcodeIndexerTask(void* pv) {
+    static GcodeIndexer ix;
+    while (true) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        for (int s = 0; s < 2; ++s) {
+            bool sd = s == 1;
+            if (sd && !sdAvailable) continue;
+            File root = sd ? SD.open("/") : LittleFS.open("/gcode");
+            if (!root || !root.isDirectory()) continue;
+            int indexed = 0;
+            File f = root.openNextFile();
+            while (f) {
+                char name[GCODE_INDEX_NAME_MAX];
+                const char* full = fileListName(f);
+                if (!f.isDirectory() && full[0] != '.' && strlen(full) < sizeof(name)) {
+                    strcpy(name, full);
+                    GcodeMeta m;
+                    uint32_t size = f.size(), mtime = (uint32_t)f.getLastWrite();
+                    bool have = withIndex(sd, [&](IndexTable& t) { return t.get(name, m); });
+                    if (!have || !indexFresh(m, size, mtime)) {
+                        m = indexScan(f, ix, true);
+                        if (withIndex(sd, [&](IndexTable& t) { return t.put(name, m); })) indexed++;
+                        else Serial.printf("G-code index full or unwritable, %s not indexed\n", name);
+                    }
+                }
+                f = root.openNextFile();
+            }
+            if (indexed) Serial.printf("Indexed %d G-code file(s) on %s\n", indexed, sd ? "SD" : "LittleFS");
+        }
+    }
+}
+
+static void kickIndexer() {
+    if (indexerTaskHandle) xTaskNotifyGive(indexerTaskHandle);
+}
+
+// Catch up on files that arrived without an upload (SD card, older firmware)
+void WebServerManager::startIndexer() {
+    indexLock = xSemaphoreCreateMutex();
+    xTaskCreatePinnedToCore(gcodeIndexerTask, "Indexer", GCODE_INDEX_TASK_STACK, NULL, GCODE_INDEX_TASK_PRIORITY, &indexerTaskHandle, 0);
+    kickIndexer();
+}
+
+// Soft-limit preflight of a stored G-code job: the travel box from its
+// index record against the envelope, before anything moves. Returns why it
+// would leave the envelope, or "" (also for files not indexed yet, whose
+// moves are still each checked as they are planned).
+static String jobPreflight(bool sd, const char* name) {
+    if (!travelEnvelope.enabled() || jobIsRaster(name)) return "";
+    File f = storageFs(sd).open(jobPath(sd, name), "r");
+    if (!f) return "";
+    uint32_t size = f.size(), mtime = (uint32_t)f.getLastWrite();
+    f.close();
+    GcodeMeta m;
+    if (!withIndex(sd, [&](IndexTable& t) { return t.get(name, m); }) || !indexFresh(m, size, mtime) || !m.moves) return "";
+    SoftLimitViolation v;
+    if (travelEnvelope.containsBox(m.travelMin, m.travelMax, &v)) return "";
+    char why[64];
+    softLimitDescribe(why, sizeof(why), v);
+    return String(why);
+}
+
+// --- Job queue (see job_queue.h) ---
+// Jobs wait in a persistent list; one runner task plays them back to back:
+// start hook, the file, end hook, then the barrier (cooldown or operator)
+// once the machine is idle. After a reboot the queue is loaded paused, so
+// nothing moves until someone resumes it.
+static JobQueue jobQueue;
+static SemaphoreHandle_t queueLock = NULL;   // jobQueue and its file
+static TaskHandle_t runnerTaskHandle = NULL;
+static StreamBufferHandle_t* runnerStream = NULL;
+static volatile bool queuePaused = true;
+static volatile bool queueWaiting = false;   // operator barrier reached
+static volatile uint32_t queueCooldownUntil = 0; // millis, 0 = none
+static QueuedJob queueCurrent;               // valid while queuePhase isn't "idle"
+static const char* volatile queuePhase = "idle";
+static uint8_t queueBlob[JOB_QUEUE_BLOB_MAX];
+
+// Caller holds queueLock. Written aside and renamed, so a reset mid-write
+// leaves the previous queue.
+static void queueSave() {
+    size_t n = jobQueue.encode(queueBlob, sizeof(queueBlob));
+    File f = LittleFS.open("/jobqueue.tmp", "w");
+    if (!f || f.write(queueBlob, n) != n) {
+        if (f) f.close();
+        Serial.println("Job queue: save failed");
+        return;
+    }
+    f.close();
+    LittleFS.rename("/jobqueue.tmp", JOB_QUEUE_PATH);
+}
+
+static void queueLoad() {
+    File f = LittleFS.open(JOB_QUEUE_PATH, "r");
+    if (!f) return;
+    size_t n = f.read(queueBlob, sizeof(queueBlob));
+    f.close();
+    if (!jobQueue.decode(queueBlob, n)) Serial.println("Job queue: " JOB_QUEUE_PATH " unreadable, starting empty");
+}
+
+static void kickRunner() {
+    if (runnerTaskHandle) xTaskNotifyGive(runnerTaskHandle);
+}
+
+// Send start/end G-code into the stream like job lines
+static void runHook(const char* gcode) {
+    size_t n = strlen(gcode), off = 0;
+    if (n == 0) return;
+    while (off < n && !jobStopRequested) off += gcodeStreamWrite(gcode + off, n - off, pdMS_TO_TICKS(100));
+    while (!jobStopRequested && gcodeStreamWrite("\n", 1, pdMS_TO_TICKS(100)) == 0) {}
+}
+
+static void jobRunnerTask(void* pv) {
+    WebServerManager* self = (WebServerManager*)pv;
+    static JobStreamArgs args;
+    while (true) {
+        // Woken by queue changes and finished jobs; the timeout ends cooldowns
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(1000));
+        if (queuePaused || queueWaiting || jobActive) continue;
+        if (queueCooldownUntil) {
+            if ((int32_t)(millis() - queueCooldownUntil) < 0) continue;
+            queueCooldownUntil = 0;
+        }
+        bool have = false;
+        int remaining = 0;
+        xSemaphoreTake(queueLock, portMAX_DELAY);
+        // A client holding the executor makes the runner wait (it retries on the next wake)
+        if (jobQueue.size() && !jobClaim(jobQueue.at(0).name)) {
+            jobQueue.pop(queueCurrent);
+            queueSave();
+            remaining = jobQueue.size();
+            have = true;
+        }
+        xSemaphoreGive(queueLock);
+        if (!have) continue;
+
+        const QueuedJob& j = queueCurrent;
+        const char* storage = jobStorageName(j.storage);
+        args.mgr = self; args.gcodeStream = runnerStream; args.storage = j.storage;
+        strcpy(args.filename, j.name);
+        Serial.printf("Job queue: starting %s (%d more queued)\n", j.name, remaining);
+        self->broadcastJobEvent("started", j.name, storage, -1);
+
+        const char* event = "error";
+        bool exists = j.storage == STORAGE_SD ? sdAvailable && SD.exists(jobPath(true, j.name)) : LittleFS.exists(jobPath(false, j.name));
+        String outside = exists ? jobPreflight(j.storage == STORAGE_SD, j.name) : String("");
+        bool runs = exists && outside.length() == 0;
+        if (!runs) {
+            // Nothing has moved: report it and go on with the next job
+            if (!exists) self->broadcastError(String("Queued job not found: ") + j.name);
+            else self->broadcastError(String("Queued job refused, soft limit: ") + outside + " (" + j.name + ")");
+        } else {
+            queuePhase = "start";
+            runHook(j.startGcode);
+            queuePhase = "running";
+            event = jobIsRaster(j.name) ? runRasterJob(self, &args) : runGcodeJob(self, &args);
+            if (!jobStopRequested) {
+                waitMachineIdle(runnerStream);
+                queuePhase = "end";
+                runHook(j.endGcode);
+                waitMachineIdle(runnerStream);
+            }
+        }
+        bool stopped = jobStopRequested;
+        self->broadcastJobEvent(event, j.name, storage, -1);
+        queuePhase = "idle";
+        jobRelease();
+
+        // A stop halts the queue as well; the operator decides what's next
+        if (stopped) queuePaused = true;
+        else if (runs && jobQueue.barrier == JOB_BARRIER_OPERATOR) queueWaiting = true;
+        else if (runs && jobQueue.barrier == JOB_BARRIER_COOLDOWN && jobQueue.cooldownSec) queueCooldownUntil = (millis() + jobQueue.cooldownSec * 1000UL) | 1;
+        kickRunner();
+    }
+}
+
+void WebServerManager::startJobRunner() {
+    queueLock = xSemaphoreCreateMutex();
+    runnerStream = gcodeStream;
+    queueLoad();
+    if (jobQueue.size()) Serial.printf("Job queue: %d job(s) waiting, paused until resumed\n", jobQueue.size());
+    xTaskCreate(jobRunnerTask, "JobRunner", JOB_RUNNER_TASK_STACK, this, JOB_RUNNER_TASK_PRIORITY, &runnerTaskHandle);
+}
+
+static void queueJson(JsonDocument& doc) {
+    doc["paused"] = (bool)queuePaused;
+    doc["waiting"] = (bool)queueWaiting;
+    doc["barrier"] = jobBarrierName(jobQueue.barrier);
+    doc["cooldown"] = jobQueue.cooldownSec;
+    uint32_t until = queueCooldownUntil;
+    int32_t left = until ? (int32_t)(until - millis()) : 0;
+    doc["cooldownLeft"] = left > 0 ? (left + 999) / 1000 : 0;
+    if (strcmp(queuePhase, "idle") != 0) {
+        JsonObject cur = doc["current"].to<JsonObject>();
+        cur["id"] = queueCurrent.id;
+        cur["name"] = queueCurrent.name;
+        cur["storage"] = jobStorageName(queueCurrent.storage);
+        cur["phase"] = (const char*)queuePhase;
+    } else {
+        doc["current"] = nullptr;
+    }
+    JsonArray jobs = doc["jobs"].to<JsonArray>();
+    for (int i = 0; i < jobQueue.size(); ++i) {
+        const QueuedJob& j = jobQueue.at(i);
+        JsonObject o = jobs.add<JsonObject>();
+        o["id"] = j.id;
+        o["name"] = j.name;
+        o["storage"] = jobStorageName(j.storage);
+        if (j.startGcode[0]) o["start"] = j.startGcode;
+        if (j.endGcode[0]) o["end"] = j.endGcode;
+    }
+}
+
+// Stream one page of a directory listing with chunked encoding. Memory
+// use doesn't depend on the directory size: unsorted pages are written as
+// the directory is read; sorted pages take one directory pass per
+// FILE_LIST_PAGE_MAX entries skipped, plus one for the page itself.
+// With `withMeta`, entries whose index record is current carry it.
+void WebServerManager::streamFileList(File& root, bool sd, long offset, long limit, FileSortKey key, bool desc, bool withMeta) {
+    const char* storage = sd ? "sd" : "littlefs";
+    server->setContentLength(CONTENT_LENGTH_UNKNOWN);
+    server->send(200, "application/json", "");
+    ChunkWriter out(server);
+    char entry[448];
+    uint32_t total = 0, skipped = 0;
+    bool first = true;
+    IndexTable* index = nullptr;
+
+    // One entry; with an index, reopen the object to append "meta"
+    auto emit = [&](const char* name, uint32_t size, uint32_t mtime) {
+        size_t n = fileListJsonEntry(entry, sizeof(entry), name, size, mtime, storage);
+        if (!n) { skipped++; return; }
+        if (!first) out.add(",");
+        first = false;
+        GcodeMeta m;
+        if (index && index->get(name, m) && indexFresh(m, size, mtime)) {
+            out.add(entry, n - 1);
+            out.add(",\"meta\":");
+            n = gcodeMetaJson(entry, sizeof(entry), m);
+            out.add(entry, n);
+            out.add("}");
+        } else {
+            out.add(entry, n);
+        }
+    };
+
+    auto list = [&]() {
+        if (!root || !root.isDirectory()) return;
+        if (key == FILE_SORT_NONE) {
+            File f = root.openNextFile();
+            while (f) {
+                const char* name = fileListName(f);
+                if (!f.isDirectory() && name[0] != '.') {
+                    if ((long)total >= offset && (long)total < offset + limit) emit(name, f.size(), (uint32_t)f.getLastWrite());
+                    total++;
+                }
+                f = root.openNextFile();
+            }
+            return;
+        }
+        // Walk to `offset` a page at a time, remembering the last entry
+        FileListEntry cursor;
+        bool haveCursor = false, exhausted = false;
+        long skip = offset;
+        while (skip > 0 && !exhausted) {
+            int take = skip > FILE_LIST_PAGE_MAX ? FILE_LIST_PAGE_MAX : (int)skip;
+            filePage.begin(key, desc, take, haveCursor ? &cursor : nullptr);
+            fileListPass(root, filePage);
+            if (filePage.count() < take) exhausted = true;
+            if (filePage.count()) { cursor = filePage.at(filePage.count() - 1); haveCursor = true; }
+            skip -= take;
+        }
+        filePage.begin(key, desc, exhausted ? 0 : (int)limit, haveCursor ? &cursor : nullptr);
+        fileListPass(root, filePage);
+        for (int i = 0; i < filePage.count(); ++i) {
+            const FileListEntry& e = filePage.at(i);
+            emit(e.name, e.size, e.mtime);
+        }
+        total = filePage.total();
+        skipped += filePage.skippedLongNames();
+    };
+
+    out.add("{\"files\":[");
+    if (withMeta) {
+        // Hold the index for the whole page rather than reopening it per entry
+        bool opened = withIndex(sd, [&](IndexTable& t) { index = &t; list(); index = nullptr; return true; });
+        if (!opened) list();
+    } else {
+        list();
+    }
+
+    static const char* sortNames[] = { "none", "name", "size", "mtime" };
+    int n = snprintf(entry, sizeof(entry), "],\"offset\":%ld,\"limit\":%ld,\"total\":%lu,\"sort\":\"%s\",\"order\":\"%s\"",
+                     offset, limit, (unsigned long)total, sortNames[key], desc ? "desc" : "asc");
+    out.add(entry, n);
+    // Names too long to list (sorted pages hold FILE_NAME_MAX chars)
+    if (skipped) { n = snprintf(entry, sizeof(entry), ",\"skipped\":%lu", (unsigned long)skipped); out.add(entry, n); }
+    out.add("}");
+    out.flush();
+    server->sendContent("", 0);
+}
+
+// Settings blob received by /api/config/import (one upload at a time)
+static uint8_t importBlob[SETTINGS_BLOB_MAX];
+static size_t importLen = 0;
+
+// Resolve a registry path ("pid.x.p") inside a JSON object. With `create`,
+// missing intermediate objects are added; otherwise a null variant is
+// returned when any segment is absent.
+static JsonVariant settingJsonPath(JsonObject obj, const char* path, bool create) {
+    char seg[32];
+    const char* p = path;
+    while (true) {
+        const char* dot = strchr(p, '.');
+        size_t n = dot ? (size_t)(dot - p) : strlen(p);
+        if (n >= sizeof(seg)) n = sizeof(seg) - 1;
+        memcpy(seg, p, n); seg[n] = '\0';
+        if (!dot) return create ? obj[seg].to<JsonVariant>() : obj[seg].as<JsonVariant>();
+        JsonObject child = obj[seg].as<JsonObject>();
+        if (child.isNull()) {
+            if (!create) return JsonVariant();
+            child = obj[seg].to<JsonObject>();
+        }
+        obj = child;
+        p = dot + 1;
+    }
 }
 
 void WebServerManager::setupRoutes() {
-    // API: Scan Networks (Always available)
+    // API: Scan Networks (Always available). Returns the cached list at once;
+    // a scan runs in the background when the cache is stale or ?refresh=1.
+    // Poll /api/wifi/job?id=<job> for the fresh list.
     server->on("/api/wifi/scan", HTTP_GET, [this]() {
-        int n = WiFi.scanNetworks();
-        DynamicJsonDocument doc(1024);
-        JsonArray array = doc.to<JsonArray>();
-        for (int i = 0; i < n; ++i) {
-            JsonObject obj = array.add<JsonObject>();
-            obj["ssid"] = WiFi.SSID(i);
-            obj["rssi"] = WiFi.RSSI(i);
-            obj["secure"] = (WiFi.encryptionType(i) != WIFI_AUTH_OPEN);
+        uint32_t job = wifi.scan(millis(), server->hasArg("refresh"));
+        DynamicJsonDocument doc(2048);
+        doc["job"] = job;
+        doc["status"] = wifiJobName(wifi.job(job));
+        doc["ageMs"] = wifi.scanAgeMs(millis());
+        addScanResults(doc["networks"].to<JsonArray>());
+        String output;
+        serializeJson(doc, output);
+        server->send(200, "application/json", output);
+    });
+
+    // API: WiFi job status (scan or connect started by another endpoint)
+    server->on("/api/wifi/job", HTTP_GET, [this]() {
+        uint32_t id = server->hasArg("id") ? (uint32_t)server->arg("id").toInt() : 0;
+        WifiJobStatus st = wifi.job(id);
+        DynamicJsonDocument doc(2048);
+        doc["id"] = id;
+        doc["status"] = wifiJobName(st);
+        if (wifi.isScanJob(id)) {
+            doc["type"] = "scan";
+            if (st == WIFI_JOB_DONE) addScanResults(doc["networks"].to<JsonArray>());
+        } else if (st != WIFI_JOB_UNKNOWN) {
+            doc["type"] = "connect";
+            if (st == WIFI_JOB_DONE) {
+                doc["ip"] = WiFi.localIP().toString();
+                doc["hostname"] = deviceHostname.length() ? deviceHostname + ".local" : String("");
+            }
         }
         String output;
         serializeJson(doc, output);
+        server->send(st == WIFI_JOB_UNKNOWN ? 404 : 200, "application/json", output);
+    });
+
+    // API: WiFi connection state
+    server->on("/api/wifi/status", HTTP_GET, [this]() {
+        static const char* const names[] = { "idle", "connecting", "connected", "backoff" };
+        uint32_t now = millis();
+        DynamicJsonDocument doc(256);
+        doc["state"] = names[wifi.state()];
+        doc["ssid"] = wifiSsid;
+        doc["ap"] = wifi.apActive();
+        if (wifi.state() == WIFI_ST_CONNECTED) { doc["ip"] = WiFi.localIP().toString(); doc["rssi"] = WiFi.RSSI(); }
+        if (wifi.state() == WIFI_ST_BACKOFF) doc["retryInMs"] = wifi.retryInMs(now);
+        String output;
+        serializeJson(doc, output);
         server->send(200, "application/json", output);
     });
 
@@ -361,53 +1257,21 @@ void WebServerManager::setupRoutes() {
             return;
         }
 
-        // SSID provided: attempt to connect (keep AP alive)
-        WiFi.mode(WIFI_AP_STA);
-        if (hostname.length() > 0) WiFi.setHostname(hostname.c_str());
-        WiFi.begin(ssid.c_str(), pass.c_str());
-
-        // Wait up to 10s for connection
-        unsigned long start = millis();
-        while (WiFi.status() != WL_CONNECTED && millis() - start < 10000) {
-            delay(100);
-        }
-
-        if (WiFi.status() == WL_CONNECTED) {
-            // If hostname provided, ensure mDNS is started with it
-            if (hostname.length() > 0) {
-                MDNS.begin(hostname.c_str());
-                MDNS.addService("http", "tcp", 80);
-            }
-            doc["success"] = true;
-            doc["ip"] = WiFi.localIP().toString();
-            doc["hostname"] = (hostname.length() > 0) ? hostname + ".local" : String("");
-            String output; serializeJson(doc, output);
-            server->send(200, "application/json", output);
-
-            // Reboot to apply WiFi changes
-            delay(500);
-            ESP.restart();
-        } else {
-            // Save done but connection failed
-            // If hostname provided, try to start mDNS locally (best-effort)
-            if (hostname.length() > 0) {
-                MDNS.begin(hostname.c_str());
-                MDNS.addService("http", "tcp", 80);
-            }
-            doc["success"] = false;
-            doc["message"] = "Connection failed. Credentials saved.";
-            String output; serializeJson(doc, output);
-            server->send(200, "application/json", output);
-        }
+        // SSID provided: connect in the background (the setup AP stays up
+        // until the new network is joined). Poll /api/wifi/job for the result.
+        wifiSsid = ssid;
+        wifiPass = pass;
+        uint32_t job = wifi.connect(millis());
+        doc["success"] = true;
+        doc["job"] = job;
+        doc["message"] = "Connecting";
+        String output; serializeJson(doc, output);
+        server->send(202, "application/json", output);
     });
 
     // WiFi Config Page (Always available)
     server->on("/wifi.html", HTTP_GET, [this]() {
-        if (LittleFS.exists("/www/wifi.html")) {
-            File file = LittleFS.open("/www/wifi.html", "r");
-            server->streamFile(file, "text/html");
-            file.close();
-        } else {
+        if (!serveStaticFile("/wifi.html")) {
             // Fallback if LittleFS fails
             server->send(200, "text/html", "<h1>WiFi Setup</h1><form action='/api/wifi/save' method='POST'>SSID: <input name='ssid'><br>Pass: <input name='pass'><br><input type='submit'></form>");
         }
@@ -416,11 +1280,60 @@ void WebServerManager::setupRoutes() {
     // --- STA MODE ROUTES ---
 
     // G-Code Upload
+    // G-Code Upload (multipart, field "file")
+    //   ?storage=littlefs|sd  &size=N (expected bytes; else Content-Length)
+    //   &crc32=hex8 / &sha256=hex64 (optional, checked before the file is kept)
+    // -> {"success","name","storage","size","crc32","sha256","ms","mbps"}
     server->on("/api/upload", HTTP_POST, 
-        [this]() { server->send(200, "text/plain", "Upload successful"); },
+        [this]() { this->finishUpload(); },
         [this]() { this->handleUpload(); }
     );
 
+    // API: Boot timeline (microseconds since reset for each stage reached)
+    server->on("/api/diag/boot", HTTP_GET, [this]() {
+        DynamicJsonDocument doc(1024);
+        JsonObject stages = doc["stages"].to<JsonObject>();
+        for (int i = 0; i < bootTimeline.size(); ++i) stages[bootTimeline.name(i)] = bootTimeline.us(i);
+        // Ready = control loop running; network = reachable over WiFi or AP
+        if (bootTimeline.has(BOOT_MOTION_READY)) doc["readyMs"] = bootTimeline.at(BOOT_MOTION_READY) / 1000.0f;
+        const char* net = bootTimeline.has(BOOT_WIFI) ? BOOT_WIFI : BOOT_AP;
+        if (bootTimeline.has(net)) doc["networkMs"] = bootTimeline.at(net) / 1000.0f;
+        doc["wifiConnecting"] = wifi.state() == WIFI_ST_CONNECTING;
+        doc["uptimeMs"] = millis();
+        String output;
+        serializeJson(doc, output);
+        server->send(200, "application/json", output);
+    });
+
+    // API: Per-protocol latency (us); POST resets the counters
+    server->on("/api/diag/latency", HTTP_GET, [this]() {
+        DynamicJsonDocument doc(1536);
+        struct { const char* name; ProtocolLatency* p; const char* serviceName; } rows[] = {
+            { "http", &httpLatency, "service" }, { "ws", &wsLatency, "cmd" }, { "telnet", &telnetLatency, "cmd" },
+        };
+        for (auto &r : rows) {
+            JsonObject o = doc[r.name].to<JsonObject>();
+            const LatencyStats* stats[] = { &r.p->gap, &r.p->service };
+            const char* names[] = { "gap", r.serviceName };
+            for (int i = 0; i < 2; ++i) {
+                JsonObject m = o[names[i]].to<JsonObject>();
+                m["count"] = stats[i]->count();
+                m["meanUs"] = stats[i]->mean();
+                m["p99Us"] = stats[i]->percentile(99.0f);
+                m["maxUs"] = stats[i]->max();
+            }
+        }
+        String output;
+        serializeJson(doc, output);
+        server->send(200, "application/json", output);
+    });
+
+    server->on("/api/diag/latency", HTTP_POST, [this]() {
+        ProtocolLatency* all[] = { &httpLatency, &wsLatency, &telnetLatency };
+        for (ProtocolLatency* p : all) { p->gap.reset(); p->service.reset(); }
+        server->send(200, "application/json", "{\"success\":true}");
+    });
+
     // API: Status
     server->on("/api/status", HTTP_GET, [this]() {
         DynamicJsonDocument doc(128);
@@ -434,156 +1347,142 @@ void WebServerManager::setupRoutes() {
     // API: Executor status + control
     server->on("/api/executor", HTTP_GET, [this]() {
         DynamicJsonDocument doc(256);
-        doc["busy"] = executorBusy;
-        doc["owner_type"] = (int)executorOwnerType;
-        doc["owner_id"] = executorOwnerId;
-        unsigned long now = millis();
-        unsigned long remaining = 0;
-        if (executorReservedUntil != 0 && executorReservedUntil > now) remaining = executorReservedUntil - now;
-        doc["reserved_ms"] = remaining;
+        ExecutorOwnerView v = executorOwner.view(millis());
+        doc["busy"] = v.busy;
+        doc["owner_type"] = (int)v.type;
+        doc["owner_id"] = v.id;
+        doc["session"] = v.generation;
+        doc["held"] = v.pinned;    // until released (a job)
+        doc["active"] = v.active;  // executing the owner's command
+        doc["reserved_ms"] = v.leaseMs;
         String out; serializeJson(doc, out);
         server->send(200, "application/json", out);
     });
 
     server->on("/api/executor/release", HTTP_POST, [this]() {
         // Release executor ownership immediately (admin action)
-        portENTER_CRITICAL(&g_executorMux);
-        executorBusy = false;
-        executorOwnerType = SRC_SERIAL;
-        executorOwnerId = -1;
-        executorReservedUntil = 0;
-        portEXIT_CRITICAL(&g_executorMux);
+        executorOwner.reset();
         DynamicJsonDocument doc(128); doc["success"] = true; doc["released"] = true;
         String out; serializeJson(doc, out);
         server->send(200, "application/json", out);
     });
 
-    // API: Config (get)
+    // API: Config (get). Built from the settings registry; each dotted path
+    // becomes nested objects, e.g. "pid.x.p" -> {"pid":{"x":{"p":...}}}
     server->on("/api/config", HTTP_GET, [this]() {
-        DynamicJsonDocument doc(1024);
-        JsonObject c = doc["countsPerMM"].to<JsonObject>();
-        c["x"] = countsPerMM_X; c["y"] = countsPerMM_Y; c["z"] = countsPerMM_Z; c["e"] = countsPerMM_E;
-        JsonObject pid = doc["pid"].to<JsonObject>();
-        JsonObject px = pid["x"].to<JsonObject>(); px["p"] = pid_kp_x; px["i"] = pid_ki_x; px["d"] = pid_kd_x;
-        JsonObject py = pid["y"].to<JsonObject>(); py["p"] = pid_kp_y; py["i"] = pid_ki_y; py["d"] = pid_kd_y;
-        JsonObject pz = pid["z"].to<JsonObject>(); pz["p"] = pid_kp_z; pz["i"] = pid_ki_z; pz["d"] = pid_kd_z;
-        JsonObject pe = pid["e"].to<JsonObject>(); pe["p"] = pid_kp_e; pe["i"] = pid_ki_e; pe["d"] = pid_kd_e;
-        JsonObject mf = doc["maxFeedrate"].to<JsonObject>();
-        mf["x"] = maxFeedrateX; mf["y"] = maxFeedrateY; mf["z"] = maxFeedrateZ; mf["e"] = maxFeedrateE;
+        DynamicJsonDocument doc(2048);
+        JsonObject root = doc.to<JsonObject>();
+        for (int i = 0; i < settingsCount; ++i) {
+            const SettingDesc &d = settingsTable[i];
+            JsonVariant v = settingJsonPath(root, d.path, true);
+            if (d.type == SETTING_INT) v.set((int)settingGet(d));
+            else v.set(settingGet(d));
+        }
         String output;
         serializeJson(doc, output);
         server->send(200, "application/json", output);
     });
 
-    // API: Config (set)
+    // API: Config (set). Any subset of the GET document; values outside the
+    // registry range are left unchanged and listed in "rejected".
     server->on("/api/config", HTTP_POST, [this]() {
         if (!server->hasArg("plain")) { server->send(400, "text/plain", "Missing body"); return; }
         String body = server->arg("plain");
-        DynamicJsonDocument doc(1024);
+        DynamicJsonDocument doc(2048);
         DeserializationError err = deserializeJson(doc, body);
         if (err) { server->send(400, "text/plain", "Invalid JSON"); return; }
-        Preferences prefs; prefs.begin("cnc", false);
-        if (doc["countsPerMM"].is<JsonObject>()) {
-            JsonObject c = doc["countsPerMM"].as<JsonObject>();
-            if (c["x"].is<float>()) { countsPerMM_X = c["x"].as<float>(); prefs.putFloat("cpm_x", countsPerMM_X); }
-            if (c["y"].is<float>()) { countsPerMM_Y = c["y"].as<float>(); prefs.putFloat("cpm_y", countsPerMM_Y); }
-            if (c["z"].is<float>()) { countsPerMM_Z = c["z"].as<float>(); prefs.putFloat("cpm_z", countsPerMM_Z); }
-            if (c["e"].is<float>()) { countsPerMM_E = c["e"].as<float>(); prefs.putFloat("cpm_e", countsPerMM_E); }
-        }
-        if (doc["pid"].is<JsonObject>()) {
-            JsonObject p = doc["pid"].as<JsonObject>();
-            if (p["x"].is<JsonObject>()) {
-                JsonObject px = p["x"].as<JsonObject>();
-                if (px["p"].is<float>()) pid_kp_x = px["p"].as<float>();
-                if (px["i"].is<float>()) pid_ki_x = px["i"].as<float>();
-                if (px["d"].is<float>()) pid_kd_x = px["d"].as<float>();
-                prefs.putFloat("pid_kp_x", pid_kp_x);
-                prefs.putFloat("pid_ki_x", pid_ki_x);
-                prefs.putFloat("pid_kd_x", pid_kd_x);
-                pidX.setTunings(pid_kp_x, pid_ki_x, pid_kd_x);
-            }
-            if (p["y"].is<JsonObject>()) {
-                JsonObject py = p["y"].as<JsonObject>();
-                if (py["p"].is<float>()) pid_kp_y = py["p"].as<float>();
-                if (py["i"].is<float>()) pid_ki_y = py["i"].as<float>();
-                if (py["d"].is<float>()) pid_kd_y = py["d"].as<float>();
-                prefs.putFloat("pid_kp_y", pid_kp_y);
-                prefs.putFloat("pid_ki_y", pid_ki_y);
-                prefs.putFloat("pid_kd_y", pid_kd_y);
-                pidY.setTunings(pid_kp_y, pid_ki_y, pid_kd_y);
-            }
-            if (p["z"].is<JsonObject>()) {
-                JsonObject pz = p["z"].as<JsonObject>();
-                if (pz["p"].is<float>()) pid_kp_z = pz["p"].as<float>();
-                if (pz["i"].is<float>()) pid_ki_z = pz["i"].as<float>();
-                if (pz["d"].is<float>()) pid_kd_z = pz["d"].as<float>();
-                prefs.putFloat("pid_kp_z", pid_kp_z);
-                prefs.putFloat("pid_ki_z", pid_ki_z);
-                prefs.putFloat("pid_kd_z", pid_kd_z);
-                pidZ.setTunings(pid_kp_z, pid_ki_z, pid_kd_z);
-            }
-            if (p["e"].is<JsonObject>()) {
-                JsonObject pe = p["e"].as<JsonObject>();
-                if (pe["p"].is<float>()) pid_kp_e = pe["p"].as<float>();
-                if (pe["i"].is<float>()) pid_ki_e = pe["i"].as<float>();
-                if (pe["d"].is<float>()) pid_kd_e = pe["d"].as<float>();
-                prefs.putFloat("pid_kp_e", pid_kp_e);
-                prefs.putFloat("pid_ki_e", pid_ki_e);
-                prefs.putFloat("pid_kd_e", pid_kd_e);
-                pidE.setTunings(pid_kp_e, pid_ki_e, pid_kd_e);
-            }
+        DynamicJsonDocument res(1024);
+        JsonArray rejected = res["rejected"].to<JsonArray>();
+        int applied = 0;
+        JsonObject root = doc.as<JsonObject>();
+        for (int i = 0; i < settingsCount; ++i) {
+            const SettingDesc &d = settingsTable[i];
+            JsonVariant v = settingJsonPath(root, d.path, false);
+            if (v.isNull()) continue;
+            if (v.is<float>() && settingSet(d, v.as<float>())) applied++;
+            else rejected.add(d.path);
         }
-        if (doc["maxFeedrate"].is<JsonObject>()) {
-            JsonObject m = doc["maxFeedrate"].as<JsonObject>();
-            if (m["x"].is<int>()) { maxFeedrateX = m["x"].as<int>(); prefs.putInt("maxF_x", maxFeedrateX); }
-            if (m["y"].is<int>()) { maxFeedrateY = m["y"].as<int>(); prefs.putInt("maxF_y", maxFeedrateY); }
-            if (m["z"].is<int>()) { maxFeedrateZ = m["z"].as<int>(); prefs.putInt("maxF_z", maxFeedrateZ); }
-            if (m["e"].is<int>()) { maxFeedrateE = m["e"].as<int>(); prefs.putInt("maxF_e", maxFeedrateE); }
+        if (applied) settingsChanged(); // settingsTask writes NVS after the debounce
+        res["success"] = rejected.size() == 0;
+        res["applied"] = applied;
+        String out; serializeJson(res, out);
+        server->send(rejected.size() == 0 ? 200 : 400, "application/json", out);
+    });
+
+    // API: Settings schema (drives the config form)
+    server->on("/api/config/schema", HTTP_GET, [this]() {
+        DynamicJsonDocument doc(6144);
+        JsonArray arr = doc.to<JsonArray>();
+        for (int i = 0; i < settingsCount; ++i) {
+            const SettingDesc &d = settingsTable[i];
+            JsonObject o = arr.add<JsonObject>();
+            o["path"] = d.path; o["key"] = d.key;
+            o["type"] = d.type == SETTING_INT ? "int" : "float";
+            o["default"] = d.def; o["min"] = d.min; o["max"] = d.max;
+            o["persist"] = d.persist;
         }
-        prefs.end();
-        server->send(200, "application/json", "{\"success\":true}");
+        String output;
+        serializeJson(doc, output);
+        server->send(200, "application/json", output);
     });
 
-    // API: Files listing. Accept optional query arg `storage=sd|littlefs` (default littlefs).
-    server->on("/api/files", HTTP_GET, [this]() {
-        String storageArg = server->hasArg("storage") ? server->arg("storage") : String("littlefs");
-        DynamicJsonDocument res(2048);
-        JsonArray arr = res.to<JsonArray>();
-        if (storageArg == "sd") {
-            if (!sdAvailable) {
-                server->send(503, "application/json", "{\"error\":\"sd not available\"}");
-                return;
-            }
-            File root = SD.open("/");
-            if (root) {
-                File file = root.openNextFile();
-                while (file) {
-                    String name = file.name();
-                    JsonObject o = arr.createNestedObject();
-                    o["name"] = name;
-                    o["size"] = file.size();
-                    o["storage"] = "sd";
-                    file = root.openNextFile();
-                }
-            }
+    // API: Binary settings export/import (same blob format as NVS), for
+    // cloning one machine's configuration onto another
+    server->on("/api/config/export", HTTP_GET, [this]() {
+        static uint8_t blob[SETTINGS_BLOB_MAX];
+        size_t len = settingsEncode(settingsTable, settingsCount, blob, sizeof(blob));
+        if (!len) { server->send(500, "text/plain", "Settings too large"); return; }
+        server->sendHeader("Content-Disposition", "attachment; filename=\"encoder3d-settings.bin\"");
+        server->setContentLength(len);
+        server->send(200, "application/octet-stream", "");
+        server->sendContent((const char*)blob, len);
+    });
+
+    server->on("/api/config/import", HTTP_POST, [this]() {
+        DynamicJsonDocument res(256);
+        SettingsImportResult r = settingsDecode(settingsTable, settingsCount, importBlob, importLen, true);
+        if (!r.valid) {
+            res["success"] = false; res["error"] = importLen > sizeof(importBlob) ? "too large" : "invalid settings file";
         } else {
-            // littlefs: list /gcode
-            File root = LittleFS.open("/gcode");
-            if (root) {
-                File file = root.openNextFile();
-                while (file) {
-                    String name = file.name();
-                    if (name.startsWith("/gcode/")) name = name.substring(7);
-                    JsonObject o = arr.createNestedObject();
-                    o["name"] = name;
-                    o["size"] = file.size();
-                    o["storage"] = "littlefs";
-                    file = root.openNextFile();
-                }
-            }
+            if (r.applied) settingsChanged();
+            res["success"] = true; res["applied"] = r.applied; res["rejected"] = r.rejected; res["unknown"] = r.unknown;
         }
+        importLen = 0;
         String out; serializeJson(res, out);
-        server->send(200, "application/json", out);
+        server->send(r.valid ? 200 : 400, "application/json", out);
+    }, [this]() {
+        HTTPUpload& upload = server->upload();
+        if (upload.status == UPLOAD_FILE_START) {
+            importLen = 0;
+        } else if (upload.status == UPLOAD_FILE_WRITE) {
+            // Oversized uploads keep counting so the handler can report them
+            if (importLen + upload.currentSize <= sizeof(importBlob)) memcpy(importBlob + importLen, upload.buf, upload.currentSize);
+            importLen += upload.currentSize;
+        }
+    });
+
+    // API: Files listing. Accept optional query arg `storage=sd|littlefs` (default littlefs).
+    // API: list G-code files as a streamed JSON page
+    //   ?storage=littlefs|sd  &offset=N  &limit=1..FILE_LIST_PAGE_MAX
+    //   &sort=name|size|mtime|none  &order=asc|desc  &meta=1 (add indexed metadata)
+    // -> {"files":[{name,size,mtime,storage[,meta]}...],"offset":N,"limit":N,"total":N}
+    server->on("/api/files", HTTP_GET, [this]() {
+        bool sd = server->hasArg("storage") && server->arg("storage") == "sd";
+        if (sd && !sdAvailable) {
+            server->send(503, "application/json", "{\"error\":\"sd not available\"}");
+            return;
+        }
+        long offset = server->hasArg("offset") ? server->arg("offset").toInt() : 0;
+        if (offset < 0) offset = 0;
+        long limit = server->hasArg("limit") ? server->arg("limit").toInt() : FILE_LIST_PAGE_MAX;
+        if (limit < 1) limit = 1;
+        if (limit > FILE_LIST_PAGE_MAX) limit = FILE_LIST_PAGE_MAX;
+        String sortArg = server->arg("sort");
+        FileSortKey key = fileSortKeyFromString(sortArg.c_str());
+        bool desc = server->arg("order") == "desc";
+        bool withMeta = server->hasArg("meta") && server->arg("meta") != "0";
+        File root = sd ? SD.open("/") : LittleFS.open("/gcode");
+        streamFileList(root, sd, offset, limit, key, desc, withMeta);
     });
 
     // API: Download a file (GET) - query args: storage=sd|littlefs, filename=<name>
@@ -595,19 +1494,29 @@ void WebServerManager::setupRoutes() {
             if (!sdAvailable) { server->send(503, "text/plain", "SD not available"); return; }
             File f = SD.open(filename, FILE_READ);
             if (!f) { server->send(404, "text/plain", "File not found"); return; }
-            server->streamFile(f, "application/octet-stream");
+            sendFile(f);
             f.close();
             return;
         } else {
             String path = String("/gcode/") + filename;
             if (!LittleFS.exists(path)) { server->send(404, "text/plain", "File not found"); return; }
             File f = LittleFS.open(path, "r");
-            server->streamFile(f, "application/octet-stream");
+            sendFile(f);
             f.close();
             return;
         }
     });
 
+    // API: Chunked, resumable uploads (see openUploadSession)
+    server->on("/api/upload/session", HTTP_POST, [this]() { this->openUploadSession(); });
+    server->on("/api/upload/session", HTTP_GET, [this]() { this->uploadSessionStatus(); });
+    server->on("/api/upload/session", HTTP_PUT,
+        [this]() { this->finishUploadChunk(); },
+        [this]() { this->handleUploadChunk(); }
+    );
+    server->on("/api/upload/session", HTTP_DELETE, [this]() { this->abortUploadSession(); });
+    server->on("/api/upload/session/commit", HTTP_POST, [this]() { this->commitUploadSession(); });
+
     // API: Delete file (POST) body JSON { storage: "sd"|"littlefs", filename: "..." }
     server->on("/api/files/delete", HTTP_POST, [this]() {
         if (!server->hasArg("plain")) { server->send(400, "text/plain", "Missing body"); return; }
@@ -620,21 +1529,107 @@ void WebServerManager::setupRoutes() {
         if (storage == "sd") {
             if (!sdAvailable) { server->send(503, "text/plain", "SD not available"); return; }
             bool ok = SD.remove(filename);
+            if (ok) withIndex(true, [&](IndexTable& t) { return t.remove(filename.c_str()); });
             DynamicJsonDocument res(128); res["success"] = ok; String out; serializeJson(res, out); server->send(200, "application/json", out); return;
         } else {
             String path = String("/gcode/") + filename;
             bool ok = LittleFS.remove(path);
+            if (ok) withIndex(false, [&](IndexTable& t) { return t.remove(filename.c_str()); });
             DynamicJsonDocument res(128); res["success"] = ok; String out; serializeJson(res, out); server->send(200, "application/json", out); return;
         }
     });
 
+    // API: indexed metadata for one job
+    //   ?storage=littlefs|sd&filename=..  -> {"name","storage","meta":{...}}
+    // 202 {"indexing":true} while the background indexer hasn't reached it
+    server->on("/api/files/meta", HTTP_GET, [this]() {
+        bool sd = server->arg("storage") == "sd";
+        String filename = server->arg("filename");
+        if (filename.length() == 0) { server->send(400, "application/json", "{\"error\":\"missing filename\"}"); return; }
+        if (sd && !sdAvailable) { server->send(503, "application/json", "{\"error\":\"sd not available\"}"); return; }
+        File f = storageFs(sd).open(jobPath(sd, filename), "r");
+        if (!f || f.isDirectory()) { server->send(404, "application/json", "{\"error\":\"not found\"}"); return; }
+        uint32_t size = f.size(), mtime = (uint32_t)f.getLastWrite();
+        f.close();
+        GcodeMeta m;
+        const char* name = filename.c_str();
+        if (!withIndex(sd, [&](IndexTable& t) { return t.get(name, m); }) || !indexFresh(m, size, mtime)) {
+            kickIndexer();
+            server->send(202, "application/json", "{\"indexing\":true}");
+            return;
+        }
+        char metaJson[448];
+        if (!gcodeMetaJson(metaJson, sizeof(metaJson), m)) { server->send(500, "application/json", "{\"error\":\"meta\"}"); return; }
+        DynamicJsonDocument doc(256);
+        doc["name"] = filename;
+        doc["storage"] = sd ? "sd" : "littlefs";
+        doc["meta"] = serialized(metaJson);
+        // Preflight against the soft limits (null while they are off)
+        if (travelEnvelope.enabled()) {
+            SoftLimitViolation v;
+            char why[64] = "";
+            bool inside = !m.moves || travelEnvelope.containsBox(m.travelMin, m.travelMax, &v);
+            if (!inside) softLimitDescribe(why, sizeof(why), v);
+            doc["withinLimits"] = inside;
+            if (!inside) doc["limitError"] = why;
+        } else {
+            doc["withinLimits"] = nullptr;
+        }
+        String out; serializeJson(doc, out);
+        server->send(200, "application/json", out);
+    });
+
+    // API: embedded slicer thumbnail of a job as PNG (404 if it has none)
+    server->on("/api/files/thumbnail", HTTP_GET, [this]() {
+        bool sd = server->arg("storage") == "sd";
+        String filename = server->arg("filename");
+        if (sd && !sdAvailable) { server->send(503, "text/plain", "SD not available"); return; }
+        File f = storageFs(sd).open(jobPath(sd, filename), "r");
+        if (filename.length() == 0 || !f || f.isDirectory()) { server->send(404, "text/plain", "File not found"); return; }
+        GcodeMeta m;
+        const char* name = filename.c_str();
+        bool have = withIndex(sd, [&](IndexTable& t) { return t.get(name, m); });
+        if (!have || !indexFresh(m, f.size(), (uint32_t)f.getLastWrite()) || !m.thumbLength || !f.seek(m.thumbOffset)) {
+            f.close();
+            server->send(404, "text/plain", "No thumbnail");
+            return;
+        }
+        server->sendHeader("Cache-Control", "no-cache");
+        server->setContentLength(CONTENT_LENGTH_UNKNOWN);
+        server->send(200, "image/png", "");
+        ChunkWriter out(server);
+        Base64Decoder dec;
+        char in[256];
+        uint8_t png[sizeof(in) * 3 / 4 + 1];
+        uint32_t left = m.thumbLength;
+        while (left > 0) {
+            size_t n = f.read((uint8_t*)in, left < sizeof(in) ? left : sizeof(in));
+            if (n == 0) break;
+            left -= n;
+            size_t k = dec.feed(in, n, png);
+            out.add((const char*)png, k);
+        }
+        f.close();
+        out.flush();
+        server->sendContent("", 0);
+    });
+
+    // API: drop a storage's index and rebuild it in the background
+    server->on("/api/files/reindex", HTTP_POST, [this]() {
+        bool sd = server->arg("storage") == "sd";
+        if (sd && !sdAvailable) { server->send(503, "application/json", "{\"error\":\"sd not available\"}"); return; }
+        if (indexLock) {
+            xSemaphoreTake(indexLock, portMAX_DELAY);
+            storageFs(sd).remove(GCODE_INDEX_PATH);
+            xSemaphoreGive(indexLock);
+        }
+        kickIndexer();
+        server->send(202, "application/json", "{\"indexing\":true}");
+    });
+
     // Serve Files page
     server->on("/files.html", HTTP_GET, [this]() {
-        if (LittleFS.exists("/www/files.html")) {
-            File file = LittleFS.open("/www/files.html", "r");
-            server->streamFile(file, "text/html");
-            file.close();
-        } else {
+        if (!serveStaticFile("/files.html")) {
             server->send(200, "text/html", "<h1>Files</h1><p>Upload files to /gcode</p>");
         }
     });
@@ -696,33 +1691,46 @@ void WebServerManager::setupRoutes() {
         server->send(200, "application/json", out);
     });
 
-    // API: Spindle control
+    // API: Spindle control. With a tachometer `rpm` is the setpoint and
+    // reading; `power` is the PWM output (and the open-loop setpoint).
     server->on("/api/spindle", HTTP_GET, [this]() {
-        DynamicJsonDocument res(128);
-        int current = 0;
-        if (PIN_SPINDLE >= 0) current = ledcRead(PWM_CHAN_SPINDLE);
-        res["power"] = current;
+        DynamicJsonDocument res(256);
+        res["power"] = spindlePower;
         res["available"] = (PIN_SPINDLE >= 0);
+        res["closedLoop"] = spindle.isClosedLoop();
+        if (spindle.isClosedLoop()) {
+            res["rpm"] = spindle.rpm();
+            res["targetRpm"] = spindle.getTarget();
+            res["maxRpm"] = spindle.getMaxRpm();
+        }
+        res["atSpeed"] = spindle.atSpeed();
+        res["stalled"] = spindle.stalled();
         String out; serializeJson(res, out);
         server->send(200, "application/json", out);
     });
 
     server->on("/api/spindle", HTTP_POST, [this]() {
-        int val = -1;
+        float rpm = -1, power = -1;
         if (server->hasArg("plain")) {
             String body = server->arg("plain");
             DynamicJsonDocument doc(128);
             if (!deserializeJson(doc, body)) {
-                if (doc["power"].is<int>()) val = doc["power"].as<int>();
+                if (doc["rpm"].is<float>()) rpm = doc["rpm"].as<float>();
+                if (doc["power"].is<int>()) power = doc["power"].as<int>();
             }
         }
-        if (val == -1 && server->hasArg("power")) val = server->arg("power").toInt();
-        if (val < 0) { server->send(400, "text/plain", "Missing power"); return; }
-        if (val < 0) val = 0; if (val > 255) val = 255;
-        if (PIN_SPINDLE >= 0) ledcWrite(PWM_CHAN_SPINDLE, val);
-        Preferences prefs; prefs.begin("cnc", false); prefs.putInt("spindle_p", val); prefs.end();
+        if (rpm < 0 && server->hasArg("rpm")) rpm = server->arg("rpm").toFloat();
+        if (power < 0 && server->hasArg("power")) power = server->arg("power").toInt();
+        if (rpm < 0 && power < 0) { server->send(400, "text/plain", "Missing rpm or power"); return; }
+        if (power > 255) power = 255;
+        // Setpoint only: spindleTask drives the output (no NVS write). A
+        // closed-loop spindle takes RPM; `power` is scaled onto its range.
+        float target = power >= 0 ? power : 0;
+        if (spindle.isClosedLoop()) target = rpm >= 0 ? rpm : power / 255.0f * spindle.getMaxRpm();
+        if (PIN_SPINDLE >= 0) spindle.setTarget(target);
         DynamicJsonDocument res(128);
-        res["success"] = true; res["power"] = val;
+        res["success"] = true;
+        if (spindle.isClosedLoop()) res["rpm"] = spindle.getTarget(); else res["power"] = spindle.getTarget();
         String out; serializeJson(res, out);
         server->send(200, "application/json", out);
     });
@@ -733,6 +1741,11 @@ void WebServerManager::setupRoutes() {
         int current = 0;
         if (PIN_LASER >= 0) current = ledcRead(PWM_CHAN_LASER);
         res["power"] = current;
+        const char* mode = "off";
+        if (laserMode == LASER_CONSTANT) mode = "constant";
+        else if (laserMode == LASER_DYNAMIC) mode = "dynamic";
+        else if (laserMode == LASER_RASTER) mode = "raster";
+        res["mode"] = mode;
         res["available"] = (PIN_LASER >= 0);
         String out; serializeJson(res, out);
         server->send(200, "application/json", out);
@@ -751,7 +1764,8 @@ void WebServerManager::setupRoutes() {
         if (val < 0) { server->send(400, "text/plain", "Missing power"); return; }
         if (val < 0) val = 0; if (val > 255) val = 255;
         if (PIN_LASER >= 0) ledcWrite(PWM_CHAN_LASER, val);
-        Preferences prefs; prefs.begin("cnc", false); prefs.putInt("laser_p", val); prefs.end();
+        savedLaserPower = val;
+        settingsChanged();
         DynamicJsonDocument res(128);
         res["success"] = true; res["power"] = val;
         String out; serializeJson(res, out);
@@ -768,73 +1782,17 @@ void WebServerManager::setupRoutes() {
     });
 
     server->on("/api/job/start", HTTP_POST, [this]() {
-        String filename;
-        String storageArg = String("littlefs");
-        if (server->hasArg("plain")) {
-            String body = server->arg("plain");
-            DynamicJsonDocument doc(256);
-            if (!deserializeJson(doc, body)) {
-                if (doc["filename"].is<const char*>()) filename = String((const char*)doc["filename"]);
-                if (doc["storage"].is<const char*>()) storageArg = String((const char*)doc["storage"]);
-                // optional: reserve executor for the job so other clients cannot steal ownership
-                bool reserveJob = false;
-                if (doc["reserve"].is<bool>()) reserveJob = doc["reserve"].as<bool>();
-                if (reserveJob) {
-                    // attempt to reserve executor for serial owner (src=SRC_SERIAL, id=0)
-                    portENTER_CRITICAL(&g_executorMux);
-                    if (executorBusy) {
-                        portEXIT_CRITICAL(&g_executorMux);
-                        server->send(409, "application/json", "{\"success\":false,\"message\":\"executor busy\"}");
-                        return;
-                    }
-                    executorBusy = true;
-                    executorOwnerType = SRC_SERIAL;
-                    executorOwnerId = 0;
-                    // leave executorReservedUntil as 0 to indicate an indefinite reservation
-                    executorReservedUntil = 0;
-                    portEXIT_CRITICAL(&g_executorMux);
-                }
-            }
-        }
-        if (filename.length() == 0 && server->hasArg("filename")) filename = server->arg("filename");
-        if (server->hasArg("storage")) storageArg = server->arg("storage");
-        uint8_t storage = STORAGE_LITTLEFS;
-        if (storageArg == "sd") storage = STORAGE_SD;
-        if (filename.length() == 0) { server->send(400, "text/plain", "Missing filename"); return; }
-
-        // Verify file exists in selected storage
-        if (storage == STORAGE_LITTLEFS) {
-            String path = String("/gcode/") + filename;
-            if (!LittleFS.exists(path)) { server->send(404, "text/plain", "File not found"); return; }
-        } else {
-            if (!sdAvailable) { server->send(503, "text/plain", "SD not available"); return; }
-            if (!SD.exists(filename)) { server->send(404, "text/plain", "File not found on SD"); return; }
-        }
-
-        // Spawn background streamer task
-        JobStreamArgs* args = new JobStreamArgs();
-        args->mgr = this; args->gcodeStream = gcodeStream; strncpy(args->filename, filename.c_str(), sizeof(args->filename)-1); args->filename[sizeof(args->filename)-1] = '\0';
-        args->storage = storage;
-        BaseType_t created = xTaskCreate(
-            jobStreamerTask,
-            "jobStreamer",
-            4096 / sizeof(portSTACK_TYPE),
-            args,
-            1,
-            NULL
-        );
-        if (created != pdTRUE) {
-            delete args;
-            server->send(500, "text/plain", "Failed to start job streamer");
-            return;
-        }
-        DynamicJsonDocument res(128); res["success"] = true; res["started"] = true; res["filename"] = filename;
-        // echo reservation state
-        res["reserved"] = (executorBusy && executorOwnerType == SRC_SERIAL && executorOwnerId == 0);
-        String out; serializeJson(res, out);
-        server->send(200, "application/json", out);
+        handleJobStart(server->hasArg("plain") ? server->arg("plain") : String(""));
     });
 
+    // API: Print. A JSON body {filename, storage} starts a stored job like
+    // /api/job/start; any other body is the job itself, run as it arrives
+    // (see handlePrintStream).
+    server->on("/api/print", HTTP_POST,
+        [this]() { this->finishPrintStream(); },
+        [this]() { this->handlePrintStream(); }
+    );
+
     server->on("/api/job/stop", HTTP_POST, [this]() {
         // Request streamer to stop and signal controlTask to stop current motion
         jobStopRequested = true;
@@ -844,23 +1802,116 @@ void WebServerManager::setupRoutes() {
         server->send(200, "application/json", out);
     });
 
+    // Job queue: jobs run one after another by the runner task (see jobRunnerTask)
+    server->on("/api/queue", HTTP_GET, [this]() {
+        DynamicJsonDocument doc(4096);
+        xSemaphoreTake(queueLock, portMAX_DELAY);
+        queueJson(doc);
+        xSemaphoreGive(queueLock);
+        sendJson(200, doc);
+    });
+
+    // Body: {filename, storage?, start?, end?, position?}; start/end are
+    // G-code run before and after this job
+    server->on("/api/queue/add", HTTP_POST, [this]() {
+        DynamicJsonDocument req(768);
+        if (!server->hasArg("plain") || deserializeJson(req, server->arg("plain"))) { sendJsonError(400, "invalid JSON"); return; }
+        const char* name = req["filename"] | "";
+        bool sd = strcmp(req["storage"] | "littlefs", "sd") == 0;
+        if (!*name) { sendJsonError(400, "missing filename"); return; }
+        if (sd && !sdAvailable) { sendJsonError(503, "sd not available"); return; }
+        if (!storageFs(sd).exists(jobPath(sd, name))) { sendJsonError(404, "file not found"); return; }
+        int position = req["position"].is<int>() ? req["position"].as<int>() : -1;
+        xSemaphoreTake(queueLock, portMAX_DELAY);
+        uint32_t id = jobQueue.add(name, sd ? STORAGE_SD : STORAGE_LITTLEFS, req["start"] | "", req["end"] | "", position);
+        if (id) queueSave();
+        int index = jobQueue.indexOf(id);
+        bool full = jobQueue.full();
+        xSemaphoreGive(queueLock);
+        if (!id) { sendJsonError(full ? 507 : 400, full ? "queue full" : "name or hook G-code too long"); return; }
+        kickRunner();
+        DynamicJsonDocument doc(128);
+        doc["success"] = true; doc["id"] = id; doc["position"] = index;
+        sendJson(200, doc);
+    });
+
+    // Body: {id, position}
+    server->on("/api/queue/move", HTTP_POST, [this]() {
+        DynamicJsonDocument req(128);
+        if (!server->hasArg("plain") || deserializeJson(req, server->arg("plain"))) { sendJsonError(400, "invalid JSON"); return; }
+        xSemaphoreTake(queueLock, portMAX_DELAY);
+        bool ok = jobQueue.move(req["id"] | 0u, req["position"] | 0);
+        if (ok) queueSave();
+        xSemaphoreGive(queueLock);
+        if (!ok) { sendJsonError(404, "no such queued job"); return; }
+        sendJsonOk();
+    });
+
+    // Body: {id}. Cancelling the running job stops it (and pauses the queue).
+    server->on("/api/queue/cancel", HTTP_POST, [this]() {
+        DynamicJsonDocument req(128);
+        if (!server->hasArg("plain") || deserializeJson(req, server->arg("plain"))) { sendJsonError(400, "invalid JSON"); return; }
+        uint32_t id = req["id"] | 0u;
+        xSemaphoreTake(queueLock, portMAX_DELAY);
+        bool removed = jobQueue.remove(id);
+        if (removed) queueSave();
+        xSemaphoreGive(queueLock);
+        if (!removed) {
+            if (strcmp(queuePhase, "idle") == 0 || queueCurrent.id != id) { sendJsonError(404, "no such job"); return; }
+            jobStopRequested = true;
+            runStopped = true;
+        }
+        sendJsonOk();
+    });
+
+    // The running job finishes; the next one waits for resume
+    server->on("/api/queue/pause", HTTP_POST, [this]() {
+        queuePaused = true;
+        sendJsonOk();
+    });
+
+    // Also the operator's "bed is clear, carry on" after a barrier
+    server->on("/api/queue/resume", HTTP_POST, [this]() {
+        queuePaused = false;
+        queueWaiting = false;
+        kickRunner();
+        sendJsonOk();
+    });
+
+    // Body: {barrier: "none"|"cooldown"|"operator", cooldown: seconds}
+    server->on("/api/queue/config", HTTP_POST, [this]() {
+        DynamicJsonDocument req(128);
+        if (!server->hasArg("plain") || deserializeJson(req, server->arg("plain"))) { sendJsonError(400, "invalid JSON"); return; }
+        JobBarrier b = jobQueue.barrier;
+        if (req["barrier"].is<const char*>() && !jobBarrierFromString(req["barrier"], b)) { sendJsonError(400, "unknown barrier"); return; }
+        uint32_t cooldown = req["cooldown"] | (uint32_t)jobQueue.cooldownSec;
+        if (cooldown > 65535) { sendJsonError(400, "cooldown out of range"); return; }
+        xSemaphoreTake(queueLock, portMAX_DELAY);
+        jobQueue.barrier = b;
+        jobQueue.cooldownSec = (uint16_t)cooldown;
+        queueSave();
+        xSemaphoreGive(queueLock);
+        sendJsonOk();
+    });
+
     // (no test-only HTTP endpoints are installed in production firmware)
     
     // Default to index.html
     server->on("/", HTTP_GET, [this]() {
-        if (LittleFS.exists("/www/index.html")) {
-            File file = LittleFS.open("/www/index.html", "r");
-            server->streamFile(file, "text/html");
-            file.close();
-        } else {
+        if (!serveStaticFile("/index.html")) {
             server->send(200, "text/plain", "Encoder3D UI - Upload index.html to /www/");
         }
     });
 
-    // Serve Static Files (Last to avoid intercepting API calls)
-    server->serveStatic("/", LittleFS, "/www/");
+    // Conditional / compressed static serving, ranged downloads, /api/print
+    // and the upload space check need these request headers
+    static const char* collected[] = { "If-None-Match", "Accept-Encoding", "Content-Length", "Range", "If-Range", "Content-Type" };
+    server->collectHeaders(collected, 6);
 
     server->onNotFound([this]() {
+        // Static UI files (checked last so API routes always win)
+        HTTPMethod m = server->method();
+        if ((m == HTTP_GET || m == HTTP_HEAD) && serveStaticFile(server->uri())) return;
         if (isAPMode) {
             // Redirect captive portal checks to index
             server->sendHeader("Location", "http://" + WiFi.softAPIP().toString() + "/", true);
@@ -871,34 +1922,724 @@ void WebServerManager::setupRoutes() {
     });
 }
 
+// Upload sink: the open file on the destination storage
+struct UploadFileSink {
+    File f;
+    size_t write(const uint8_t* p, size_t n) { return f.write(p, n); }
+};
+
+// File being written by the upload or chunk in progress and its write
+// buffer. The WebServer runs one request at a time, so one is enough.
+static UploadFileSink uploadSink;
+static BufferedWriter<UploadFileSink> uploadWriter;
+
+// State of the form upload in progress; keeping it here (not in handler
+// statics) means a failed or aborted upload is reset by the next START.
+static struct {
+    GcodeIndexer indexer; // indexed as it arrives, listed with metadata at once
+    mbedtls_sha256_context sha;
+    bool shaActive;
+    bool sd;
+    char name[GCODE_INDEX_NAME_MAX];
+    String finalPath, tempPath;
+    uint32_t crc;
+    uint32_t bytes;
+    int64_t startUs, endUs;
+    int status;         // HTTP status for the reply; 0 = no upload seen
+    const char* error;
+    char crcHex[9], shaHex[65];
+} up;
+
+static bool uploadFits(bool sd, uint64_t bytes) {
+    uint64_t freeBytes = sd ? SD.totalBytes() - SD.usedBytes()
+                            : (uint64_t)LittleFS.totalBytes() - LittleFS.usedBytes();
+    return bytes + UPLOAD_FREE_MARGIN <= freeBytes;
+}
+
+// Hidden name a file is written under until it is complete
+static String uploadTempPath(bool sd, const char* name, const char* suffix) {
+    if (!sd && !LittleFS.exists("/gcode")) LittleFS.mkdir("/gcode");
+    return String(sd ? "" : "/gcode") + "/." + name + suffix;
+}
+
+// Move a complete upload over the job it replaces
+static bool uploadPlace(bool sd, const String& tempPath, const String& finalPath) {
+    fs::FS& fs = storageFs(sd);
+    // LittleFS renames over an existing file atomically; FAT refuses to
+    if (sd && fs.exists(finalPath)) fs.remove(finalPath);
+    return fs.rename(tempPath, finalPath);
+}
+
+static void sha256Hex(mbedtls_sha256_context* ctx, char* out) {
+    uint8_t digest[32];
+    mbedtls_sha256_finish(ctx, digest);
+    for (int i = 0; i < 32; ++i) snprintf(out + 2 * i, 3, "%02x", digest[i]);
+}
+
+static void uploadFail(int status, const char* error) {
+    if (up.status != 200) return; // keep the first error
+    up.status = status;
+    up.error = error;
+    Serial.printf("Upload %s failed: %s\n", up.name, error);
+}
+
+static void uploadCleanup() {
+    if (uploadSink.f) uploadSink.f.close();
+    if (up.shaActive) { mbedtls_sha256_free(&up.sha); up.shaActive = false; }
+    if (up.tempPath.length()) storageFs(up.sd).remove(up.tempPath);
+}
+
 void WebServerManager::handleUpload() {
     HTTPUpload& upload = server->upload();
-    static File uploadFile;
-    
+
     if (upload.status == UPLOAD_FILE_START) {
-        String filename = upload.filename;
-        if (!filename.startsWith("/")) filename = "/" + filename;
-        String path = "/gcode" + filename;
-        // Ensure directory exists
-        if (!LittleFS.exists("/gcode")) LittleFS.mkdir("/gcode");
-        uploadFile = LittleFS.open(path, "w");
+        uploadCleanup();
+        up.status = 200;
+        up.error = nullptr;
+        up.bytes = 0;
+        up.crc = 0;
+        up.tempPath = "";
+        up.finalPath = "";
+        up.startUs = esp_timer_get_time();
+        up.sd = server->arg("storage") == "sd";
+        if (!uploadSanitizeName(upload.filename.c_str(), up.name, sizeof(up.name))) {
+            strncpy(up.name, upload.filename.c_str(), sizeof(up.name) - 1);
+            up.name[sizeof(up.name) - 1] = '\0';
+            uploadFail(400, "bad filename");
+            return;
+        }
+        if (up.sd && !sdAvailable) { uploadFail(503, "sd not available"); return; }
+        fs::FS& fs = storageFs(up.sd);
+
+        // Refuse up front rather than filling the filesystem
+        String sizeArg = server->hasArg("size") ? server->arg("size") : server->header("Content-Length");
+        if (!uploadFits(up.sd, (uint64_t)sizeArg.toInt())) { uploadFail(507, "insufficient space"); return; }
+
+        // Written under a hidden temp name and renamed when complete and
+        // verified, so listings and jobs never see a partial file
+        up.finalPath = jobPath(up.sd, up.name);
+        up.tempPath = uploadTempPath(up.sd, up.name, ".part");
+        uploadSink.f = fs.open(up.tempPath, "w");
+        if (!uploadSink.f) { up.tempPath = ""; uploadFail(500, "cannot create file"); return; }
+        uploadWriter.begin(&uploadSink);
+        up.indexer.begin();
+        mbedtls_sha256_init(&up.sha);
+        mbedtls_sha256_starts(&up.sha, 0);
+        up.shaActive = true;
     } else if (upload.status == UPLOAD_FILE_WRITE) {
-        if (uploadFile) uploadFile.write(upload.buf, upload.currentSize);
+        if (up.status != 200) return;
+        if (!uploadWriter.write(upload.buf, upload.currentSize)) { uploadFail(507, "write failed (storage full?)"); return; }
+        up.bytes += upload.currentSize;
+        up.crc = uploadCrc32Update(up.crc, upload.buf, upload.currentSize);
+        mbedtls_sha256_update(&up.sha, upload.buf, upload.currentSize);
+        up.indexer.feed((const char*)upload.buf, upload.currentSize);
     } else if (upload.status == UPLOAD_FILE_END) {
-        if (uploadFile) uploadFile.close();
+        if (up.status != 200) { uploadCleanup(); return; }
+        if (!uploadWriter.flush()) uploadFail(507, "write failed (storage full?)");
+        uploadSink.f.close();
+        sha256Hex(&up.sha, up.shaHex);
+        mbedtls_sha256_free(&up.sha);
+        up.shaActive = false;
+        snprintf(up.crcHex, sizeof(up.crcHex), "%08lx", (unsigned long)up.crc);
+
+        if (up.status == 200 && server->hasArg("crc32") && !server->arg("crc32").equalsIgnoreCase(up.crcHex)) uploadFail(422, "crc32 mismatch");
+        if (up.status == 200 && server->hasArg("sha256") && !server->arg("sha256").equalsIgnoreCase(up.shaHex)) uploadFail(422, "sha256 mismatch");
+        if (up.status != 200) { uploadCleanup(); return; }
+
+        if (!uploadPlace(up.sd, up.tempPath, up.finalPath)) { uploadFail(500, "rename failed"); uploadCleanup(); return; }
+        up.tempPath = "";
+        up.endUs = esp_timer_get_time();
+
+        File f = storageFs(up.sd).open(up.finalPath, "r");
+        if (f) {
+            GcodeMeta m = up.indexer.finish();
+            m.size = f.size();
+            m.mtime = (uint32_t)f.getLastWrite();
+            f.close();
+            withIndex(up.sd, [&](IndexTable& t) { return t.put(up.name, m); });
+        }
+    } else if (upload.status == UPLOAD_FILE_ABORTED) {
+        uploadFail(400, "upload aborted");
+        uploadCleanup();
+    }
+}
+
+// Reply once the request (and its upload callbacks) is complete
+void WebServerManager::finishUpload() {
+    DynamicJsonDocument doc(512);
+    int status = up.status ? up.status : 400;
+    if (!up.status) up.error = "no file in request";
+    doc["success"] = status == 200;
+    doc["name"] = up.name;
+    doc["storage"] = up.sd ? "sd" : "littlefs";
+    if (status == 200) {
+        uint32_t us = (uint32_t)(up.endUs - up.startUs);
+        doc["size"] = up.bytes;
+        doc["crc32"] = up.crcHex;
+        doc["sha256"] = up.shaHex;
+        doc["ms"] = us / 1000;
+        doc["mbps"] = uploadMBps(up.bytes, us);
+    } else {
+        doc["error"] = up.error;
+    }
+    up.status = 0;
+    String out; serializeJson(doc, out);
+    server->send(status, "application/json", out);
+}
+// --- Chunked upload sessions (see upload_session.h) ---
+// POST   /api/upload/session           {filename, storage, size[, sha256]} -> {id, offset, ...}
+// GET    /api/upload/session?id=       current offset, to resume after a dropped connection
+// PUT    /api/upload/session?id=&offset=&crc32=   raw chunk (Content-Type: application/octet-stream)
+// POST   /api/upload/session/commit?id=[&sha256=]
+// DELETE /api/upload/session?id=
+// Sessions live in RAM; the partial file is a hidden ".<name>.resume".
+struct ChunkSession {
+    uint32_t id;            // 0 = free slot
+    bool sd;
+    char name[GCODE_INDEX_NAME_MAX];
+    String tempPath;
+    uint32_t size, received;
+    uint32_t crc;           // of the bytes received so far
+    mbedtls_sha256_context sha;
+    char expectSha[65];     // from the client, "" = not checked
+    int64_t startUs;
+    uint32_t lastMs;
+};
+static ChunkSession sessions[UPLOAD_SESSION_MAX];
+
+// The chunk being received. Its hash state is a copy of the session's,
+// taken over only when the chunk's CRC checks out, so a corrupt chunk can
+// simply be sent again.
+static struct {
+    ChunkSession* s;
+    UploadChunkVerdict verdict;
+    uint32_t offset, expectLen, len;
+    uint32_t crc, fileCrc;
+    bool checkCrc;
+    uint32_t expectCrc;
+    mbedtls_sha256_context sha;
+    bool shaActive;
+    int status;
+    const char* error;
+} chunk;
+
+static ChunkSession* sessionFind(const String& idArg) {
+    uint32_t id;
+    if (!uploadParseHex32(idArg.c_str(), id) || id == 0) return nullptr;
+    for (ChunkSession& s : sessions) if (s.id == id) return &s;
+    return nullptr;
+}
+
+static void sessionDrop(ChunkSession& s) {
+    if (!s.id) return;
+    if (s.tempPath.length()) storageFs(s.sd).remove(s.tempPath);
+    mbedtls_sha256_free(&s.sha);
+    s.id = 0;
+    s.tempPath = "";
+}
+
+static void sessionExpire() {
+    uint32_t now = millis();
+    for (ChunkSession& s : sessions) {
+        if (s.id && now - s.lastMs > UPLOAD_SESSION_IDLE_MS) {
+            Serial.printf("Upload session for %s expired at %lu/%lu bytes\n", s.name, (unsigned long)s.received, (unsigned long)s.size);
+            sessionDrop(s);
+        }
+    }
+}
+
+static void sessionJson(JsonDocument& doc, const ChunkSession& s) {
+    char id[9];
+    snprintf(id, sizeof(id), "%08lx", (unsigned long)s.id);
+    doc["id"] = id;
+    doc["name"] = s.name;
+    doc["storage"] = s.sd ? "sd" : "littlefs";
+    doc["size"] = s.size;
+    doc["offset"] = s.received;
+    doc["chunkSize"] = UPLOAD_CHUNK_SIZE;
+}
+
+void WebServerManager::sendJson(int status, JsonDocument& doc) {
+    String out; serializeJson(doc, out);
+    server->send(status, "application/json", out);
+}
+
+void WebServerManager::sendJsonOk() {
+    server->send(200, "application/json", "{\"success\":true}");
+}
+
+void WebServerManager::sendJsonError(int status, const char* error) {
+    DynamicJsonDocument doc(128);
+    doc["success"] = false;
+    doc["error"] = error;
+    sendJson(status, doc);
+}
+
+// Open a session, or pick up the existing one for the same file and size
+void WebServerManager::openUploadSession() {
+    sessionExpire();
+    DynamicJsonDocument req(512);
+    if (!server->hasArg("plain") || deserializeJson(req, server->arg("plain"))) { sendJsonError(400, "invalid JSON"); return; }
+    char name[GCODE_INDEX_NAME_MAX];
+    if (!uploadSanitizeName(req["filename"] | "", name, sizeof(name))) { sendJsonError(400, "bad filename"); return; }
+    bool sd = strcmp(req["storage"] | "littlefs", "sd") == 0;
+    if (sd && !sdAvailable) { sendJsonError(503, "sd not available"); return; }
+    if (!req["size"].is<uint32_t>()) { sendJsonError(400, "missing size"); return; }
+    uint32_t size = req["size"];
+    const char* sha = req["sha256"] | "";
+    if (*sha && strlen(sha) != 64) { sendJsonError(400, "bad sha256"); return; }
+
+    DynamicJsonDocument doc(256);
+    for (ChunkSession& s : sessions) {
+        if (s.id && s.sd == sd && strcmp(s.name, name) == 0) {
+            if (s.size == size) {
+                s.lastMs = millis();
+                sessionJson(doc, s);
+                sendJson(200, doc);
+                return;
+            }
+            sessionDrop(s); // same file, different content: start over
+        }
     }
+    ChunkSession* s = nullptr;
+    for (ChunkSession& c : sessions) if (!c.id) { s = &c; break; }
+    if (!s) { sendJsonError(503, "too many upload sessions"); return; }
+    if (!uploadFits(sd, size)) { sendJsonError(507, "insufficient space"); return; }
+
+    s->tempPath = uploadTempPath(sd, name, ".resume");
+    File f = storageFs(sd).open(s->tempPath, "w");
+    if (!f) { s->tempPath = ""; sendJsonError(500, "cannot create file"); return; }
+    f.close();
+    bool taken;
+    do {
+        s->id = esp_random();
+        taken = s->id == 0;
+        for (ChunkSession& c : sessions) if (&c != s && c.id == s->id) taken = true;
+    } while (taken);
+    s->sd = sd;
+    strcpy(s->name, name);
+    strcpy(s->expectSha, sha);
+    s->size = size;
+    s->received = 0;
+    s->crc = 0;
+    mbedtls_sha256_init(&s->sha);
+    mbedtls_sha256_starts(&s->sha, 0);
+    s->startUs = esp_timer_get_time();
+    s->lastMs = millis();
+    sessionJson(doc, *s);
+    sendJson(201, doc);
+}
+
+static void chunkFail(int status, const char* error) {
+    if (chunk.status != 200) return;
+    chunk.status = status;
+    chunk.error = error;
+}
+
+static void chunkCleanup() {
+    if (uploadSink.f) uploadSink.f.close();
+    if (chunk.shaActive) { mbedtls_sha256_free(&chunk.sha); chunk.shaActive = false; }
+}
+
+// Body of a PUT: written at the end of the partial file, kept only if the
+// whole chunk arrived and matches its CRC
+void WebServerManager::handleUploadChunk() {
+    HTTPRaw& raw = server->raw();
+    if (raw.status == RAW_START) {
+        chunkCleanup();
+        chunk.status = 200;
+        chunk.error = nullptr;
+        chunk.len = 0;
+        chunk.s = sessionFind(server->arg("id"));
+        if (!chunk.s) { chunkFail(404, "no such upload session"); return; }
+        chunk.s->lastMs = millis();
+        chunk.offset = (uint32_t)server->arg("offset").toInt();
+        chunk.expectLen = (uint32_t)server->header("Content-Length").toInt();
+        chunk.checkCrc = server->hasArg("crc32");
+        if (chunk.checkCrc && !uploadParseHex32(server->arg("crc32").c_str(), chunk.expectCrc)) { chunkFail(400, "bad crc32"); return; }
+        chunk.verdict = uploadChunkCheck(chunk.s->received, chunk.s->size, chunk.offset, chunk.expectLen);
+        if (chunk.verdict == UPLOAD_CHUNK_TOO_LARGE) { chunkFail(413, "chunk too large or past the declared size"); return; }
+        if (chunk.verdict == UPLOAD_CHUNK_CONFLICT) { chunkFail(409, "offset does not match the session"); return; }
+        if (chunk.verdict != UPLOAD_CHUNK_APPEND) return;
+
+        // Anything past `received` is left over from a rejected chunk and
+        // is overwritten
+        uploadSink.f = storageFs(chunk.s->sd).open(chunk.s->tempPath, "r+");
+        if (!uploadSink.f || !uploadSink.f.seek(chunk.s->received)) { chunkFail(500, "cannot open partial file"); return; }
+        uploadWriter.begin(&uploadSink);
+        chunk.crc = 0;
+        chunk.fileCrc = chunk.s->crc;
+        mbedtls_sha256_init(&chunk.sha);
+        mbedtls_sha256_clone(&chunk.sha, &chunk.s->sha);
+        chunk.shaActive = true;
+    } else if (raw.status == RAW_WRITE) {
+        if (chunk.status != 200 || chunk.verdict != UPLOAD_CHUNK_APPEND) return;
+        if (chunk.len + raw.currentSize > chunk.expectLen) { chunkFail(400, "body longer than Content-Length"); return; }
+        if (!uploadWriter.write(raw.buf, raw.currentSize)) { chunkFail(507, "write failed (storage full?)"); return; }
+        chunk.len += raw.currentSize;
+        chunk.crc = uploadCrc32Update(chunk.crc, raw.buf, raw.currentSize);
+        chunk.fileCrc = uploadCrc32Update(chunk.fileCrc, raw.buf, raw.currentSize);
+        mbedtls_sha256_update(&chunk.sha, raw.buf, raw.currentSize);
+    } else if (raw.status == RAW_END) {
+        if (chunk.status != 200 || chunk.verdict != UPLOAD_CHUNK_APPEND) { chunkCleanup(); return; }
+        if (!uploadWriter.flush()) chunkFail(507, "write failed (storage full?)");
+        uploadSink.f.close();
+        if (chunk.len != chunk.expectLen) chunkFail(400, "incomplete chunk");
+        if (chunk.checkCrc && chunk.crc != chunk.expectCrc) chunkFail(422, "crc32 mismatch");
+        if (chunk.status == 200) {
+            ChunkSession& s = *chunk.s;
+            s.received += chunk.len;
+            s.crc = chunk.fileCrc;
+            mbedtls_sha256_free(&s.sha);
+            mbedtls_sha256_init(&s.sha);
+            mbedtls_sha256_clone(&s.sha, &chunk.sha);
+        }
+        chunkCleanup();
+    } else if (raw.status == RAW_ABORTED) {
+        chunkFail(400, "chunk aborted");
+        chunkCleanup();
+    }
+}
+
+// Reply to a PUT with where the session stands, success or not
+void WebServerManager::finishUploadChunk() {
+    if (chunk.status == 0) { sendJsonError(400, "empty chunk"); return; }
+    DynamicJsonDocument doc(384);
+    int status = chunk.status;
+    chunk.status = 0;
+    doc["success"] = status == 200;
+    if (status != 200) doc["error"] = chunk.error;
+    // Sessions can be gone by now only if the chunk named none
+    if (status != 404 && chunk.s && chunk.s->id) {
+        sessionJson(doc, *chunk.s);
+        if (status == 200 && chunk.verdict == UPLOAD_CHUNK_DUPLICATE) doc["duplicate"] = true;
+    }
+    sendJson(status, doc);
+}
+
+void WebServerManager::uploadSessionStatus() {
+    sessionExpire();
+    ChunkSession* s = sessionFind(server->arg("id"));
+    if (!s) { sendJsonError(404, "no such upload session"); return; }
+    DynamicJsonDocument doc(256);
+    char crc[9];
+    snprintf(crc, sizeof(crc), "%08lx", (unsigned long)s->crc);
+    sessionJson(doc, *s);
+    doc["crc32"] = crc; // of the first `offset` bytes
+    sendJson(200, doc);
+}
+
+// All bytes in: check the whole file and move it into place
+void WebServerManager::commitUploadSession() {
+    ChunkSession* s = sessionFind(server->arg("id"));
+    if (!s) { sendJsonError(404, "no such upload session"); return; }
+    if (s->received != s->size) { sendJsonError(409, "upload incomplete"); return; }
+    String shaArg = server->arg("sha256");
+    const char* expect = shaArg.length() ? shaArg.c_str() : s->expectSha;
+    char shaHex[65], crcHex[9];
+    mbedtls_sha256_context sha;
+    mbedtls_sha256_init(&sha);
+    mbedtls_sha256_clone(&sha, &s->sha); // the session stays usable if this fails
+    sha256Hex(&sha, shaHex);
+    mbedtls_sha256_free(&sha);
+    snprintf(crcHex, sizeof(crcHex), "%08lx", (unsigned long)s->crc);
+    if (*expect && strcasecmp(expect, shaHex) != 0) { sendJsonError(422, "sha256 mismatch"); return; }
+    if (!uploadPlace(s->sd, s->tempPath, jobPath(s->sd, s->name))) { sendJsonError(500, "rename failed"); return; }
+    s->tempPath = ""; // nothing left to remove
+
+    uint32_t us = (uint32_t)(esp_timer_get_time() - s->startUs);
+    DynamicJsonDocument doc(512);
+    doc["success"] = true;
+    doc["name"] = s->name;
+    doc["storage"] = s->sd ? "sd" : "littlefs";
+    doc["size"] = s->size;
+    doc["crc32"] = crcHex;
+    doc["sha256"] = shaHex;
+    doc["ms"] = us / 1000;
+    doc["mbps"] = uploadMBps(s->size, us); // including pauses between chunks
+    sessionDrop(*s);
+    kickIndexer();
+    sendJson(200, doc);
+}
+
+void WebServerManager::abortUploadSession() {
+    ChunkSession* s = sessionFind(server->arg("id"));
+    if (!s) { sendJsonError(404, "no such upload session"); return; }
+    sessionDrop(*s);
+    sendJsonOk();
+}
+
+// Spawn the streamer for a stored job; the caller holds the job slot
+// (released here if the task can't be created)
+static bool startJobTask(WebServerManager* self, StreamBufferHandle_t* stream, const char* filename, uint8_t storage) {
+    JobStreamArgs* args = new JobStreamArgs();
+    args->mgr = self; args->gcodeStream = stream; strncpy(args->filename, filename, sizeof(args->filename)-1); args->filename[sizeof(args->filename)-1] = '\0';
+    args->storage = storage;
+    BaseType_t created = xTaskCreate(
+        jobStreamerTask,
+        "jobStreamer",
+        4096 / sizeof(portSTACK_TYPE),
+        args,
+        1,
+        NULL
+    );
+    if (created != pdTRUE) { delete args; jobRelease(); }
+    return created == pdTRUE;
+}
+
+// Start a stored job. `body` is the request's JSON (may be empty, with
+// query args instead).
+void WebServerManager::handleJobStart(const String& body) {
+    if (jobActive) { server->send(409, "application/json", "{\"success\":false,\"message\":\"a job is already running\"}"); return; }
+    String filename;
+    String storageArg = String("littlefs");
+    if (body.length()) {
+        DynamicJsonDocument doc(256);
+        if (!deserializeJson(doc, body)) {
+            if (doc["filename"].is<const char*>()) filename = String((const char*)doc["filename"]);
+            if (doc["storage"].is<const char*>()) storageArg = String((const char*)doc["storage"]);
+            // "reserve" is no longer needed: every job holds the executor
+        }
+    }
+    if (filename.length() == 0 && server->hasArg("filename")) filename = server->arg("filename");
+    if (server->hasArg("storage")) storageArg = server->arg("storage");
+    uint8_t storage = STORAGE_LITTLEFS;
+    if (storageArg == "sd") storage = STORAGE_SD;
+    if (filename.length() == 0) { server->send(400, "text/plain", "Missing filename"); return; }
+
+    // Verify file exists in selected storage
+    if (storage == STORAGE_LITTLEFS) {
+        String path = String("/gcode/") + filename;
+        if (!LittleFS.exists(path)) { server->send(404, "text/plain", "File not found"); return; }
+    } else {
+        if (!sdAvailable) { server->send(503, "text/plain", "SD not available"); return; }
+        if (!SD.exists(filename)) { server->send(404, "text/plain", "File not found on SD"); return; }
+    }
+
+    // Soft limits: refuse a job whose indexed travel leaves the envelope
+    String outside = jobPreflight(storage == STORAGE_SD, filename.c_str());
+    if (outside.length()) {
+        DynamicJsonDocument res(256); res["success"] = false; res["message"] = String("soft limit: ") + outside;
+        sendJson(422, res);
+        return;
+    }
+
+    // One job at a time; queued jobs wait for the runner instead
+    if (const char* why = jobClaim(filename.c_str())) { server->send(409, "application/json", String("{\"success\":false,\"message\":\"") + why + "\"}"); return; }
+    bool isRaster = jobIsRaster(filename.c_str());
+    if (!startJobTask(this, gcodeStream, filename.c_str(), storage)) {
+        server->send(500, "text/plain", "Failed to start job streamer");
+        return;
+    }
+    DynamicJsonDocument res(128); res["success"] = true; res["started"] = true; res["filename"] = filename;
+    res["type"] = isRaster ? "raster" : "gcode";
+    res["reserved"] = true;
+    String out; serializeJson(res, out);
+    server->send(200, "application/json", out);
+}
+
+// --- Streamed print: POST /api/print?name=&store=littlefs|sd ---
+// The body is fed to the parser while it is still arriving, so motion
+// starts after the first few KB instead of after the whole upload. With
+// store=, it is also written to storage (renamed into place only if the
+// whole job arrived) for re-runs. Raster (.e3r) bodies can't be consumed
+// from the socket, so they need store= and run once stored.
+static struct {
+    int status;         // 0 = no body seen
+    const char* error;
+    bool json;          // {filename, storage}: start a stored job instead
+    String jsonBody;
+    bool claimed;       // this request holds the job slot
+    bool started;       // G-code is flowing to the parser
+    bool raster;
+    bool store, sd;
+    bool stopped;
+    char name[GCODE_INDEX_NAME_MAX];
+    String tempPath;
+    uint32_t bytes;
+    int64_t startUs, firstUs, endUs;
+    PrintStreamFeeder feeder;
+    StreamBufferHandle_t* stream;
+} pr;
+
+static size_t printStreamWrite(const uint8_t* p, size_t n) { return gcodeStreamWrite(p, n, pdMS_TO_TICKS(100)); }
+static bool printStreamStopped() { return jobStopRequested; }
+
+static void printFail(int status, const char* error) {
+    if (pr.status != 200) return;
+    pr.status = status;
+    pr.error = error;
+    Serial.printf("Streamed print %s: %s\n", pr.name, error);
+}
+
+// A streamed print whose body has been fed: its tail is still in the
+// stream and the motion queue, so the job slot is handed to this task,
+// which gives it back once the machine has run it
+struct PrintDrainArgs {
+    WebServerManager* mgr;
+    StreamBufferHandle_t* stream;
+    const char* event;
+    char name[GCODE_INDEX_NAME_MAX];
+};
+
+static void printDrainTask(void* pv) {
+    PrintDrainArgs* a = reinterpret_cast<PrintDrainArgs*>(pv);
+    if (!jobStopRequested) waitMachineIdle(a->stream);
+    const char* event = jobStopRequested && strcmp(a->event, "finished") == 0 ? "stopped" : a->event;
+    a->mgr->broadcastJobEvent(event, a->name, "stream", -1);
+    jobRelease();
+    delete a;
+    vTaskDelete(NULL);
+}
+
+// Give the job slot back (and discard a partial stored copy). Once G-code
+// has flowed, the release waits in printDrainTask unless the job was stopped.
+static void printRelease(WebServerManager* self, const char* event) {
+    if (!pr.claimed) return;
+    pr.claimed = false;
+    if (uploadSink.f) uploadSink.f.close();
+    if (pr.tempPath.length()) { storageFs(pr.sd).remove(pr.tempPath); pr.tempPath = ""; }
+    bool started = pr.started;
+    pr.started = false;
+    if (started && !jobStopRequested) {
+        PrintDrainArgs* a = new PrintDrainArgs();
+        a->mgr = self; a->stream = pr.stream; a->event = event;
+        strncpy(a->name, pr.name, sizeof(a->name) - 1); a->name[sizeof(a->name) - 1] = '\0';
+        if (xTaskCreate(printDrainTask, "printDrain", 3072 / sizeof(portSTACK_TYPE), a, 1, NULL) == pdTRUE) return;
+        delete a; // no task: release now rather than never
+    }
+    if (started) self->broadcastJobEvent(event, pr.name, "stream", -1);
+    jobRelease();
+}
+
+void WebServerManager::handlePrintStream() {
+    HTTPRaw& raw = server->raw();
+    if (raw.status == RAW_START) {
+        pr.status = 200;
+        pr.error = nullptr;
+        pr.json = server->header("Content-Type").startsWith("application/json");
+        pr.jsonBody = "";
+        if (pr.json) return;
+        pr.started = pr.raster = pr.stopped = false;
+        pr.bytes = 0;
+        pr.tempPath = "";
+        pr.startUs = esp_timer_get_time();
+        pr.firstUs = 0;
+        pr.stream = gcodeStream;
+        pr.feeder.begin();
+        String name = server->hasArg("name") ? server->arg("name") : String("stream.gcode");
+        if (!uploadSanitizeName(name.c_str(), pr.name, sizeof(pr.name))) { strcpy(pr.name, "?"); printFail(400, "bad name"); return; }
+        String store = server->arg("store");
+        pr.store = store.length() > 0;
+        pr.sd = store == "sd";
+        if (pr.store && store != "sd" && store != "littlefs") { printFail(400, "store must be littlefs or sd"); return; }
+        if (pr.sd && !sdAvailable) { printFail(503, "sd not available"); return; }
+        if (pr.store && !uploadFits(pr.sd, (uint64_t)server->header("Content-Length").toInt())) { printFail(507, "insufficient space"); return; }
+        // Hold the job slot for the whole request
+        if (const char* why = jobClaim(pr.name)) { printFail(409, why); return; }
+        pr.claimed = true;
+        if (pr.store) {
+            pr.tempPath = uploadTempPath(pr.sd, pr.name, ".part");
+            uploadSink.f = storageFs(pr.sd).open(pr.tempPath, "w");
+            if (!uploadSink.f) { pr.tempPath = ""; printFail(500, "cannot create file"); printRelease(this, "error"); return; }
+            uploadWriter.begin(&uploadSink);
+        }
+    } else if (raw.status == RAW_WRITE) {
+        if (pr.json) {
+            if (pr.jsonBody.length() + raw.currentSize > 512) { printFail(413, "JSON body too large"); return; }
+            pr.jsonBody.concat((const char*)raw.buf, raw.currentSize);
+            return;
+        }
+        if (pr.status != 200 || pr.stopped) return;
+        if (pr.bytes == 0) {
+            pr.raster = printBodyKind(raw.buf, raw.currentSize) == PRINT_BODY_RASTER;
+            if (pr.raster && !pr.store) { printFail(415, "raster jobs must be stored first (store=littlefs|sd)"); printRelease(this, "error"); return; }
+            if (pr.raster && !String(pr.name).endsWith(".e3r")) { printFail(400, "raster job name must end in .e3r"); printRelease(this, "error"); return; }
+            if (!pr.raster) {
+                pr.started = true;
+                broadcastJobEvent("started", pr.name, "stream", -1);
+            }
+        }
+        pr.bytes += raw.currentSize;
+        if (pr.store && !uploadWriter.write(raw.buf, raw.currentSize)) { printFail(507, "write failed (storage full?)"); printRelease(this, "error"); return; }
+        if (pr.raster) return;
+        if (!pr.feeder.push(raw.buf, raw.currentSize, printStreamWrite, printStreamStopped)) {
+            // Stopped from /api/job/stop: the rest of the body is read and dropped
+            pr.stopped = true;
+            return;
+        }
+        if (!pr.firstUs) pr.firstUs = esp_timer_get_time();
+    } else if (raw.status == RAW_END) {
+        if (pr.json || pr.status != 200) return;
+        if (pr.started && !pr.stopped && !pr.feeder.finish(printStreamWrite, printStreamStopped)) pr.stopped = true;
+        pr.endUs = esp_timer_get_time();
+        if (pr.store && !pr.stopped) {
+            if (!uploadWriter.flush()) printFail(507, "write failed (storage full?)");
+            uploadSink.f.close();
+            if (pr.status == 200) {
+                if (uploadPlace(pr.sd, pr.tempPath, jobPath(pr.sd, pr.name))) { pr.tempPath = ""; kickIndexer(); }
+                else printFail(500, "rename failed");
+            }
+        }
+        bool raster = pr.raster && pr.status == 200;
+        printRelease(this, pr.stopped ? "stopped" : (pr.status == 200 ? "finished" : "error"));
+        if (raster) {
+            if (const char* why = jobClaim(pr.name)) printFail(409, why);
+            else if (!startJobTask(this, gcodeStream, pr.name, pr.sd ? STORAGE_SD : STORAGE_LITTLEFS)) printFail(500, "failed to start job");
+        }
+    } else if (raw.status == RAW_ABORTED) {
+        if (pr.json) { pr.status = 0; return; }
+        // Whatever arrived may already be moving; a truncated job must not
+        // carry on from where the connection dropped
+        if (pr.started) runStopped = true;
+        printFail(400, "connection lost");
+        printRelease(this, "error");
+    }
+}
+
+void WebServerManager::finishPrintStream() {
+    if (pr.json) { pr.json = false; handleJobStart(pr.jsonBody); pr.jsonBody = ""; return; }
+    if (pr.status == 0) { sendJsonError(400, "empty body"); return; }
+    int status = pr.status;
+    pr.status = 0;
+    if (status != 200) { sendJsonError(status, pr.error); return; }
+    DynamicJsonDocument doc(384);
+    doc["success"] = true;
+    doc["name"] = pr.name;
+    doc["type"] = pr.raster ? "raster" : "gcode";
+    doc["bytes"] = pr.bytes;
+    doc["ms"] = (uint32_t)((pr.endUs - pr.startUs) / 1000);
+    // Request start to the first bytes reaching the parser
+    if (pr.firstUs) doc["firstLineMs"] = (uint32_t)((pr.firstUs - pr.startUs) / 1000);
+    if (pr.stopped) doc["stopped"] = true;
+    if (pr.store) doc["stored"] = pr.stopped ? "" : (pr.sd ? "sd" : "littlefs");
+    sendJson(200, doc);
 }
 
 void WebServerManager::onWebSocketEvent(uint8_t num, WStype_t type, uint8_t * payload, size_t length) {
-    if (type == WStype_TEXT) {
+    if (type == WStype_DISCONNECTED) {
+        // The client's session ends with its connection
+        if (executorOwner.release(SRC_WEBSOCKET, num)) Serial.printf("WebSocket %u disconnected -> executor released\n", num);
+    } else if (type == WStype_TEXT) {
+        int64_t t0 = esp_timer_get_time();
         // Assume payload is G-Code or JSON command
         // For now, treat as raw G-Code line and forward to command queue
         RawCommand rc;
         rc.srcType = SRC_WEBSOCKET;
         rc.srcId = num;
-        size_t l = min((size_t)127, length);
-        memcpy(rc.line, payload, l);
+        // Realtime bytes act at once; whatever else the message holds is queued
+        RealtimeFilter realtime;
+        size_t l = 0;
+        for (size_t i = 0; i < length; ++i) {
+            RealtimeCommand rt = realtime.feed(payload[i]);
+            if (rt != RT_NONE) handleRealtime(rt, rc.srcType, rc.srcId);
+            else if (l < 127) rc.line[l++] = (char)payload[i];
+        }
         rc.line[l] = '\0'; rc.len = l;
+        if (realtimeFromLine(rc.line, l) == RT_ESTOP) { handleRealtime(RT_ESTOP, rc.srcType, rc.srcId); return; }
+        bool blank = true;
+        for (size_t i = 0; i < l && blank; ++i) blank = isspace((unsigned char)rc.line[i]);
+        if (blank) return;
         // push to command queue with ownership checks
         String reason = pushClientCommand(rc);
         if (reason.length() == 0) {
@@ -908,9 +2649,44 @@ void WebServerManager::onWebSocketEvent(uint8_t num, WStype_t type, uint8_t * pa
         } else {
             sendResponseToClient(rc.srcType, rc.srcId, String("error:") + reason);
         }
+        wsLatency.service.record((uint32_t)(esp_timer_get_time() - t0));
     }
 }
 
+// Realtime commands skip commandQueue, the parser and motionQueue: they set
+// the run flags controlTask checks on every 1 ms tick, so they take effect
+// within a tick even behind a full queue or in the middle of a long move.
+// Any client may send them, owner or not.
+void WebServerManager::handleRealtime(RealtimeCommand c, uint8_t srcType, int srcId) {
+    switch (c) {
+        case RT_FEED_HOLD:
+            runPaused = true;
+            break;
+        case RT_RESUME:
+            runPaused = false;
+            break;
+        case RT_STATUS:
+            sendResponseToClient(srcType, srcId, machineStatusReport());
+            return;
+        case RT_RESET:
+            // Like /api/job/stop: cancel the job and drop what's queued; the
+            // position is kept and the machine is not halted
+            if (jobActive) jobStopRequested = true;
+            runPaused = false;
+            runStopped = true;
+            break;
+        case RT_ESTOP:
+            if (jobActive) jobStopRequested = true;
+            emergencyStop();
+            broadcastError("Emergency Stop (M112)");
+            break;
+        default:
+            return;
+    }
+    Serial.printf("Realtime %s from %d/%d\n", realtimeName(c), srcType, srcId);
+    sendResponseToClient(srcType, srcId, String("ok:") + realtimeName(c));
+}
+
 String WebServerManager::pushClientCommand(const RawCommand &cmd) {
     // Emergency commands (M112 / M999) should be accepted regardless of owner
     String s = String(cmd.line);
@@ -919,51 +2695,31 @@ String WebServerManager::pushClientCommand(const RawCommand &cmd) {
     bool isClear = (s.indexOf("M999") != -1);
     // Always queue motion commands — execution-time errors will be emitted by the control task
     bool isMotion = (s.indexOf("G0") != -1) || (s.indexOf("G1") != -1);
-    // Clear expired reservation if present
-    portENTER_CRITICAL(&g_executorMux);
-    if (executorBusy && executorReservedUntil != 0 && millis() > executorReservedUntil) {
-        // reservation expired -> release
-        executorBusy = false;
-        executorOwnerType = SRC_SERIAL;
-        executorOwnerId = -1;
-        executorReservedUntil = 0;
-        Serial.println("pushClientCommand: executor reservation expired -> released");
-    }
-    portEXIT_CRITICAL(&g_executorMux);
-
-    // If executor is busy and owned by a different client, reject (unless emergency/clear)
-    if (!isEmergency && !isClear && executorBusy && !(executorOwnerType == cmd.srcType && executorOwnerId == cmd.srcId)) {
-        return String("busy");
-    }
-    // Reserve executor early: if this is a motion/homing/emergency command and
-    // the executor is not already busy, claim executor ownership right now so
-    // other clients will receive immediate error:busy when attempting to push.
     bool isHoming = (s.indexOf("G28") != -1);
-    if ((isMotion || isHoming || isEmergency) && !executorBusy) {
-        // claim ownership atomically to avoid races across cores
-        portENTER_CRITICAL(&g_executorMux);
-        if (!executorBusy) {
-            executorBusy = true;
-            executorOwnerType = cmd.srcType;
-            executorOwnerId = cmd.srcId;
-            // set a short reservation window; controlTask will claim executor properly
-            executorReservedUntil = millis() + EXECUTOR_RESERVATION_MS;
-            Serial.printf("pushClientCommand: reserved executor for %d/%d at push-time (reservedUntil=%lu)\n", cmd.srcType, cmd.srcId, executorReservedUntil);
-        }
-        portEXIT_CRITICAL(&g_executorMux);
+    // Motion and homing take the executor (or renew the sender's lease), so
+    // other clients get an immediate error:busy until this one disconnects,
+    // releases or goes quiet for EXECUTOR_LEASE_MS. Other commands only need
+    // it not to be someone else's. Emergency/clear are always accepted.
+    if (!isEmergency && !isClear) {
+        uint32_t now = millis();
+        bool admitted = (isMotion || isHoming) ? executorOwner.claim(cmd.srcType, cmd.srcId, now, EXECUTOR_LEASE_MS)
+                                               : executorOwner.admits(cmd.srcType, cmd.srcId, now);
+        if (!admitted) return String("busy");
+        executorOwner.renew(cmd.srcType, cmd.srcId, now, EXECUTOR_LEASE_MS);
     }
     // If there's no command queue, treat it as a busy/unavailable state
     if (commandQueue == nullptr) return String("busy");
 
     // Try to enqueue immediately (don't block the network task).
     BaseType_t ok = xQueueSend(*commandQueue, &cmd, 0);
-    Serial.printf("pushClientCommand: incoming %d/%d executorBusy=%d immediateEnqueue=%d\n", cmd.srcType, cmd.srcId, (int)executorBusy, (int)(ok==pdTRUE));
+    bool owner = executorOwner.owns(cmd.srcType, cmd.srcId);
+    Serial.printf("pushClientCommand: incoming %d/%d owner=%d immediateEnqueue=%d\n", cmd.srcType, cmd.srcId, (int)owner, (int)(ok==pdTRUE));
     if (ok == pdTRUE) return String("");
 
     // Queue is full. If the requestor is the current executor owner, spawn a
     // background enqueue waiter so we don't block the network thread waiting
     // for space. If the requester isn't the owner, return busy immediately.
-    if (executorBusy && (executorOwnerType == cmd.srcType && executorOwnerId == cmd.srcId)) {
+    if (owner) {
         const uint32_t OWNER_WAIT_MS = 2000; // wait up to 2s for queue space
 
         EnqueueWaitArgs* args = new EnqueueWaitArgs();
@@ -996,6 +2752,13 @@ String WebServerManager::pushClientCommand(const RawCommand &cmd) {
     return String("busy");
 }
 
+void WebServerManager::stopJob(const String& why) {
+    if (!jobActive || jobStopRequested) return;
+    jobStopRequested = true;
+    runStopped = true;
+    broadcastError(why);
+}
+
 void WebServerManager::sendResponseToClient(uint8_t srcType, int srcId, const String &msg) {
     if (srcType == SRC_WEBSOCKET) {
         if (!ws) return;
@@ -1026,8 +2789,10 @@ void WebServerManager::sendResponseToClient(uint8_t srcType, int srcId, const St
         out += "{\"type\":\"response\",\"status\":\"" + status + "\"";
         out += ",\"detail\":\"" + detail + "\"";
         out += ",\"raw\":\"" + raw + "\"}";
+        NetLock lock(wsLock);
         ws->sendTXT(srcId, out.c_str());
     } else if (srcType == SRC_TELNET) {
+        NetLock lock(telnetLock);
         if (telnetClient && telnetClient.connected()) telnetClient.println(msg);
     } else { // serial
         Serial.println(msg);
@@ -1061,9 +2826,11 @@ void WebServerManager::broadcastStatus(float x, float y, float z, float e, float
     doc["lastMoveZ_ms"] = lastMoveZ;
     doc["lastMoveE_ms"] = lastMoveE;
     // executor state
-    doc["executor_busy"] = executorBusy;
-    doc["executor_owner_type"] = (int)executorOwnerType;
-    doc["executor_owner_id"] = executorOwnerId;
+    ExecutorOwnerView owner = executorOwner.view(millis());
+    doc["executor_busy"] = owner.busy;
+    doc["executor_owner_type"] = (int)owner.type;
+    doc["executor_owner_id"] = owner.id;
+    doc["homed"] = machineHomed;
     // motor outputs (signed -255..255)
     doc["motorOutX"] = motorOutX;
     doc["motorOutY"] = motorOutY;
@@ -1076,10 +2843,12 @@ void WebServerManager::broadcastStatus(float x, float y, float z, float e, float
     doc["encCountsE"] = encCountsE;
     String output;
     serializeJson(doc, output);
+    NetLock lock(wsLock);
     ws->broadcastTXT(output);
 }
 
 void WebServerManager::sendTelnet(String message) {
+    NetLock lock(telnetLock);
     if (telnetClient && telnetClient.connected()) {
         telnetClient.println(message);
     }
@@ -1090,8 +2859,12 @@ void WebServerManager::broadcastError(String message) {
     doc["error"] = message;
     String output;
     serializeJson(doc, output);
-    ws->broadcastTXT(output);
-    
+    {
+        NetLock lock(wsLock);
+        ws->broadcastTXT(output);
+    }
+
+    NetLock lock(telnetLock);
     if (telnetClient && telnetClient.connected()) {
         telnetClient.print("Error: ");
         telnetClient.println(message);
@@ -1103,8 +2876,12 @@ void WebServerManager::broadcastWarning(String message) {
     doc["warning"] = message;
     String output;
     serializeJson(doc, output);
-    ws->broadcastTXT(output);
+    {
+        NetLock lock(wsLock);
+        ws->broadcastTXT(output);
+    }
 
+    NetLock lock(telnetLock);
     if (telnetClient && telnetClient.connected()) {
         telnetClient.print("Warning: ");
         telnetClient.println(message);
@@ -1119,8 +2896,12 @@ void WebServerManager::broadcastJobEvent(const char* event, const char* filename
     doc["storage"] = String(storage);
     if (progress >= 0) doc["progress"] = progress;
     String output; serializeJson(doc, output);
-    ws->broadcastTXT(output);
+    {
+        NetLock lock(wsLock);
+        ws->broadcastTXT(output);
+    }
 
+    NetLock lock(telnetLock);
     if (telnetClient && telnetClient.connected()) {
         telnetClient.print("JobEvent: "); telnetClient.print(event); telnetClient.print(" "); telnetClient.println(filename);
     }
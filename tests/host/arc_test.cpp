@@ -0,0 +1,168 @@
+// Host test: G2/G3 arc segmentation honours the chord tolerance and geometry,
+// and the native arc trajectory stays on the true circle.
+//
+// Build & run from the repo root:
+//   g++ -std=c++17 -Iinclude tests/host/arc_test.cpp -o /tmp/arc_test && /tmp/arc_test
+#include <stdio.h>
+#include <math.h>
+#include "arc.h"
+
+static int failures = 0;
+
+static void check(bool ok, const char* what) {
+    printf("  %s %s\n", what, ok ? "✓" : "✗");
+    if (!ok) failures++;
+}
+
+// Walk the arc and measure the worst sagitta (chord midpoint distance from
+// the true circle) plus the worst vertex radius error.
+static void measure(ArcGenerator &arc, const float start[NUM_AXES], float &worstChord, float &worstVertex, int &points) {
+    float prev[NUM_AXES];
+    for (int i = 0; i < NUM_AXES; ++i) prev[i] = start[i];
+    float p[NUM_AXES];
+    worstChord = 0.0f; worstVertex = 0.0f; points = 0;
+    while (arc.next(p)) {
+        float mx = 0.5f * (prev[AXIS_X] + p[AXIS_X]) - arc.centerX();
+        float my = 0.5f * (prev[AXIS_Y] + p[AXIS_Y]) - arc.centerY();
+        float sag = arc.radius() - sqrtf(mx * mx + my * my);
+        if (sag > worstChord) worstChord = sag;
+        float vx = p[AXIS_X] - arc.centerX(), vy = p[AXIS_Y] - arc.centerY();
+        float ve = fabsf(sqrtf(vx * vx + vy * vy) - arc.radius());
+        if (ve > worstVertex) worstVertex = ve;
+        for (int i = 0; i < NUM_AXES; ++i) prev[i] = p[i];
+        points++;
+    }
+}
+
+int main() {
+    printf("Test: chord error stays within tolerance\n");
+    const float radii[] = { 0.5f, 5.0f, 50.0f, 250.0f };
+    const float tols[] = { 0.002f, 0.01f, 0.05f };
+    for (float r : radii) {
+        for (float tol : tols) {
+            float start[NUM_AXES] = { r, 0, 0, 0 };
+            ArcGenerator arc;
+            arc.beginCenter(start, start, -r, 0, false, tol); // full CCW circle
+            float chord, vertex; int n;
+            measure(arc, start, chord, vertex, n);
+            char buf[128];
+            snprintf(buf, sizeof(buf), "r=%-6.1f tol=%.3f -> %4d segs, chord err %.5f, vertex err %.6f", r, tol, n, chord, vertex);
+            // allow for float rounding of the vertices themselves on large radii
+            check(chord <= tol + vertex + 1e-5f && vertex < 1e-3f, buf);
+        }
+    }
+    {
+        // Old firmware rule was one segment per mm of radius*angle (min 8)
+        float start[NUM_AXES] = { 2.0f, 0, 0, 0 };
+        ArcGenerator arc;
+        arc.beginCenter(start, start, -2.0f, 0, false, 0.01f);
+        int legacy = (int)(2.0f * 2.0f * (float)M_PI); if (legacy < 8) legacy = 8;
+        float chord, vertex; int n;
+        measure(arc, start, chord, vertex, n);
+        char buf[128];
+        snprintf(buf, sizeof(buf), "r=2 full circle: %d segs (legacy rule %d gave %.3f mm chord error)", n, legacy,
+                 2.0f * (1.0f - cosf((float)M_PI / legacy)));
+        check(chord <= 0.0101f, buf);
+    }
+
+    printf("Test: end point, direction and helical Z\n");
+    {
+        float start[NUM_AXES] = { 10, 0, 0, 0 };
+        float end[NUM_AXES] = { 0, 10, 5, 2 };
+        ArcGenerator arc;
+        bool ok = arc.beginCenter(start, end, -10, 0, false, 0.01f);
+        float p[NUM_AXES], last[NUM_AXES] = { 0, 0, 0, 0 };
+        bool zMonotonic = true; float prevZ = 0;
+        while (arc.next(p)) {
+            if (p[AXIS_Z] < prevZ) zMonotonic = false;
+            prevZ = p[AXIS_Z];
+            for (int i = 0; i < NUM_AXES; ++i) last[i] = p[i];
+        }
+        check(ok && fabsf(arc.sweep() - (float)M_PI / 2) < 1e-4f, "G3 quarter circle sweeps +90 deg");
+        check(last[AXIS_X] == 0 && last[AXIS_Y] == 10 && last[AXIS_Z] == 5 && last[AXIS_E] == 2, "last point is the exact end point");
+        check(zMonotonic, "Z rises linearly along the helix");
+
+        ArcGenerator cw;
+        cw.beginCenter(start, end, -10, 0, true, 0.01f);
+        check(fabsf(cw.sweep() + 3.0f * (float)M_PI / 2) < 1e-4f, "G2 to the same point sweeps -270 deg");
+    }
+
+    printf("Test: R-form arcs\n");
+    {
+        float start[NUM_AXES] = { 0, 0, 0, 0 };
+        float end[NUM_AXES] = { 10, 0, 0, 0 };
+        ArcGenerator shortArc, longArc, bad;
+        bool a = shortArc.beginRadius(start, end, 10.0f, true, 0.01f);
+        bool b = longArc.beginRadius(start, end, -10.0f, true, 0.01f);
+        check(a && fabsf(shortArc.radius() - 10.0f) < 1e-3f && fabsf(shortArc.sweep()) < (float)M_PI, "R10 picks the short arc");
+        check(b && fabsf(longArc.sweep()) > (float)M_PI, "R-10 picks the long arc");
+        check(!bad.beginRadius(start, end, 2.0f, true, 0.01f), "R smaller than half the chord is rejected");
+        check(!bad.beginRadius(start, start, 5.0f, true, 0.01f), "R-form full circle is rejected");
+    }
+
+    printf("Test: CORDIC sine/cosine\n");
+    {
+        float worst = 0.0f;
+        for (float a = -10.0f; a <= 10.0f; a += 0.001f) {
+            float s, c;
+            cordicSinCos(a, s, c);
+            float e = fmaxf(fabsf(s - sinf(a)), fabsf(c - cosf(a)));
+            if (e > worst) worst = e;
+        }
+        char buf[96];
+        snprintf(buf, sizeof(buf), "worst error over +-10 rad: %.2e", worst);
+        check(worst < 1e-6f, buf);
+    }
+
+    printf("Test: native arc vs segmented contour error (1 kHz setpoints)\n");
+    {
+        const float feed = 1200.0f; // mm/min
+        const float radii2[] = { 2.0f, 20.0f, 100.0f };
+        for (float r : radii2) {
+            float start[NUM_AXES] = { r, 0, 0, 0 };
+            ArcGenerator arc;
+            arc.beginCenter(start, start, -r, 0, false, 0.01f);
+
+            // Segmented: setpoint runs linearly along each chord
+            float segWorst = 0.0f;
+            float prev[NUM_AXES] = { start[0], start[1], start[2], start[3] };
+            float p[NUM_AXES];
+            while (arc.next(p)) {
+                float len = hypotf(p[AXIS_X] - prev[AXIS_X], p[AXIS_Y] - prev[AXIS_Y]);
+                int ticks = (int)ceilf(len / feed * 60000.0f);
+                for (int k = 0; k <= ticks; ++k) {
+                    float t = ticks ? (float)k / ticks : 1.0f;
+                    float x = prev[AXIS_X] + (p[AXIS_X] - prev[AXIS_X]) * t - arc.centerX();
+                    float y = prev[AXIS_Y] + (p[AXIS_Y] - prev[AXIS_Y]) * t - arc.centerY();
+                    float e = fabsf(sqrtf(x * x + y * y) - r);
+                    if (e > segWorst) segWorst = e;
+                }
+                for (int i = 0; i < NUM_AXES; ++i) prev[i] = p[i];
+            }
+
+            // Native: one move, setpoint evaluated on the circle every tick
+            ArcPath path;
+            path.begin(start, start, arc.centerX(), arc.centerY(), arc.sweep());
+            int ticks = (int)ceilf(path.length() / feed * 60000.0f);
+            float nativeWorst = 0.0f;
+            for (int k = 0; k <= ticks; ++k) {
+                path.at((float)k / ticks, p);
+                float x = p[AXIS_X] - arc.centerX(), y = p[AXIS_Y] - arc.centerY();
+                float e = fabsf(sqrtf(x * x + y * y) - r);
+                if (e > nativeWorst) nativeWorst = e;
+            }
+            bool closed = p[AXIS_X] == start[AXIS_X] && p[AXIS_Y] == start[AXIS_Y];
+            char buf[160];
+            snprintf(buf, sizeof(buf), "r=%-5.1f %4d segs -> %.5f mm, native 1 move -> %.6f mm",
+                     r, arc.segments(), segWorst, nativeWorst);
+            check(closed && nativeWorst < 1e-4f && nativeWorst < segWorst, buf);
+        }
+    }
+
+    if (failures) {
+        printf("\n✗ %d arc check(s) failed\n", failures);
+        return 1;
+    }
+    printf("\n✓ All arc tests passed\n");
+    return 0;
+}
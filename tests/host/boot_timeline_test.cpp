@@ -0,0 +1,52 @@
+// Host test: boot timeline keeps the first mark of each stage.
+//
+// Build & run from the repo root:
+//   g++ -std=c++17 -Iinclude tests/host/boot_timeline_test.cpp -o /tmp/boot_timeline_test && /tmp/boot_timeline_test
+#include <stdio.h>
+#include "boot_timeline.h"
+
+static int failures = 0;
+
+static void check(bool ok, const char* what) {
+    printf("  %s %s\n", what, ok ? "✓" : "✗");
+    if (!ok) failures++;
+}
+
+int main() {
+    printf("Test: stage marks\n");
+    {
+        BootTimeline t;
+        t.mark(BOOT_SETUP, 310000);
+        t.mark(BOOT_SETTINGS, 312500);
+        t.mark(BOOT_TASKS, 340000);
+        // controlTask and thermalTask mark every iteration's first pass only
+        for (uint32_t us = 341000; us < 351000; us += 1000) t.mark(BOOT_MOTION_READY, us);
+        check(t.size() == 4 && t.at(BOOT_MOTION_READY) == 341000, "repeated marks keep the first timestamp");
+        check(t.has(BOOT_SETTINGS) && !t.has(BOOT_WIFI) && t.at(BOOT_WIFI) == 0, "unreached stages report 0");
+        // Stage names may come from different string literals
+        char name[32]; snprintf(name, sizeof(name), "%s", BOOT_SETUP);
+        check(!t.mark(name, 999999) && t.at(BOOT_SETUP) == 310000, "stages are matched by name, not pointer");
+        bool inOrder = true;
+        for (int i = 1; i < t.size(); ++i) if (t.us(i) < t.us(i - 1)) inOrder = false;
+        check(inOrder && strcmp(t.name(0), BOOT_SETUP) == 0, "stages are listed in the order they were reached");
+    }
+
+    printf("Test: capacity\n");
+    {
+        BootTimeline t;
+        static char names[BOOT_MAX_STAGES + 4][8];
+        int added = 0;
+        for (int i = 0; i < BOOT_MAX_STAGES + 4; ++i) {
+            snprintf(names[i], sizeof(names[i]), "s%d", i);
+            if (t.mark(names[i], i)) added++;
+        }
+        check(added == BOOT_MAX_STAGES && t.size() == BOOT_MAX_STAGES, "marks beyond BOOT_MAX_STAGES are dropped");
+    }
+
+    if (failures) {
+        printf("\n✗ %d boot timeline check(s) failed\n", failures);
+        return 1;
+    }
+    printf("\n✓ All boot timeline tests passed\n");
+    return 0;
+}
@@ -0,0 +1,113 @@
+// Host test: executor ownership (claims, leases, release on disconnect)
+// and the compare-and-swap under contention.
+//
+// Build & run from the repo root:
+//   g++ -std=c++17 -pthread -Iinclude tests/host/executor_owner_test.cpp -o /tmp/executor_owner_test && /tmp/executor_owner_test
+#include <stdio.h>
+#include <thread>
+#include "executor_owner.h"
+
+static int failures = 0;
+
+static void check(bool ok, const char* what) {
+    printf("  %s %s\n", what, ok ? "✓" : "✗");
+    if (!ok) failures++;
+}
+
+// Owner types as in web_server.h
+enum { SERIAL_SRC = 0, WS = 1, TELNET = 2, JOB = 3 };
+static const uint32_t LEASE = 5000;
+
+int main() {
+    printf("Test: claims and leases\n");
+    {
+        ExecutorOwnership o;
+        uint32_t t = 1000;
+        check(!o.view(t).busy && o.view(t).id == -1 && o.admits(WS, 4, t), "starts free");
+        check(o.claim(WS, 1, t, LEASE) && o.owns(WS, 1), "first client claims");
+        uint8_t gen = o.view(t).generation;
+        check(!o.claim(WS, 2, t + 100, LEASE) && !o.admits(WS, 2, t + 100) && !o.admits(SERIAL_SRC, 0, t + 100),
+              "others are refused while the lease runs");
+        check(o.claim(WS, 1, t + 4000, LEASE) && o.view(t + 4000).generation == gen, "the owner's next command renews, same session");
+        check(!o.claim(WS, 2, t + 8000, LEASE), "renewed lease still held past the first deadline");
+        ExecutorOwnerView v = o.view(t + 4000);
+        check(v.busy && v.type == WS && v.id == 1 && v.leaseMs >= LEASE && v.leaseMs < LEASE + EXECUTOR_LEASE_TICK_MS, "view reports the lease left");
+        check(o.claim(WS, 2, t + 4000 + LEASE + 2 * EXECUTOR_LEASE_TICK_MS, LEASE) && o.owns(WS, 2) && o.view(t + 10000).generation != gen,
+              "a lapsed lease can be taken over, new session");
+        check(!o.renew(WS, 1, t + 10000, LEASE) && !o.release(WS, 1) && o.owns(WS, 2), "the old owner can neither renew nor release");
+        check(!o.claim(WS, 99, t, LEASE) && !o.claim(WS, -1, t, LEASE), "ids outside the word are refused");
+    }
+
+    printf("Test: executing commands\n");
+    {
+        ExecutorOwnership o;
+        check(o.claim(WS, 3, 0, LEASE) && o.begin(WS, 3, 10), "owner's command starts");
+        check(o.view(60000).busy && o.view(60000).active && !o.claim(TELNET, 0, 60000, LEASE), "a long move cannot lose the lease");
+        o.end(WS, 3, 60000, LEASE);
+        check(!o.view(60000).active && !o.claim(TELNET, 0, 60000 + LEASE - 200, LEASE), "the lease runs from the end of the move");
+        check(!o.begin(SERIAL_SRC, 0, 61000), "other sources' commands are refused meanwhile");
+        check(o.begin(SERIAL_SRC, 0, 60000 + LEASE + 2 * EXECUTOR_LEASE_TICK_MS) && !o.owns(SERIAL_SRC, 0),
+              "after it lapses they run, without taking ownership");
+    }
+
+    printf("Test: release\n");
+    {
+        ExecutorOwnership o;
+        o.claim(WS, 0, 0, LEASE);
+        check(!o.release(WS, 5) && o.owns(WS, 0), "a different client's disconnect changes nothing");
+        check(o.release(WS, 0) && !o.view(1).busy && o.claim(TELNET, 0, 1, LEASE), "the owner's disconnect frees it at once");
+        check(o.claim(TELNET, 0, 2, 0) && o.view(1000000).pinned && !o.claim(WS, 1, 1000000, LEASE), "a pin outlives any lease");
+        check(o.renew(TELNET, 0, 3, LEASE) && o.view(1000000).pinned, "renewing keeps the pin");
+        check(o.claim(JOB, 0, 4, 0) == false, "a job cannot start while a client holds it");
+        o.reset();
+        check(!o.view(5).busy && o.claim(JOB, 0, 5, 0) && o.view(5).type == JOB, "reset frees it for anyone");
+        o.release(JOB, 0);
+        o.claim(WS, 2, 100, LEASE);
+        check(!o.expire(100 + LEASE - 200) && o.expire(100 + LEASE + 2 * EXECUTOR_LEASE_TICK_MS) && !o.view(0).busy,
+              "expire frees lapsed leases only");
+    }
+
+    printf("Test: deadlines across the millis() wrap\n");
+    {
+        ExecutorOwnership o;
+        uint32_t t = 0xFFFFFFFFu - 1000;
+        o.claim(WS, 1, t, LEASE);
+        check(!o.claim(WS, 2, t + 3000, LEASE), "held just after the wrap");
+        check(o.claim(WS, 2, t + LEASE + 2 * EXECUTOR_LEASE_TICK_MS, LEASE), "lapses on time after the wrap");
+    }
+
+    printf("Test: contention\n");
+    {
+        // Two clients on two threads race for the executor; the holder of
+        // the word must always be alone in its critical section.
+        static ExecutorOwnership o;
+        static std::atomic<int> inside(0);
+        static std::atomic<int> overlaps(0);
+        static std::atomic<int> wins[2];
+        static std::atomic<bool> go(false);
+        wins[0] = 0; wins[1] = 0;
+        auto client = [](int id) {
+            while (!go) {}
+            for (int i = 0; i < 200000; ++i) {
+                if (!o.claim(WS, id, 0, LEASE)) continue;
+                if (inside.fetch_add(1) != 0) overlaps++;
+                wins[id]++;
+                inside.fetch_sub(1);
+                o.release(WS, id);
+            }
+        };
+        std::thread a(client, 0), b(client, 1);
+        go = true;
+        a.join(); b.join();
+        printf("    claims won: %d / %d\n", wins[0].load(), wins[1].load());
+        check(overlaps == 0 && wins[0] + wins[1] > 0, "never two owners at once");
+        check(!o.view(0).busy, "all released");
+    }
+
+    if (failures) {
+        printf("\n✗ %d executor ownership check(s) failed\n", failures);
+        return 1;
+    }
+    printf("\n✓ All executor ownership tests passed\n");
+    return 0;
+}
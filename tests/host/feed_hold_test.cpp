@@ -0,0 +1,111 @@
+// Host test: feed hold decelerates along the S-curve path, freezes the
+// profile time while held and resumes without a position jump.
+//
+// Build & run from the repo root:
+//   g++ -std=c++17 -Iinclude tests/host/feed_hold_test.cpp -o /tmp/feed_hold_test && /tmp/feed_hold_test
+#include <stdio.h>
+#include <math.h>
+#include "scurve.h"
+#include "feed_hold.h"
+
+static int failures = 0;
+
+static void check(bool ok, const char* what) {
+    printf("  %s %s\n", what, ok ? "✓" : "✗");
+    if (!ok) failures++;
+}
+
+static const float DT = 0.001f; // one control tick
+static const float DIST = 100.0f, VMAX = 50.0f, ACCEL = 500.0f, JERK = 5000.0f;
+
+// Run a move with the operator pressing hold at `holdAt` and resume at
+// `resumeAt` (s, real time); tracks what the control loop would command
+struct Run {
+    float maxStep = 0;      // largest position change in one tick (mm)
+    float maxAccel = 0;     // largest |dv/dt| while stopping / restarting (mm/s^2)
+    float stopPos = -1;     // where the path stopped
+    float heldDrift = 0;    // movement while held
+    float endPos = 0;
+    float endTime = 0;
+    bool heldSeen = false;
+
+    Run(float holdAt, float resumeAt) {
+        SCurveProfile p;
+        p.plan(DIST, VMAX, ACCEL, JERK);
+        FeedHold fh;
+        fh.startMove();
+        float s = 0, v = 0, prevS = 0, prevV = 0;
+        for (int tick = 1; tick < 20000; ++tick) {
+            float now = tick * DT;
+            bool pause = now >= holdAt && now < resumeAt;
+            if (pause != fh.holding()) {
+                p.evaluate(fh.profileTime(), s, v);
+                fh.request(pause, v, ACCEL);
+            }
+            float t = fh.advance(DT);
+            p.evaluate(t, s, v);
+            float step = s - prevS;
+            float pathV = step / DT;
+            if (fabsf(step) > maxStep) maxStep = fabsf(step);
+            bool ramping = fh.rate() > 0.0f && fh.rate() < 1.0f;
+            if (ramping && tick > 2) {
+                float a = fabsf(pathV - prevV) / DT;
+                if (a > maxAccel) maxAccel = a;
+            }
+            if (fh.held()) {
+                if (!heldSeen) { heldSeen = true; stopPos = s; }
+                heldDrift = fmaxf(heldDrift, fabsf(s - stopPos));
+            }
+            prevS = s;
+            prevV = pathV;
+            if (t >= p.duration()) { endPos = s; endTime = now; break; }
+        }
+    }
+};
+
+int main() {
+    SCurveProfile plain;
+    float plainT = plain.plan(DIST, VMAX, ACCEL, JERK);
+
+    printf("Test: hold while cruising\n");
+    {
+        Run r(1.0f, 3.0f);
+        printf("    stopped at %.3f mm, max decel %.0f mm/s^2, max step %.4f mm\n", r.stopPos, r.maxAccel, r.maxStep);
+        check(r.heldSeen && r.heldDrift == 0.0f, "the path stops and stays put while held");
+        check(r.maxAccel <= ACCEL * 1.02f, "deceleration and re-acceleration stay within the limit");
+        check(r.maxStep <= VMAX * DT * 1.001f, "no position jump on hold or resume");
+        check(fabsf(r.endPos - DIST) < 1e-3f, "the move still ends exactly at its target");
+        // Cruise distance covered by 1 s in, then the ramp: 1.5 v / a long at mean rate 1/2
+        float expected = 0.0f, v = 0.0f;
+        plain.evaluate(1.0f, expected, v);
+        expected += 0.5f * v * (1.5f * v / ACCEL);
+        check(fabsf(r.stopPos - expected) < 0.1f, "stops a controlled ramp's length after the hold");
+        check(r.endTime > plainT + 2.0f - 0.05f, "the hold time is added, the profile time was frozen");
+    }
+
+    printf("Test: hold while accelerating, resume before stopped\n");
+    {
+        Run r(0.1f, 0.13f);
+        check(!r.heldSeen && r.maxStep <= VMAX * DT * 1.001f && fabsf(r.endPos - DIST) < 1e-3f,
+              "turning around mid-ramp is smooth and the move completes");
+    }
+
+    printf("Test: hold before the move starts\n");
+    {
+        FeedHold fh;
+        fh.request(true, 0.0f, ACCEL);
+        check(fh.held() && fh.holding(), "no speed to lose: held at once");
+        fh.startMove();
+        fh.advance(1.0f);
+        check(fh.profileTime() == 0.0f, "a new move does not start while held");
+        fh.request(false, 0.0f, ACCEL);
+        check(fh.fullSpeed() && fh.advance(0.5f) == 0.5f, "resume at rest is immediate");
+    }
+
+    if (failures) {
+        printf("\n✗ %d feed hold check(s) failed\n", failures);
+        return 1;
+    }
+    printf("\n✓ All feed hold tests passed\n");
+    return 0;
+}
@@ -0,0 +1,135 @@
+// Host test: fixed-memory sorted directory pages and JSON entry encoding
+// used by the streamed /api/files listing.
+//
+// Build & run from the repo root:
+//   g++ -std=c++17 -Iinclude tests/host/file_list_test.cpp -o /tmp/file_list_test && /tmp/file_list_test
+#include <stdio.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include "file_list.h"
+
+static int failures = 0;
+
+static void check(bool ok, const char* what) {
+    printf("  %s %s\n", what, ok ? "✓" : "✗");
+    if (!ok) failures++;
+}
+
+struct Dirent { std::string name; uint32_t size, mtime; };
+
+static void pass(const std::vector<Dirent>& dir, FileListPage& page) {
+    for (const Dirent& d : dir) page.offer(d.name.c_str(), d.size, d.mtime);
+}
+
+// Same walk as WebServerManager::streamFileList: skip `offset` a page at a
+// time, then fill the requested page. Returns the names and the number of
+// directory passes made.
+static std::vector<std::string> listPage(const std::vector<Dirent>& dir, FileSortKey key, bool desc, long offset, int limit, int* passes) {
+    static FileListPage page;
+    FileListEntry cursor;
+    bool haveCursor = false, exhausted = false;
+    long skip = offset;
+    *passes = 0;
+    while (skip > 0 && !exhausted) {
+        int take = skip > FILE_LIST_PAGE_MAX ? FILE_LIST_PAGE_MAX : (int)skip;
+        page.begin(key, desc, take, haveCursor ? &cursor : nullptr);
+        pass(dir, page); (*passes)++;
+        if (page.count() < take) exhausted = true;
+        if (page.count()) { cursor = page.at(page.count() - 1); haveCursor = true; }
+        skip -= take;
+    }
+    page.begin(key, desc, exhausted ? 0 : limit, haveCursor ? &cursor : nullptr);
+    pass(dir, page); (*passes)++;
+    std::vector<std::string> out;
+    for (int i = 0; i < page.count(); ++i) out.push_back(page.at(i).name);
+    return out;
+}
+
+int main() {
+    // 500 jobs in scrambled directory order, with repeated sizes and times
+    std::vector<Dirent> dir;
+    for (int i = 0; i < 500; ++i) {
+        int j = (i * 317) % 500;
+        char name[32]; snprintf(name, sizeof(name), "job_%03d.gcode", j);
+        dir.push_back({ name, (uint32_t)(1000 + (j % 37) * 100), (uint32_t)(1700000000 + (j % 11) * 60) });
+    }
+
+    printf("Test: sorted pages cover the directory exactly once\n");
+    {
+        const FileSortKey keys[] = { FILE_SORT_NAME, FILE_SORT_SIZE, FILE_SORT_MTIME };
+        bool allOk = true;
+        for (FileSortKey key : keys) {
+            for (int desc = 0; desc < 2; ++desc) {
+                std::vector<Dirent> want = dir;
+                std::sort(want.begin(), want.end(), [&](const Dirent& a, const Dirent& b) {
+                    int c;
+                    if (key == FILE_SORT_SIZE && a.size != b.size) c = a.size < b.size ? -1 : 1;
+                    else if (key == FILE_SORT_MTIME && a.mtime != b.mtime) c = a.mtime < b.mtime ? -1 : 1;
+                    else c = a.name.compare(b.name);
+                    return desc ? c > 0 : c < 0;
+                });
+                std::vector<std::string> got;
+                int passes;
+                for (long off = 0; off < 500; off += 30) {
+                    std::vector<std::string> p = listPage(dir, key, desc, off, 30, &passes);
+                    got.insert(got.end(), p.begin(), p.end());
+                }
+                for (size_t i = 0; i < want.size(); ++i) if (i >= got.size() || got[i] != want[i].name) allOk = false;
+                if (got.size() != want.size()) allOk = false;
+            }
+        }
+        check(allOk, "name/size/mtime, asc/desc: pages of 30 concatenate to the full sorted listing");
+    }
+
+    printf("Test: page boundaries\n");
+    {
+        int passes;
+        std::vector<std::string> p = listPage(dir, FILE_SORT_NAME, false, 0, 5, &passes);
+        check(p.size() == 5 && p[0] == "job_000.gcode" && p[4] == "job_004.gcode" && passes == 1, "first page needs one pass");
+        p = listPage(dir, FILE_SORT_NAME, false, 495, 50, &passes);
+        check(p.size() == 5 && p[4] == "job_499.gcode", "last page is short");
+        check(passes == 11, "offset 495 takes ten skip passes plus one");
+        p = listPage(dir, FILE_SORT_NAME, false, 600, 50, &passes);
+        check(p.empty(), "offset past the end is empty");
+        p = listPage(dir, FILE_SORT_NAME, true, 0, 1, &passes);
+        check(p.size() == 1 && p[0] == "job_499.gcode", "descending starts from the end");
+
+        FileListPage page;
+        page.begin(FILE_SORT_NAME, false, 10, nullptr);
+        pass(dir, page);
+        check(page.total() == 500, "total counts every entry, not just the page");
+    }
+
+    printf("Test: long names\n");
+    {
+        FileListPage page;
+        page.begin(FILE_SORT_NAME, false, 10, nullptr);
+        std::string longName(FILE_NAME_MAX, 'a');
+        page.offer(longName.c_str(), 1, 0);
+        page.offer("b.gcode", 1, 0);
+        check(page.count() == 1 && page.skippedLongNames() == 1 && page.total() == 2, "too-long name is counted, not truncated");
+    }
+
+    printf("Test: JSON entries\n");
+    {
+        char out[160];
+        size_t n = fileListJsonEntry(out, sizeof(out), "part \"A\"\\1.gcode", 1234, 1700000000, "sd");
+        check(n == strlen(out) && std::string(out) ==
+              "{\"name\":\"part \\\"A\\\"\\\\1.gcode\",\"size\":1234,\"mtime\":1700000000,\"storage\":\"sd\"}",
+              "quotes and backslashes are escaped");
+        n = fileListJsonEntry(out, sizeof(out), "tab\there", 0, 0, "littlefs");
+        check(n && std::string(out).find("tab\\u0009here") != std::string::npos, "control characters use \\u escapes");
+        check(fileListJsonEntry(out, 20, "a-rather-long-file-name.gcode", 1, 1, "sd") == 0, "a name that doesn't fit fails rather than truncating");
+        check(fileSortKeyFromString("") == FILE_SORT_NAME && fileSortKeyFromString("size") == FILE_SORT_SIZE &&
+              fileSortKeyFromString("date") == FILE_SORT_MTIME && fileSortKeyFromString("none") == FILE_SORT_NONE,
+              "sort argument parsing");
+    }
+
+    if (failures) {
+        printf("\n✗ %d file list check(s) failed\n", failures);
+        return 1;
+    }
+    printf("\n✓ All file list tests passed\n");
+    return 0;
+}
@@ -0,0 +1,202 @@
+// Host test: G-code metadata scan (bounds, time, filament, layers,
+// thumbnail), the sidecar index table and thumbnail base64 decoding.
+//
+// Build & run from the repo root:
+//   g++ -std=c++17 -Iinclude tests/host/gcode_index_test.cpp -o /tmp/gcode_index_test && /tmp/gcode_index_test
+#include <stdio.h>
+#include <math.h>
+#include <string>
+#include <vector>
+#include "gcode_index.h"
+
+static int failures = 0;
+
+static void check(bool ok, const char* what) {
+    printf("  %s %s\n", what, ok ? "✓" : "✗");
+    if (!ok) failures++;
+}
+
+static bool near(float a, float b, float tol) { return fabsf(a - b) <= tol; }
+
+static GcodeMeta scan(const std::string& g, size_t step) {
+    GcodeIndexer ix;
+    for (size_t i = 0; i < g.size(); i += step) ix.feed(g.data() + i, g.size() - i < step ? g.size() - i : step);
+    return ix.finish();
+}
+
+// Records kept in memory instead of a file
+struct MemStore {
+    std::vector<uint8_t> data;
+    int reads = 0;
+    explicit MemStore(uint32_t slots) : data(slots * GCODE_INDEX_RECORD, 0) {}
+    bool read(uint32_t slot, uint8_t* rec) { reads++; memcpy(rec, &data[slot * GCODE_INDEX_RECORD], GCODE_INDEX_RECORD); return true; }
+    bool write(uint32_t slot, const uint8_t* rec) { memcpy(&data[slot * GCODE_INDEX_RECORD], rec, GCODE_INDEX_RECORD); return true; }
+};
+
+int main() {
+    // "PNG" payload 0..99, base64 encoded in slicer comment lines
+    std::vector<uint8_t> png;
+    for (int i = 0; i < 100; ++i) png.push_back((uint8_t)(i * 7));
+    static const char* b64 = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::string enc;
+    for (size_t i = 0; i < png.size(); i += 3) {
+        uint32_t v = png[i] << 16 | (i + 1 < png.size() ? png[i + 1] << 8 : 0) | (i + 2 < png.size() ? png[i + 2] : 0);
+        enc += b64[v >> 18 & 63]; enc += b64[v >> 12 & 63];
+        enc += i + 1 < png.size() ? b64[v >> 6 & 63] : '=';
+        enc += i + 2 < png.size() ? b64[v & 63] : '=';
+    }
+    std::string thumb = "; thumbnail begin 16x16 " + std::to_string(enc.size()) + "\n";
+    for (size_t i = 0; i < enc.size(); i += 78) thumb += "; " + enc.substr(i, 78) + "\n";
+    thumb += "; thumbnail end\n";
+
+    // Small two-layer print, Cura flavour (absolute E, layer comments)
+    std::string print =
+        "; generated by a slicer\n"
+        "; thumbnail begin 8x8 4\n; AAAA\n; thumbnail end\n" + thumb +
+        "M82\r\nG28\r\n"
+        "G1 Z0.2 F600\n"
+        "G92 E0\n"
+        ";LAYER:0\n"
+        "G1 X10 Y10 F3000\n"          // travel
+        "G1 X50 Y10 E2.0 F1200\n"     // 40 mm at 1200 mm/min = 2 s
+        "G1 X50 Y30 E3.0\n"           // 20 mm = 1 s
+        "G1 E2.0 F2400\n"             // retract 1 mm
+        ";LAYER:1\n"
+        "G1 Z0.4 F600\n"
+        "G1 E3.0 F2400\n"             // unretract
+        "G1 X10 Y30 E5.0 F1200 ; perimeter\n"
+        "G4 P500\n"
+        "G91\nG1 Z10 F600\nG90\n"     // lift, relative
+        "G1 X0 Y200 F6000";           // park, no newline at the end
+
+    printf("Test: print file\n");
+    {
+        GcodeMeta m = scan(print, 4096);
+        // header comment, 3 + 4 thumbnail lines, 18 G-code lines
+        check(m.lines == 1 + 3 + (2 + (uint32_t)(enc.size() + 77) / 78) + 18, "every line is counted, including the unterminated last one");
+        check(near(m.min[0], 10, 1e-4f) && near(m.max[0], 50, 1e-4f) && near(m.min[1], 10, 1e-4f) && near(m.max[1], 30, 1e-4f),
+              "X/Y bounds cover extruding moves only (not travel or park)");
+        check(near(m.min[2], 0.2f, 1e-4f) && near(m.max[2], 0.4f, 1e-4f), "Z bounds are the printed layers");
+        check(near(m.travelMin[0], 0, 1e-4f) && near(m.travelMin[1], 0, 1e-4f) && near(m.travelMin[2], 0, 1e-4f) &&
+              near(m.travelMax[0], 50, 1e-4f) && near(m.travelMax[1], 200, 1e-4f) && near(m.travelMax[2], 10.4f, 1e-4f),
+              "the travel box covers every move, from home to the park position");
+        check(m.layers == 2, "layer comments are counted");
+        check(near(m.filamentMm, 5.0f, 1e-4f), "net filament follows absolute E with G92 and retracts");
+        // z 0.2/600 + travel sqrt(200)/3000 + 2 + 1 + retract 1/2400 + z 0.2/600 + 1/2400 + 40/1200
+        // + dwell 0.5 + lift 10/600 + park
+        float park = sqrtf(10 * 10 + 170 * 170) / 6000.0f * 60.0f;
+        float want = 0.02f + sqrtf(200.0f) / 50.0f + 2 + 1 + 0.025f + 0.02f + 0.025f + 2 + 0.5f + 1 + park;
+        check(near(m.timeSec, want, 0.01f), "time is distance / feed plus dwells");
+        check(m.moves == 8, "moves with XYZ motion are counted");
+        check(m.thumbW == 16 && m.thumbH == 16, "the largest thumbnail is kept");
+
+        size_t at = print.find(thumb) + thumb.find('\n') + 1;
+        size_t len = thumb.rfind("; thumbnail end") - (thumb.find('\n') + 1);
+        check(m.thumbOffset == at && m.thumbLength == len, "thumbnail offset/length span its base64 lines");
+
+        Base64Decoder dec;
+        std::vector<uint8_t> out(len);
+        size_t n = 0;
+        for (size_t i = 0; i < len; i += 10) n += dec.feed(print.data() + at + i, len - i < 10 ? len - i : 10, out.data() + n);
+        out.resize(n);
+        check(out == png, "base64 block decodes to the original bytes, chunk by chunk");
+
+        GcodeMeta one = scan(print, 1);
+        check(memcmp(&one, &m, sizeof(m)) == 0, "feeding one byte at a time gives the same result");
+    }
+
+    printf("Test: laser / CNC file (no extrusion, inches, relative E)\n");
+    {
+        GcodeMeta m = scan("G20\nG0 X1 Y1\nG1 X2 Y1 F10\nG1 X2 Y2\nG0 X0 Y0\nM83\nG1 E1\nG1 E1\n", 7);
+        check(near(m.min[0], 25.4f, 1e-3f) && near(m.max[0], 50.8f, 1e-3f) && near(m.max[1], 50.8f, 1e-3f),
+              "without extrusion the bounds are the G1-G3 moves, converted from inches");
+        check(m.layers == 0, "no layers without extrusion or layer comments");
+        check(near(m.filamentMm, 50.8f, 1e-3f), "relative E (M83) accumulates");
+    }
+
+    printf("Test: arcs in the travel box\n");
+    {
+        // Quarter circles around (10, 0): I/J from (0, 0) through the bottom left, R from (10, 10) to the right
+        GcodeMeta q = scan("G0 X0 Y0\nG3 X10 Y-10 I10 J0 F600\n", 16);
+        check(near(q.travelMin[0], 0, 1e-3f) && near(q.travelMax[0], 10, 1e-3f) && near(q.travelMin[1], -10, 1e-3f) && near(q.travelMax[1], 0, 1e-3f),
+              "a quarter arc's box is its end points");
+        GcodeMeta m = scan("G0 X0 Y0\nG2 X10 Y-10 I10 J0 F600\nG0 X10 Y10\nG2 X20 Y0 R10\n", 16);
+        check(near(m.travelMax[0], 20, 1e-3f) && near(m.travelMax[1], 10, 1e-3f) && near(m.travelMin[1], -10, 1e-3f),
+              "the long way round (G2 over the top) reaches the far side");
+        GcodeMeta h = scan("G0 X0 Y0\nG3 X0 Y0 I10 J0 Z5 F600\n", 16);
+        check(near(h.travelMax[0], 20, 1e-3f) && near(h.travelMin[1], -10, 1e-3f) && near(h.travelMax[1], 10, 1e-3f) && near(h.travelMax[2], 5, 1e-3f),
+              "a full helical circle takes its whole diameter, not its chord");
+    }
+
+    printf("Test: Z-step layer count\n");
+    {
+        std::string g = "G92 E0\nM83\n";
+        for (int l = 1; l <= 5; ++l) g += "G1 Z" + std::to_string(l * 0.2) + "\nG1 X10 E1\nG1 X0 E1\n";
+        GcodeMeta m = scan(g, 64);
+        check(m.layers == 5, "without comments, layers are Z increases while extruding");
+    }
+
+    printf("Test: records and header\n");
+    {
+        GcodeMeta m = scan(print, 512);
+        m.size = 123456; m.mtime = 1700000000;
+        uint8_t rec[GCODE_INDEX_RECORD];
+        gcodeIndexEncode(rec, "benchy.gcode", m);
+        GcodeMeta back;
+        gcodeIndexDecode(rec, back);
+        check(memcmp(&back, &m, sizeof(m)) == 0 && strcmp((char*)rec, "benchy.gcode") == 0, "record round trip");
+
+        uint8_t h[GCODE_INDEX_HEADER];
+        gcodeIndexHeader(h, 128);
+        check(gcodeIndexHeaderSlots(h) == 128, "header carries the slot count");
+        h[4]++;
+        check(gcodeIndexHeaderSlots(h) == 0, "other format versions are not used");
+
+        char json[448];
+        size_t n = gcodeMetaJson(json, sizeof(json), m);
+        std::string j(json, n);
+        check(n && j.find("\"layers\":2") != std::string::npos && j.find("\"thumbnail\":{\"width\":16,\"height\":16}") != std::string::npos &&
+              j.find("\"travel\":{\"min\":[0.000,0.000,0.000],\"max\":[50.000,200.000,10.400]}") != std::string::npos,
+              "metadata JSON");
+        check(gcodeMetaJson(json, 40, m) == 0, "JSON refuses a short buffer");
+    }
+
+    printf("Test: index table\n");
+    {
+        MemStore store(8);
+        GcodeIndexTable<MemStore> t(store, 8);
+        GcodeMeta m = {};
+        char name[16];
+        bool ok = true;
+        for (int i = 0; i < 8; ++i) { snprintf(name, sizeof(name), "job%d.gcode", i); m.size = i; ok = ok && t.put(name, m); }
+        check(ok, "table fills every slot");
+        check(!t.put("one-more.gcode", m), "a full table refuses new names");
+        m.size = 99;
+        check(t.put("job3.gcode", m), "an existing name is updated in place even when full");
+        GcodeMeta got;
+        check(t.get("job3.gcode", got) && got.size == 99 && t.get("job7.gcode", got) && got.size == 7, "lookups after collisions");
+        check(t.remove("job5.gcode") && !t.get("job5.gcode", got), "remove");
+        check(t.get("job6.gcode", got) && got.size == 6, "entries probing past a removed one are still found");
+        check(t.put("new.gcode", m) && t.get("new.gcode", got), "the removed slot is reused");
+        check(!t.get("missing.gcode", got), "missing name");
+
+        std::string longName(GCODE_INDEX_NAME_MAX, 'n');
+        check(!t.put(longName.c_str(), m), "over-long name is not indexed");
+
+        // Lookups stay cheap in a sparsely filled big table
+        MemStore big(GCODE_INDEX_SLOTS_SD);
+        GcodeIndexTable<MemStore> bt(big, GCODE_INDEX_SLOTS_SD);
+        for (int i = 0; i < 500; ++i) { snprintf(name, sizeof(name), "j%03d.gcode", i); bt.put(name, m); }
+        big.reads = 0;
+        for (int i = 0; i < 500; ++i) { snprintf(name, sizeof(name), "j%03d.gcode", i); bt.get(name, got); }
+        printf("    500 lookups in %d slots: %.2f record reads each\n", GCODE_INDEX_SLOTS_SD, big.reads / 500.0);
+        check(big.reads < 500 * 3, "under three record reads per lookup at half load");
+    }
+
+    if (failures) {
+        printf("\n✗ %d G-code index check(s) failed\n", failures);
+        return 1;
+    }
+    printf("\n✓ All G-code index tests passed\n");
+    return 0;
+}
@@ -0,0 +1,55 @@
+// Host test: Range header parsing for resumable downloads.
+//
+// Build & run from the repo root:
+//   g++ -std=c++17 -Iinclude tests/host/http_range_test.cpp -o /tmp/http_range_test && /tmp/http_range_test
+#include <stdio.h>
+#include "http_range.h"
+
+static int failures = 0;
+
+static void check(bool ok, const char* what) {
+    printf("  %s %s\n", what, ok ? "✓" : "✗");
+    if (!ok) failures++;
+}
+
+static bool range(const char* h, uint32_t size, HttpRangeResult want, uint32_t wantFirst = 0, uint32_t wantLast = 0) {
+    uint32_t first = 12345, last = 12345;
+    HttpRangeResult r = httpParseRange(h, size, first, last);
+    if (r != want) return false;
+    return r != HTTP_RANGE_OK || (first == wantFirst && last == wantLast);
+}
+
+int main() {
+    printf("Test: satisfiable ranges\n");
+    check(range("bytes=0-99", 1000, HTTP_RANGE_OK, 0, 99), "first 100 bytes");
+    check(range("bytes=500-", 1000, HTTP_RANGE_OK, 500, 999), "open-ended resume");
+    check(range("bytes=-200", 1000, HTTP_RANGE_OK, 800, 999), "suffix");
+    check(range("bytes=900-5000", 1000, HTTP_RANGE_OK, 900, 999), "end past the file is clamped");
+    check(range("bytes=-5000", 1000, HTTP_RANGE_OK, 0, 999), "suffix longer than the file is the whole file");
+    check(range("bytes=999-999", 1000, HTTP_RANGE_OK, 999, 999), "last byte");
+    check(range(" bytes= 10 - 20 ", 1000, HTTP_RANGE_OK, 10, 20), "whitespace tolerated");
+    check(range("bytes=4000000000-", 4294967295u, HTTP_RANGE_OK, 4000000000u, 4294967294u), "offsets near 4 GB");
+
+    printf("Test: unsatisfiable ranges (416)\n");
+    check(range("bytes=1000-", 1000, HTTP_RANGE_UNSATISFIABLE), "starts at the end");
+    check(range("bytes=99999999999-", 1000, HTTP_RANGE_UNSATISFIABLE), "huge start");
+    check(range("bytes=-0", 1000, HTTP_RANGE_UNSATISFIABLE), "empty suffix");
+    check(range("bytes=0-", 0, HTTP_RANGE_UNSATISFIABLE), "any range of an empty file");
+
+    printf("Test: ignored headers (whole file, 200)\n");
+    check(range(nullptr, 1000, HTTP_RANGE_NONE), "no header");
+    check(range("", 1000, HTTP_RANGE_NONE), "empty header");
+    check(range("items=0-5", 1000, HTTP_RANGE_NONE), "other unit");
+    check(range("bytes=0-5,10-20", 1000, HTTP_RANGE_NONE), "multiple ranges");
+    check(range("bytes=20-10", 1000, HTTP_RANGE_NONE), "reversed range");
+    check(range("bytes=-", 1000, HTTP_RANGE_NONE), "no numbers");
+    check(range("bytes=5", 1000, HTTP_RANGE_NONE), "no dash");
+    check(range("bytes=5-x", 1000, HTTP_RANGE_NONE), "trailing junk");
+
+    if (failures) {
+        printf("\n✗ %d range check(s) failed\n", failures);
+        return 1;
+    }
+    printf("\n✓ All range tests passed\n");
+    return 0;
+}
@@ -0,0 +1,104 @@
+// Host test: job queue ordering (add, move, cancel, pop) and the
+// persisted queue blob.
+//
+// Build & run from the repo root:
+//   g++ -std=c++17 -Iinclude tests/host/job_queue_test.cpp -o /tmp/job_queue_test && /tmp/job_queue_test
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include "job_queue.h"
+
+static int failures = 0;
+
+static void check(bool ok, const char* what) {
+    printf("  %s %s\n", what, ok ? "✓" : "✗");
+    if (!ok) failures++;
+}
+
+static std::string order(const JobQueue& q) {
+    std::string s;
+    for (int i = 0; i < q.size(); ++i) s += std::string(i ? "," : "") + q.at(i).name;
+    return s;
+}
+
+int main() {
+    static JobQueue q;
+
+    printf("Test: ordering\n");
+    {
+        uint32_t a = q.add("a.gcode", 0, "", "");
+        uint32_t b = q.add("b.gcode", 0, "", "");
+        uint32_t c = q.add("c.gcode", 1, "M104 S200", "M104 S0\nG28 X");
+        check(a && b && c && a != b && b != c && order(q) == "a.gcode,b.gcode,c.gcode", "jobs queue in order with distinct ids");
+        uint32_t d = q.add("d.gcode", 0, "", "", 0);
+        check(order(q) == "d.gcode,a.gcode,b.gcode,c.gcode", "insert at the front");
+        check(q.move(d, 3) && order(q) == "a.gcode,b.gcode,c.gcode,d.gcode", "move to the back");
+        check(q.move(c, 0) && order(q) == "c.gcode,a.gcode,b.gcode,d.gcode", "move to the front");
+        check(q.move(b, 99) && order(q) == "c.gcode,a.gcode,d.gcode,b.gcode", "positions past the end are clamped");
+        check(q.remove(a) && order(q) == "c.gcode,d.gcode,b.gcode", "cancel");
+        check(!q.remove(a) && !q.move(a, 0), "cancelled id is gone");
+
+        QueuedJob j;
+        check(q.pop(j) && j.id == c && j.storage == 1 && std::string(j.endGcode) == "M104 S0\nG28 X", "pop takes the front job with its hooks");
+        check(order(q) == "d.gcode,b.gcode", "and leaves the rest");
+        uint32_t e = q.add("e.gcode", 0, "", "");
+        check(e > d && e != c, "ids are not reused");
+    }
+
+    printf("Test: limits\n");
+    {
+        JobQueue l;
+        check(!l.add("", 0, "", ""), "empty name refused");
+        check(!l.add(std::string(JOB_NAME_MAX, 'n').c_str(), 0, "", ""), "over-long name refused");
+        check(!l.add("x.gcode", 0, std::string(JOB_HOOK_MAX, 'G').c_str(), ""), "over-long hook refused");
+        char name[16];
+        int added = 0;
+        for (int i = 0; i < JOB_QUEUE_MAX + 3; ++i) { snprintf(name, sizeof(name), "j%d.gcode", i); if (l.add(name, 0, "", "")) added++; }
+        check(added == JOB_QUEUE_MAX && l.full(), "queue holds JOB_QUEUE_MAX jobs");
+        QueuedJob j;
+        while (l.pop(j)) {}
+        check(l.size() == 0 && !l.pop(j), "drains to empty");
+    }
+
+    printf("Test: persistence\n");
+    {
+        q.barrier = JOB_BARRIER_COOLDOWN;
+        q.cooldownSec = 900;
+        static uint8_t blob[JOB_QUEUE_BLOB_MAX];
+        size_t n = q.encode(blob, sizeof(blob));
+        static JobQueue back;
+        check(n > JOB_QUEUE_BLOB_HEADER && back.decode(blob, n), "round trip");
+        check(order(back) == order(q) && back.barrier == JOB_BARRIER_COOLDOWN && back.cooldownSec == 900, "order and barrier survive");
+        check(back.add("f.gcode", 0, "", "") == q.add("f.gcode", 0, "", ""), "id counter survives");
+
+        // A full queue with maximal hooks fits the blob buffer
+        JobQueue big;
+        std::string hook(JOB_HOOK_MAX - 1, 'G'), longName(JOB_NAME_MAX - 1, 'n');
+        while (!big.full()) big.add(longName.c_str(), 0, hook.c_str(), hook.c_str());
+        check(big.encode(blob, sizeof(blob)) > 0, "worst case fits JOB_QUEUE_BLOB_MAX");
+
+        n = q.encode(blob, sizeof(blob));
+        blob[n - 1] ^= 1;
+        int before = back.size();
+        check(!back.decode(blob, n) && back.size() == before, "corrupt blob is refused, queue unchanged");
+        blob[n - 1] ^= 1;
+        check(!back.decode(blob, n - 1), "truncated blob refused");
+        check(q.encode(blob, 10) == 0, "encode refuses a short buffer");
+    }
+
+    printf("Test: barrier names\n");
+    {
+        JobBarrier b;
+        check(jobBarrierFromString("operator", b) && b == JOB_BARRIER_OPERATOR && jobBarrierFromString("none", b) && b == JOB_BARRIER_NONE,
+              "parse");
+        check(!jobBarrierFromString("later", b), "unknown barrier refused");
+        check(strcmp(jobBarrierName(JOB_BARRIER_COOLDOWN), "cooldown") == 0, "name");
+    }
+
+    if (failures) {
+        printf("\n✗ %d job queue check(s) failed\n", failures);
+        return 1;
+    }
+    printf("\n✓ All job queue tests passed\n");
+    return 0;
+}
@@ -0,0 +1,63 @@
+// Host test: forward/inverse kinematics round trip for every policy.
+//
+// Build & run from the repo root:
+//   g++ -std=c++17 -Iinclude tests/host/kinematics_test.cpp -o /tmp/kinematics_test && /tmp/kinematics_test
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "kinematics.h"
+
+static int failures = 0;
+
+template <class K>
+static void roundTrip(const char* name, float range, float zMin, float zMax) {
+    float worst = 0.0f;
+    int points = 0;
+    for (float x = -range; x <= range; x += range / 8.0f) {
+        for (float y = -range; y <= range; y += range / 8.0f) {
+            for (float z = zMin; z <= zMax; z += (zMax - zMin) / 4.0f) {
+                float cart[NUM_AXES] = { x, y, z, 12.5f };
+                float motor[NUM_AXES];
+                float back[NUM_AXES];
+                if (!K::inverse(cart, motor)) continue;
+                if (!K::forward(motor, back)) { failures++; continue; }
+                for (int i = 0; i < NUM_AXES; ++i) {
+                    float err = fabsf(back[i] - cart[i]);
+                    if (err > worst) worst = err;
+                }
+                points++;
+            }
+        }
+    }
+    bool ok = points > 0 && worst < 1e-3f;
+    printf("  %-10s %4d points, worst error %.6f mm %s\n", name, points, worst, ok ? "✓" : "✗");
+    if (!ok) failures++;
+}
+
+int main() {
+    printf("Test: kinematics round trip (inverse -> forward)\n");
+    roundTrip<CartesianKinematics<NUM_AXES> >("cartesian", 200.0f, 0.0f, 100.0f);
+    roundTrip<CoreXYKinematics<NUM_AXES> >("corexy", 200.0f, 0.0f, 100.0f);
+    roundTrip<DeltaKinematics<NUM_AXES> >("delta", 80.0f, 0.0f, 100.0f);
+
+    printf("Test: CoreXY belt mixing\n");
+    float cart[NUM_AXES] = { 10.0f, 0.0f, 0.0f, 0.0f };
+    float motor[NUM_AXES];
+    CoreXYKinematics<NUM_AXES>::inverse(cart, motor);
+    bool mix = motor[AXIS_X] == 10.0f && motor[AXIS_Y] == 10.0f;
+    printf("  X10 drives A=%.1f B=%.1f %s\n", motor[AXIS_X], motor[AXIS_Y], mix ? "✓" : "✗");
+    if (!mix) failures++;
+
+    printf("Test: delta rejects unreachable targets\n");
+    float far[NUM_AXES] = { 500.0f, 0.0f, 0.0f, 0.0f };
+    bool rejected = !DeltaKinematics<NUM_AXES>::inverse(far, motor);
+    printf("  X500 rejected %s\n", rejected ? "✓" : "✗");
+    if (!rejected) failures++;
+
+    if (failures) {
+        printf("\n✗ %d kinematics check(s) failed\n", failures);
+        return 1;
+    }
+    printf("\n✓ All kinematics tests passed\n");
+    return 0;
+}
@@ -0,0 +1,87 @@
+// Host test: G-code stream line reassembly.
+//
+// Build & run from the repo root:
+//   g++ -std=c++17 -Iinclude tests/host/line_assembler_test.cpp -o /tmp/line_assembler_test && /tmp/line_assembler_test
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include "line_assembler.h"
+
+static int failures = 0;
+
+static void check(bool ok, const char* what) {
+    printf("  %s %s\n", what, ok ? "✓" : "✗");
+    if (!ok) failures++;
+}
+
+// Feed `data` in pieces of `step` bytes, collecting every completed line
+static std::vector<std::string> assemble(LineAssembler& a, const char* data, size_t n, size_t step, int* dropped = nullptr) {
+    std::vector<std::string> out;
+    size_t pos = 0;
+    while (pos < n) {
+        size_t chunk = n - pos < step ? n - pos : step;
+        size_t used = 0;
+        while (used < chunk) {
+            used += a.feed(data + pos + used, chunk - used);
+            if (a.takeDropped() && dropped) (*dropped)++;
+            if (a.ready()) { out.push_back(a.line()); a.next(); }
+        }
+        pos += chunk;
+    }
+    return out;
+}
+
+int main() {
+    printf("Test: lines split across receives\n");
+    {
+        LineAssembler a;
+        const char s[] = "G1 X10 F3000\nG1 Y20\nM114\n";
+        std::vector<std::string> l = assemble(a, s, sizeof(s) - 1, 5);
+        check(l.size() == 3 && l[0] == "G1 X10 F3000" && l[1] == "G1 Y20" && l[2] == "M114",
+              "a line cut mid-way is joined with the next receive");
+
+        LineAssembler b;
+        l = assemble(b, s, sizeof(s) - 1, 64);
+        check(l.size() == 3 && l[1] == "G1 Y20", "several lines in one receive come out one at a time");
+    }
+
+    printf("Test: terminators\n");
+    {
+        LineAssembler a;
+        // Job streamer sends NUL-terminated lines; Serial sends CRLF
+        const char s[] = "G28\0G90\r\nM105\r\n\n\n";
+        std::vector<std::string> l = assemble(a, s, sizeof(s) - 1, 3);
+        check(l.size() == 3 && l[0] == "G28" && l[1] == "G90" && l[2] == "M105", "NUL, CR and LF end lines; empty lines are skipped");
+
+        LineAssembler b;
+        const char partial[] = "G1 X1";
+        l = assemble(b, partial, sizeof(partial) - 1, 64);
+        check(l.empty() && !b.ready(), "an unterminated line is held until its end arrives");
+        l = assemble(b, "\n", 1, 1);
+        check(l.size() == 1 && l[0] == "G1 X1", "and released once it does");
+    }
+
+    printf("Test: over-long lines\n");
+    {
+        LineAssembler a;
+        std::string s(GCODE_LINE_MAX + 40, 'X');
+        s = "G1 X1\n" + s + "\nG1 X2\n";
+        int dropped = 0;
+        std::vector<std::string> l = assemble(a, s.data(), s.size(), 17, &dropped);
+        check(dropped == 1, "a line longer than GCODE_LINE_MAX is reported once");
+        check(l.size() == 2 && l[0] == "G1 X1" && l[1] == "G1 X2", "it is dropped whole; its tail is not parsed as a new line");
+
+        LineAssembler b;
+        std::string exact(GCODE_LINE_MAX, 'Y');
+        exact += '\n';
+        l = assemble(b, exact.data(), exact.size(), 64, &dropped);
+        check(l.size() == 1 && l[0].size() == GCODE_LINE_MAX && dropped == 1, "a line of exactly GCODE_LINE_MAX fits");
+    }
+
+    if (failures) {
+        printf("\n✗ %d line assembler check(s) failed\n", failures);
+        return 1;
+    }
+    printf("\n✓ All line assembler tests passed\n");
+    return 0;
+}
@@ -0,0 +1,175 @@
+// Host test: measured receive -> motion-start latency of the G-code path.
+// Threads stand in for the tasks: a reader writes lines into the stream,
+// the parser blocks on the stream like parserTask's queue-set select and
+// reassembles lines with the real LineAssembler, and the control loop
+// takes each command off a 10-deep motion queue and then waits out its
+// 1 ms tick. The same harness runs the old polled parser (10 ms sleeps)
+// for comparison.
+//
+// Build & run from the repo root:
+//   g++ -std=c++17 -pthread -Iinclude tests/host/parser_latency_test.cpp -o /tmp/parser_latency_test && /tmp/parser_latency_test
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "line_assembler.h"
+#include "latency_stats.h"
+
+static int failures = 0;
+
+static void check(bool ok, const char* what) {
+    printf("  %s %s\n", what, ok ? "✓" : "✗");
+    if (!ok) failures++;
+}
+
+typedef std::chrono::steady_clock Clock;
+
+static int64_t nowUs(Clock::time_point t0) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - t0).count();
+}
+
+struct Move {
+    int seq;
+    int64_t receivedUs; // last byte of its line written to the stream
+};
+
+struct Path {
+    // gcodeStream plus its signal in the parser's queue set
+    std::mutex streamLock;
+    std::condition_variable streamReady;
+    std::deque<char> stream;
+    // motionQueue (10 deep, as in setup())
+    std::mutex motionLock;
+    std::condition_variable motionChanged;
+    std::deque<Move> motion;
+    bool done = false;
+};
+
+static const int LINES = 200;
+
+// One run: returns receive -> dequeue latency and whether every line came
+// through once, in order
+static LatencyStats run(bool polled, bool& inOrder) {
+    Path p;
+    Clock::time_point t0 = Clock::now();
+    std::vector<int64_t> received(LINES, 0);
+
+    // Serial reader: a line every 2-5 ms, sometimes split over two receives
+    std::thread reader([&] {
+        uint32_t seed = 12345;
+        for (int i = 0; i < LINES; ++i) {
+            seed = seed * 1103515245u + 12345u;
+            std::this_thread::sleep_for(std::chrono::microseconds(2000 + (seed >> 16) % 3000));
+            char line[32];
+            int n = snprintf(line, sizeof(line), "G1 X%d.5 F3000\n", i);
+            int split = (seed & 1) ? n / 2 : n;
+            for (int part = 0; part < 2; ++part) {
+                const char* from = part ? line + split : line;
+                int len = part ? n - split : split;
+                if (len == 0) continue;
+                std::lock_guard<std::mutex> g(p.streamLock);
+                p.stream.insert(p.stream.end(), from, from + len);
+                if (part == 1 || split == n) received[i] = nowUs(t0);
+                p.streamReady.notify_one(); // xSemaphoreGive(gcodeStreamSignal)
+            }
+        }
+    });
+
+    // parserTask: select on the stream (or poll it), 64-byte receives, line reassembly
+    std::thread parser([&] {
+        LineAssembler lines;
+        char chunk[64];
+        size_t chunkLen = 0, chunkPos = 0;
+        int parsed = 0;
+        while (parsed < LINES) {
+            bool pending = lines.ready() || chunkPos < chunkLen;
+            {
+                std::unique_lock<std::mutex> g(p.streamLock);
+                if (!pending) {
+                    if (polled) { g.unlock(); std::this_thread::sleep_for(std::chrono::milliseconds(10)); g.lock(); }
+                    else p.streamReady.wait(g, [&] { return !p.stream.empty(); });
+                }
+            }
+            while (!lines.ready()) {
+                if (chunkPos >= chunkLen) {
+                    std::lock_guard<std::mutex> g(p.streamLock);
+                    chunkLen = 0; chunkPos = 0;
+                    while (chunkLen < sizeof(chunk) && !p.stream.empty()) { chunk[chunkLen++] = p.stream.front(); p.stream.pop_front(); }
+                    if (chunkLen == 0) break;
+                }
+                chunkPos += lines.feed(chunk + chunkPos, chunkLen - chunkPos);
+            }
+            if (!lines.ready()) continue;
+            int x = 0;
+            sscanf(lines.line(), "G1 X%d", &x);
+            lines.next();
+            std::unique_lock<std::mutex> g(p.motionLock);
+            p.motionChanged.wait(g, [&] { return p.motion.size() < 10; });
+            p.motion.push_back({ x, received[x] });
+            p.motionChanged.notify_all();
+            parsed++;
+        }
+    });
+
+    // controlTask: blocking receive (10 ms timeout), then the 1 kHz tick
+    LatencyStats latency;
+    inOrder = true;
+    std::thread control([&] {
+        Clock::time_point lastWake = Clock::now();
+        int expect = 0;
+        while (expect < LINES) {
+            std::unique_lock<std::mutex> g(p.motionLock);
+            if (p.motionChanged.wait_for(g, std::chrono::milliseconds(10), [&] { return !p.motion.empty(); })) {
+                Move m = p.motion.front();
+                p.motion.pop_front();
+                p.motionChanged.notify_all();
+                g.unlock();
+                latency.record((uint32_t)(nowUs(t0) - m.receivedUs));
+                if (m.seq != expect) inOrder = false;
+                expect++;
+            } else {
+                g.unlock();
+            }
+            // vTaskDelayUntil(&xLastWakeTime, 1)
+            lastWake += std::chrono::milliseconds(1);
+            if (lastWake < Clock::now()) lastWake = Clock::now();
+            std::this_thread::sleep_until(lastWake);
+        }
+    });
+
+    reader.join();
+    parser.join();
+    control.join();
+    return latency;
+}
+
+int main() {
+    printf("Test: receive -> motion start, measured\n");
+    {
+        bool eventOrder = false, polledOrder = false;
+        LatencyStats event = run(false, eventOrder);
+        LatencyStats polled = run(true, polledOrder);
+        printf("    event-driven: mean %u us, p99 <= %u us, max %u us (%u lines)\n",
+               event.mean(), event.percentile(99), event.max(), event.count());
+        printf("    polled 10 ms: mean %u us, p99 <= %u us, max %u us (%u lines)\n",
+               polled.mean(), polled.percentile(99), polled.max(), polled.count());
+        check(event.count() == LINES && eventOrder && polled.count() == LINES && polledOrder,
+              "every line reaches the control loop once, in order, split or not");
+        // Host scheduling noise is far below the 10 ms poll period, so the
+        // comparison holds on a loaded machine too
+        check(event.mean() < polled.mean(), "waking on the stream beats polling it");
+        check(event.percentile(50) <= 4096, "half the lines start within a few ms of their last byte");
+    }
+
+    if (failures) {
+        printf("\n✗ %d parser latency check(s) failed\n", failures);
+        return 1;
+    }
+    printf("\n✓ All parser latency tests passed\n");
+    return 0;
+}
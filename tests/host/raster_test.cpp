@@ -0,0 +1,113 @@
+// Host test: raster (.e3r) header decoding, row planning and pixel lookup.
+//
+// Build & run from the repo root:
+//   g++ -std=c++17 -Iinclude tests/host/raster_test.cpp -o /tmp/raster_test && /tmp/raster_test
+#include <stdio.h>
+#include <math.h>
+#include "raster.h"
+
+static int failures = 0;
+
+static void check(bool ok, const char* what) {
+    printf("  %s %s\n", what, ok ? "✓" : "✗");
+    if (!ok) failures++;
+}
+
+static void putFloat(uint8_t* p, float f) {
+    uint32_t u;
+    memcpy(&u, &f, sizeof(u));
+    p[0] = u & 0xFF; p[1] = (u >> 8) & 0xFF; p[2] = (u >> 16) & 0xFF; p[3] = (u >> 24) & 0xFF;
+}
+
+static void makeHeader(uint8_t* b, uint16_t w, uint16_t h, float ox, float oy, float px, float py, float feed, float over, uint8_t flags) {
+    memset(b, 0, RASTER_HEADER_SIZE);
+    memcpy(b, "E3R1", 4);
+    b[4] = w & 0xFF; b[5] = w >> 8;
+    b[6] = h & 0xFF; b[7] = h >> 8;
+    putFloat(b + 8, ox); putFloat(b + 12, oy);
+    putFloat(b + 16, px); putFloat(b + 20, py);
+    putFloat(b + 24, feed); putFloat(b + 28, over);
+    b[32] = flags;
+}
+
+int main() {
+    printf("Test: header decoding\n");
+    uint8_t buf[RASTER_HEADER_SIZE];
+    RasterHeader h;
+    makeHeader(buf, 400, 300, 10.0f, 20.0f, 0.1f, -0.1f, 3000.0f, 5.0f, RASTER_FLAG_BIDIRECTIONAL);
+    bool ok = h.parse(buf, sizeof(buf));
+    check(ok && h.width == 400 && h.height == 300 && h.originX == 10.0f && h.pitchY == -0.1f && h.overscan == 5.0f, "valid header decodes");
+    uint8_t bad[RASTER_HEADER_SIZE];
+    makeHeader(bad, RASTER_MAX_WIDTH + 1, 10, 0, 0, 0.1f, 0.1f, 1000, 0, 0);
+    check(!h.parse(bad, sizeof(bad)), "row wider than the row buffer is rejected");
+    makeHeader(bad, 10, 10, 0, 0, 0.0f, 0.1f, 1000, 0, 0);
+    check(!h.parse(bad, sizeof(bad)), "zero pixel pitch is rejected");
+    makeHeader(bad, 10, 10, 0, 0, 0.1f, 0.1f, 1000, 0, 0);
+    bad[0] = 'X';
+    check(!h.parse(bad, sizeof(bad)), "bad magic is rejected");
+
+    printf("Test: bidirectional rows with overscan\n");
+    h.parse(buf, sizeof(buf));
+    RasterRowPlan r0 = rasterPlanRow(h, 0, 0);
+    RasterRowPlan r1 = rasterPlanRow(h, 1, 1);
+    RasterRowPlan r2 = rasterPlanRow(h, 5, 2);
+    check(!r0.reversed && r0.startX == 5.0f && fabsf(r0.endX - 55.0f) < 1e-4f && r0.y == 20.0f, "row 0 runs left to right from the run-in");
+    check(r1.reversed && r1.startX == r0.endX && r1.endX == r0.startX && fabsf(r1.y - 19.9f) < 1e-4f, "row 1 returns right to left one pitch down");
+    check(!r2.reversed && fabsf(r2.y - 19.5f) < 1e-4f, "third scanned row (image row 5, after blanks) runs forward again");
+    h.flags = 0;
+    check(!rasterPlanRow(h, 1, 1).reversed, "unidirectional rows always run forward");
+
+    printf("Test: pixel under the head\n");
+    uint8_t row[4] = { 10, 20, 30, 40 };
+    check(rasterPixelAt(row, 4, 0.0f, 0.5f, -0.01f) == 0, "run-in overscan is dark");
+    check(rasterPixelAt(row, 4, 0.0f, 0.5f, 0.0f) == 10, "pixel 0 starts at the origin");
+    check(rasterPixelAt(row, 4, 0.0f, 0.5f, 1.2f) == 30, "mid-row position maps to its pixel");
+    check(rasterPixelAt(row, 4, 0.0f, 0.5f, 2.0f) == 0, "run-out overscan is dark");
+    check(rasterRowBlank((const uint8_t*)"\0\0\0", 3) && !rasterRowBlank(row, 4), "blank rows are detected");
+
+    printf("Test: 1 kHz scan at constant speed burns every pixel in order\n");
+    {
+        // 0.1 mm pixels at 50 mm/s: a new pixel every 2 control ticks
+        uint8_t img[64];
+        for (int i = 0; i < 64; ++i) img[i] = (uint8_t)(i + 1);
+        int seen[64] = { 0 };
+        bool ordered = true;
+        int last = -1;
+        for (float t = 0.0f; t < 0.2f; t += 0.001f) {
+            float x = -1.0f + 50.0f * t;
+            uint8_t p = rasterPixelAt(img, 64, 0.0f, 0.1f, x);
+            if (!p) continue;
+            if (p - 1 < last) ordered = false;
+            last = p - 1;
+            seen[p - 1]++;
+        }
+        int covered = 0;
+        for (int i = 0; i < 64; ++i) if (seen[i] >= 1) covered++;
+        char msg[96];
+        snprintf(msg, sizeof(msg), "%d/64 pixels burned, in order", covered);
+        check(covered == 64 && ordered, msg);
+    }
+
+    printf("Test: row buffer pool\n");
+    {
+        static RasterRowPool pool;
+        int slots[RASTER_ROW_SLOTS];
+        bool distinct = true;
+        for (int i = 0; i < RASTER_ROW_SLOTS; ++i) {
+            slots[i] = pool.acquire();
+            for (int j = 0; j < i; ++j) if (slots[j] == slots[i]) distinct = false;
+        }
+        bool full = pool.acquire() == -1;
+        pool.release(slots[1]);
+        bool reused = pool.acquire() == slots[1];
+        pool.release(-1); // commands without a row release nothing
+        check(distinct && full && reused, "slots are exclusive, exhausted, then reused");
+    }
+
+    if (failures) {
+        printf("\n✗ %d raster check(s) failed\n", failures);
+        return 1;
+    }
+    printf("\n✓ All raster tests passed\n");
+    return 0;
+}
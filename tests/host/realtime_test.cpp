@@ -0,0 +1,72 @@
+// Host test: realtime command bytes picked out of client streams, and the
+// M112 priority line.
+//
+// Build & run from the repo root:
+//   g++ -std=c++17 -Iinclude tests/host/realtime_test.cpp -o /tmp/realtime_test && /tmp/realtime_test
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include "realtime.h"
+
+static int failures = 0;
+
+static void check(bool ok, const char* what) {
+    printf("  %s %s\n", what, ok ? "✓" : "✗");
+    if (!ok) failures++;
+}
+
+// Run `in` through a filter; returns the kept text, adds command names to `commands`
+static std::string filter(RealtimeFilter& f, const char* in, std::string& commands) {
+    std::string kept;
+    for (const char* p = in; *p; ++p) {
+        RealtimeCommand c = f.feed((uint8_t)*p);
+        if (c == RT_NONE) kept += *p;
+        else commands += std::string(commands.empty() ? "" : ",") + realtimeName(c);
+    }
+    return kept;
+}
+
+int main() {
+    printf("Test: realtime bytes\n");
+    {
+        RealtimeFilter f;
+        std::string cmds;
+        std::string kept = filter(f, "G1 X10 F600\n!?~G1 X20\n", cmds);
+        check(kept == "G1 X10 F600\nG1 X20\n" && cmds == "hold,status,resume", "picked out between and inside lines");
+        cmds.clear();
+        kept = filter(f, "G1 X5!Y5\n", cmds);
+        check(kept == "G1 X5Y5\n" && cmds == "hold", "a hold in the middle of a line leaves the line intact");
+    }
+
+    printf("Test: comments\n");
+    {
+        RealtimeFilter f;
+        std::string cmds;
+        std::string kept = filter(f, "G1 X1 ; layer done!?\n", cmds);
+        check(kept == "G1 X1 ; layer done!?\n" && cmds.empty(), "text in a ';' comment");
+        kept = filter(f, "(why?) G1 X2 !\n", cmds);
+        check(kept == "(why?) G1 X2 \n" && cmds == "hold", "text in a '(...)' comment, command after it");
+        cmds.clear();
+        kept = filter(f, "; stop\x18 now\n", cmds);
+        check(kept == "; stop now\n" && cmds == "reset", "Ctrl-X is a reset even inside a comment");
+        cmds.clear();
+        filter(f, "; open comment", cmds);
+        f.reset();
+        filter(f, "?", cmds);
+        check(cmds == "status", "reset() forgets an unterminated comment (new connection)");
+    }
+
+    printf("Test: M112 line\n");
+    {
+        auto estop = [](const char* s) { return realtimeFromLine(s, strlen(s)) == RT_ESTOP; };
+        check(estop("M112") && estop("m112") && estop("  M112 ; panic") && estop("M112\r"), "M112 forms");
+        check(!estop("M1120") && !estop("G1 M112") && !estop("M11") && !estop(""), "not M112");
+    }
+
+    if (failures) {
+        printf("\n✗ %d realtime check(s) failed\n", failures);
+        return 1;
+    }
+    printf("\n✓ All realtime tests passed\n");
+    return 0;
+}
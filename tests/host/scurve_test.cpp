@@ -0,0 +1,171 @@
+// Host test: S-curve profile limits, and a simulated servo axis comparing the
+// old constant-velocity trajectory with the jerk-limited one.
+//
+// Build & run from the repo root:
+//   g++ -std=c++17 -Iinclude tests/host/scurve_test.cpp -o /tmp/scurve_test && /tmp/scurve_test
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "scurve.h"
+
+static int failures = 0;
+
+static void check(bool ok, const char* what) {
+    printf("  %s %s\n", what, ok ? "✓" : "✗");
+    if (!ok) failures++;
+}
+
+// Sample a planned profile at 1 kHz and verify it respects its limits
+static void checkLimits(float dist, float vmax, float amax, float jmax) {
+    SCurveProfile p;
+    float T = p.plan(dist, vmax, amax, jmax);
+    const float dt = 0.0005f;
+    float prevS = 0, prevV = 0, prevA = 0;
+    float worstV = 0, worstA = 0, worstJ = 0;
+    bool monotonic = true;
+    for (float t = dt; t <= T + dt; t += dt) {
+        float s, v;
+        p.evaluate(t, s, v);
+        float a = (v - prevV) / dt;
+        float j = (a - prevA) / dt;
+        if (s < prevS - 1e-5f) monotonic = false;
+        worstV = fmaxf(worstV, fabsf(v));
+        worstA = fmaxf(worstA, fabsf(a));
+        if (t > 2 * dt && t < T - dt) worstJ = fmaxf(worstJ, fabsf(j));
+        prevS = s; prevV = v; prevA = a;
+    }
+    float endS, endV;
+    p.evaluate(T, endS, endV);
+    char buf[160];
+    snprintf(buf, sizeof(buf), "%6.1f mm @ %5.0f mm/s: T=%.3fs vpk=%.1f amax=%.0f jmax=%.0f",
+             dist, vmax, T, worstV, worstA, worstJ);
+    // numeric differentiation overshoots the jerk at phase corners by one sample
+    check(monotonic && endS == dist && worstV <= vmax * 1.001f && worstA <= amax * 1.01f && worstJ <= jmax * 1.05f, buf);
+}
+
+// Simple DC servo axis: first-order motor speed response to PWM plus the
+// firmware's P-only default tuning (KP_DEFAULT = 1, output clamped to +-255)
+struct Axis {
+    float pos = 0, vel = 0;            // counts, counts/s
+    float countsPerMM = 100.0f;
+    float speedPerPwm = 80.0f;         // counts/s at steady state per PWM step
+    float tau = 0.03f;                 // mechanical time constant (s)
+    float kp = 1.0f;
+    int out = 0;
+
+    void step(float desired, float dt) {
+        float u = kp * (desired - pos);
+        if (u > 255) u = 255;
+        if (u < -255) u = -255;
+        out = (int)u;
+        vel += (speedPerPwm * out - vel) * dt / tau;
+        pos += vel * dt;
+    }
+};
+
+struct RunResult { float maxFollow; float settleMs; int maxPwmSlew; };
+
+// Run a move of `dist` mm at `feed` mm/s with either the legacy linear time
+// ramp or the S-curve. Following error is measured against the moving
+// setpoint; settle time is from trajectory end until within 5 counts.
+// PWM slew is the largest change in motor command between ticks.
+static RunResult simulate(bool scurve, float dist, float feed) {
+    Axis ax;
+    SCurveProfile p;
+    float T = scurve ? p.plan(dist, feed, 1000.0f, 20000.0f) : dist / feed;
+    const float dt = 0.001f;
+    RunResult r = { 0, -1, 0 };
+    int prevOut = 0;
+    for (int k = 1; k < 20000; ++k) {
+        float t = k * dt;
+        float s;
+        if (scurve) { float v; p.evaluate(t, s, v); }
+        else s = t >= T ? dist : dist * t / T;
+        float desired = s * ax.countsPerMM;
+        ax.step(desired, dt);
+        if (abs(ax.out - prevOut) > r.maxPwmSlew) r.maxPwmSlew = abs(ax.out - prevOut);
+        prevOut = ax.out;
+        r.maxFollow = fmaxf(r.maxFollow, fabsf(desired - ax.pos));
+        if (t >= T && fabsf(dist * ax.countsPerMM - ax.pos) <= 5.0f) {
+            // settled once it stays within tolerance for 50 ms
+            bool stays = true;
+            Axis probe = ax;
+            for (int m = 0; m < 50; ++m) {
+                probe.step(dist * ax.countsPerMM, dt);
+                if (fabsf(dist * ax.countsPerMM - probe.pos) > 5.0f) { stays = false; break; }
+            }
+            if (stays) { r.settleMs = (t - T) * 1000.0f; break; }
+        }
+    }
+    return r;
+}
+
+int main() {
+    printf("Test: S-curve profile respects velocity/accel/jerk limits\n");
+    checkLimits(100.0f, 200.0f, 1000.0f, 20000.0f);   // reaches cruise
+    checkLimits(5.0f, 200.0f, 1000.0f, 20000.0f);     // never reaches vmax
+    checkLimits(0.2f, 200.0f, 1000.0f, 20000.0f);     // never reaches amax
+    checkLimits(50.0f, 20.0f, 5000.0f, 10000.0f);     // jerk-limited only
+
+    printf("Test: simulated servo axis, constant velocity vs S-curve\n");
+    const float moves[][2] = { { 10.0f, 50.0f }, { 50.0f, 100.0f }, { 2.0f, 20.0f } };
+    for (auto &m : moves) {
+        RunResult lin = simulate(false, m[0], m[1]);
+        RunResult sc = simulate(true, m[0], m[1]);
+        printf("  %5.1f mm @ %5.1f mm/s  linear: follow %6.1f cts, settle %6.1f ms, PWM slew %d/tick\n",
+               m[0], m[1], lin.maxFollow, lin.settleMs, lin.maxPwmSlew);
+        printf("  %5.1f mm @ %5.1f mm/s  s-curve: follow %6.1f cts, settle %6.1f ms, PWM slew %d/tick\n",
+               m[0], m[1], sc.maxFollow, sc.settleMs, sc.maxPwmSlew);
+        check(sc.settleMs >= 0 && sc.settleMs < lin.settleMs && sc.maxFollow < lin.maxFollow && sc.maxPwmSlew <= lin.maxPwmSlew,
+              "S-curve: lower following error, faster settle, gentler PWM demand");
+    }
+
+    printf("Test: speed override re-plans the rest of a move while cruising\n");
+    {
+        // 100 mm at 50 mm/s, override raised to 300% mid-move with the axis
+        // limited to 120 mm/s, then lowered to 50% on the next re-plan
+        const float axisLimit = 120.0f;
+        const float overrides[] = { 3.0f, 0.5f };
+        SCurveProfile p;
+        p.plan(100.0f, 50.0f, 1000.0f, 20000.0f);
+        const float dt = 0.001f;
+        float offset = 0.0f, tp = 0.0f, prevPos = 0.0f, prevVel = 0.0f, prevAcc = 0.0f;
+        float worstV = 0.0f, worstA = 0.0f;
+        int replans = 0;
+        bool continuous = true; // acceleration never steps between ticks (bounded jerk)
+        for (int k = 1; k < 20000; ++k) {
+            tp += dt;
+            if (replans < 2 && p.cruising(tp) && tp > 0.2f) {
+                float sNow, vNow;
+                p.evaluate(tp, sNow, vNow);
+                float vNew = fminf(50.0f * overrides[replans], axisLimit);
+                SCurveProfile next;
+                if (next.plan(p.distance() - sNow, vNew, 1000.0f, 20000.0f, vNow) > 0.0f) {
+                    p = next; offset += sNow; tp = 0.0f;
+                }
+                replans++;
+            }
+            float s, v;
+            p.evaluate(tp, s, v);
+            float pos = offset + s;
+            float vel = v;
+            float acc = (vel - prevVel) / dt;
+            if (k > 2 && fabsf(acc - prevAcc) > 20000.0f * dt * 2.0f) continuous = false;
+            worstV = fmaxf(worstV, vel);
+            worstA = fmaxf(worstA, fabsf(acc));
+            prevPos = pos; prevVel = vel; prevAcc = acc;
+            if (tp >= p.duration()) break;
+        }
+        char buf[160];
+        snprintf(buf, sizeof(buf), "2 re-plans, end %.4f mm, peak %.1f mm/s (limit %.0f), peak accel %.0f",
+                 prevPos, worstV, axisLimit, worstA);
+        check(replans == 2 && fabsf(prevPos - 100.0f) < 1e-3f && worstV <= axisLimit * 1.01f && worstA <= 1000.0f * 1.02f && continuous, buf);
+    }
+
+    if (failures) {
+        printf("\n✗ %d S-curve check(s) failed\n", failures);
+        return 1;
+    }
+    printf("\n✓ All S-curve tests passed\n");
+    return 0;
+}
@@ -0,0 +1,141 @@
+// Host test: settings registry blob round trip, validation and the debounced
+// NVS flush schedule.
+//
+// Build & run from the repo root:
+//   g++ -std=c++17 -Iinclude tests/host/settings_test.cpp -o /tmp/settings_test && /tmp/settings_test
+#include <stdio.h>
+#include "settings.h"
+
+static int failures = 0;
+
+static void check(bool ok, const char* what) {
+    printf("  %s %s\n", what, ok ? "✓" : "✗");
+    if (!ok) failures++;
+}
+
+// A cut-down registry shaped like the one in main.cpp
+static float cpmX = 80.0f, kpX = 2.0f, arcTol = 0.01f, scratch = 1.0f;
+static int maxFX = 3000, laserP = 0;
+static const SettingDesc table[] = {
+    { "cpm_x",    "countsPerMM.x", SETTING_FLOAT, &cpmX,    80.0f,  0.001f, 1000000.0f, true },
+    { "pid_kp_x", "pid.x.p",       SETTING_FLOAT, &kpX,     2.0f,   0.0f,   10000.0f,   true },
+    { "maxF_x",   "maxFeedrate.x", SETTING_INT,   &maxFX,   3000,   1.0f,   100000.0f,  true },
+    { "arc_tol",  "arcTolerance",  SETTING_FLOAT, &arcTol,  0.01f,  0.0001f, 1.0f,      true },
+    { "laser_p",  "laser.power",   SETTING_INT,   &laserP,  0,      0.0f,   255.0f,     true },
+    { "scratch",  "scratch",       SETTING_FLOAT, &scratch, 1.0f,   0.0f,   10.0f,      false },
+};
+static const int tableN = sizeof(table) / sizeof(table[0]);
+
+int main() {
+    uint8_t blob[SETTINGS_BLOB_MAX];
+
+    printf("Test: registry lookup and range checks\n");
+    {
+        check(settingFind(table, tableN, "PID_KP_X") == &table[1] && settingFind(table, tableN, "maxfeedrate.x") == &table[2],
+              "settings are found by key or path, case-insensitively");
+        check(!settingSet(table[4], 300.0f) && laserP == 0, "out-of-range value is rejected and leaves the setting alone");
+        check(settingSet(table[2], 4500.4f) && maxFX == 4500, "int settings round to the nearest integer");
+        settingsResetDefaults(table, tableN);
+        check(maxFX == 3000, "reset restores defaults");
+    }
+
+    printf("Test: command writes are all or nothing\n");
+    {
+        settingsResetDefaults(table, tableN);
+        SettingWrite bad[] = { { "pid.x.p", 5.0f, true }, { "countsPerMM.x", 0.0f, true } };
+        const char* err = settingsWriteAll(table, tableN, bad, 2);
+        check(err && strcmp(err, "countsPerMM.x") == 0 && kpX == 2.0f && cpmX == 80.0f,
+              "M92 X0 is refused and the valid word on the same line is not applied");
+        SettingWrite missing[] = { { "pid.x.p", 0.0f, false } };
+        check(settingsWriteAll(table, tableN, missing, 1) != nullptr && kpX == 2.0f, "a word without a number is refused");
+        SettingWrite good[] = { { "pid.x.p", 5.0f, true }, { "cpm_x", 100.0f, true } };
+        check(settingsWriteAll(table, tableN, good, 2) == nullptr && kpX == 5.0f && cpmX == 100.0f, "valid writes all apply");
+        settingsResetDefaults(table, tableN);
+    }
+
+    printf("Test: blob round trip\n");
+    {
+        cpmX = 123.456f; kpX = 7.5f; maxFX = 9000; laserP = 200; scratch = 5.0f;
+        size_t len = settingsEncode(table, tableN, blob, sizeof(blob));
+        check(len == SETTINGS_BLOB_HEADER + 5 * SETTINGS_BLOB_ENTRY, "only persisted settings are encoded");
+        settingsResetDefaults(table, tableN);
+        SettingsImportResult r = settingsDecode(table, tableN, blob, len, true);
+        check(r.valid && r.applied == 5 && r.rejected == 0 && r.unknown == 0, "decode applies every entry");
+        check(cpmX == 123.456f && kpX == 7.5f && maxFX == 9000 && laserP == 200 && scratch == 1.0f,
+              "values survive bit-exactly; non-persisted ones are untouched");
+    }
+
+    printf("Test: corrupt or foreign blobs are refused as a whole\n");
+    {
+        settingsResetDefaults(table, tableN);
+        cpmX = 50.0f;
+        size_t len = settingsEncode(table, tableN, blob, sizeof(blob));
+        cpmX = 80.0f;
+
+        uint8_t bad[SETTINGS_BLOB_MAX];
+        memcpy(bad, blob, len); bad[SETTINGS_BLOB_HEADER + 20] ^= 0x01;
+        SettingsImportResult r = settingsDecode(table, tableN, bad, len, true);
+        check(!r.valid && cpmX == 80.0f, "flipped bit fails the CRC and writes nothing");
+
+        memcpy(bad, blob, len); settingsPut16(bad + 4, SETTINGS_BLOB_VERSION + 1);
+        check(!settingsDecode(table, tableN, bad, len, true).valid, "unknown format version is refused");
+        check(!settingsDecode(table, tableN, blob, len - 1, true).valid, "truncated blob is refused");
+        check(!settingsDecode(table, tableN, (const uint8_t*)"not a blob", 10, true).valid, "bad magic is refused");
+    }
+
+    printf("Test: values from another firmware build\n");
+    {
+        // Exporter knew an extra key and had an out-of-range laser power
+        static float extra = 3.0f;
+        static int hot = 999;
+        const SettingDesc other[] = {
+            { "cpm_x",   "countsPerMM.x", SETTING_FLOAT, &cpmX,  80.0f, 0.0f, 1e9f, true },
+            { "laser_p", "laser.power",   SETTING_INT,   &hot,   0,     0.0f, 1e9f, true },
+            { "new_key", "future.thing",  SETTING_FLOAT, &extra, 0.0f,  0.0f, 1e9f, true },
+        };
+        settingsResetDefaults(table, tableN);
+        cpmX = 42.0f;
+        size_t len = settingsEncode(other, 3, blob, sizeof(blob));
+        cpmX = 80.0f; laserP = 10;
+        SettingsImportResult r = settingsDecode(table, tableN, blob, len, true);
+        check(r.valid && r.applied == 1 && r.rejected == 1 && r.unknown == 1, "known keys apply, unknown and out-of-range are counted");
+        check(cpmX == 42.0f && laserP == 10, "the rejected value keeps its current setting");
+        check(settingsEncode(table, tableN, blob, SETTINGS_BLOB_HEADER) == 0, "encode refuses a buffer that is too small");
+    }
+
+    printf("Test: flush schedule\n");
+    {
+        SettingsFlushSchedule s;
+        uint32_t t = 0;
+        int flushes = 0;
+        // Slider drag: a change every 20 ms for 1 s
+        for (; t < 1000; t += 20) { s.markDirty(t); if (s.take(t)) flushes++; }
+        check(flushes == 0 && s.pending(), "nothing flushed while changes keep coming");
+        t += SETTINGS_FLUSH_DEBOUNCE_MS;
+        if (s.take(t)) flushes++;
+        check(flushes == 1 && !s.pending(), "one flush once changes go quiet");
+
+        int firstAt = -1;
+        SettingsFlushSchedule c;
+        for (t = 0; t < 30000 && firstAt < 0; t += 50) { c.markDirty(t); if (c.take(t)) firstAt = (int)t; }
+        check(firstAt >= 0 && firstAt <= SETTINGS_FLUSH_MAX_DELAY_MS, "continuous changes still flush within the max delay");
+
+        SettingsFlushSchedule m;
+        m.requestFlush(5);
+        check(m.take(5), "M500 flushes without waiting for the debounce");
+
+        SettingsFlushSchedule f;
+        f.markDirty(0);
+        check(f.take(SETTINGS_FLUSH_DEBOUNCE_MS), "due flush is handed out");
+        f.markFailed(SETTINGS_FLUSH_DEBOUNCE_MS);
+        check(f.pending() && !f.take(SETTINGS_FLUSH_DEBOUNCE_MS + 1), "failed write stays pending without a hot retry");
+        check(f.take(SETTINGS_FLUSH_DEBOUNCE_MS * 2), "and is retried after another debounce");
+    }
+
+    if (failures) {
+        printf("\n✗ %d settings check(s) failed\n", failures);
+        return 1;
+    }
+    printf("\n✓ All settings tests passed\n");
+    return 0;
+}
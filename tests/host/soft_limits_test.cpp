@@ -0,0 +1,82 @@
+// Host test: travel envelope checks for straight moves and arcs, and the
+// arc bounding box they rely on.
+//
+// Build & run from the repo root:
+//   g++ -std=c++17 -Iinclude tests/host/soft_limits_test.cpp -o /tmp/soft_limits_test && /tmp/soft_limits_test
+#include <stdio.h>
+#include <math.h>
+#include <string.h>
+#include "soft_limits.h"
+
+static int failures = 0;
+
+static void check(bool ok, const char* what) {
+    printf("  %s %s\n", what, ok ? "✓" : "✗");
+    if (!ok) failures++;
+}
+
+static bool near(float a, float b) { return fabsf(a - b) < 1e-3f; }
+
+int main() {
+    const float mins[3] = { 0.0f, -10.0f, 0.0f };
+    const float maxs[3] = { 300.0f, 200.0f, 0.0f }; // Z unlimited
+    TravelEnvelope env;
+    env.configure(true, mins, maxs);
+
+    printf("Test: straight moves\n");
+    {
+        SoftLimitViolation v;
+        float a[NUM_AXES] = { 10, 10, 5, 0 }, b[NUM_AXES] = { 300, -10, 5000, 99 };
+        check(env.containsLine(a, b, &v), "ends on the limits, any Z and E: inside");
+        b[AXIS_X] = 300.0005f;
+        check(env.containsLine(a, b, &v), "G-code rounding past a limit is let through");
+        b[AXIS_X] = 312.0f;
+        check(!env.containsLine(a, b, &v) && v.axis == AXIS_X && v.above && near(v.value, 312) && near(v.limit, 300), "past X max");
+        char msg[64];
+        check(softLimitDescribe(msg, sizeof(msg), v) && strcmp(msg, "X=312.000 above max 300.000") == 0, "the error names axis, target and limit");
+        b[AXIS_X] = 0.0f; b[AXIS_Y] = -10.5f;
+        check(!env.containsLine(a, b, &v) && v.axis == AXIS_Y && !v.above && near(v.value, -10.5f), "below Y min");
+        check(!env.containsLine(b, a, &v) && v.axis == AXIS_Y, "the direction doesn't matter");
+        check(softLimitDescribe(msg, 8, v) == 0, "describe refuses a short buffer");
+
+        TravelEnvelope off;
+        off.configure(false, mins, maxs);
+        b[AXIS_X] = 1e6f;
+        check(off.containsLine(a, b, nullptr) && !off.limited(AXIS_X), "disabled: everything passes");
+    }
+
+    printf("Test: arc bounds\n");
+    {
+        float lo[2], hi[2];
+        // Quarter from the left point anticlockwise to the bottom of a circle around the origin
+        arcBoundsXY(-10, 0, 0, -10, 0, 0, (float)M_PI / 2.0f, lo, hi);
+        check(near(lo[0], -10) && near(hi[0], 0) && near(lo[1], -10) && near(hi[1], 0), "quarter arc: only its end points");
+        // Same points clockwise: three quarters over the top and right
+        arcBoundsXY(-10, 0, 0, -10, 0, 0, -3.0f * (float)M_PI / 2.0f, lo, hi);
+        check(near(lo[0], -10) && near(hi[0], 10) && near(lo[1], -10) && near(hi[1], 10), "three quarters reach both far sides");
+        arcBoundsXY(5, 0, 5, 0, 0, 0, 2.0f * (float)M_PI, lo, hi);
+        check(near(lo[0], -5) && near(hi[0], 5) && near(lo[1], -5) && near(hi[1], 5), "full circle");
+        arcBoundsXY(10, 1, 10, -1, 0, 0, -0.2f, lo, hi);
+        check(near(hi[0], sqrtf(101.0f)) && near(lo[1], -1) && near(hi[1], 1), "small arc across 0 degrees bulges out to the radius");
+    }
+
+    printf("Test: arcs against the envelope\n");
+    {
+        SoftLimitViolation v;
+        // Both ends inside, the bulge crosses Y min
+        float a[NUM_AXES] = { 45, 0, 1, 0 }, b[NUM_AXES] = { 75, 0, 3, 0 };
+        check(!env.containsArc(a, b, 60, 0, (float)M_PI, &v) && v.axis == AXIS_Y && !v.above && near(v.value, -15),
+              "a half circle dipping below Y min is refused though its ends are inside");
+        check(env.containsArc(a, b, 60, 0, -(float)M_PI, &v), "the other half stays inside");
+        float c[NUM_AXES] = { 285, 50, 0, 0 };
+        check(!env.containsArc(c, c, 295, 50, 2.0f * (float)M_PI, &v) && v.axis == AXIS_X && v.above && near(v.value, 305),
+              "a full circle starting inside but reaching past X max");
+    }
+
+    if (failures) {
+        printf("\n✗ %d soft limit check(s) failed\n", failures);
+        return 1;
+    }
+    printf("\n✓ All soft limit tests passed\n");
+    return 0;
+}
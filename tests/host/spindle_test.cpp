@@ -0,0 +1,124 @@
+// Host test: spindle RPM regulator against a simulated spindle motor with a
+// pulse tachometer, compared with the old open-loop PWM output.
+//
+// Build & run from the repo root:
+//   g++ -std=c++17 -Iinclude tests/host/spindle_test.cpp -o /tmp/spindle_test && /tmp/spindle_test
+#include <stdio.h>
+#include <math.h>
+#include "spindle.h"
+
+static int failures = 0;
+
+static void check(bool ok, const char* what) {
+    printf("  %s %s\n", what, ok ? "✓" : "✗");
+    if (!ok) failures++;
+}
+
+// DC spindle: first-order speed response, loaded by the cut. The PWM to RPM
+// gain is deliberately off from the configured SPINDLE_MAX_RPM (as on real
+// hardware) so open-loop S values land at the wrong speed.
+struct Motor {
+    float rpm = 0;
+    float revs = 0;        // accumulated revolutions (for tach pulses)
+    float fullRpm = 21000; // actual RPM at PWM 255, unloaded
+    float tau = 0.35f;     // s
+    float load = 0;        // fraction of speed lost to the cut
+    bool locked = false;
+
+    void step(int pwm, float dt) {
+        float ss = locked ? 0.0f : pwm / 255.0f * fullRpm * (1.0f - load);
+        rpm += (ss - rpm) * dt / tau;
+        revs += rpm / 60.0f * dt;
+    }
+};
+
+// 50 Hz regulator loop with 1 ms motor simulation in between. Returns the
+// time to first report at-speed (ms), and fills the mean speed error during
+// the last second.
+struct Run { int atSpeedMs; float loadedErr; bool stalled; };
+
+static Run run(bool closedLoop, float target, float load, bool lockUp) {
+    Motor m;
+    SpindleTach tach;
+    tach.setPulsesPerRev(2);
+    SpindleRegulator reg;
+    reg.setClosedLoop(closedLoop);
+    // Open loop (old behaviour) the caller converts RPM to PWM via the nominal max
+    reg.setTarget(closedLoop ? target : target / SPINDLE_MAX_RPM * 255.0f);
+    Run r = { -1, 0, false };
+    long lastPulses = 0;
+    int pwm = 0;
+    float errSum = 0; int errN = 0;
+    for (int ms = 1; ms <= 8000; ++ms) {
+        if (ms == 3000) m.load = load;
+        if (lockUp && ms == 5000) m.locked = true;
+        m.step(pwm, 0.001f);
+        if (ms % 20 == 0) {
+            long p = (long)floorf(m.revs * 2.0f);
+            float rpm = tach.add(p - lastPulses, 20);
+            lastPulses = p;
+            pwm = reg.update(rpm, 20);
+            if (r.atSpeedMs < 0 && closedLoop && reg.atSpeed()) r.atSpeedMs = ms;
+            if (reg.stalled()) r.stalled = true;
+        }
+        if (ms > 7000) { errSum += fabsf(m.rpm - target); errN++; }
+    }
+    r.loadedErr = errSum / errN;
+    return r;
+}
+
+int main() {
+    printf("Test: tachometer window\n");
+    {
+        SpindleTach t;
+        t.setPulsesPerRev(2);
+        float rpm = 0;
+        // 3000 RPM at 2 pulses/rev = 100 pulses/s = 2 per 20 ms
+        for (int i = 0; i < 20; ++i) rpm = t.add(2, 20);
+        check(fabsf(rpm - 3000.0f) < 1.0f, "steady pulses give the exact RPM");
+        for (int i = 0; i < 20; ++i) rpm = t.add(0, 20);
+        check(rpm == 0.0f, "no pulses over a full window reads 0 RPM");
+    }
+
+    printf("Test: closed loop holds RPM under load, open loop does not\n");
+    const float targets[] = { 6000.0f, 12000.0f, 18000.0f };
+    for (float target : targets) {
+        Run open = run(false, target, 0.15f, false);
+        Run closed = run(true, target, 0.15f, false);
+        char buf[160];
+        snprintf(buf, sizeof(buf), "S%-5.0f open loop err %6.0f RPM, closed loop err %5.0f RPM, at speed after %d ms",
+                 target, open.loadedErr, closed.loadedErr, closed.atSpeedMs);
+        check(closed.atSpeedMs > 0 && closed.atSpeedMs < 2000 && closed.loadedErr < target * SPINDLE_AT_SPEED_TOLERANCE &&
+              closed.loadedErr < open.loadedErr && !closed.stalled, buf);
+    }
+
+    printf("Test: stall detection\n");
+    {
+        Run locked = run(true, 12000.0f, 0.1f, true);
+        check(locked.stalled, "spindle locking up mid-cut is reported as a stall");
+        Run unreachable = run(true, 12000.0f, 0.9f, false);
+        check(unreachable.stalled, "speed collapsing under an overload is reported as a stall");
+        Run fine = run(true, 12000.0f, 0.1f, false);
+        check(!fine.stalled, "a normally loaded spindle is not flagged");
+    }
+
+    printf("Test: setpoint handling\n");
+    {
+        SpindleRegulator reg;
+        reg.setClosedLoop(true);
+        reg.setTarget(50000.0f);
+        check(reg.getTarget() == SPINDLE_MAX_RPM && !reg.atSpeed(), "setpoint is clamped to the max RPM and waits for speed");
+        reg.setTarget(0.0f);
+        check(reg.atSpeed() && reg.update(0.0f, 20) == 0, "spindle off is immediately 'at speed' with no output");
+        SpindleRegulator open;
+        open.setTarget(128.0f);
+        check(open.atSpeed() && open.update(0.0f, 20) == 128, "open loop passes PWM straight through");
+    }
+
+    if (failures) {
+        printf("\n✗ %d spindle check(s) failed\n", failures);
+        return 1;
+    }
+    printf("\n✓ All spindle tests passed\n");
+    return 0;
+}
@@ -0,0 +1,93 @@
+// Host test: UI asset manifest parsing, ETag revalidation and gzip
+// negotiation used by the static file handler.
+//
+// Build & run from the repo root:
+//   g++ -std=c++17 -Iinclude tests/host/static_assets_test.cpp -o /tmp/static_assets_test && /tmp/static_assets_test
+#include <stdio.h>
+#include <string>
+#include "static_assets.h"
+
+static int failures = 0;
+
+static void check(bool ok, const char* what) {
+    printf("  %s %s\n", what, ok ? "✓" : "✗");
+    if (!ok) failures++;
+}
+
+int main() {
+    printf("Test: manifest parsing\n");
+    {
+        StaticAssetIndex idx;
+        check(idx.parseLine("/index.html\t3747c226d12802d6\tz\n"), "gzipped html entry");
+        check(idx.parseLine("/js/three.r128.min.js\t68bb9076cce938e4\tzi\r\n"), "immutable vendor entry (CRLF)");
+        check(idx.parseLine("/js/vendor/FBXExporter.js\t78fb38f212fa4902\ti"), "uncompressed entry");
+        check(idx.parseLine("/favicon.ico\tabcdef"), "entry without flags");
+        check(idx.size() == 4, "all four are indexed");
+
+        const StaticAsset* a = idx.find("/index.html");
+        check(a && a->gzipped && !a->immutable && std::string(a->etag) == "\"3747c226d12802d6\"",
+              "etag is stored quoted, flags decoded");
+        a = idx.find("/js/three.r128.min.js");
+        check(a && a->gzipped && a->immutable && std::string(staticCacheControl(*a)) == STATIC_CACHE_IMMUTABLE,
+              "version-pinned file is cached as immutable");
+        a = idx.find("/js/vendor/FBXExporter.js");
+        check(a && !a->gzipped, "file stored uncompressed is not flagged gzip");
+        a = idx.find("/favicon.ico");
+        check(a && std::string(staticCacheControl(*a)) == STATIC_CACHE_REVALIDATE, "other files revalidate on each use");
+        check(idx.find("/index.htm") == nullptr && idx.find("/INDEX.HTML") == nullptr, "lookup is by exact path");
+
+        check(!idx.parseLine("index.html\tabc\tz"), "relative path is refused");
+        check(!idx.parseLine("/index.html"), "line without an etag is refused");
+        check(!idx.parseLine("/index.html\t\tz"), "empty etag is refused");
+        check(!idx.parseLine("/x\t0123456789abcdef0123\tz"), "over-long etag is refused");
+        std::string longPath = "/" + std::string(STATIC_PATH_MAX, 'a') + "\tabc";
+        check(!idx.parseLine(longPath.c_str()), "over-long path is refused");
+        check(idx.size() == 4, "refused lines add nothing");
+
+        StaticAssetIndex full;
+        char line[64];
+        int added = 0;
+        for (int i = 0; i < STATIC_ASSETS_MAX + 5; ++i) {
+            snprintf(line, sizeof(line), "/f%d.js\t%08x\tz", i, i);
+            if (full.parseLine(line)) added++;
+        }
+        check(added == STATIC_ASSETS_MAX && full.find("/f0.js") && !full.find("/f70.js"), "table stops at STATIC_ASSETS_MAX");
+    }
+
+    printf("Test: If-None-Match\n");
+    {
+        const char* tag = "\"3747c226d12802d6\"";
+        check(staticEtagMatches("\"3747c226d12802d6\"", tag), "exact tag matches");
+        check(staticEtagMatches("W/\"3747c226d12802d6\"", tag), "weak form of the tag matches");
+        check(staticEtagMatches("\"aaaa\", \"3747c226d12802d6\"", tag), "tag inside a list matches");
+        check(staticEtagMatches("*", tag), "* matches anything");
+        check(!staticEtagMatches("\"3747c226d12802d7\"", tag), "different tag does not match");
+        check(!staticEtagMatches("\"3747c226d12802d6", tag), "unterminated tag does not match");
+        check(!staticEtagMatches("", tag) && !staticEtagMatches(nullptr, tag), "missing header does not match");
+    }
+
+    printf("Test: Accept-Encoding\n");
+    {
+        check(staticAcceptsGzip("gzip, deflate, br"), "typical browser header");
+        check(staticAcceptsGzip("br;q=1.0, GZIP;q=0.8"), "gzip with a quality value, any case");
+        check(staticAcceptsGzip("*"), "wildcard");
+        check(!staticAcceptsGzip("gzip;q=0"), "q=0 refuses gzip");
+        check(!staticAcceptsGzip("deflate, br"), "gzip not listed");
+        check(!staticAcceptsGzip("x-gzip2") && !staticAcceptsGzip(""), "similar names and empty header");
+    }
+
+    printf("Test: content types\n");
+    {
+        check(std::string(staticContentType("/js/three-mesh-bvh.umd.cjs")) == "application/javascript", ".cjs is javascript");
+        check(std::string(staticContentType("/INDEX.HTML")) == "text/html", "extension match ignores case");
+        check(std::string(staticContentType("/css/style.css")) == "text/css", "css");
+        check(std::string(staticContentType("/blob")) == "application/octet-stream", "no extension");
+    }
+
+    if (failures) {
+        printf("\n✗ %d static asset check(s) failed\n", failures);
+        return 1;
+    }
+    printf("\n✓ All static asset tests passed\n");
+    return 0;
+}
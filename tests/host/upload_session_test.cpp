@@ -0,0 +1,165 @@
+// Host test: upload write buffering, streaming CRC-32, file name checks
+// and chunked upload session bookkeeping.
+//
+// Build & run from the repo root:
+//   g++ -std=c++17 -Iinclude tests/host/upload_session_test.cpp -o /tmp/upload_session_test && /tmp/upload_session_test
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include "upload_session.h"
+#include "settings.h"
+
+static int failures = 0;
+
+static void check(bool ok, const char* what) {
+    printf("  %s %s\n", what, ok ? "✓" : "✗");
+    if (!ok) failures++;
+}
+
+// Records every write the filesystem would see; can run out of space
+struct MockFile {
+    std::vector<uint8_t> data;
+    std::vector<size_t> writes;
+    size_t capacity = (size_t)-1;
+    size_t write(const uint8_t* p, size_t n) {
+        writes.push_back(n);
+        size_t room = capacity - data.size();
+        size_t w = n < room ? n : room;
+        data.insert(data.end(), p, p + w);
+        return w;
+    }
+};
+
+static const size_t CHUNK = 1436; // what the WebServer hands the upload callback
+
+int main() {
+    std::vector<uint8_t> payload(100000);
+    uint32_t seed = 7;
+    for (auto& b : payload) { seed = seed * 1103515245u + 12345u; b = (uint8_t)(seed >> 16); }
+
+    printf("Test: CRC-32\n");
+    {
+        const char* s = "123456789";
+        check(uploadCrc32Update(0, (const uint8_t*)s, 9) == 0xCBF43926u, "standard check value");
+        uint32_t crc = 0;
+        for (size_t i = 0; i < payload.size(); i += CHUNK) {
+            size_t n = payload.size() - i < CHUNK ? payload.size() - i : CHUNK;
+            crc = uploadCrc32Update(crc, payload.data() + i, n);
+        }
+        check(crc == settingsCrc32(payload.data(), payload.size()), "chunked CRC matches the one-shot CRC");
+        check(uploadCrc32Update(0, payload.data(), 0) == 0, "empty input");
+    }
+
+    printf("Test: buffered writes\n");
+    {
+        MockFile f;
+        static BufferedWriter<MockFile> w;
+        w.begin(&f);
+        bool ok = true;
+        for (size_t i = 0; i < payload.size(); i += CHUNK) {
+            size_t n = payload.size() - i < CHUNK ? payload.size() - i : CHUNK;
+            ok = ok && w.write(payload.data() + i, n);
+        }
+        ok = ok && w.flush();
+        check(ok && f.data == payload && w.written() == payload.size(), "file content is the upload, in order");
+        bool aligned = true;
+        for (size_t i = 0; i + 1 < f.writes.size(); ++i) if (f.writes[i] != UPLOAD_WRITE_BUF) aligned = false;
+        check(aligned && f.writes.back() == payload.size() % UPLOAD_WRITE_BUF, "every write but the last is a full buffer");
+        size_t direct = (payload.size() + CHUNK - 1) / CHUNK;
+        printf("    filesystem writes: %zu buffered vs %zu unbuffered\n", f.writes.size(), direct);
+        check(f.writes.size() * 5 < direct, "at least five times fewer filesystem writes");
+        check(w.flush() && f.writes.size() == (payload.size() + UPLOAD_WRITE_BUF - 1) / UPLOAD_WRITE_BUF, "flushing an empty buffer writes nothing");
+    }
+
+    printf("Test: storage full\n");
+    {
+        MockFile f;
+        f.capacity = 20000;
+        static BufferedWriter<MockFile> w;
+        w.begin(&f);
+        bool ok = true;
+        size_t i = 0;
+        for (; i < payload.size() && ok; i += CHUNK) ok = w.write(payload.data() + i, CHUNK);
+        check(!ok && !w.ok(), "a short write fails the upload");
+        check(i < 30000 && w.written() == 20000, "and is noticed within one buffer");
+        size_t writes = f.writes.size();
+        check(!w.write(payload.data(), 10) && !w.flush() && f.writes.size() == writes, "nothing more is written after the failure");
+    }
+
+    printf("Test: file names\n");
+    {
+        char out[64];
+        check(uploadSanitizeName("/part.gcode", out, sizeof(out)) && std::string(out) == "part.gcode", "leading slash dropped");
+        check(uploadSanitizeName("benchy v2 (0.2mm).gcode", out, sizeof(out)), "spaces and brackets are fine");
+        check(!uploadSanitizeName("../main.cpp", out, sizeof(out)), "path traversal refused");
+        check(!uploadSanitizeName("sub/dir.gcode", out, sizeof(out)), "subdirectories refused");
+        check(!uploadSanitizeName("..", out, sizeof(out)) && !uploadSanitizeName("", out, sizeof(out)) && !uploadSanitizeName("/", out, sizeof(out)),
+              "empty and dot names refused");
+        check(!uploadSanitizeName(".gcode.idx", out, sizeof(out)), "dot-files (index, temp uploads) refused");
+        check(!uploadSanitizeName("a\nb.gcode", out, sizeof(out)), "control characters refused");
+        std::string longName(64, 'x');
+        check(!uploadSanitizeName(longName.c_str(), out, sizeof(out)), "name longer than the buffer refused");
+    }
+
+    printf("Test: chunk offsets\n");
+    {
+        check(uploadChunkCheck(0, 1000, 0, 400) == UPLOAD_CHUNK_APPEND, "first chunk");
+        check(uploadChunkCheck(400, 1000, 0, 400) == UPLOAD_CHUNK_DUPLICATE, "resent chunk is acknowledged, not rewritten");
+        check(uploadChunkCheck(400, 1000, 200, 400) == UPLOAD_CHUNK_CONFLICT, "overlap with the end");
+        check(uploadChunkCheck(400, 1000, 800, 200) == UPLOAD_CHUNK_CONFLICT, "gap");
+        check(uploadChunkCheck(800, 1000, 800, 300) == UPLOAD_CHUNK_TOO_LARGE, "past the declared size");
+        check(uploadChunkCheck(0, 0xFFFFFFFFu, 0, UPLOAD_CHUNK_MAX + 1) == UPLOAD_CHUNK_TOO_LARGE, "over the chunk limit");
+        check(uploadChunkCheck(0xFFFFFF00u, 0xFFFFFFFFu, 0xFFFFFF00u, 0x200) == UPLOAD_CHUNK_TOO_LARGE, "no 32-bit wrap-around");
+        uint32_t v = 0;
+        check(uploadParseHex32("cbf43926", v) && v == 0xCBF43926u && uploadParseHex32("CBF43926", v) && uploadParseHex32("0", v) && v == 0,
+              "hex CRC parsing");
+        check(!uploadParseHex32("", v) && !uploadParseHex32("123456789", v) && !uploadParseHex32("12g4", v), "malformed hex refused");
+    }
+
+    printf("Test: resuming over a flaky link\n");
+    {
+        // Client/device exchange as in app.js uploadResumable: chunks are
+        // cut off on the way in, corrupted, or stored with the reply lost.
+        // After a failure the client either resends (reply lost) or asks
+        // for the session's offset.
+        const uint32_t size = (uint32_t)payload.size(), chunkSize = 16384;
+        std::vector<uint8_t> stored(size, 0);
+        uint32_t received = 0, crc = 0, sent = 0;
+        uint32_t offset = 0;
+        int round = 0, duplicates = 0;
+        while (offset < size) {
+            uint32_t len = size - offset < chunkSize ? size - offset : chunkSize;
+            uint32_t want = uploadCrc32Update(0, payload.data() + offset, len);
+            std::vector<uint8_t> wire(payload.begin() + offset, payload.begin() + offset + len);
+            int fault = round++ % 4; // 0 fine, 1 cut off half way, 2 reply lost, 3 bit flip
+            if (fault == 3) wire[len / 2] ^= 0x10;
+            uint32_t arrived = fault == 1 ? len / 2 : len;
+            sent += arrived;
+            UploadChunkVerdict v = uploadChunkCheck(received, size, offset, len);
+            if (v == UPLOAD_CHUNK_DUPLICATE) duplicates++;
+            if (v == UPLOAD_CHUNK_APPEND && arrived == len && uploadCrc32Update(0, wire.data(), len) == want) {
+                memcpy(&stored[offset], wire.data(), len);
+                crc = uploadCrc32Update(crc, wire.data(), len);
+                received += len;
+            }
+            if (fault != 2) offset = received; // reply, or status query after a failure
+        }
+        check(stored == payload && crc == settingsCrc32(payload.data(), size), "file assembled intact despite every kind of fault");
+        check(duplicates > 0, "chunks resent after a lost reply were recognised as duplicates");
+        printf("    %u bytes sent for a %u byte file\n", sent, size);
+        check(sent < 2 * size, "each fault costs at most one chunk");
+    }
+
+    printf("Test: throughput\n");
+    {
+        check(uploadMBps(2000000, 1000000) == 2.0f, "2 MB in 1 s is 2 MB/s");
+        check(uploadMBps(100, 0) == 0.0f, "no time, no rate");
+    }
+
+    if (failures) {
+        printf("\n✗ %d upload check(s) failed\n", failures);
+        return 1;
+    }
+    printf("\n✓ All upload tests passed\n");
+    return 0;
+}
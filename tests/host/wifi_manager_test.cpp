@@ -0,0 +1,149 @@
+// Host test: WiFi connection manager never blocks, falls back to the setup
+// AP, reconnects with backoff and serves scans from its cache.
+//
+// Build & run from the repo root:
+//   g++ -std=c++17 -Iinclude tests/host/wifi_manager_test.cpp -o /tmp/wifi_manager_test && /tmp/wifi_manager_test
+#include <stdio.h>
+#include <vector>
+#include "wifi_manager.h"
+
+static int failures = 0;
+
+static void check(bool ok, const char* what) {
+    printf("  %s %s\n", what, ok ? "✓" : "✗");
+    if (!ok) failures++;
+}
+
+// Network task stand-in: polls every 10 ms and records actions with their time
+struct Log { WifiAction act; uint32_t t; };
+
+static void pump(WifiManager &w, std::vector<Log> &log, uint32_t &t, uint32_t until) {
+    for (; t < until; t += 10) {
+        WifiAction a;
+        while ((a = w.poll(t)) != WIFI_ACT_NONE) log.push_back({ a, t });
+    }
+}
+
+static int count(const std::vector<Log> &log, WifiAction a) {
+    int n = 0;
+    for (const Log &l : log) if (l.act == a) n++;
+    return n;
+}
+
+int main() {
+    printf("Test: boot with good credentials\n");
+    {
+        WifiManager w; std::vector<Log> log; uint32_t t = 0;
+        uint32_t job = w.connect(t);
+        pump(w, log, t, 3000);
+        check(count(log, WIFI_ACT_BEGIN) == 1 && w.state() == WIFI_ST_CONNECTING && w.job(job) == WIFI_JOB_PENDING,
+              "one WiFi.begin(), then waits without blocking");
+        w.onGotIp();
+        pump(w, log, t, 4000);
+        check(w.state() == WIFI_ST_CONNECTED && count(log, WIFI_ACT_CONNECTED) == 1 && count(log, WIFI_ACT_START_AP) == 0 &&
+              w.job(job) == WIFI_JOB_DONE, "connected on the IP event, no setup AP");
+    }
+
+    printf("Test: unreachable network at boot\n");
+    {
+        WifiManager w; std::vector<Log> log; uint32_t t = 0;
+        uint32_t job = w.connect(t);
+        pump(w, log, t, 120000);
+        uint32_t apAt = 0;
+        for (const Log &l : log) if (l.act == WIFI_ACT_START_AP) apAt = l.t;
+        check(count(log, WIFI_ACT_START_AP) == 1 && apAt >= WIFI_CONNECT_TIMEOUT_MS && apAt < WIFI_CONNECT_TIMEOUT_MS + 100 &&
+              w.job(job) == WIFI_JOB_FAILED, "setup AP comes up once after the first attempt times out");
+        // Gaps between attempts (begin to begin, minus the attempt itself) double
+        std::vector<uint32_t> begins;
+        for (const Log &l : log) if (l.act == WIFI_ACT_BEGIN) begins.push_back(l.t);
+        bool doubling = begins.size() >= 4;
+        for (size_t i = 2; i < begins.size(); ++i) {
+            uint32_t prevGap = begins[i - 1] - begins[i - 2] - WIFI_CONNECT_TIMEOUT_MS;
+            uint32_t gap = begins[i] - begins[i - 1] - WIFI_CONNECT_TIMEOUT_MS;
+            if (gap < prevGap * 2 - 20 || gap > prevGap * 2 + 20) doubling = false;
+        }
+        char buf[96];
+        snprintf(buf, sizeof(buf), "%d background retries in 2 min with doubling backoff", (int)begins.size() - 1);
+        check(doubling, buf);
+        w.onGotIp();
+        // Retry loop notices the IP on its next attempt or while backing off
+        pump(w, log, t, 120000 + WIFI_BACKOFF_MAX_MS);
+        check(w.state() == WIFI_ST_CONNECTED && !w.apActive() && count(log, WIFI_ACT_STOP_AP) == 1,
+              "network appearing later is joined and the setup AP is dropped");
+    }
+
+    printf("Test: backoff is capped\n");
+    {
+        WifiManager w; std::vector<Log> log; uint32_t t = 0;
+        w.connect(t);
+        pump(w, log, t, 3600000);
+        uint32_t lastGap = 0, prev = 0;
+        for (const Log &l : log) if (l.act == WIFI_ACT_BEGIN) { if (prev) lastGap = l.t - prev; prev = l.t; }
+        check(lastGap <= WIFI_BACKOFF_MAX_MS + WIFI_CONNECT_TIMEOUT_MS + 20 && lastGap >= WIFI_BACKOFF_MAX_MS,
+              "retries settle at WIFI_BACKOFF_MAX_MS after an hour offline");
+    }
+
+    printf("Test: station drop and reconnect\n");
+    {
+        WifiManager w; std::vector<Log> log; uint32_t t = 0;
+        w.connect(t);
+        w.onGotIp();
+        pump(w, log, t, 1000);
+        w.onDisconnected();
+        pump(w, log, t, 1000 + WIFI_BACKOFF_MIN_MS - 100);
+        check(w.state() == WIFI_ST_BACKOFF && count(log, WIFI_ACT_BEGIN) == 1, "no immediate retry storm after a drop");
+        pump(w, log, t, 1000 + WIFI_BACKOFF_MIN_MS + 100);
+        check(count(log, WIFI_ACT_BEGIN) == 2 && w.state() == WIFI_ST_CONNECTING, "reconnect after the first backoff step");
+        w.onGotIp();
+        pump(w, log, t, t + 100);
+        check(w.state() == WIFI_ST_CONNECTED && count(log, WIFI_ACT_START_AP) == 0, "back online without the setup AP");
+    }
+
+    printf("Test: new credentials from the setup AP\n");
+    {
+        WifiManager w; std::vector<Log> log; uint32_t t = 0;
+        w.startApOnly();
+        pump(w, log, t, 500);
+        check(w.apActive() && count(log, WIFI_ACT_START_AP) == 1, "no credentials: setup AP only");
+        uint32_t job = w.connect(t);
+        pump(w, log, t, 2000);
+        check(w.job(job) == WIFI_JOB_PENDING, "save returns a pending job at once");
+        w.onGotIp();
+        pump(w, log, t, 2100);
+        check(w.job(job) == WIFI_JOB_DONE && w.apActive(), "job done; AP kept so the client can read the new IP");
+        pump(w, log, t, 2100 + WIFI_AP_LINGER_MS + 100);
+        check(!w.apActive() && count(log, WIFI_ACT_STOP_AP) == 1, "AP dropped after the linger time");
+        uint32_t job2 = w.connect(t);
+        check(w.job(job) == WIFI_JOB_UNKNOWN && w.job(job2) == WIFI_JOB_PENDING, "a newer save supersedes the old job");
+    }
+
+    printf("Test: scan cache\n");
+    {
+        WifiManager w; std::vector<Log> log; uint32_t t = 0;
+        w.connect(t);
+        pump(w, log, t, 100);
+        uint32_t s1 = w.scan(t, false);
+        pump(w, log, t, 1000);
+        check(count(log, WIFI_ACT_SCAN) == 0 && w.job(s1) == WIFI_JOB_PENDING, "scan waits while associating");
+        w.onGotIp();
+        pump(w, log, t, 1100);
+        check(count(log, WIFI_ACT_SCAN) == 1 && w.scanStarted(), "scan starts once connected");
+        check(w.scan(t, false) == s1, "requests during a scan share its job");
+        w.scanFinished(t, true);
+        uint32_t s2 = w.scan(t + 5000, false);
+        pump(w, log, t, 1200);
+        check(w.job(s2) == WIFI_JOB_DONE && count(log, WIFI_ACT_SCAN) == 1, "fresh results are served from the cache");
+        uint32_t s3 = w.scan(t, true);
+        pump(w, log, t, 1300);
+        check(w.job(s3) == WIFI_JOB_PENDING && count(log, WIFI_ACT_SCAN) == 2, "refresh forces a new scan");
+        w.scanFinished(t, false);
+        check(w.job(s3) == WIFI_JOB_FAILED && w.hasScanResults(), "failed scan keeps the previous results");
+    }
+
+    if (failures) {
+        printf("\n✗ %d WiFi manager check(s) failed\n", failures);
+        return 1;
+    }
+    printf("\n✓ All WiFi manager tests passed\n");
+    return 0;
+}